@@ -19,6 +19,22 @@ fwupd_client_download_bytes2_async(FwupdClient *self,
 				   GCancellable *cancellable,
 				   GAsyncReadyCallback callback,
 				   gpointer callback_data) G_GNUC_NON_NULL(1, 2);
+void
+fwupd_client_download_file2_async(FwupdClient *self,
+				  GPtrArray *urls,
+				  GFile *file,
+				  const gchar *checksum,
+				  FwupdClientDownloadFlags flags,
+				  GCancellable *cancellable,
+				  GAsyncReadyCallback callback,
+				  gpointer callback_data) G_GNUC_NON_NULL(1, 2, 3);
+GHashTable *
+fwupd_client_upgrades_hash_from_variant(GVariant *value, GError **error) G_GNUC_NON_NULL(1);
+void
+fwupd_client_device_cache_insert(FwupdClient *self, GVariant *value) G_GNUC_NON_NULL(1, 2);
+FwupdDevice *
+fwupd_client_device_cache_update(FwupdClient *self, GVariant *parameters, GError **error)
+    G_GNUC_NON_NULL(1, 2);
 
 #ifdef HAVE_GIO_UNIX
 void
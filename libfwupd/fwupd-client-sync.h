@@ -50,6 +50,12 @@ fwupd_client_get_upgrades(FwupdClient *self,
 			  const gchar *device_id,
 			  GCancellable *cancellable,
 			  GError **error) G_GNUC_WARN_UNUSED_RESULT G_GNUC_NON_NULL(1, 2);
+GHashTable *
+fwupd_client_get_upgrades_all(FwupdClient *self,
+			      FwupdReleaseFlags include,
+			      FwupdReleaseFlags exclude,
+			      GCancellable *cancellable,
+			      GError **error) G_GNUC_WARN_UNUSED_RESULT G_GNUC_NON_NULL(1);
 GPtrArray *
 fwupd_client_get_details(FwupdClient *self,
 			 const gchar *filename,
@@ -80,6 +80,9 @@ typedef struct {
 	gchar *user_agent;
 	GHashTable *hints;		/* str:str */
 	GHashTable *immediate_requests; /* str:FwupdRequest */
+	FwupdFeatureFlags feature_flags;
+	GMutex devices_mutex; /* for @devices */
+	GHashTable *devices;  /* str:GVariant, as last sent by the daemon */
 	GStrv hwid_keys;
 	GStrv hwid_values;
 } FwupdClientPrivate;
@@ -89,6 +92,8 @@ typedef struct {
 	CURL *curl;
 	curl_mime *mime;
 	struct curl_slist *headers;
+	GFile *file;	 /* (nullable): stream the download here rather than into memory */
+	gchar *checksum; /* (nullable): expected checksum of @file */
 } FwupdCurlHelper;
 
 enum {
@@ -139,6 +144,9 @@ fwupd_client_curl_helper_free(FwupdCurlHelper *helper)
 		curl_slist_free_all(helper->headers);
 	if (helper->urls != NULL)
 		g_ptr_array_unref(helper->urls);
+	if (helper->file != NULL)
+		g_object_unref(helper->file);
+	g_free(helper->checksum);
 	g_free(helper);
 }
 
@@ -673,6 +681,12 @@ fwupd_client_update_proxy_name_owner(FwupdClient *self)
 		fwupd_client_set_status(self, FWUPD_STATUS_SHUTDOWN);
 	}
 
+	/* the daemon will not send changes relative to what the old daemon sent */
+	if (name_owner == NULL || priv->proxy_name_owner != NULL) {
+		g_autoptr(GMutexLocker) locker = g_mutex_locker_new(&priv->devices_mutex);
+		g_hash_table_remove_all(priv->devices);
+	}
+
 	/* save so we can detect when the daemon is replaced */
 	g_free(priv->proxy_name_owner);
 	priv->proxy_name_owner = g_steal_pointer(&name_owner);
@@ -684,6 +698,109 @@ fwupd_client_name_owner_changed_cb(GDBusProxy *proxy, GParamSpec *pspec, FwupdCl
 	fwupd_client_update_proxy_name_owner(self);
 }
 
+/**
+ * fwupd_client_device_cache_insert: (skip):
+ **/
+void
+fwupd_client_device_cache_insert(FwupdClient *self, GVariant *value)
+{
+	FwupdClientPrivate *priv = GET_PRIVATE(self);
+	const gchar *device_id = NULL;
+	g_autoptr(GMutexLocker) locker = NULL;
+	g_autoptr(GVariant) dict = NULL;
+
+	g_return_if_fail(FWUPD_IS_CLIENT(self));
+	g_return_if_fail(value != NULL);
+
+	if (g_variant_is_of_type(value, G_VARIANT_TYPE("(a{sv})")))
+		dict = g_variant_get_child_value(value, 0);
+	else
+		dict = g_variant_ref(value);
+	if (!g_variant_lookup(dict, FWUPD_RESULT_KEY_DEVICE_ID, "&s", &device_id))
+		return;
+	locker = g_mutex_locker_new(&priv->devices_mutex);
+	g_hash_table_insert(priv->devices, g_strdup(device_id), g_steal_pointer(&dict));
+}
+
+/**
+ * fwupd_client_device_cache_update: (skip):
+ **/
+FwupdDevice *
+fwupd_client_device_cache_update(FwupdClient *self, GVariant *parameters, GError **error)
+{
+	FwupdClientPrivate *priv = GET_PRIVATE(self);
+	GVariant *val_old;
+	GVariant *value;
+	GVariantIter iter;
+	const gchar *device_id = NULL;
+	const gchar *key;
+	g_autofree const gchar **invalidated = NULL;
+	g_autoptr(FwupdDevice) dev = fwupd_device_new();
+	g_autoptr(GMutexLocker) locker = NULL;
+	g_autoptr(GVariant) changed = NULL;
+	g_autoptr(GVariant) val = NULL;
+	g_autoptr(GVariantDict) dict = NULL;
+
+	g_return_val_if_fail(FWUPD_IS_CLIENT(self), NULL);
+	g_return_val_if_fail(parameters != NULL, NULL);
+	g_return_val_if_fail(error == NULL || *error == NULL, NULL);
+
+	if (!g_variant_is_of_type(parameters, G_VARIANT_TYPE("(sa{sv}as)"))) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_INVALID_DATA,
+			    "GVariant type %s not known",
+			    g_variant_get_type_string(parameters));
+		return NULL;
+	}
+	g_variant_get(parameters, "(&s@a{sv}^a&s)", &device_id, &changed, &invalidated);
+
+	/* apply the changes to the device as last sent */
+	locker = g_mutex_locker_new(&priv->devices_mutex);
+	val_old = g_hash_table_lookup(priv->devices, device_id);
+	dict = g_variant_dict_new(val_old);
+	if (val_old == NULL) {
+		g_debug("no previous state for %s, so using just the changes", device_id);
+		g_variant_dict_insert(dict, FWUPD_RESULT_KEY_DEVICE_ID, "s", device_id);
+	}
+	g_variant_iter_init(&iter, changed);
+	while (g_variant_iter_loop(&iter, "{&sv}", &key, &value))
+		g_variant_dict_insert_value(dict, key, value);
+	for (guint i = 0; invalidated[i] != NULL; i++)
+		g_variant_dict_remove(dict, invalidated[i]);
+	val = g_variant_ref_sink(g_variant_dict_end(dict));
+	g_hash_table_insert(priv->devices, g_strdup(device_id), g_variant_ref(val));
+	if (!fwupd_codec_from_variant(FWUPD_CODEC(dev), val, error))
+		return NULL;
+	return g_steal_pointer(&dev);
+}
+
+static gboolean
+fwupd_client_device_cache_enabled(FwupdClient *self)
+{
+	FwupdClientPrivate *priv = GET_PRIVATE(self);
+	return (priv->feature_flags & FWUPD_FEATURE_FLAG_DEVICE_PROPERTIES_CHANGED) > 0;
+}
+
+static void
+fwupd_client_signal_emit_device_changed(FwupdClient *self, FwupdDevice *dev)
+{
+	FwupdClientPrivate *priv = GET_PRIVATE(self);
+
+	g_debug("emitting ::device-changed(%s)", fwupd_device_get_id(dev));
+	fwupd_client_signal_emit_object(self, SIGNAL_DEVICE_CHANGED, G_OBJECT(dev));
+
+	/* invalidate request */
+	if (fwupd_device_get_status(dev) != FWUPD_STATUS_WAITING_FOR_USER) {
+		FwupdRequest *req =
+		    g_hash_table_lookup(priv->immediate_requests, fwupd_device_get_id(dev));
+		if (req != NULL) {
+			fwupd_client_request_invalidate(self, req);
+			g_hash_table_remove(priv->immediate_requests, fwupd_device_get_id(dev));
+		}
+	}
+}
+
 static void
 fwupd_client_signal_cb(GDBusProxy *proxy,
 		       const gchar *sender_name,
@@ -705,6 +822,8 @@ fwupd_client_signal_cb(GDBusProxy *proxy,
 			g_warning("failed to build FwupdDevice[DeviceAdded]: %s", error->message);
 			return;
 		}
+		if (fwupd_client_device_cache_enabled(self))
+			fwupd_client_device_cache_insert(self, parameters);
 		g_debug("emitting ::device-added(%s)", fwupd_device_get_id(dev));
 		fwupd_client_signal_emit_object(self, SIGNAL_DEVICE_ADDED, G_OBJECT(dev));
 		return;
@@ -715,6 +834,10 @@ fwupd_client_signal_cb(GDBusProxy *proxy,
 			g_warning("failed to build FwupdDevice[DeviceRemoved]: %s", error->message);
 			return;
 		}
+		if (fwupd_device_get_id(dev) != NULL) {
+			g_autoptr(GMutexLocker) locker = g_mutex_locker_new(&priv->devices_mutex);
+			g_hash_table_remove(priv->devices, fwupd_device_get_id(dev));
+		}
 		g_debug("emitting ::device-removed(%s)", fwupd_device_get_id(dev));
 		fwupd_client_signal_emit_object(self, SIGNAL_DEVICE_REMOVED, G_OBJECT(dev));
 		return;
@@ -725,19 +848,19 @@ fwupd_client_signal_cb(GDBusProxy *proxy,
 			g_warning("failed to build FwupdDevice[DeviceChanged]: %s", error->message);
 			return;
 		}
-		g_debug("emitting ::device-changed(%s)", fwupd_device_get_id(dev));
-		fwupd_client_signal_emit_object(self, SIGNAL_DEVICE_CHANGED, G_OBJECT(dev));
-
-		/* invalidate request */
-		if (fwupd_device_get_status(dev) != FWUPD_STATUS_WAITING_FOR_USER) {
-			FwupdRequest *req =
-			    g_hash_table_lookup(priv->immediate_requests, fwupd_device_get_id(dev));
-			if (req != NULL) {
-				fwupd_client_request_invalidate(self, req);
-				g_hash_table_remove(priv->immediate_requests,
-						    fwupd_device_get_id(dev));
-			}
+		if (fwupd_client_device_cache_enabled(self))
+			fwupd_client_device_cache_insert(self, parameters);
+		fwupd_client_signal_emit_device_changed(self, dev);
+		return;
+	}
+	if (g_strcmp0(signal_name, "DevicePropertiesChanged") == 0) {
+		dev = fwupd_client_device_cache_update(self, parameters, &error);
+		if (dev == NULL) {
+			g_warning("failed to build FwupdDevice[DevicePropertiesChanged]: %s",
+				  error->message);
+			return;
 		}
+		fwupd_client_signal_emit_device_changed(self, dev);
 		return;
 	}
 	if (g_strcmp0(signal_name, "DeviceRequest") == 0) {
@@ -1790,6 +1913,7 @@ static void
 fwupd_client_get_devices_cb(GObject *source, GAsyncResult *res, gpointer user_data)
 {
 	g_autoptr(GTask) task = G_TASK(user_data);
+	FwupdClient *self = g_task_get_source_object(task);
 	g_autoptr(GError) error = NULL;
 	g_autoptr(GPtrArray) array = NULL;
 	g_autoptr(GVariant) val = NULL;
@@ -1807,6 +1931,16 @@ fwupd_client_get_devices_cb(GObject *source, GAsyncResult *res, gpointer user_da
 	}
 	fwupd_device_array_ensure_parents(array);
 
+	/* DevicePropertiesChanged only has the changes since these */
+	if (fwupd_client_device_cache_enabled(self) &&
+	    g_variant_is_of_type(val, G_VARIANT_TYPE("(aa{sv})"))) {
+		g_autoptr(GVariant) devices = g_variant_get_child_value(val, 0);
+		for (gsize i = 0; i < g_variant_n_children(devices); i++) {
+			g_autoptr(GVariant) dict = g_variant_get_child_value(devices, i);
+			fwupd_client_device_cache_insert(self, dict);
+		}
+	}
+
 	/* success */
 	g_task_return_pointer(task, g_steal_pointer(&array), (GDestroyNotify)g_ptr_array_unref);
 }
@@ -2596,6 +2730,146 @@ fwupd_client_get_upgrades_finish(FwupdClient *self, GAsyncResult *res, GError **
 	return g_task_propagate_pointer(G_TASK(res), error);
 }
 
+/**
+ * fwupd_client_upgrades_hash_from_variant: (skip):
+ **/
+GHashTable *
+fwupd_client_upgrades_hash_from_variant(GVariant *value, GError **error)
+{
+	gsize sz;
+	g_autoptr(GHashTable) hash = NULL;
+	g_autoptr(GVariant) untuple = NULL;
+
+	hash = g_hash_table_new_full(g_str_hash,
+				     g_str_equal,
+				     g_free,
+				     (GDestroyNotify)g_ptr_array_unref);
+	untuple = g_variant_get_child_value(value, 0);
+	sz = g_variant_n_children(untuple);
+	for (guint i = 0; i < sz; i++) {
+		const gchar *device_id = NULL;
+		gsize releasesz;
+		g_autoptr(GPtrArray) array = NULL;
+		g_autoptr(GVariant) data = g_variant_get_child_value(untuple, i);
+		g_autoptr(GVariant) releases = NULL;
+
+		g_variant_get(data, "{&s@aa{sv}}", &device_id, &releases);
+		array = g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
+		releasesz = g_variant_n_children(releases);
+		for (guint j = 0; j < releasesz; j++) {
+			g_autoptr(FwupdRelease) release = fwupd_release_new();
+			g_autoptr(GVariant) release_data = g_variant_get_child_value(releases, j);
+			if (!fwupd_codec_from_variant(FWUPD_CODEC(release), release_data, error))
+				return NULL;
+			g_ptr_array_add(array, g_steal_pointer(&release));
+		}
+		g_hash_table_insert(hash, g_strdup(device_id), g_steal_pointer(&array));
+	}
+	return g_steal_pointer(&hash);
+}
+
+static void
+fwupd_client_get_upgrades_all_cb(GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	g_autoptr(GTask) task = G_TASK(user_data);
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GHashTable) hash = NULL;
+	g_autoptr(GVariant) val = NULL;
+
+	val = g_dbus_proxy_call_finish(G_DBUS_PROXY(source), res, &error);
+	if (val == NULL) {
+		/* the caller can fall back to fwupd_client_get_upgrades_async() */
+		if (g_error_matches(error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD)) {
+			g_task_return_new_error(task,
+						FWUPD_ERROR,
+						FWUPD_ERROR_NOT_SUPPORTED,
+						"daemon does not support GetUpgradesAll");
+			return;
+		}
+		fwupd_client_fixup_dbus_error(error);
+		g_task_return_error(task, g_steal_pointer(&error));
+		return;
+	}
+	hash = fwupd_client_upgrades_hash_from_variant(val, &error);
+	if (hash == NULL) {
+		g_task_return_error(task, g_steal_pointer(&error));
+		return;
+	}
+
+	/* success */
+	g_task_return_pointer(task, g_steal_pointer(&hash), (GDestroyNotify)g_hash_table_unref);
+}
+
+/**
+ * fwupd_client_get_upgrades_all_async:
+ * @self: a #FwupdClient
+ * @include: #FwupdReleaseFlags that must be set, or %FWUPD_RELEASE_FLAG_NONE
+ * @exclude: #FwupdReleaseFlags that must not be set, or %FWUPD_RELEASE_FLAG_NONE
+ * @cancellable: (nullable): optional #GCancellable
+ * @callback: (scope async) (closure callback_data): the function to run on completion
+ * @callback_data: the data to pass to @callback
+ *
+ * Gets the upgrades for all the supported devices using one request.
+ *
+ * The release flags are matched by the daemon, and devices without any matching upgrade are
+ * not included in the result.
+ *
+ * If the daemon is too old to support this method then %FWUPD_ERROR_NOT_SUPPORTED is
+ * returned, and [method@FwupdClient.get_upgrades_async] should be used for each device.
+ *
+ * You must have called [method@Client.connect_async] on @self before using
+ * this method.
+ *
+ * Since: 2.0.19
+ **/
+void
+fwupd_client_get_upgrades_all_async(FwupdClient *self,
+				    FwupdReleaseFlags include,
+				    FwupdReleaseFlags exclude,
+				    GCancellable *cancellable,
+				    GAsyncReadyCallback callback,
+				    gpointer callback_data)
+{
+	FwupdClientPrivate *priv = GET_PRIVATE(self);
+	g_autoptr(GTask) task = NULL;
+
+	g_return_if_fail(FWUPD_IS_CLIENT(self));
+	g_return_if_fail(cancellable == NULL || G_IS_CANCELLABLE(cancellable));
+	g_return_if_fail(priv->proxy != NULL);
+
+	/* call into daemon */
+	task = g_task_new(self, cancellable, callback, callback_data);
+	g_dbus_proxy_call(priv->proxy,
+			  "GetUpgradesAll",
+			  g_variant_new("(tt)", (guint64)include, (guint64)exclude),
+			  G_DBUS_CALL_FLAGS_NONE,
+			  FWUPD_CLIENT_DBUS_PROXY_TIMEOUT,
+			  cancellable,
+			  fwupd_client_get_upgrades_all_cb,
+			  g_steal_pointer(&task));
+}
+
+/**
+ * fwupd_client_get_upgrades_all_finish:
+ * @self: a #FwupdClient
+ * @res: (not nullable): the asynchronous result
+ * @error: (nullable): optional return location for an error
+ *
+ * Gets the result of [method@FwupdClient.get_upgrades_all_async].
+ *
+ * Returns: (element-type utf8 GPtrArray) (transfer container): device ID to #FwupdRelease array
+ *
+ * Since: 2.0.19
+ **/
+GHashTable *
+fwupd_client_get_upgrades_all_finish(FwupdClient *self, GAsyncResult *res, GError **error)
+{
+	g_return_val_if_fail(FWUPD_IS_CLIENT(self), NULL);
+	g_return_val_if_fail(g_task_is_valid(res, self), NULL);
+	g_return_val_if_fail(error == NULL || *error == NULL, NULL);
+	return g_task_propagate_pointer(G_TASK(res), error);
+}
+
 static void
 fwupd_client_modify_config_cb(GObject *source, GAsyncResult *res, gpointer user_data)
 {
@@ -3491,6 +3765,7 @@ typedef struct {
 	FwupdRelease *release;
 	FwupdInstallFlags install_flags;
 	FwupdClientDownloadFlags download_flags;
+	GFile *file; /* downloaded firmware in the cache directory */
 } FwupdClientInstallReleaseData;
 
 static void
@@ -3498,6 +3773,8 @@ fwupd_client_install_release_data_free(FwupdClientInstallReleaseData *data)
 {
 	g_object_unref(data->device);
 	g_object_unref(data->release);
+	if (data->file != NULL)
+		g_object_unref(data->file);
 	g_free(data);
 }
 
@@ -3517,12 +3794,18 @@ fwupd_client_install_release_cb(GObject *source, GAsyncResult *res, gpointer use
 }
 
 static void
-fwupd_client_install_release_bytes_cb(GObject *source, GAsyncResult *res, gpointer user_data)
+fwupd_client_install_release_file_cb(GObject *source, GAsyncResult *res, gpointer user_data)
 {
 	g_autoptr(GError) error = NULL;
 	g_autoptr(GTask) task = G_TASK(user_data);
+	FwupdClientInstallReleaseData *data = g_task_get_task_data(task);
 
-	if (!fwupd_client_install_bytes_finish(FWUPD_CLIENT(source), res, &error)) {
+	/* the daemon has finished with the fd so the download is no longer required */
+	if (!g_file_delete(data->file, NULL, &error)) {
+		g_debug("failed to delete download: %s", error->message);
+		g_clear_error(&error);
+	}
+	if (!fwupd_client_install_finish(FWUPD_CLIENT(source), res, &error)) {
 		g_task_return_error(task, g_steal_pointer(&error));
 		return;
 	}
@@ -3534,42 +3817,47 @@ fwupd_client_install_release_bytes_cb(GObject *source, GAsyncResult *res, gpoint
 static void
 fwupd_client_install_release_download_cb(GObject *source, GAsyncResult *res, gpointer user_data)
 {
-	g_autoptr(GBytes) blob = NULL;
 	g_autoptr(GError) error = NULL;
 	g_autoptr(GTask) task = G_TASK(user_data);
 	FwupdClientInstallReleaseData *data = g_task_get_task_data(task);
-	GChecksumType checksum_type;
 	GCancellable *cancellable = g_task_get_cancellable(task);
-	const gchar *checksum_expected;
-	g_autofree gchar *checksum_actual = NULL;
+	g_autofree gchar *filename = NULL;
 
-	blob = fwupd_client_download_bytes_finish(FWUPD_CLIENT(source), res, &error);
-	if (blob == NULL) {
+	/* the checksum was verified as the data was received */
+	if (!fwupd_client_download_file_finish(FWUPD_CLIENT(source), res, &error)) {
 		g_task_return_error(task, g_steal_pointer(&error));
 		return;
 	}
 
-	/* verify checksum */
-	checksum_expected = fwupd_checksum_get_best(fwupd_release_get_checksums(data->release));
-	checksum_type = fwupd_checksum_guess_kind(checksum_expected);
-	checksum_actual = g_compute_checksum_for_bytes(checksum_type, blob);
-	if (g_strcmp0(checksum_expected, checksum_actual) != 0) {
-		g_task_return_new_error(task,
-					FWUPD_ERROR,
-					FWUPD_ERROR_INVALID_FILE,
-					"checksum invalid, expected %s got %s",
-					checksum_expected,
-					checksum_actual);
-		return;
-	}
+	/* pass the daemon an fd rather than copying the firmware into memory */
+	filename = g_file_get_path(data->file);
+	fwupd_client_install_async(FWUPD_CLIENT(source),
+				   fwupd_device_get_id(data->device),
+				   filename,
+				   data->install_flags,
+				   cancellable,
+				   fwupd_client_install_release_file_cb,
+				   g_steal_pointer(&task));
+}
+
+/* named by checksum so that an interrupted download of the same release can be resumed */
+static GFile *
+fwupd_client_install_release_build_file(FwupdRelease *release, GError **error)
+{
+	const gchar *checksum = fwupd_checksum_get_best(fwupd_release_get_checksums(release));
+	g_autofree gchar *basename = NULL;
+	g_autofree gchar *filename = NULL;
 
-	fwupd_client_install_bytes_async(FWUPD_CLIENT(source),
-					 fwupd_device_get_id(data->device),
-					 blob,
-					 data->install_flags,
-					 cancellable,
-					 fwupd_client_install_release_bytes_cb,
-					 g_steal_pointer(&task));
+	if (checksum == NULL) {
+		g_set_error_literal(error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_INVALID_FILE,
+				    "release has no checksum");
+		return NULL;
+	}
+	basename = g_strdup_printf("%s.cab", checksum);
+	filename = g_build_filename(g_get_user_cache_dir(), "fwupd", "downloads", basename, NULL);
+	return g_file_new_for_path(filename);
 }
 
 static gboolean
@@ -3614,6 +3902,7 @@ static void
 fwupd_client_install_release_remote_cb(GObject *source, GAsyncResult *res, gpointer user_data)
 {
 	GPtrArray *locations;
+	const gchar *checksum;
 	const gchar *uri_tmp;
 	g_autofree gchar *fn = NULL;
 	g_autoptr(FwupdRemote) remote = NULL;
@@ -3704,12 +3993,15 @@ fwupd_client_install_release_remote_cb(GObject *source, GAsyncResult *res, gpoin
 	}
 
 	/* download file */
-	fwupd_client_download_bytes2_async(FWUPD_CLIENT(source),
-					   uris_built,
-					   data->download_flags,
-					   cancellable,
-					   fwupd_client_install_release_download_cb,
-					   g_steal_pointer(&task));
+	checksum = fwupd_checksum_get_best(fwupd_release_get_checksums(data->release));
+	fwupd_client_download_file2_async(FWUPD_CLIENT(source),
+					  uris_built,
+					  data->file,
+					  checksum,
+					  data->download_flags,
+					  cancellable,
+					  fwupd_client_install_release_download_cb,
+					  g_steal_pointer(&task));
 }
 
 static GPtrArray *
@@ -3770,6 +4062,7 @@ fwupd_client_install_release_async(FwupdClient *self,
 {
 	FwupdClientPrivate *priv = GET_PRIVATE(self);
 	g_autoptr(GTask) task = NULL;
+	g_autoptr(GError) error = NULL;
 	FwupdClientInstallReleaseData *data;
 	const gchar *remote_id;
 
@@ -3787,16 +4080,25 @@ fwupd_client_install_release_async(FwupdClient *self,
 	data->download_flags = download_flags;
 	data->install_flags = install_flags;
 	g_task_set_task_data(task, data, (GDestroyNotify)fwupd_client_install_release_data_free);
+	data->file = fwupd_client_install_release_build_file(release, &error);
+	if (data->file == NULL) {
+		g_task_return_error(task, g_steal_pointer(&error));
+		return;
+	}
 
 	/* work out what remote-specific URI fields this should use */
 	remote_id = fwupd_release_get_remote_id(release);
 	if (remote_id == NULL) {
-		fwupd_client_download_bytes2_async(self,
-						   fwupd_release_get_locations(release),
-						   download_flags,
-						   cancellable,
-						   fwupd_client_install_release_download_cb,
-						   g_steal_pointer(&task));
+		const gchar *checksum =
+		    fwupd_checksum_get_best(fwupd_release_get_checksums(release));
+		fwupd_client_download_file2_async(self,
+						  fwupd_release_get_locations(release),
+						  data->file,
+						  checksum,
+						  download_flags,
+						  cancellable,
+						  fwupd_client_install_release_download_cb,
+						  g_steal_pointer(&task));
 		return;
 	}
 
@@ -5171,6 +5473,7 @@ fwupd_client_set_feature_flags_async(FwupdClient *self,
 	g_return_if_fail(priv->proxy != NULL);
 
 	/* call into daemon */
+	priv->feature_flags = feature_flags;
 	task = g_task_new(self, cancellable, callback, callback_data);
 	g_dbus_proxy_call(priv->proxy,
 			  "SetFeatureFlags",
@@ -5727,12 +6030,167 @@ fwupd_client_set_user_agent_for_package(FwupdClient *self,
 	fwupd_client_rebuild_user_agent(self);
 }
 
+/* the destination of the response body, either in memory or streamed into a file */
+typedef struct {
+	CURL *curl;
+	GByteArray *buf;	 /* payload when in memory, otherwise the error response */
+	GFileIOStream *iostream; /* (nullable) */
+	GChecksum *checksum;	 /* (nullable): of the data written to @iostream */
+	goffset offset;		 /* bytes written to @iostream */
+	gboolean received;	 /* data was received in this attempt */
+	GError *error;		 /* (nullable): failure writing to @iostream */
+} FwupdClientDownload;
+
+static FwupdClientDownload *
+fwupd_client_download_new(CURL *curl)
+{
+	FwupdClientDownload *download = g_new0(FwupdClientDownload, 1);
+	download->curl = curl;
+	download->buf = g_byte_array_new();
+	return download;
+}
+
+static void
+fwupd_client_download_free(FwupdClientDownload *download)
+{
+	if (download->iostream != NULL)
+		g_object_unref(download->iostream);
+	if (download->checksum != NULL)
+		g_checksum_free(download->checksum);
+	if (download->error != NULL)
+		g_error_free(download->error);
+	g_byte_array_unref(download->buf);
+	g_free(download);
+}
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(FwupdClientDownload, fwupd_client_download_free)
+
+/* existing data is only kept when there is a checksum to verify the resumed download */
+static gboolean
+fwupd_client_download_open_file(FwupdClientDownload *download,
+				GFile *file,
+				const gchar *checksum,
+				GCancellable *cancellable,
+				GError **error)
+{
+	GInputStream *istream;
+	gsize bufsz = 0x8000;
+	g_autofree guint8 *buf = g_malloc(bufsz);
+	g_autoptr(GFile) parent = g_file_get_parent(file);
+	g_autoptr(GError) error_local = NULL;
+
+	if (parent != NULL &&
+	    !g_file_make_directory_with_parents(parent, cancellable, &error_local)) {
+		if (!g_error_matches(error_local, G_IO_ERROR, G_IO_ERROR_EXISTS)) {
+			g_propagate_error(error, g_steal_pointer(&error_local));
+			return FALSE;
+		}
+	}
+	if (g_file_query_exists(file, cancellable)) {
+		download->iostream = g_file_open_readwrite(file, cancellable, error);
+	} else {
+		download->iostream =
+		    g_file_create_readwrite(file, G_FILE_CREATE_PRIVATE, cancellable, error);
+	}
+	if (download->iostream == NULL)
+		return FALSE;
+
+	/* the old data might be from a different file, and nothing would notice */
+	if (checksum == NULL)
+		return g_seekable_truncate(G_SEEKABLE(download->iostream), 0, cancellable, error);
+	download->checksum = g_checksum_new(fwupd_checksum_guess_kind(checksum));
+
+	/* hash what is already there, which also leaves the stream positioned at the end */
+	istream = g_io_stream_get_input_stream(G_IO_STREAM(download->iostream));
+	while (TRUE) {
+		gssize rc = g_input_stream_read(istream, buf, bufsz, cancellable, error);
+		if (rc < 0)
+			return FALSE;
+		if (rc == 0)
+			break;
+		g_checksum_update(download->checksum, buf, rc);
+		download->offset += rc;
+	}
+	if (download->offset > 0)
+		g_info("resuming download from 0x%x bytes", (guint)download->offset);
+
+	/* success */
+	return TRUE;
+}
+
+/* the data in the file is complete and matches @checksum */
+static gboolean
+fwupd_client_download_is_complete(FwupdClientDownload *download, const gchar *checksum)
+{
+	g_autoptr(GChecksum) checksum_tmp = NULL;
+
+	if (checksum == NULL || download->checksum == NULL || download->offset == 0)
+		return FALSE;
+	checksum_tmp = g_checksum_copy(download->checksum);
+	return g_strcmp0(g_checksum_get_string(checksum_tmp), checksum) == 0;
+}
+
+static gboolean
+fwupd_client_download_truncate(FwupdClientDownload *download, GError **error)
+{
+	if (!g_seekable_truncate(G_SEEKABLE(download->iostream), 0, NULL, error))
+		return FALSE;
+	if (!g_seekable_seek(G_SEEKABLE(download->iostream), 0, G_SEEK_SET, NULL, error))
+		return FALSE;
+	if (download->checksum != NULL)
+		g_checksum_reset(download->checksum);
+	download->offset = 0;
+	return TRUE;
+}
+
+static gboolean
+fwupd_client_download_write(FwupdClientDownload *download,
+			    const guint8 *data,
+			    gsize datasz,
+			    GError **error)
+{
+	GOutputStream *ostream;
+
+	if (download->iostream == NULL) {
+		g_byte_array_append(download->buf, data, datasz);
+		return TRUE;
+	}
+	ostream = g_io_stream_get_output_stream(G_IO_STREAM(download->iostream));
+	if (!g_output_stream_write_all(ostream, data, datasz, NULL, NULL, error))
+		return FALSE;
+	if (download->checksum != NULL)
+		g_checksum_update(download->checksum, data, datasz);
+	download->offset += datasz;
+	return TRUE;
+}
+
 static size_t
 fwupd_client_download_write_callback_cb(char *ptr, size_t size, size_t nmemb, void *userdata)
 {
-	GByteArray *buf = (GByteArray *)userdata;
+	FwupdClientDownload *download = (FwupdClientDownload *)userdata;
 	gsize realsize = size * nmemb;
-	g_byte_array_append(buf, (const guint8 *)ptr, realsize);
+
+	if (download->iostream != NULL) {
+		glong status_code = 0;
+
+		/* the error response is only used for the error message */
+		(void)curl_easy_getinfo(download->curl, CURLINFO_RESPONSE_CODE, &status_code);
+		if (status_code >= 400) {
+			if (download->buf->len < 4000)
+				g_byte_array_append(download->buf, (const guint8 *)ptr, realsize);
+			return realsize;
+		}
+
+		/* the server ignored the range request and is sending everything again */
+		if (status_code == 200 && !download->received && download->offset > 0) {
+			g_info("server does not support resuming downloads, starting again");
+			if (!fwupd_client_download_truncate(download, &download->error))
+				return 0;
+		}
+	}
+	download->received = TRUE;
+	if (!fwupd_client_download_write(download, (const guint8 *)ptr, realsize, &download->error))
+		return 0;
 	return realsize;
 }
 
@@ -5780,13 +6238,18 @@ fwupd_client_download_ipfs(FwupdClient *self,
 	return g_steal_pointer(&bstdout);
 }
 
-static GBytes *
-fwupd_client_download_http(FwupdClient *self, CURL *curl, const gchar *url, GError **error)
+static gboolean
+fwupd_client_download_http(FwupdClient *self,
+			   CURL *curl,
+			   const gchar *url,
+			   FwupdClientDownload *download,
+			   GError **error)
 {
 	CURLcode res;
+	GByteArray *buf = download->buf;
 	gchar errbuf[CURL_ERROR_SIZE] = {'\0'};
 	glong status_code = 0;
-	g_autoptr(GByteArray) buf = g_byte_array_new();
+	g_autofree gchar *range = NULL;
 
 	/* relax the SSL checks on localhost URLs and broken corporate proxies */
 	if (fwupd_client_is_localhost(url) || g_getenv("DISABLE_SSL_STRICT") != NULL) {
@@ -5803,17 +6266,31 @@ fwupd_client_download_http(FwupdClient *self, CURL *curl, const gchar *url, GErr
 	(void)curl_easy_setopt(curl,
 			       CURLOPT_WRITEFUNCTION,
 			       fwupd_client_download_write_callback_cb);
-	(void)curl_easy_setopt(curl, CURLOPT_WRITEDATA, buf);
+	(void)curl_easy_setopt(curl, CURLOPT_WRITEDATA, download);
+
+	/* continue from where the last attempt stopped */
+	g_byte_array_set_size(buf, 0);
+	download->received = FALSE;
+	if (download->offset > 0)
+		range = g_strdup_printf("%" G_GOFFSET_FORMAT "-", download->offset);
+	(void)curl_easy_setopt(curl, CURLOPT_RANGE, range);
+
 	res = curl_easy_perform(curl);
 	fwupd_client_set_status(self, FWUPD_STATUS_IDLE);
 	fwupd_client_set_percentage(self, 100);
-	if (res == CURLE_SEND_ERROR || res == CURLE_RECV_ERROR) {
+	if (res == CURLE_WRITE_ERROR && download->error != NULL) {
+		g_propagate_prefixed_error(error,
+					   g_steal_pointer(&download->error),
+					   "failed to write download: ");
+		return FALSE;
+	}
+	if (res == CURLE_SEND_ERROR || res == CURLE_RECV_ERROR || res == CURLE_PARTIAL_FILE) {
 		g_set_error(error,
 			    FWUPD_ERROR,
 			    FWUPD_ERROR_TIMED_OUT,
 			    "transient failure: %s",
 			    errbuf);
-		return NULL;
+		return FALSE;
 	}
 	if (res != CURLE_OK) {
 		if (errbuf[0] != '\0') {
@@ -5822,19 +6299,27 @@ fwupd_client_download_http(FwupdClient *self, CURL *curl, const gchar *url, GErr
 				    FWUPD_ERROR_INVALID_FILE,
 				    "failed to download file: %s",
 				    errbuf);
-			return NULL;
+			return FALSE;
 		}
 		g_set_error(error,
 			    FWUPD_ERROR,
 			    FWUPD_ERROR_INVALID_FILE,
 			    "failed to download file: %s",
 			    curl_easy_strerror(res));
-		return NULL;
+		return FALSE;
 	}
 
 	/* check for server limit */
 	curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status_code);
 	g_info("status-code was %ld", status_code);
+
+	/* the partial file is either already complete or not what the server has */
+	if (status_code == 416 && download->offset > 0) {
+		g_info("cannot resume download, starting again");
+		if (!fwupd_client_download_truncate(download, error))
+			return FALSE;
+		return fwupd_client_download_http(self, curl, url, download, error);
+	}
 	if (status_code == 429) {
 		g_autofree gchar *str = g_strndup((const gchar *)buf->data, MIN(buf->len, 4000));
 		if (g_str_is_ascii(str)) {
@@ -5843,13 +6328,13 @@ fwupd_client_download_http(FwupdClient *self, CURL *curl, const gchar *url, GErr
 				    FWUPD_ERROR_TIMED_OUT,
 				    "Failed to download due to server limit: %s",
 				    str);
-			return NULL;
+			return FALSE;
 		}
 		g_set_error_literal(error,
 				    FWUPD_ERROR,
 				    FWUPD_ERROR_INVALID_FILE,
 				    "Failed to download due to server limit");
-		return NULL;
+		return FALSE;
 	}
 	if (status_code == 502 || status_code == 503 || status_code == 504) {
 		g_autofree gchar *str = g_strndup((const gchar *)buf->data, MIN(buf->len, 4000));
@@ -5860,14 +6345,14 @@ fwupd_client_download_http(FwupdClient *self, CURL *curl, const gchar *url, GErr
 				    "Transient failure to download, server response was %u: %s",
 				    (guint)status_code,
 				    str);
-			return NULL;
+			return FALSE;
 		}
 		g_set_error(error,
 			    FWUPD_ERROR,
 			    FWUPD_ERROR_TIMED_OUT,
 			    "Transient failure to download, server response was %u",
 			    (guint)status_code);
-		return NULL;
+		return FALSE;
 	}
 	if (status_code >= 400) {
 		g_autofree gchar *str = g_strndup((const gchar *)buf->data, MIN(buf->len, 4000));
@@ -5878,17 +6363,18 @@ fwupd_client_download_http(FwupdClient *self, CURL *curl, const gchar *url, GErr
 				    "Failed to download, server response was %u: %s",
 				    (guint)status_code,
 				    str);
-			return NULL;
+			return FALSE;
 		}
 		g_set_error(error,
 			    FWUPD_ERROR,
 			    FWUPD_ERROR_INVALID_FILE,
 			    "Failed to download, server response was %u",
 			    (guint)status_code);
-		return NULL;
+		return FALSE;
 	}
 
-	return g_bytes_new(buf->data, buf->len);
+	/* success */
+	return TRUE;
 }
 
 static gboolean
@@ -5931,32 +6417,44 @@ fwupd_client_test_network(const gchar *url, GError **error)
 	return TRUE;
 }
 
-static GBytes *
-fwupd_client_download_http_retry(FwupdClient *self, CURL *curl, const gchar *url, GError **error)
+static gboolean
+fwupd_client_download_http_retry(FwupdClient *self,
+				 CURL *curl,
+				 const gchar *url,
+				 FwupdClientDownload *download,
+				 GError **error)
 {
 	FwupdClientPrivate *priv = GET_PRIVATE(self);
 	gulong delay_ms = 2500;
 
 	/* test if we can reach this network */
 	if (!fwupd_client_test_network(url, error))
-		return NULL;
+		return FALSE;
 
-	for (guint i = 0;; i++, delay_ms *= 2) {
-		g_autoptr(GBytes) blob = NULL;
+	for (guint i = 0;; i++) {
+		goffset offset_old = download->offset;
 		g_autoptr(GError) error_local = NULL;
 
-		blob = fwupd_client_download_http(self, curl, url, &error_local);
-		if (blob != NULL)
-			return g_steal_pointer(&blob);
+		if (fwupd_client_download_http(self, curl, url, download, &error_local))
+			return TRUE;
 		if (i >= priv->download_retries ||
 		    fwupd_client_download_error_is_fatal(error_local)) {
 			g_propagate_error(error, g_steal_pointer(&error_local));
 			break;
 		}
+
+		/* the connection dropped part way through, so resume straight away */
+		if (download->offset > offset_old) {
+			g_debug("resuming from 0x%x bytes: %s",
+				(guint)download->offset,
+				error_local->message);
+			continue;
+		}
 		g_debug("ignoring and trying again: %s", error_local->message);
 		g_usleep(delay_ms * 1000);
+		delay_ms *= 2;
 	}
-	return NULL;
+	return FALSE;
 }
 static void
 fwupd_client_download_bytes_thread_cb(GTask *task,
@@ -5967,6 +6465,7 @@ fwupd_client_download_bytes_thread_cb(GTask *task,
 	FwupdClient *self = FWUPD_CLIENT(source_object);
 	FwupdCurlHelper *helper = g_task_get_task_data(task);
 	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(FwupdClientDownload) download = fwupd_client_download_new(helper->curl);
 
 	for (guint i = 0; i < helper->urls->len; i++) {
 		const gchar *url = g_ptr_array_index(helper->urls, i);
@@ -5977,9 +6476,14 @@ fwupd_client_download_bytes_thread_cb(GTask *task,
 			return;
 		}
 		if (fwupd_client_is_url_http(url)) {
-			blob = fwupd_client_download_http_retry(self, helper->curl, url, &error);
-			if (blob != NULL)
+			if (fwupd_client_download_http_retry(self,
+							     helper->curl,
+							     url,
+							     download,
+							     &error)) {
+				blob = g_bytes_new(download->buf->data, download->buf->len);
 				break;
+			}
 		} else if (fwupd_client_is_url_ipfs(url)) {
 			blob = fwupd_client_download_ipfs(self, url, cancellable, &error);
 			if (blob != NULL)
@@ -6101,6 +6605,241 @@ fwupd_client_download_bytes_finish(FwupdClient *self, GAsyncResult *res, GError
 	return g_task_propagate_pointer(G_TASK(res), error);
 }
 
+static void
+fwupd_client_download_file_thread_cb(GTask *task,
+				     gpointer source_object,
+				     gpointer task_data,
+				     GCancellable *cancellable)
+{
+	FwupdClient *self = FWUPD_CLIENT(source_object);
+	FwupdCurlHelper *helper = g_task_get_task_data(task);
+	g_autofree gchar *basename = g_file_get_basename(helper->file);
+	g_autofree gchar *basename_part = g_strdup_printf("%s.part", basename);
+	g_autoptr(FwupdClientDownload) download = fwupd_client_download_new(helper->curl);
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GFile) file_part = NULL;
+	g_autoptr(GFile) parent = g_file_get_parent(helper->file);
+
+	/* the partial file lives next to the destination so it can be renamed */
+	if (parent == NULL) {
+		g_task_return_new_error(task,
+					FWUPD_ERROR,
+					FWUPD_ERROR_INVALID_FILE,
+					"no parent directory for %s",
+					basename);
+		return;
+	}
+	file_part = g_file_get_child(parent, basename_part);
+	if (!fwupd_client_download_open_file(download,
+					     file_part,
+					     helper->checksum,
+					     cancellable,
+					     &error)) {
+		g_task_return_error(task, g_steal_pointer(&error));
+		return;
+	}
+
+	/* an earlier attempt may have already got everything */
+	for (guint i = 0; i < helper->urls->len; i++) {
+		const gchar *url = g_ptr_array_index(helper->urls, i);
+		if (fwupd_client_download_is_complete(download, helper->checksum)) {
+			g_info("already downloaded %s", url);
+			break;
+		}
+		g_info("downloading %s", url);
+		if (!fwupd_client_curl_helper_set_proxy(self, helper, url, &error)) {
+			g_task_return_error(task, g_steal_pointer(&error));
+			return;
+		}
+		if (fwupd_client_is_url_http(url)) {
+			if (fwupd_client_download_http_retry(self,
+							     helper->curl,
+							     url,
+							     download,
+							     &error))
+				break;
+		} else if (fwupd_client_is_url_ipfs(url)) {
+			g_autoptr(GBytes) blob = NULL;
+			blob = fwupd_client_download_ipfs(self, url, cancellable, &error);
+			if (blob != NULL) {
+				if (!fwupd_client_download_truncate(download, &error) ||
+				    !fwupd_client_download_write(download,
+								 g_bytes_get_data(blob, NULL),
+								 g_bytes_get_size(blob),
+								 &error)) {
+					g_task_return_error(task, g_steal_pointer(&error));
+					return;
+				}
+				break;
+			}
+		} else {
+			g_set_error(&error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_INVALID_FILE,
+				    "not sure how to handle: %s",
+				    url);
+			/* nocheck:error-false-return */
+		}
+		if (i == helper->urls->len - 1) {
+			g_task_return_error(task, g_steal_pointer(&error));
+			return;
+		}
+		fwupd_client_set_percentage(self, 0);
+		fwupd_client_set_status(self, FWUPD_STATUS_IDLE);
+		g_info("failed to download %s: %s, trying next URI…", url, error->message);
+		g_clear_error(&error);
+	}
+	if (!g_io_stream_close(G_IO_STREAM(download->iostream), cancellable, &error)) {
+		g_task_return_error(task, g_steal_pointer(&error));
+		return;
+	}
+
+	/* verify checksum, and do not resume from corrupt data next time */
+	if (download->checksum != NULL) {
+		const gchar *checksum_actual = g_checksum_get_string(download->checksum);
+		if (g_strcmp0(helper->checksum, checksum_actual) != 0) {
+			(void)g_file_delete(file_part, NULL, NULL);
+			g_task_return_new_error(task,
+						FWUPD_ERROR,
+						FWUPD_ERROR_INVALID_FILE,
+						"checksum invalid, expected %s got %s",
+						helper->checksum,
+						checksum_actual);
+			return;
+		}
+	}
+	if (!g_file_move(file_part,
+			 helper->file,
+			 G_FILE_COPY_OVERWRITE,
+			 cancellable,
+			 NULL,
+			 NULL,
+			 &error)) {
+		g_task_return_error(task, g_steal_pointer(&error));
+		return;
+	}
+
+	/* success */
+	g_task_return_boolean(task, TRUE);
+}
+
+/* private */
+void
+fwupd_client_download_file2_async(FwupdClient *self,
+				  GPtrArray *urls,
+				  GFile *file,
+				  const gchar *checksum,
+				  FwupdClientDownloadFlags flags,
+				  GCancellable *cancellable,
+				  GAsyncReadyCallback callback,
+				  gpointer callback_data)
+{
+	g_autoptr(GTask) task = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(FwupdCurlHelper) helper = NULL;
+
+	g_return_if_fail(FWUPD_IS_CLIENT(self));
+	g_return_if_fail(urls != NULL);
+	g_return_if_fail(G_IS_FILE(file));
+	g_return_if_fail(cancellable == NULL || G_IS_CANCELLABLE(cancellable));
+
+	/* ensure networking set up */
+	task = g_task_new(self, cancellable, callback, callback_data);
+	helper = fwupd_client_curl_new(self, &error);
+	if (helper == NULL) {
+		g_task_return_error(task, g_steal_pointer(&error));
+		return;
+	}
+	helper->urls = fwupd_client_filter_locations(urls, flags, &error);
+	if (helper->urls == NULL) {
+		g_task_return_error(task, g_steal_pointer(&error));
+		return;
+	}
+	helper->file = g_object_ref(file);
+	helper->checksum = g_strdup(checksum);
+	g_task_set_task_data(task,
+			     g_steal_pointer(&helper),
+			     (GDestroyNotify)fwupd_client_curl_helper_free);
+
+	/* download data */
+	g_task_run_in_thread(task, fwupd_client_download_file_thread_cb);
+}
+
+/**
+ * fwupd_client_download_file_async:
+ * @self: a #FwupdClient
+ * @url: (not nullable): the remote URL
+ * @file: (not nullable): the destination file
+ * @checksum: (nullable): the expected checksum of the data, e.g. a SHA256 hash
+ * @flags: download flags, e.g. %FWUPD_CLIENT_DOWNLOAD_FLAG_NONE
+ * @cancellable: (nullable): optional #GCancellable
+ * @callback: (scope async) (closure callback_data): the function to run on completion
+ * @callback_data: the data to pass to @callback
+ *
+ * Downloads data from a remote server into a file without holding it all in memory.
+ * The [method@Client.set_user_agent] function should be called before this method is used.
+ *
+ * The data is written to a temporary file alongside @file, and an interrupted download is
+ * resumed from where it stopped when retrying.
+ * If @checksum is set then the data is hashed as it is received and @file is only written
+ * if the checksum matches, which also allows resuming when this method is called again.
+ *
+ * NOTE: This method is thread-safe, but progress signals will be
+ * emitted in the global default main context, if not explicitly set with
+ * [method@Client.set_main_context].
+ *
+ * Since: 2.0.19
+ **/
+void
+fwupd_client_download_file_async(FwupdClient *self,
+				 const gchar *url,
+				 GFile *file,
+				 const gchar *checksum,
+				 FwupdClientDownloadFlags flags,
+				 GCancellable *cancellable,
+				 GAsyncReadyCallback callback,
+				 gpointer callback_data)
+{
+	g_autoptr(GPtrArray) urls = g_ptr_array_new_with_free_func(g_free);
+
+	g_return_if_fail(FWUPD_IS_CLIENT(self));
+	g_return_if_fail(url != NULL);
+	g_return_if_fail(G_IS_FILE(file));
+	g_return_if_fail(cancellable == NULL || G_IS_CANCELLABLE(cancellable));
+
+	/* just proxy */
+	g_ptr_array_add(urls, g_strdup(url));
+	fwupd_client_download_file2_async(self,
+					  urls,
+					  file,
+					  checksum,
+					  flags,
+					  cancellable,
+					  callback,
+					  callback_data);
+}
+
+/**
+ * fwupd_client_download_file_finish:
+ * @self: a #FwupdClient
+ * @res: (not nullable): the asynchronous result
+ * @error: (nullable): optional return location for an error
+ *
+ * Gets the result of [method@FwupdClient.download_file_async].
+ *
+ * Returns: %TRUE if the file was written
+ *
+ * Since: 2.0.19
+ **/
+gboolean
+fwupd_client_download_file_finish(FwupdClient *self, GAsyncResult *res, GError **error)
+{
+	g_return_val_if_fail(FWUPD_IS_CLIENT(self), FALSE);
+	g_return_val_if_fail(g_task_is_valid(res, self), FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+	return g_task_propagate_boolean(G_TASK(res), error);
+}
+
 static void
 fwupd_client_upload_bytes_thread_cb(GTask *task,
 				    gpointer source_object,
@@ -7877,6 +8616,9 @@ fwupd_client_init(FwupdClient *self)
 	priv->battery_threshold = FWUPD_BATTERY_LEVEL_INVALID;
 	priv->immediate_requests =
 	    g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)g_object_unref);
+	g_mutex_init(&priv->devices_mutex);
+	priv->devices =
+	    g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)g_variant_unref);
 
 	/* we get this one for free */
 	fwupd_client_add_hint(self, "locale", g_getenv("LANG"));
@@ -7903,6 +8645,8 @@ fwupd_client_finalize(GObject *object)
 	g_free(priv->proxy_name_owner);
 	g_hash_table_unref(priv->hints);
 	g_hash_table_unref(priv->immediate_requests);
+	g_hash_table_unref(priv->devices);
+	g_mutex_clear(&priv->devices_mutex);
 	g_mutex_clear(&priv->idle_mutex);
 	if (priv->idle_id != 0)
 		g_source_remove(priv->idle_id);
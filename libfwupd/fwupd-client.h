@@ -182,6 +182,17 @@ fwupd_client_get_upgrades_finish(FwupdClient *self,
 				 GAsyncResult *res,
 				 GError **error) G_GNUC_WARN_UNUSED_RESULT G_GNUC_NON_NULL(1, 2);
 void
+fwupd_client_get_upgrades_all_async(FwupdClient *self,
+				    FwupdReleaseFlags include,
+				    FwupdReleaseFlags exclude,
+				    GCancellable *cancellable,
+				    GAsyncReadyCallback callback,
+				    gpointer callback_data) G_GNUC_NON_NULL(1);
+GHashTable *
+fwupd_client_get_upgrades_all_finish(FwupdClient *self,
+				     GAsyncResult *res,
+				     GError **error) G_GNUC_WARN_UNUSED_RESULT G_GNUC_NON_NULL(1, 2);
+void
 fwupd_client_get_details_bytes_async(FwupdClient *self,
 				     GBytes *bytes,
 				     GCancellable *cancellable,
@@ -646,6 +657,18 @@ fwupd_client_download_bytes_finish(FwupdClient *self,
 				   GAsyncResult *res,
 				   GError **error) G_GNUC_WARN_UNUSED_RESULT G_GNUC_NON_NULL(1, 2);
 void
+fwupd_client_download_file_async(FwupdClient *self,
+				 const gchar *url,
+				 GFile *file,
+				 const gchar *checksum,
+				 FwupdClientDownloadFlags flags,
+				 GCancellable *cancellable,
+				 GAsyncReadyCallback callback,
+				 gpointer callback_data) G_GNUC_NON_NULL(1, 2, 3);
+gboolean
+fwupd_client_download_file_finish(FwupdClient *self, GAsyncResult *res, GError **error)
+    G_GNUC_WARN_UNUSED_RESULT G_GNUC_NON_NULL(1, 2);
+void
 fwupd_client_download_set_retries(FwupdClient *self, guint retries) G_GNUC_NON_NULL(1);
 void
 fwupd_client_upload_bytes_async(FwupdClient *self,
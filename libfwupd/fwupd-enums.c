@@ -443,6 +443,8 @@ fwupd_plugin_flag_to_string(FwupdPluginFlags plugin_flag)
 		return "test-only";
 	if (plugin_flag == FWUPD_PLUGIN_FLAG_MUTABLE_ENUMERATION)
 		return "mutable-enumeration";
+	if (plugin_flag == FWUPD_PLUGIN_FLAG_THREAD_SAFE)
+		return "thread-safe";
 	return NULL;
 }
 
@@ -501,6 +503,8 @@ fwupd_plugin_flag_from_string(const gchar *plugin_flag)
 		return FWUPD_PLUGIN_FLAG_TEST_ONLY;
 	if (g_strcmp0(plugin_flag, "mutable-enumeration") == 0)
 		return FWUPD_PLUGIN_FLAG_MUTABLE_ENUMERATION;
+	if (g_strcmp0(plugin_flag, "thread-safe") == 0)
+		return FWUPD_PLUGIN_FLAG_THREAD_SAFE;
 	return FWUPD_PLUGIN_FLAG_UNKNOWN;
 }
 
@@ -595,6 +599,8 @@ fwupd_feature_flag_to_string(FwupdFeatureFlags feature_flag)
 		return "allow-authentication";
 	if (feature_flag == FWUPD_FEATURE_FLAG_REQUESTS_NON_GENERIC)
 		return "requests-non-generic";
+	if (feature_flag == FWUPD_FEATURE_FLAG_DEVICE_PROPERTIES_CHANGED)
+		return "device-properties-changed";
 	return NULL;
 }
 
@@ -633,6 +639,8 @@ fwupd_feature_flag_from_string(const gchar *feature_flag)
 		return FWUPD_FEATURE_FLAG_ALLOW_AUTHENTICATION;
 	if (g_strcmp0(feature_flag, "requests-non-generic") == 0)
 		return FWUPD_FEATURE_FLAG_REQUESTS_NON_GENERIC;
+	if (g_strcmp0(feature_flag, "device-properties-changed") == 0)
+		return FWUPD_FEATURE_FLAG_DEVICE_PROPERTIES_CHANGED;
 	return FWUPD_FEATURE_FLAG_UNKNOWN;
 }
 
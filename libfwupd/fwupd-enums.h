@@ -234,6 +234,15 @@ typedef enum {
 	 * Since: 1.9.8
 	 */
 	FWUPD_FEATURE_FLAG_REQUESTS_NON_GENERIC = 1 << 9, /* Since: 1.9.8 */
+	/**
+	 * FWUPD_FEATURE_FLAG_DEVICE_PROPERTIES_CHANGED:
+	 *
+	 * Can handle the `DevicePropertiesChanged` signal, which only includes the changed keys,
+	 * instead of the `DeviceChanged` signal.
+	 *
+	 * Since: 2.0.19
+	 */
+	FWUPD_FEATURE_FLAG_DEVICE_PROPERTIES_CHANGED = 1 << 10, /* Since: 2.0.19 */
 	/*< private >*/
 	FWUPD_FEATURE_FLAG_UNKNOWN = G_MAXUINT64,
 } G_GNUC_FLAG_ENUM FwupdFeatureFlags;
@@ -1081,6 +1090,15 @@ typedef enum {
 	 * Since: 2.0.12
 	 */
 	FWUPD_PLUGIN_FLAG_MUTABLE_ENUMERATION = 1ull << 19,
+	/**
+	 * FWUPD_PLUGIN_FLAG_THREAD_SAFE:
+	 *
+	 * The plugin has been audited to set up and update devices from more than one thread
+	 * at a time.
+	 *
+	 * Since: 2.0.19
+	 */
+	FWUPD_PLUGIN_FLAG_THREAD_SAFE = 1ull << 20,
 	/**
 	 * FWUPD_PLUGIN_FLAG_UNKNOWN:
 	 *
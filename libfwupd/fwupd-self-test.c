@@ -6,14 +6,17 @@
 
 #include "config.h"
 
+#include <glib/gstdio.h>
 #include <locale.h>
 #include <string.h>
 
 #include "fwupd-bios-setting.h"
+#include "fwupd-client-private.h"
 #include "fwupd-client-sync.h"
 #include "fwupd-codec.h"
 #include "fwupd-common.h"
 #include "fwupd-device-private.h"
+#include "fwupd-enums-private.h"
 #include "fwupd-enums.h"
 #include "fwupd-error.h"
 #include "fwupd-plugin.h"
@@ -106,7 +109,7 @@ fwupd_enums_func(void)
 		g_assert_cmpstr(tmp, !=, NULL);
 		g_assert_cmpint(fwupd_plugin_flag_from_string(tmp), ==, i);
 	}
-	for (guint64 i = 1; i <= FWUPD_FEATURE_FLAG_REQUESTS_NON_GENERIC; i *= 2) {
+	for (guint64 i = 1; i <= FWUPD_FEATURE_FLAG_DEVICE_PROPERTIES_CHANGED; i *= 2) {
 		const gchar *tmp = fwupd_feature_flag_to_string(i);
 		g_assert_cmpstr(tmp, !=, NULL);
 		g_assert_cmpint(fwupd_feature_flag_from_string(tmp), ==, i);
@@ -709,6 +712,441 @@ fwupd_client_api(void)
 	g_value_unset(&value_bool);
 }
 
+static void
+fwupd_client_upgrades_hash_func(void)
+{
+	GPtrArray *releases;
+	GVariantBuilder builder;
+	GVariantBuilder builder_releases;
+	g_autoptr(FwupdRelease) release1 = fwupd_release_new();
+	g_autoptr(FwupdRelease) release2 = fwupd_release_new();
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GHashTable) upgrades = NULL;
+	g_autoptr(GVariant) value = NULL;
+
+	/* one device with two upgrades, and one with none */
+	fwupd_release_set_version(release1, "1.2.4");
+	fwupd_release_set_version(release2, "1.2.5");
+	g_variant_builder_init(&builder, G_VARIANT_TYPE("a{saa{sv}}"));
+	g_variant_builder_init(&builder_releases, G_VARIANT_TYPE("aa{sv}"));
+	g_variant_builder_add_value(&builder_releases,
+				    fwupd_codec_to_variant(FWUPD_CODEC(release1),
+							   FWUPD_CODEC_FLAG_NONE));
+	g_variant_builder_add_value(&builder_releases,
+				    fwupd_codec_to_variant(FWUPD_CODEC(release2),
+							   FWUPD_CODEC_FLAG_NONE));
+	g_variant_builder_add(&builder, "{saa{sv}}", "device1", &builder_releases);
+	g_variant_builder_init(&builder_releases, G_VARIANT_TYPE("aa{sv}"));
+	g_variant_builder_add(&builder, "{saa{sv}}", "device2", &builder_releases);
+	value = g_variant_ref_sink(g_variant_new("(a{saa{sv}})", &builder));
+
+	upgrades = fwupd_client_upgrades_hash_from_variant(value, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(upgrades);
+	g_assert_cmpint(g_hash_table_size(upgrades), ==, 2);
+	releases = g_hash_table_lookup(upgrades, "device1");
+	g_assert_nonnull(releases);
+	g_assert_cmpint(releases->len, ==, 2);
+	g_assert_cmpstr(fwupd_release_get_version(g_ptr_array_index(releases, 0)), ==, "1.2.4");
+	g_assert_cmpstr(fwupd_release_get_version(g_ptr_array_index(releases, 1)), ==, "1.2.5");
+	releases = g_hash_table_lookup(upgrades, "device2");
+	g_assert_nonnull(releases);
+	g_assert_cmpint(releases->len, ==, 0);
+	g_assert_null(g_hash_table_lookup(upgrades, "device3"));
+}
+
+static void
+fwupd_client_device_cache_func(void)
+{
+	GVariantBuilder builder;
+	const gchar *invalidated[] = {FWUPD_RESULT_KEY_SUMMARY, NULL};
+	g_autoptr(FwupdClient) client = fwupd_client_new();
+	g_autoptr(FwupdDevice) dev = fwupd_device_new();
+	g_autoptr(FwupdDevice) dev_changed = NULL;
+	g_autoptr(FwupdDevice) dev_unknown = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GVariant) parameters = NULL;
+	g_autoptr(GVariant) value = NULL;
+
+	/* as sent in DeviceAdded */
+	fwupd_device_set_id(dev, "dev");
+	fwupd_device_set_name(dev, "Name");
+	fwupd_device_set_summary(dev, "Summary");
+	fwupd_device_set_version(dev, "1.2.3");
+	value = g_variant_ref_sink(fwupd_codec_to_variant(FWUPD_CODEC(dev), FWUPD_CODEC_FLAG_NONE));
+	fwupd_client_device_cache_insert(client, value);
+
+	/* one changed value and one removed value */
+	g_variant_builder_init(&builder, G_VARIANT_TYPE_VARDICT);
+	g_variant_builder_add(&builder,
+			      "{sv}",
+			      FWUPD_RESULT_KEY_VERSION,
+			      g_variant_new_string("1.2.4"));
+	parameters = g_variant_ref_sink(
+	    g_variant_new("(sa{sv}^as)", "dev", &builder, (gchar **)invalidated));
+	dev_changed = fwupd_client_device_cache_update(client, parameters, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(dev_changed);
+	g_assert_cmpstr(fwupd_device_get_id(dev_changed), ==, "dev");
+	g_assert_cmpstr(fwupd_device_get_name(dev_changed), ==, "Name");
+	g_assert_cmpstr(fwupd_device_get_version(dev_changed), ==, "1.2.4");
+	g_assert_null(fwupd_device_get_summary(dev_changed));
+
+	/* without a previous state only the changes are known */
+	g_clear_pointer(&parameters, g_variant_unref);
+	g_variant_builder_init(&builder, G_VARIANT_TYPE_VARDICT);
+	g_variant_builder_add(&builder,
+			      "{sv}",
+			      FWUPD_RESULT_KEY_VERSION,
+			      g_variant_new_string("2.0.0"));
+	parameters = g_variant_ref_sink(
+	    g_variant_new("(sa{sv}^as)", "other", &builder, (gchar **)invalidated));
+	dev_unknown = fwupd_client_device_cache_update(client, parameters, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(dev_unknown);
+	g_assert_cmpstr(fwupd_device_get_id(dev_unknown), ==, "other");
+	g_assert_cmpstr(fwupd_device_get_version(dev_unknown), ==, "2.0.0");
+	g_assert_null(fwupd_device_get_name(dev_unknown));
+}
+
+typedef struct {
+	GSocket *socket;
+	guint16 port;
+	GBytes *blob;
+	guint requests;
+	gboolean drop_first;	 /* only send half of the body on the first connection */
+	gint ignore_range;	 /* (atomic): reply with everything even when asked for a range */
+	goffset offsets[4];	 /* the range start asked for by each connection */
+} FwupdClientDownloadServer;
+
+/* a stand-in HTTP server that implements just enough of range requests */
+static gpointer
+fwupd_client_download_server_thread_cb(gpointer user_data)
+{
+	FwupdClientDownloadServer *server = (FwupdClientDownloadServer *)user_data;
+	gsize blobsz = g_bytes_get_size(server->blob);
+	const guint8 *blobbuf = g_bytes_get_data(server->blob, NULL);
+
+	for (guint i = 0; i < server->requests; i++) {
+		const gchar *range;
+		gchar buf[4096] = {'\0'};
+		gsize bufsz = 0;
+		gsize offset = 0;
+		gsize length;
+		g_autofree gchar *hdr = NULL;
+		g_autoptr(GError) error = NULL;
+		g_autoptr(GSocket) socket = NULL;
+		g_autoptr(GSocketConnection) conn = NULL;
+		GInputStream *istream;
+		GOutputStream *ostream;
+
+		socket = g_socket_accept(server->socket, NULL, &error);
+		g_assert_no_error(error);
+		g_assert_nonnull(socket);
+		conn = g_socket_connection_factory_create_connection(socket);
+		istream = g_io_stream_get_input_stream(G_IO_STREAM(conn));
+		ostream = g_io_stream_get_output_stream(G_IO_STREAM(conn));
+
+		/* read the request headers */
+		while (g_strstr_len(buf, bufsz, "\r\n\r\n") == NULL) {
+			gssize rc = g_input_stream_read(istream,
+							buf + bufsz,
+							sizeof(buf) - bufsz - 1,
+							NULL,
+							&error);
+			g_assert_no_error(error);
+			g_assert_cmpint(rc, >, 0);
+			bufsz += rc;
+		}
+		range = g_strstr_len(buf, bufsz, "Range: bytes=");
+		if (range != NULL)
+			offset = g_ascii_strtoull(range + 13, NULL, 10);
+		if (i < G_N_ELEMENTS(server->offsets))
+			server->offsets[i] = offset;
+		if (g_atomic_int_get(&server->ignore_range))
+			offset = 0;
+		if (offset >= blobsz) {
+			hdr = g_strdup_printf("HTTP/1.1 416 Range Not Satisfiable\r\n"
+					      "Content-Length: 0\r\n"
+					      "Content-Range: bytes */%u\r\n"
+					      "Connection: close\r\n\r\n",
+					      (guint)blobsz);
+			offset = blobsz;
+		} else if (offset > 0) {
+			hdr = g_strdup_printf("HTTP/1.1 206 Partial Content\r\n"
+					      "Content-Length: %u\r\n"
+					      "Content-Range: bytes %u-%u/%u\r\n"
+					      "Connection: close\r\n\r\n",
+					      (guint)(blobsz - offset),
+					      (guint)offset,
+					      (guint)blobsz - 1,
+					      (guint)blobsz);
+		} else {
+			hdr = g_strdup_printf("HTTP/1.1 200 OK\r\n"
+					      "Content-Length: %u\r\n"
+					      "Connection: close\r\n\r\n",
+					      (guint)blobsz);
+		}
+		(void)g_output_stream_write_all(ostream, hdr, strlen(hdr), NULL, NULL, &error);
+		g_assert_no_error(error);
+
+		/* optionally only send half of the data the first time */
+		length = server->drop_first && i == 0 ? (blobsz - offset) / 2 : blobsz - offset;
+		(void)g_output_stream_write_all(ostream,
+						blobbuf + offset,
+						length,
+						NULL,
+						NULL,
+						&error);
+		g_assert_no_error(error);
+		(void)g_io_stream_close(G_IO_STREAM(conn), NULL, NULL);
+	}
+	return NULL;
+}
+
+/* listen on an ephemeral loopback port, returning the data that will be served */
+static GByteArray *
+fwupd_client_download_server_start(FwupdClientDownloadServer *server)
+{
+	gboolean ret;
+	GByteArray *payload = g_byte_array_new();
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GInetAddress) inet_address = NULL;
+	g_autoptr(GSocketAddress) address = NULL;
+	g_autoptr(GSocketAddress) address_local = NULL;
+
+	for (guint i = 0; i < 0x40000; i++) {
+		guint8 tmp = i % 251;
+		g_byte_array_append(payload, &tmp, sizeof(tmp));
+	}
+	server->blob = g_bytes_new(payload->data, payload->len);
+	server->socket = g_socket_new(G_SOCKET_FAMILY_IPV4,
+				      G_SOCKET_TYPE_STREAM,
+				      G_SOCKET_PROTOCOL_TCP,
+				      &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(server->socket);
+	inet_address = g_inet_address_new_loopback(G_SOCKET_FAMILY_IPV4);
+	address = g_inet_socket_address_new(inet_address, 0);
+	ret = g_socket_bind(server->socket, address, TRUE, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	ret = g_socket_listen(server->socket, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	address_local = g_socket_get_local_address(server->socket, &error);
+	g_assert_no_error(error);
+	server->port = g_inet_socket_address_get_port(G_INET_SOCKET_ADDRESS(address_local));
+	return payload;
+}
+
+typedef struct {
+	GMainLoop *loop;
+	GError *error;
+} FwupdClientDownloadHelper;
+
+static void
+fwupd_client_download_file_cb(GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	FwupdClientDownloadHelper *helper = (FwupdClientDownloadHelper *)user_data;
+	(void)fwupd_client_download_file_finish(FWUPD_CLIENT(source), res, &helper->error);
+	g_main_loop_quit(helper->loop);
+}
+
+static void
+fwupd_client_download_resume_func(void)
+{
+	gboolean ret;
+	gsize bufsz = 0;
+	FwupdClientDownloadServer server = {.requests = 3, .drop_first = TRUE};
+	FwupdClientDownloadHelper helper = {NULL};
+	g_autofree gchar *buf = NULL;
+	g_autofree gchar *checksum = NULL;
+	g_autofree gchar *checksum_bad = NULL;
+	g_autofree gchar *fn = NULL;
+	g_autofree gchar *fn_part = NULL;
+	g_autofree gchar *tmpdir = NULL;
+	g_autofree gchar *url = NULL;
+	g_autoptr(FwupdClient) client = fwupd_client_new();
+	g_autoptr(GByteArray) payload = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GFile) file = NULL;
+	g_autoptr(GThread) thread = NULL;
+
+	payload = fwupd_client_download_server_start(&server);
+	url = g_strdup_printf("http://127.0.0.1:%u/firmware.cab", server.port);
+	thread = g_thread_new("self-test-http", fwupd_client_download_server_thread_cb, &server);
+
+	tmpdir = g_dir_make_tmp("fwupd-self-test-XXXXXX", &error);
+	g_assert_no_error(error);
+	fn = g_build_filename(tmpdir, "firmware.cab", NULL);
+	fn_part = g_build_filename(tmpdir, "firmware.cab.part", NULL);
+	file = g_file_new_for_path(fn);
+
+	/* the first connection is dropped, and the retry resumes from the partial file */
+	helper.loop = g_main_loop_new(NULL, FALSE);
+	(void)g_setenv("FWUPD_IGNORE_NETWORK_REACHABLE", "1", TRUE);
+	fwupd_client_set_user_agent_for_package(client, "fwupd", "2.0.0");
+	fwupd_client_download_set_retries(client, 1);
+	checksum = g_compute_checksum_for_bytes(G_CHECKSUM_SHA256, server.blob);
+	fwupd_client_download_file_async(client,
+					 url,
+					 file,
+					 checksum,
+					 FWUPD_CLIENT_DOWNLOAD_FLAG_NONE,
+					 NULL,
+					 fwupd_client_download_file_cb,
+					 &helper);
+	g_main_loop_run(helper.loop);
+	g_assert_no_error(helper.error);
+	ret = g_file_get_contents(fn, &buf, &bufsz, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	g_assert_cmpint(bufsz, ==, payload->len);
+	g_assert_cmpint(memcmp(buf, payload->data, bufsz), ==, 0);
+	g_assert_false(g_file_test(fn_part, G_FILE_TEST_EXISTS));
+	g_assert_cmpint(server.offsets[0], ==, 0);
+	g_assert_cmpint(server.offsets[1], ==, payload->len / 2);
+
+	/* the checksum does not match, so the partial data is not kept */
+	checksum_bad = g_compute_checksum_for_string(G_CHECKSUM_SHA256, "hello", -1);
+	fwupd_client_download_file_async(client,
+					 url,
+					 file,
+					 checksum_bad,
+					 FWUPD_CLIENT_DOWNLOAD_FLAG_NONE,
+					 NULL,
+					 fwupd_client_download_file_cb,
+					 &helper);
+	g_main_loop_run(helper.loop);
+	g_assert_error(helper.error, FWUPD_ERROR, FWUPD_ERROR_INVALID_FILE);
+	g_assert_false(g_file_test(fn_part, G_FILE_TEST_EXISTS));
+
+	(void)g_thread_join(g_steal_pointer(&thread));
+	(void)g_unlink(fn);
+	(void)g_rmdir(tmpdir);
+	g_clear_error(&helper.error);
+	g_main_loop_unref(helper.loop);
+	g_object_unref(server.socket);
+	g_bytes_unref(server.blob);
+}
+
+static void
+fwupd_client_download_restart_func(void)
+{
+	gboolean ret;
+	gsize bufsz = 0;
+	FwupdClientDownloadServer server = {.requests = 4};
+	FwupdClientDownloadHelper helper = {NULL};
+	g_autofree gchar *buf = NULL;
+	g_autofree gchar *checksum = NULL;
+	g_autofree gchar *fn = NULL;
+	g_autofree gchar *fn_part = NULL;
+	g_autofree gchar *tmpdir = NULL;
+	g_autofree gchar *url = NULL;
+	g_autoptr(FwupdClient) client = fwupd_client_new();
+	g_autoptr(GByteArray) payload = NULL;
+	g_autoptr(GByteArray) payload_long = g_byte_array_new();
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GFile) file = NULL;
+	g_autoptr(GThread) thread = NULL;
+
+	payload = fwupd_client_download_server_start(&server);
+	url = g_strdup_printf("http://127.0.0.1:%u/firmware.cab", server.port);
+	thread = g_thread_new("self-test-http", fwupd_client_download_server_thread_cb, &server);
+
+	tmpdir = g_dir_make_tmp("fwupd-self-test-XXXXXX", &error);
+	g_assert_no_error(error);
+	fn = g_build_filename(tmpdir, "firmware.cab", NULL);
+	fn_part = g_build_filename(tmpdir, "firmware.cab.part", NULL);
+	file = g_file_new_for_path(fn);
+	helper.loop = g_main_loop_new(NULL, FALSE);
+	(void)g_setenv("FWUPD_IGNORE_NETWORK_REACHABLE", "1", TRUE);
+	fwupd_client_set_user_agent_for_package(client, "fwupd", "2.0.0");
+	checksum = g_compute_checksum_for_bytes(G_CHECKSUM_SHA256, server.blob);
+
+	/* stale data from some other file cannot be verified without a checksum */
+	ret = g_file_set_contents(fn_part, "hello world", -1, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	ret = fwupd_client_download_file(client,
+					 url,
+					 file,
+					 FWUPD_CLIENT_DOWNLOAD_FLAG_NONE,
+					 NULL,
+					 &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	ret = g_file_get_contents(fn, &buf, &bufsz, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	g_assert_cmpint(bufsz, ==, payload->len);
+	g_assert_cmpint(memcmp(buf, payload->data, bufsz), ==, 0);
+	g_assert_false(g_file_test(fn_part, G_FILE_TEST_EXISTS));
+	g_assert_cmpint(server.offsets[0], ==, 0);
+	g_clear_pointer(&buf, g_free);
+
+	/* the server ignores the range request and sends everything again */
+	g_atomic_int_set(&server.ignore_range, TRUE);
+	ret = g_file_set_contents(fn_part, (const gchar *)payload->data, payload->len / 2, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	fwupd_client_download_file_async(client,
+					 url,
+					 file,
+					 checksum,
+					 FWUPD_CLIENT_DOWNLOAD_FLAG_NONE,
+					 NULL,
+					 fwupd_client_download_file_cb,
+					 &helper);
+	g_main_loop_run(helper.loop);
+	g_assert_no_error(helper.error);
+	ret = g_file_get_contents(fn, &buf, &bufsz, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	g_assert_cmpint(bufsz, ==, payload->len);
+	g_assert_cmpint(memcmp(buf, payload->data, bufsz), ==, 0);
+	g_assert_false(g_file_test(fn_part, G_FILE_TEST_EXISTS));
+	g_assert_cmpint(server.offsets[1], ==, payload->len / 2);
+	g_atomic_int_set(&server.ignore_range, FALSE);
+	g_clear_pointer(&buf, g_free);
+
+	/* the partial file is longer than the data, so the server refuses the range */
+	g_byte_array_append(payload_long, payload->data, payload->len);
+	g_byte_array_append(payload_long, (const guint8 *)"junk", 4);
+	ret = g_file_set_contents(fn_part,
+				  (const gchar *)payload_long->data,
+				  payload_long->len,
+				  &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	fwupd_client_download_file_async(client,
+					 url,
+					 file,
+					 checksum,
+					 FWUPD_CLIENT_DOWNLOAD_FLAG_NONE,
+					 NULL,
+					 fwupd_client_download_file_cb,
+					 &helper);
+	g_main_loop_run(helper.loop);
+	g_assert_no_error(helper.error);
+	ret = g_file_get_contents(fn, &buf, &bufsz, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	g_assert_cmpint(bufsz, ==, payload->len);
+	g_assert_cmpint(memcmp(buf, payload->data, bufsz), ==, 0);
+	g_assert_false(g_file_test(fn_part, G_FILE_TEST_EXISTS));
+	g_assert_cmpint(server.offsets[2], ==, payload_long->len);
+	g_assert_cmpint(server.offsets[3], ==, 0);
+
+	(void)g_thread_join(g_steal_pointer(&thread));
+	(void)g_unlink(fn);
+	(void)g_rmdir(tmpdir);
+	g_main_loop_unref(helper.loop);
+	g_object_unref(server.socket);
+	g_bytes_unref(server.blob);
+}
+
 static void
 fwupd_common_history_report_func(void)
 {
@@ -1485,6 +1923,10 @@ main(int argc, char **argv)
 	g_test_add_func("/fwupd/security-attr", fwupd_security_attr_func);
 	g_test_add_func("/fwupd/bios-attrs", fwupd_bios_settings_func);
 	g_test_add_func("/fwupd/client_api", fwupd_client_api);
+	g_test_add_func("/fwupd/client{upgrades-hash}", fwupd_client_upgrades_hash_func);
+	g_test_add_func("/fwupd/client{device-cache}", fwupd_client_device_cache_func);
+	g_test_add_func("/fwupd/client{download-resume}", fwupd_client_download_resume_func);
+	g_test_add_func("/fwupd/client{download-restart}", fwupd_client_download_restart_func);
 	if (g_test_undefined()) {
 		g_test_add_func("/fwupd/client_api{undefined_setter}",
 				fwupd_client_api_undefined_setter);
@@ -13,12 +13,13 @@
 #include "fu-byte-array.h"
 #include "fu-cab-firmware-private.h"
 #include "fu-cab-image.h"
+#include "fu-cab-inflate-input-stream.h"
 #include "fu-cab-struct.h"
 #include "fu-chunk-array.h"
 #include "fu-common.h"
 #include "fu-composite-input-stream.h"
 #include "fu-input-stream.h"
-#include "fu-mem-private.h"
+#include "fu-mem.h"
 #include "fu-partial-input-stream.h"
 #include "fu-string.h"
 
@@ -32,8 +33,11 @@ G_DEFINE_TYPE_WITH_PRIVATE(FuCabFirmware, fu_cab_firmware, FU_TYPE_FIRMWARE)
 
 #define FU_CAB_FIRMWARE_MAX_FILES   1024
 #define FU_CAB_FIRMWARE_MAX_FOLDERS 64
+#define FU_CAB_FIRMWARE_MAX_FILENAME 255
 
-#define FU_CAB_FIRMWARE_DECOMPRESS_BUFSZ 0x4000 /* bytes */
+/* MSZIP blocks are at most 32k uncompressed, and cannot grow by more than 6k */
+#define FU_CAB_FIRMWARE_MSZIP_MAX_UNCOMP 0x8000
+#define FU_CAB_FIRMWARE_MSZIP_MAX_COMP	 (FU_CAB_FIRMWARE_MSZIP_MAX_UNCOMP + 6144)
 
 /**
  * fu_cab_firmware_get_compressed:
@@ -112,22 +116,20 @@ typedef struct {
 	gsize rsvd_block;
 	gsize size_total;
 	FuCabCompression compression;
-	GPtrArray *folder_data; /* of FuCompositeInputStream */
-	z_stream zstrm;
-	guint8 *decompress_buf;
-	gsize decompress_bufsz;
+	GPtrArray *folder_data; /* of FuCompositeInputStream or FuCabInflateInputStream */
+	GByteArray *cffile_buf;
 	gsize ndatabsz;
 } FuCabFirmwareParseHelper;
 
 static void
 fu_cab_firmware_parse_helper_free(FuCabFirmwareParseHelper *helper)
 {
-	inflateEnd(&helper->zstrm);
 	if (helper->stream != NULL)
 		g_object_unref(helper->stream);
 	if (helper->folder_data != NULL)
 		g_ptr_array_unref(helper->folder_data);
-	g_free(helper->decompress_buf);
+	if (helper->cffile_buf != NULL)
+		g_byte_array_unref(helper->cffile_buf);
 	g_free(helper);
 }
 
@@ -221,6 +223,18 @@ fu_cab_firmware_parse_data(FuCabFirmware *self,
 				    "mismatched compressed data");
 		return FALSE;
 	}
+	if (helper->compression == FU_CAB_COMPRESSION_MSZIP &&
+	    (blob_uncomp == 0 || blob_uncomp > FU_CAB_FIRMWARE_MSZIP_MAX_UNCOMP ||
+	     blob_comp > FU_CAB_FIRMWARE_MSZIP_MAX_COMP)) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_NOT_SUPPORTED,
+			    "invalid MSZIP block size at 0x%x, compressed 0x%x, uncompressed 0x%x",
+			    (guint)*offset,
+			    (guint)blob_comp,
+			    (guint)blob_uncomp);
+		return FALSE;
+	}
 	helper->size_total += blob_uncomp;
 	if (size_max > 0 && helper->size_total > size_max) {
 		g_autofree gchar *sz_val = g_format_size(helper->size_total);
@@ -274,82 +288,39 @@ fu_cab_firmware_parse_data(FuCabFirmware *self,
 		}
 	}
 
-	/* decompress Zlib data after removing *another *header... */
+	/* decompressed lazily when read, after removing *another *header... */
 	if (helper->compression == FU_CAB_COMPRESSION_MSZIP) {
-		int zret;
-		g_autofree gchar *kind = NULL;
-		g_autoptr(GByteArray) buf = g_byte_array_new();
-		g_autoptr(GBytes) bytes_comp = NULL;
-		g_autoptr(GBytes) bytes_uncomp = NULL;
-
-		/* check compressed header */
-		bytes_comp = fu_input_stream_read_bytes(helper->stream,
-							*offset + hdr_sz,
-							blob_comp,
-							NULL,
-							error);
-		if (bytes_comp == NULL)
-			return FALSE;
-		kind = fu_memstrsafe(g_bytes_get_data(bytes_comp, NULL),
-				     g_bytes_get_size(bytes_comp),
-				     0x0,
-				     2,
-				     error);
-		if (kind == NULL)
-			return FALSE;
-		if (g_strcmp0(kind, "CK") != 0) {
-			g_set_error(error,
-				    FWUPD_ERROR,
-				    FWUPD_ERROR_NOT_SUPPORTED,
-				    "compressed header invalid: %s",
-				    kind);
-			return FALSE;
-		}
-		if (helper->decompress_buf == NULL)
-			helper->decompress_buf = g_malloc0(helper->decompress_bufsz);
-		helper->zstrm.avail_in = g_bytes_get_size(bytes_comp) - 2;
-		helper->zstrm.next_in = (z_const Bytef *)g_bytes_get_data(bytes_comp, NULL) + 2;
-		while (1) {
-			helper->zstrm.avail_out = helper->decompress_bufsz;
-			helper->zstrm.next_out = helper->decompress_buf;
-			zret = inflate(&helper->zstrm, Z_BLOCK);
-			if (zret == Z_STREAM_END)
-				break;
-			g_byte_array_append(buf,
-					    helper->decompress_buf,
-					    helper->decompress_bufsz - helper->zstrm.avail_out);
-			if (zret != Z_OK) {
-				g_set_error(error,
+		guint8 kind[2] = {0x0};
+		if (blob_comp < sizeof(kind)) {
+			g_set_error_literal(error,
 					    FWUPD_ERROR,
 					    FWUPD_ERROR_NOT_SUPPORTED,
-					    "inflate error @0x%x: %s",
-					    (guint)*offset,
-					    zError(zret));
-				return FALSE;
-			}
+					    "compressed data too small");
+			return FALSE;
 		}
-		zret = inflateReset(&helper->zstrm);
-		if (zret != Z_OK) {
-			g_set_error(error,
-				    FWUPD_ERROR,
-				    FWUPD_ERROR_NOT_SUPPORTED,
-				    "failed to reset inflate: %s",
-				    zError(zret));
+		if (!fu_input_stream_read_safe(helper->stream,
+					       kind,
+					       sizeof(kind),
+					       0x0,
+					       *offset + hdr_sz,
+					       sizeof(kind),
+					       error)) {
+			g_prefix_error_literal(error, "failed to read compressed header: ");
 			return FALSE;
 		}
-		zret = inflateSetDictionary(&helper->zstrm, buf->data, buf->len);
-		if (zret != Z_OK) {
+		if (kind[0] != 'C' || kind[1] != 'K') {
 			g_set_error(error,
 				    FWUPD_ERROR,
 				    FWUPD_ERROR_NOT_SUPPORTED,
-				    "failed to set inflate dictionary: %s",
-				    zError(zret));
+				    "compressed header invalid: 0x%02x%02x",
+				    kind[0],
+				    kind[1]);
 			return FALSE;
 		}
-		bytes_uncomp =
-		    g_byte_array_free_to_bytes(g_steal_pointer(&buf)); /* nocheck:blocked */
-		fu_composite_input_stream_add_bytes(FU_COMPOSITE_INPUT_STREAM(folder_data),
-						    bytes_uncomp);
+		fu_cab_inflate_input_stream_add_block(FU_CAB_INFLATE_INPUT_STREAM(folder_data),
+						      *offset + hdr_sz + sizeof(kind),
+						      blob_comp - sizeof(kind),
+						      blob_uncomp);
 	} else {
 		fu_composite_input_stream_add_partial_stream(
 		    FU_COMPOSITE_INPUT_STREAM(folder_data),
@@ -361,21 +332,21 @@ fu_cab_firmware_parse_data(FuCabFirmware *self,
 	return TRUE;
 }
 
-static gboolean
+static GInputStream *
 fu_cab_firmware_parse_folder(FuCabFirmware *self,
 			     FuCabFirmwareParseHelper *helper,
 			     guint idx,
 			     gsize offset,
-			     GInputStream *folder_data,
 			     GError **error)
 {
 	FuCabFirmwarePrivate *priv = GET_PRIVATE(self);
 	g_autoptr(FuStructCabFolder) st = NULL;
+	g_autoptr(GInputStream) folder_data = NULL;
 
 	/* parse header */
 	st = fu_struct_cab_folder_parse_stream(helper->stream, offset, error);
 	if (st == NULL)
-		return FALSE;
+		return NULL;
 
 	/* sanity check */
 	if (fu_struct_cab_folder_get_ndatab(st) == 0) {
@@ -383,7 +354,7 @@ fu_cab_firmware_parse_folder(FuCabFirmware *self,
 				    FWUPD_ERROR,
 				    FWUPD_ERROR_NOT_SUPPORTED,
 				    "no CFDATA blocks");
-		return FALSE;
+		return NULL;
 	}
 	helper->compression = fu_struct_cab_folder_get_compression(st);
 	if (helper->compression != FU_CAB_COMPRESSION_NONE)
@@ -395,25 +366,43 @@ fu_cab_firmware_parse_folder(FuCabFirmware *self,
 			    FWUPD_ERROR_NOT_SUPPORTED,
 			    "compression %s not supported",
 			    fu_cab_compression_to_string(helper->compression));
-		return FALSE;
+		return NULL;
+	}
+
+	/* uncompressed data is used in-place, compressed data is inflated only when read */
+	if (helper->compression == FU_CAB_COMPRESSION_MSZIP) {
+		folder_data = fu_cab_inflate_input_stream_new(helper->stream, error);
+		if (folder_data == NULL)
+			return NULL;
+	} else {
+		folder_data = fu_composite_input_stream_new();
 	}
 
 	/* parse CDATA, either using the stream offset or the per-spec FuStructCabFolder.ndatab */
 	if (helper->ndatabsz > 0) {
 		for (gsize off = fu_struct_cab_folder_get_offset(st); off < helper->ndatabsz;) {
 			if (!fu_cab_firmware_parse_data(self, helper, &off, folder_data, error))
-				return FALSE;
+				return NULL;
 		}
 	} else {
 		gsize off = fu_struct_cab_folder_get_offset(st);
 		for (guint16 i = 0; i < fu_struct_cab_folder_get_ndatab(st); i++) {
 			if (!fu_cab_firmware_parse_data(self, helper, &off, folder_data, error))
-				return FALSE;
+				return NULL;
+		}
+	}
+
+	/* a corrupt folder has to fail here, not when an image is eventually read */
+	if (helper->compression == FU_CAB_COMPRESSION_MSZIP) {
+		if (!fu_cab_inflate_input_stream_check(FU_CAB_INFLATE_INPUT_STREAM(folder_data),
+						       error)) {
+			g_prefix_error(error, "failed to decompress folder %u: ", idx);
+			return NULL;
 		}
 	}
 
 	/* success */
-	return TRUE;
+	return g_steal_pointer(&folder_data);
 }
 
 static gboolean
@@ -435,7 +424,10 @@ fu_cab_firmware_parse_file(FuCabFirmware *self,
 	g_autoptr(GTimeZone) tz_utc = g_time_zone_new_utc();
 
 	/* parse header */
-	st = fu_struct_cab_file_parse_stream(helper->stream, *offset, error);
+	st = fu_struct_cab_file_parse(helper->cffile_buf->data,
+				      helper->cffile_buf->len,
+				      *offset,
+				      error);
 	if (st == NULL)
 		return FALSE;
 	fu_firmware_set_offset(FU_FIRMWARE(img), fu_struct_cab_file_get_uoffset(st));
@@ -455,9 +447,13 @@ fu_cab_firmware_parse_file(FuCabFirmware *self,
 
 	/* parse filename */
 	*offset += FU_STRUCT_CAB_FILE_SIZE;
-	for (guint i = 0; i < 255; i++) {
+	for (guint i = 0; i < FU_CAB_FIRMWARE_MAX_FILENAME; i++) {
 		guint8 value = 0;
-		if (!fu_input_stream_read_u8(helper->stream, *offset + i, &value, error))
+		if (!fu_memread_uint8_safe(helper->cffile_buf->data,
+					   helper->cffile_buf->len,
+					   *offset + i,
+					   &value,
+					   error))
 			return FALSE;
 		if (value == 0)
 			break;
@@ -519,29 +515,13 @@ fu_cab_firmware_validate(FuFirmware *firmware, GInputStream *stream, gsize offse
 }
 
 static FuCabFirmwareParseHelper *
-fu_cab_firmware_parse_helper_new(GInputStream *stream, FuFirmwareParseFlags flags, GError **error)
+fu_cab_firmware_parse_helper_new(GInputStream *stream, FuFirmwareParseFlags flags)
 {
-	int zret;
-	g_autoptr(FuCabFirmwareParseHelper) helper = g_new0(FuCabFirmwareParseHelper, 1);
-
-	/* zlib */
-	helper->zstrm.zalloc = fu_cab_firmware_zalloc;
-	helper->zstrm.zfree = fu_cab_firmware_zfree;
-	zret = inflateInit2(&helper->zstrm, -MAX_WBITS);
-	if (zret != Z_OK) {
-		g_set_error(error,
-			    FWUPD_ERROR,
-			    FWUPD_ERROR_NOT_SUPPORTED,
-			    "failed to initialize inflate: %s",
-			    zError(zret));
-		return NULL;
-	}
-
+	FuCabFirmwareParseHelper *helper = g_new0(FuCabFirmwareParseHelper, 1);
 	helper->stream = g_object_ref(stream);
 	helper->parse_flags = flags;
 	helper->folder_data = g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
-	helper->decompress_bufsz = FU_CAB_FIRMWARE_DECOMPRESS_BUFSZ;
-	return g_steal_pointer(&helper);
+	return helper;
 }
 
 static gboolean
@@ -619,8 +599,18 @@ fu_cab_firmware_parse(FuFirmware *firmware,
 	}
 
 	/* create helper */
-	helper = fu_cab_firmware_parse_helper_new(stream, flags, error);
-	if (helper == NULL)
+	helper = fu_cab_firmware_parse_helper_new(stream, flags);
+
+	/* read all the CFFILE headers and filenames in one go */
+	helper->cffile_buf = fu_input_stream_read_byte_array(
+	    stream,
+	    off_cffile,
+	    MIN(streamsz - off_cffile,
+		(gsize)fu_struct_cab_header_get_nr_files(st) *
+		    (FU_STRUCT_CAB_FILE_SIZE + FU_CAB_FIRMWARE_MAX_FILENAME + 1)),
+	    NULL,
+	    error);
+	if (helper->cffile_buf == NULL)
 		return FALSE;
 
 	/* if the only folder is >= 2GB then FuStructCabFolder.ndatab will overflow */
@@ -642,8 +632,9 @@ fu_cab_firmware_parse(FuFirmware *firmware,
 
 	/* parse CFFOLDER */
 	for (guint i = 0; i < fu_struct_cab_header_get_nr_folders(st); i++) {
-		g_autoptr(GInputStream) folder_data = fu_composite_input_stream_new();
-		if (!fu_cab_firmware_parse_folder(self, helper, i, offset, folder_data, error))
+		g_autoptr(GInputStream) folder_data = NULL;
+		folder_data = fu_cab_firmware_parse_folder(self, helper, i, offset, error);
+		if (folder_data == NULL)
 			return FALSE;
 		if (!fu_input_stream_size(folder_data, &streamsz, error))
 			return FALSE;
@@ -659,8 +650,9 @@ fu_cab_firmware_parse(FuFirmware *firmware,
 	}
 
 	/* parse CFFILEs */
+	offset = 0;
 	for (guint i = 0; i < fu_struct_cab_header_get_nr_files(st); i++) {
-		if (!fu_cab_firmware_parse_file(self, helper, &off_cffile, error))
+		if (!fu_cab_firmware_parse_file(self, helper, &offset, error))
 			return FALSE;
 	}
 
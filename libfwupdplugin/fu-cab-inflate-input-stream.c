@@ -0,0 +1,441 @@
+/*
+ * Copyright 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#define G_LOG_DOMAIN "FuCabFirmware"
+
+#include "config.h"
+
+#include <zlib.h>
+
+#include "fwupd-codec.h"
+#include "fwupd-error.h"
+
+#include "fu-cab-inflate-input-stream.h"
+#include "fu-input-stream.h"
+#include "fu-mem.h"
+
+/**
+ * FuCabInflateInputStream:
+ *
+ * A input stream of the uncompressed contents of a MSZIP cabinet folder, e.g.
+ *
+ *     [CK|zzzz] [CK|zzzzzz] [CK|zzz]
+ *         |          |          |
+ *      inflate    inflate    inflate
+ *         |          |          |
+ *     [xxxxxxxx][xxxxxxxxxx][xxxxxx]
+ *
+ * Each CFDATA block is only decompressed when a read touches it, and only the most recently
+ * decompressed block is kept in memory. As each block uses the previous uncompressed block as
+ * the inflate dictionary, seeking backwards restarts decompression from the first block.
+ */
+
+typedef struct {
+	gsize offset; /* of the deflate data in the base stream, after the CK signature */
+	gsize size;
+	gsize uoffset; /* in the folder */
+	gsize usize;
+} FuCabInflateInputStreamBlock;
+
+struct _FuCabInflateInputStream {
+	GInputStream parent_instance;
+	GInputStream *base_stream;
+	GArray *blocks; /* of FuCabInflateInputStreamBlock */
+	z_stream zstrm;
+	GByteArray *buf_comp;
+	GByteArray *buf_uncomp;
+	guint buf_uncomp_idx; /* into blocks, or G_MAXUINT */
+	goffset pos;
+	gsize total_size;
+};
+
+static void
+fu_cab_inflate_input_stream_seekable_iface_init(GSeekableIface *iface);
+static void
+fu_cab_inflate_input_stream_codec_iface_init(FwupdCodecInterface *iface);
+
+G_DEFINE_TYPE_WITH_CODE(FuCabInflateInputStream,
+			fu_cab_inflate_input_stream,
+			G_TYPE_INPUT_STREAM,
+			G_IMPLEMENT_INTERFACE(G_TYPE_SEEKABLE,
+					      fu_cab_inflate_input_stream_seekable_iface_init)
+			    G_IMPLEMENT_INTERFACE(FWUPD_TYPE_CODEC,
+						  fu_cab_inflate_input_stream_codec_iface_init))
+
+static void
+fu_cab_inflate_input_stream_add_string(FwupdCodec *codec, guint idt, GString *str)
+{
+	FuCabInflateInputStream *self = FU_CAB_INFLATE_INPUT_STREAM(codec);
+	fwupd_codec_string_append_hex(str, idt, "Pos", self->pos);
+	fwupd_codec_string_append_hex(str, idt, "TotalSize", self->total_size);
+	fwupd_codec_string_append_int(str, idt, "Blocks", self->blocks->len);
+}
+
+static void
+fu_cab_inflate_input_stream_codec_iface_init(FwupdCodecInterface *iface)
+{
+	iface->add_string = fu_cab_inflate_input_stream_add_string;
+}
+
+/**
+ * fu_cab_inflate_input_stream_add_block:
+ * @self: a #FuCabInflateInputStream
+ * @offset: offset of the deflate data in the base stream, in bytes
+ * @size: size of the deflate data, in bytes
+ * @usize: uncompressed size of the block, in bytes
+ *
+ * Adds a MSZIP CFDATA block to the end of the folder.
+ *
+ * Since: 2.0.19
+ **/
+void
+fu_cab_inflate_input_stream_add_block(FuCabInflateInputStream *self,
+				      gsize offset,
+				      gsize size,
+				      gsize usize)
+{
+	FuCabInflateInputStreamBlock block = {
+	    .offset = offset,
+	    .size = size,
+	    .uoffset = self->total_size,
+	    .usize = usize,
+	};
+	g_return_if_fail(FU_IS_CAB_INFLATE_INPUT_STREAM(self));
+	g_array_append_val(self->blocks, block);
+	self->total_size += usize;
+}
+
+static gboolean
+fu_cab_inflate_input_stream_inflate_block(FuCabInflateInputStream *self,
+					  guint idx,
+					  GError **error)
+{
+	FuCabInflateInputStreamBlock *block =
+	    &g_array_index(self->blocks, FuCabInflateInputStreamBlock, idx);
+	int zret;
+
+	/* the previous uncompressed block is the dictionary for this one */
+	zret = inflateReset(&self->zstrm);
+	if (zret != Z_OK) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_NOT_SUPPORTED,
+			    "failed to reset inflate: %s",
+			    zError(zret));
+		return FALSE;
+	}
+	if (idx > 0) {
+		zret = inflateSetDictionary(&self->zstrm,
+					    self->buf_uncomp->data,
+					    self->buf_uncomp->len);
+		if (zret != Z_OK) {
+			g_set_error(error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_NOT_SUPPORTED,
+				    "failed to set inflate dictionary: %s",
+				    zError(zret));
+			return FALSE;
+		}
+	}
+
+	/* both buffers are reused for every block */
+	g_byte_array_set_size(self->buf_comp, block->size);
+	if (!fu_input_stream_read_safe(self->base_stream,
+				       self->buf_comp->data,
+				       self->buf_comp->len,
+				       0x0,
+				       block->offset,
+				       block->size,
+				       error))
+		return FALSE;
+	g_byte_array_set_size(self->buf_uncomp, block->usize);
+	self->buf_uncomp_idx = G_MAXUINT;
+	self->zstrm.avail_in = self->buf_comp->len;
+	self->zstrm.next_in = self->buf_comp->data;
+	self->zstrm.avail_out = self->buf_uncomp->len;
+	self->zstrm.next_out = self->buf_uncomp->data;
+	zret = inflate(&self->zstrm, Z_FINISH);
+	if (zret != Z_STREAM_END) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_NOT_SUPPORTED,
+			    "inflate error @0x%x: %s",
+			    (guint)block->offset,
+			    zError(zret));
+		return FALSE;
+	}
+	if (self->zstrm.avail_out != 0) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_NOT_SUPPORTED,
+			    "inflate size @0x%x was 0x%x, expected 0x%x",
+			    (guint)block->offset,
+			    (guint)(block->usize - self->zstrm.avail_out),
+			    (guint)block->usize);
+		return FALSE;
+	}
+
+	/* success */
+	self->buf_uncomp_idx = idx;
+	return TRUE;
+}
+
+static gboolean
+fu_cab_inflate_input_stream_ensure_block(FuCabInflateInputStream *self, guint idx, GError **error)
+{
+	guint idx_start = 0;
+
+	/* already done */
+	if (self->buf_uncomp_idx == idx)
+		return TRUE;
+
+	/* continue on from the current block if possible */
+	if (self->buf_uncomp_idx != G_MAXUINT && self->buf_uncomp_idx < idx)
+		idx_start = self->buf_uncomp_idx + 1;
+	for (guint i = idx_start; i <= idx; i++) {
+		if (!fu_cab_inflate_input_stream_inflate_block(self, i, error))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * fu_cab_inflate_input_stream_check:
+ * @self: a #FuCabInflateInputStream
+ * @error: (nullable): optional return location for an error
+ *
+ * Decompresses every block in turn, discarding the data, so that a corrupt folder can be
+ * rejected before any of it is used. Only one block is held in memory at any time.
+ *
+ * Returns: %TRUE if every block decompressed to the expected size
+ *
+ * Since: 2.0.19
+ **/
+gboolean
+fu_cab_inflate_input_stream_check(FuCabInflateInputStream *self, GError **error)
+{
+	g_return_val_if_fail(FU_IS_CAB_INFLATE_INPUT_STREAM(self), FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	if (self->blocks->len == 0)
+		return TRUE;
+	return fu_cab_inflate_input_stream_ensure_block(self, self->blocks->len - 1, error);
+}
+
+static guint
+fu_cab_inflate_input_stream_get_block_for_offset(FuCabInflateInputStream *self, gsize offset)
+{
+	guint lo = 0;
+	guint hi = self->blocks->len;
+
+	/* the block that was used last is the most likely */
+	if (self->buf_uncomp_idx != G_MAXUINT) {
+		FuCabInflateInputStreamBlock *block =
+		    &g_array_index(self->blocks, FuCabInflateInputStreamBlock, self->buf_uncomp_idx);
+		if (offset >= block->uoffset && offset < block->uoffset + block->usize)
+			return self->buf_uncomp_idx;
+	}
+
+	/* blocks are sorted by uoffset */
+	while (lo < hi) {
+		guint mid = lo + (hi - lo) / 2;
+		FuCabInflateInputStreamBlock *block =
+		    &g_array_index(self->blocks, FuCabInflateInputStreamBlock, mid);
+		if (offset < block->uoffset)
+			hi = mid;
+		else if (offset >= block->uoffset + block->usize)
+			lo = mid + 1;
+		else
+			return mid;
+	}
+	return G_MAXUINT;
+}
+
+static goffset
+fu_cab_inflate_input_stream_tell(GSeekable *seekable)
+{
+	FuCabInflateInputStream *self = FU_CAB_INFLATE_INPUT_STREAM(seekable);
+	g_return_val_if_fail(FU_IS_CAB_INFLATE_INPUT_STREAM(self), -1);
+	return self->pos;
+}
+
+static gboolean
+fu_cab_inflate_input_stream_can_seek(GSeekable *seekable)
+{
+	return TRUE;
+}
+
+static gboolean
+fu_cab_inflate_input_stream_seek(GSeekable *seekable,
+				 goffset offset,
+				 GSeekType type,
+				 GCancellable *cancellable,
+				 GError **error)
+{
+	FuCabInflateInputStream *self = FU_CAB_INFLATE_INPUT_STREAM(seekable);
+
+	g_return_val_if_fail(FU_IS_CAB_INFLATE_INPUT_STREAM(self), FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	if (type == G_SEEK_CUR) {
+		self->pos += offset;
+	} else if (type == G_SEEK_END) {
+		self->pos = self->total_size + offset;
+	} else {
+		self->pos = offset;
+	}
+	return TRUE;
+}
+
+static gboolean
+fu_cab_inflate_input_stream_can_truncate(GSeekable *seekable)
+{
+	return FALSE;
+}
+
+static gboolean
+fu_cab_inflate_input_stream_truncate(GSeekable *seekable,
+				     goffset offset,
+				     GCancellable *cancellable,
+				     GError **error)
+{
+	g_set_error_literal(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_NOT_SUPPORTED,
+			    "cannot truncate FuCabInflateInputStream");
+	return FALSE;
+}
+
+static void
+fu_cab_inflate_input_stream_seekable_iface_init(GSeekableIface *iface)
+{
+	iface->tell = fu_cab_inflate_input_stream_tell;
+	iface->can_seek = fu_cab_inflate_input_stream_can_seek;
+	iface->seek = fu_cab_inflate_input_stream_seek;
+	iface->can_truncate = fu_cab_inflate_input_stream_can_truncate;
+	iface->truncate_fn = fu_cab_inflate_input_stream_truncate;
+}
+
+static voidpf
+fu_cab_inflate_input_stream_zalloc(voidpf opaque, uInt items, uInt size)
+{
+	return g_malloc0_n(items, size);
+}
+
+static void
+fu_cab_inflate_input_stream_zfree(voidpf opaque, voidpf address)
+{
+	g_free(address);
+}
+
+/**
+ * fu_cab_inflate_input_stream_new:
+ * @base_stream: a #GInputStream of the cabinet archive
+ * @error: (nullable): optional return location for an error
+ *
+ * Creates a input stream that decompresses MSZIP CFDATA blocks as required.
+ *
+ * Returns: (transfer full): a #FuCabInflateInputStream, or %NULL on error
+ *
+ * Since: 2.0.19
+ **/
+GInputStream *
+fu_cab_inflate_input_stream_new(GInputStream *base_stream, GError **error)
+{
+	int zret;
+	g_autoptr(FuCabInflateInputStream) self =
+	    g_object_new(FU_TYPE_CAB_INFLATE_INPUT_STREAM, NULL);
+
+	g_return_val_if_fail(G_IS_INPUT_STREAM(base_stream), NULL);
+	g_return_val_if_fail(error == NULL || *error == NULL, NULL);
+
+	self->zstrm.zalloc = fu_cab_inflate_input_stream_zalloc;
+	self->zstrm.zfree = fu_cab_inflate_input_stream_zfree;
+	zret = inflateInit2(&self->zstrm, -MAX_WBITS);
+	if (zret != Z_OK) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_NOT_SUPPORTED,
+			    "failed to initialize inflate: %s",
+			    zError(zret));
+		return NULL;
+	}
+	self->base_stream = g_object_ref(base_stream);
+	return G_INPUT_STREAM(g_steal_pointer(&self));
+}
+
+static gssize
+fu_cab_inflate_input_stream_read(GInputStream *stream,
+				 void *buffer,
+				 gsize count,
+				 GCancellable *cancellable,
+				 GError **error)
+{
+	FuCabInflateInputStream *self = FU_CAB_INFLATE_INPUT_STREAM(stream);
+	FuCabInflateInputStreamBlock *block;
+	gsize block_offset;
+	gsize rc;
+	guint idx;
+
+	g_return_val_if_fail(FU_IS_CAB_INFLATE_INPUT_STREAM(self), -1);
+	g_return_val_if_fail(error == NULL || *error == NULL, -1);
+
+	/* EOF */
+	if (self->pos < 0 || (gsize)self->pos >= self->total_size)
+		return 0;
+	idx = fu_cab_inflate_input_stream_get_block_for_offset(self, self->pos);
+	if (idx == G_MAXUINT)
+		return 0;
+	if (!fu_cab_inflate_input_stream_ensure_block(self, idx, error))
+		return -1;
+
+	/* only ever return data from one block */
+	block = &g_array_index(self->blocks, FuCabInflateInputStreamBlock, idx);
+	block_offset = self->pos - block->uoffset;
+	rc = MIN(count, block->usize - block_offset);
+	if (!fu_memcpy_safe(buffer,
+			    count,
+			    0x0,
+			    self->buf_uncomp->data,
+			    self->buf_uncomp->len,
+			    block_offset,
+			    rc,
+			    error))
+		return -1;
+	self->pos += rc;
+	return rc;
+}
+
+static void
+fu_cab_inflate_input_stream_finalize(GObject *object)
+{
+	FuCabInflateInputStream *self = FU_CAB_INFLATE_INPUT_STREAM(object);
+	inflateEnd(&self->zstrm);
+	if (self->base_stream != NULL)
+		g_object_unref(self->base_stream);
+	g_array_unref(self->blocks);
+	g_byte_array_unref(self->buf_comp);
+	g_byte_array_unref(self->buf_uncomp);
+	G_OBJECT_CLASS(fu_cab_inflate_input_stream_parent_class)->finalize(object);
+}
+
+static void
+fu_cab_inflate_input_stream_class_init(FuCabInflateInputStreamClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS(klass);
+	GInputStreamClass *istream_class = G_INPUT_STREAM_CLASS(klass);
+	istream_class->read_fn = fu_cab_inflate_input_stream_read;
+	object_class->finalize = fu_cab_inflate_input_stream_finalize;
+}
+
+static void
+fu_cab_inflate_input_stream_init(FuCabInflateInputStream *self)
+{
+	self->blocks = g_array_new(FALSE, FALSE, sizeof(FuCabInflateInputStreamBlock));
+	self->buf_comp = g_byte_array_new();
+	self->buf_uncomp = g_byte_array_new();
+	self->buf_uncomp_idx = G_MAXUINT;
+}
@@ -0,0 +1,27 @@
+/*
+ * Copyright 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+#define FU_TYPE_CAB_INFLATE_INPUT_STREAM (fu_cab_inflate_input_stream_get_type())
+
+G_DECLARE_FINAL_TYPE(FuCabInflateInputStream,
+		     fu_cab_inflate_input_stream,
+		     FU,
+		     CAB_INFLATE_INPUT_STREAM,
+		     GInputStream)
+
+GInputStream *
+fu_cab_inflate_input_stream_new(GInputStream *base_stream, GError **error) G_GNUC_NON_NULL(1);
+void
+fu_cab_inflate_input_stream_add_block(FuCabInflateInputStream *self,
+				      gsize offset,
+				      gsize size,
+				      gsize usize) G_GNUC_NON_NULL(1);
+gboolean
+fu_cab_inflate_input_stream_check(FuCabInflateInputStream *self, GError **error) G_GNUC_NON_NULL(1);
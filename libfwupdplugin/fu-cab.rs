@@ -29,7 +29,7 @@ enum FuCabFileAttribute {
     NameUtf8 = 0x80,
 }
 
-#[derive(ParseStream, New)]
+#[derive(Parse, New)]
 #[repr(C, packed)]
 struct FuStructCabFile {
     usize: u32le, // uncompressed
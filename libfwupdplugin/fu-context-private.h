@@ -9,6 +9,7 @@
 #include "fu-config.h"
 #include "fu-context.h"
 #include "fu-hwids.h"
+#include "fu-poll-scheduler.h"
 #include "fu-progress.h"
 #include "fu-quirks.h"
 #include "fu-volume.h"
@@ -64,6 +65,8 @@ FuHwids *
 fu_context_get_hwids(FuContext *self) G_GNUC_NON_NULL(1);
 FuConfig *
 fu_context_get_config(FuContext *self) G_GNUC_NON_NULL(1);
+FuPollScheduler *
+fu_context_get_poll_scheduler(FuContext *self) G_GNUC_NON_NULL(1);
 void
 fu_context_set_chassis_kind(FuContext *self, FuSmbiosChassisKind chassis_kind) G_GNUC_NON_NULL(1);
 
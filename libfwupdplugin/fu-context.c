@@ -21,6 +21,7 @@
 #include "fu-hwids-private.h"
 #include "fu-path.h"
 #include "fu-pefile-firmware.h"
+#include "fu-poll-scheduler.h"
 #include "fu-volume-locker.h"
 #include "fu-volume-private.h"
 
@@ -54,6 +55,7 @@ typedef struct {
 	FuBiosSettings *host_bios_settings;
 	FuFirmware *fdt; /* optional */
 	gchar *esp_location;
+	FuPollScheduler *poll_scheduler;
 } FuContextPrivate;
 
 enum { SIGNAL_SECURITY_CHANGED, SIGNAL_HOUSEKEEPING, SIGNAL_LAST };
@@ -283,6 +285,24 @@ fu_context_get_hwids(FuContext *self)
 	return priv->hwids;
 }
 
+/**
+ * fu_context_get_poll_scheduler:
+ * @self: a #FuContext
+ *
+ * Gets the scheduler used to poll all the devices using this context.
+ *
+ * Returns: (transfer none): a #FuPollScheduler
+ *
+ * Since: 2.0.19
+ **/
+FuPollScheduler *
+fu_context_get_poll_scheduler(FuContext *self)
+{
+	FuContextPrivate *priv = GET_PRIVATE(self);
+	g_return_val_if_fail(FU_IS_CONTEXT(self), NULL);
+	return priv->poll_scheduler;
+}
+
 /**
  * fu_context_get_config:
  * @self: a #FuContext
@@ -2457,6 +2477,7 @@ fu_context_finalize(GObject *object)
 	g_free(priv->esp_location);
 	g_hash_table_unref(priv->runtime_versions);
 	g_hash_table_unref(priv->compile_versions);
+	g_object_unref(priv->poll_scheduler);
 	g_object_unref(priv->hwids);
 	g_object_unref(priv->config);
 	g_hash_table_unref(priv->hwid_flags);
@@ -2642,6 +2663,7 @@ fu_context_init(FuContext *self)
 	priv->runtime_versions = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
 	priv->compile_versions = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
 	priv->backends = g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
+	priv->poll_scheduler = fu_poll_scheduler_new();
 }
 
 /**
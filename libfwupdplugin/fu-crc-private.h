@@ -22,3 +22,8 @@ guint8
 fu_crc8_step(FuCrcKind kind, const guint8 *buf, gsize bufsz, guint8 crc);
 guint8
 fu_crc8_done(FuCrcKind kind, guint8 crc);
+
+guint
+fu_crc_get_bitwidth(FuCrcKind kind);
+guint32
+fu_crc_step_bitwise(FuCrcKind kind, const guint8 *buf, gsize bufsz, guint32 crc);
@@ -59,55 +59,184 @@ const struct {
     {FU_CRC_KIND_B8_AUTOSAR, 8, 0x2F, 0xFF, FALSE, 0xFF},
 };
 
+/* per-kind lookup tables, built on first use; only 32 bit kinds use the slices */
+typedef struct {
+	guint32 slice[8][256];
+} FuCrcTable;
+
+static FuCrcTable *crc_tables[FU_CRC_KIND_LAST] = {NULL};
+
 static guint8
 fu_crc_reflect8(guint8 data)
 {
-	guint8 val = 0;
-	for (guint8 bit = 0; bit < 8; bit++) {
-		if (data & 0x01)
-			FU_BIT_SET(val, 7 - bit);
-		data = (data >> 1);
-	}
-	return val;
+	data = ((data & 0xF0) >> 4) | ((data & 0x0F) << 4);
+	data = ((data & 0xCC) >> 2) | ((data & 0x33) << 2);
+	data = ((data & 0xAA) >> 1) | ((data & 0x55) << 1);
+	return data;
 }
 
 static guint32
 fu_crc_reflect(guint32 data, guint bitwidth)
 {
-	guint32 val = 0;
-	for (guint bit = 0; bit < bitwidth; bit++) {
-		if (data & 0x01)
-			val |= 1ul << ((bitwidth - 1) - bit); /* nocheck:blocked */
-		data = (data >> 1);
+	data = ((data & 0xFFFF0000) >> 16) | ((data & 0x0000FFFF) << 16);
+	data = ((data & 0xFF00FF00) >> 8) | ((data & 0x00FF00FF) << 8);
+	data = ((data & 0xF0F0F0F0) >> 4) | ((data & 0x0F0F0F0F) << 4);
+	data = ((data & 0xCCCCCCCC) >> 2) | ((data & 0x33333333) << 2);
+	data = ((data & 0xAAAAAAAA) >> 1) | ((data & 0x55555555) << 1);
+	return data >> (32 - bitwidth);
+}
+
+static guint32
+fu_crc_mask(guint bitwidth)
+{
+	return bitwidth == 32 ? G_MAXUINT32 : (1u << bitwidth) - 1;
+}
+
+/*
+ * Reflected kinds are computed LSB-first using the reflected polynomial, which avoids reflecting
+ * every input byte; the other kinds use the usual MSB-first table.
+ */
+static FuCrcTable *
+fu_crc_table_new(FuCrcKind kind)
+{
+	const guint bitwidth = crc_map[kind].bitwidth;
+	const guint32 mask = fu_crc_mask(bitwidth);
+	const guint32 topbit = 1u << (bitwidth - 1);
+	FuCrcTable *table = g_new0(FuCrcTable, 1);
+
+	if (crc_map[kind].reflected) {
+		guint32 poly = fu_crc_reflect(crc_map[kind].poly, bitwidth);
+		for (guint i = 0; i < 256; i++) {
+			guint32 val = i;
+			for (guint8 bit = 0; bit < 8; bit++)
+				val = (val & 0x01) ? (val >> 1) ^ poly : val >> 1;
+			table->slice[0][i] = val;
+		}
+		if (bitwidth == 32) {
+			for (guint j = 1; j < 8; j++) {
+				for (guint i = 0; i < 256; i++) {
+					guint32 val = table->slice[j - 1][i];
+					table->slice[j][i] = (val >> 8) ^ table->slice[0][val & 0xFF];
+				}
+			}
+		}
+	} else {
+		for (guint i = 0; i < 256; i++) {
+			guint32 val = i << (bitwidth - 8);
+			for (guint8 bit = 0; bit < 8; bit++)
+				val = (val & topbit) ? (val << 1) ^ crc_map[kind].poly : val << 1;
+			table->slice[0][i] = val & mask;
+		}
+		if (bitwidth == 32) {
+			for (guint j = 1; j < 8; j++) {
+				for (guint i = 0; i < 256; i++) {
+					guint32 val = table->slice[j - 1][i];
+					table->slice[j][i] = (val << 8) ^ table->slice[0][val >> 24];
+				}
+			}
+		}
+	}
+	return table;
+}
+
+static const FuCrcTable *
+fu_crc_get_table(FuCrcKind kind)
+{
+	if (g_once_init_enter(&crc_tables[kind])) {
+		FuCrcTable *table = fu_crc_table_new(kind);
+		g_once_init_leave(&crc_tables[kind], table);
+	}
+	return crc_tables[kind];
+}
+
+/* @crc is always in the MSB-first representation used by fu_crc*_done() */
+static guint32
+fu_crc_step_table(FuCrcKind kind, const guint8 *buf, gsize bufsz, guint32 crc)
+{
+	const guint bitwidth = crc_map[kind].bitwidth;
+	const guint32 mask = fu_crc_mask(bitwidth);
+	const FuCrcTable *table = fu_crc_get_table(kind);
+	const guint32 *t0 = table->slice[0];
+	gsize i = 0;
+
+	if (crc_map[kind].reflected) {
+		crc = fu_crc_reflect(crc, bitwidth);
+		if (bitwidth == 32) {
+			for (; i + 8 <= bufsz; i += 8) {
+				guint32 lo = fu_memread_uint32(buf + i, G_LITTLE_ENDIAN) ^ crc;
+				guint32 hi = fu_memread_uint32(buf + i + 4, G_LITTLE_ENDIAN);
+				crc = table->slice[7][lo & 0xFF] ^ table->slice[6][(lo >> 8) & 0xFF] ^
+				      table->slice[5][(lo >> 16) & 0xFF] ^ table->slice[4][lo >> 24] ^
+				      table->slice[3][hi & 0xFF] ^ table->slice[2][(hi >> 8) & 0xFF] ^
+				      table->slice[1][(hi >> 16) & 0xFF] ^ t0[hi >> 24];
+			}
+		}
+		for (; i < bufsz; i++) {
+			guint32 tmp = (bitwidth > 8) ? crc >> 8 : 0;
+			crc = tmp ^ t0[(crc ^ buf[i]) & 0xFF];
+		}
+		return fu_crc_reflect(crc, bitwidth);
+	}
+
+	if (bitwidth == 32) {
+		for (; i + 8 <= bufsz; i += 8) {
+			guint32 lo = fu_memread_uint32(buf + i, G_BIG_ENDIAN) ^ crc;
+			guint32 hi = fu_memread_uint32(buf + i + 4, G_BIG_ENDIAN);
+			crc = table->slice[7][lo >> 24] ^ table->slice[6][(lo >> 16) & 0xFF] ^
+			      table->slice[5][(lo >> 8) & 0xFF] ^ table->slice[4][lo & 0xFF] ^
+			      table->slice[3][hi >> 24] ^ table->slice[2][(hi >> 16) & 0xFF] ^
+			      table->slice[1][(hi >> 8) & 0xFF] ^ t0[hi & 0xFF];
+		}
+	}
+	for (; i < bufsz; i++) {
+		guint32 tmp = (bitwidth > 8) ? (crc << 8) & mask : 0;
+		crc = tmp ^ t0[((crc >> (bitwidth - 8)) ^ buf[i]) & 0xFF];
 	}
-	return val;
+	return crc;
 }
 
 /**
- * fu_crc8_step:
- * @kind: a #FuCrcKind, typically %FU_CRC_KIND_B8_MAXIM_DOW
+ * fu_crc_get_bitwidth:
+ * @kind: a #FuCrcKind
+ *
+ * Returns the width of the CRC kind.
+ *
+ * Returns: width in bits, e.g. 32
+ *
+ * Since: 2.0.19
+ **/
+guint
+fu_crc_get_bitwidth(FuCrcKind kind)
+{
+	g_return_val_if_fail(kind < FU_CRC_KIND_LAST, 0);
+	return crc_map[kind].bitwidth;
+}
+
+/**
+ * fu_crc_step_bitwise:
+ * @kind: a #FuCrcKind
  * @buf: memory buffer
  * @bufsz: size of @buf
  * @crc: initial CRC value
  *
- * Computes the cyclic redundancy check section value for the given memory buffer.
- *
- * NOTE: When all data has been added, you should call fu_crc8_done() to return the final value.
+ * Computes the cyclic redundancy check section value one bit at a time. This is only useful as a
+ * reference for testing, as it is much slower than fu_crc32_step() and friends.
  *
  * Returns: CRC value
  *
- * Since: 2.0.0
+ * Since: 2.0.19
  **/
-guint8
-fu_crc8_step(FuCrcKind kind, const guint8 *buf, gsize bufsz, guint8 crc)
+guint32
+fu_crc_step_bitwise(FuCrcKind kind, const guint8 *buf, gsize bufsz, guint32 crc)
 {
-	const guint bitwidth = sizeof(crc) * 8;
+	guint bitwidth;
 
 	g_return_val_if_fail(kind < FU_CRC_KIND_LAST, 0x0);
-	g_return_val_if_fail(crc_map[kind].bitwidth == 8, 0x0);
 
+	bitwidth = crc_map[kind].bitwidth;
 	for (gsize i = 0; i < bufsz; ++i) {
-		crc ^= crc_map[kind].reflected ? fu_crc_reflect8(buf[i]) : buf[i];
+		guint32 tmp = crc_map[kind].reflected ? fu_crc_reflect8(buf[i]) : buf[i];
+		crc ^= tmp << (bitwidth - 8);
 		for (guint8 bit = 0; bit < 8; bit++) {
 			if (crc & (1ul << (bitwidth - 1))) {
 				crc = (crc << 1) ^ crc_map[kind].poly;
@@ -115,10 +244,34 @@ fu_crc8_step(FuCrcKind kind, const guint8 *buf, gsize bufsz, guint8 crc)
 				crc = (crc << 1);
 			}
 		}
+		crc &= fu_crc_mask(bitwidth);
 	}
 	return crc;
 }
 
+/**
+ * fu_crc8_step:
+ * @kind: a #FuCrcKind, typically %FU_CRC_KIND_B8_MAXIM_DOW
+ * @buf: memory buffer
+ * @bufsz: size of @buf
+ * @crc: initial CRC value
+ *
+ * Computes the cyclic redundancy check section value for the given memory buffer.
+ *
+ * NOTE: When all data has been added, you should call fu_crc8_done() to return the final value.
+ *
+ * Returns: CRC value
+ *
+ * Since: 2.0.0
+ **/
+guint8
+fu_crc8_step(FuCrcKind kind, const guint8 *buf, gsize bufsz, guint8 crc)
+{
+	g_return_val_if_fail(kind < FU_CRC_KIND_LAST, 0x0);
+	g_return_val_if_fail(crc_map[kind].bitwidth == 8, 0x0);
+	return fu_crc_step_table(kind, buf, bufsz, crc);
+}
+
 /**
  * fu_crc8_done:
  * @kind: a #FuCrcKind, typically %FU_CRC_KIND_B8_MAXIM_DOW
@@ -196,23 +349,9 @@ fu_crc8_bytes(FuCrcKind kind, GBytes *blob)
 guint16
 fu_crc16_step(FuCrcKind kind, const guint8 *buf, gsize bufsz, guint16 crc)
 {
-	const guint bitwidth = sizeof(crc) * 8;
-
 	g_return_val_if_fail(kind < FU_CRC_KIND_LAST, 0x0);
 	g_return_val_if_fail(crc_map[kind].bitwidth == 16, 0x0);
-
-	for (gsize i = 0; i < bufsz; ++i) {
-		guint16 tmp = crc_map[kind].reflected ? fu_crc_reflect8(buf[i]) : buf[i];
-		crc ^= tmp << (bitwidth - 8);
-		for (guint8 bit = 0; bit < 8; bit++) {
-			if (crc & (1ul << (bitwidth - 1))) {
-				crc = (crc << 1) ^ crc_map[kind].poly;
-			} else {
-				crc = (crc << 1);
-			}
-		}
-	}
-	return crc;
+	return fu_crc_step_table(kind, buf, bufsz, crc);
 }
 
 /**
@@ -292,23 +431,9 @@ fu_crc16_bytes(FuCrcKind kind, GBytes *blob)
 guint32
 fu_crc32_step(FuCrcKind kind, const guint8 *buf, gsize bufsz, guint32 crc)
 {
-	const guint bitwidth = sizeof(crc) * 8;
-
 	g_return_val_if_fail(kind < FU_CRC_KIND_LAST, 0x0);
 	g_return_val_if_fail(crc_map[kind].bitwidth == 32, 0x0);
-
-	for (gsize i = 0; i < bufsz; ++i) {
-		guint32 tmp = crc_map[kind].reflected ? fu_crc_reflect8(buf[i]) : buf[i];
-		crc ^= tmp << (bitwidth - 8);
-		for (guint8 bit = 0; bit < 8; bit++) {
-			if (crc & (1ul << (bitwidth - 1))) {
-				crc = (crc << 1) ^ crc_map[kind].poly;
-			} else {
-				crc = (crc << 1);
-			}
-		}
-	}
-	return crc;
+	return fu_crc_step_table(kind, buf, bufsz, crc);
 }
 
 /**
@@ -180,7 +180,8 @@ fu_device_event_set_i64(FuDeviceEvent *self, const gchar *key, gint64 value)
  * @key: (not nullable): a unique key, e.g. `Name`
  * @value: (not nullable): a #GBytes
  *
- * Sets a blob on the event. Note: blobs are stored internally as BASE-64 strings.
+ * Sets a blob on the event. Note: blobs are stored internally as binary data and only converted
+ * to BASE-64 strings when exporting to JSON.
  *
  * Since: 2.0.0
  **/
@@ -191,11 +192,10 @@ fu_device_event_set_bytes(FuDeviceEvent *self, const gchar *key, GBytes *value)
 	g_return_if_fail(key != NULL);
 	g_return_if_fail(value != NULL);
 	g_ptr_array_add(self->values,
-			fu_device_event_blob_new(
-			    G_TYPE_STRING,
-			    key,
-			    g_base64_encode(g_bytes_get_data(value, NULL), g_bytes_get_size(value)),
-			    g_free));
+			fu_device_event_blob_new(G_TYPE_BYTES,
+						 key,
+						 g_bytes_ref(value),
+						 (GDestroyNotify)g_bytes_unref));
 }
 
 /**
@@ -205,7 +205,8 @@ fu_device_event_set_bytes(FuDeviceEvent *self, const gchar *key, GBytes *value)
  * @buf: (nullable): a buffer
  * @bufsz: size of @buf
  *
- * Sets a memory buffer on the event. Note: memory buffers are stored internally as BASE-64 strings.
+ * Sets a memory buffer on the event. Note: memory buffers are stored internally as binary data and
+ * only converted to BASE-64 strings when exporting to JSON.
  *
  * Since: 2.0.0
  **/
@@ -214,9 +215,11 @@ fu_device_event_set_data(FuDeviceEvent *self, const gchar *key, const guint8 *bu
 {
 	g_return_if_fail(FU_IS_DEVICE_EVENT(self));
 	g_return_if_fail(key != NULL);
-	g_ptr_array_add(
-	    self->values,
-	    fu_device_event_blob_new(G_TYPE_STRING, key, g_base64_encode(buf, bufsz), g_free));
+	g_ptr_array_add(self->values,
+			fu_device_event_blob_new(G_TYPE_BYTES,
+						 key,
+						 g_bytes_new(buf, bufsz),
+						 (GDestroyNotify)g_bytes_unref));
 }
 
 /**
@@ -274,22 +277,24 @@ fu_device_event_check_error(FuDeviceEvent *self, GError **error)
 	return FALSE;
 }
 
-static gpointer
-fu_device_event_lookup(FuDeviceEvent *self, const gchar *key, GType gtype, GError **error)
+static FuDeviceEventBlob *
+fu_device_event_lookup_blob(FuDeviceEvent *self, const gchar *key, GError **error)
 {
-	FuDeviceEventBlob *blob = NULL;
-
 	for (guint i = 0; i < self->values->len; i++) {
-		FuDeviceEventBlob *blob_tmp = g_ptr_array_index(self->values, i);
-		if (g_strcmp0(blob_tmp->key, key) == 0) {
-			blob = blob_tmp;
-			break;
-		}
+		FuDeviceEventBlob *blob = g_ptr_array_index(self->values, i);
+		if (g_strcmp0(blob->key, key) == 0)
+			return blob;
 	}
-	if (blob == NULL) {
-		g_set_error(error, FWUPD_ERROR, FWUPD_ERROR_NOT_FOUND, "no event for key %s", key);
+	g_set_error(error, FWUPD_ERROR, FWUPD_ERROR_NOT_FOUND, "no event for key %s", key);
+	return NULL;
+}
+
+static gpointer
+fu_device_event_lookup(FuDeviceEvent *self, const gchar *key, GType gtype, GError **error)
+{
+	FuDeviceEventBlob *blob = fu_device_event_lookup_blob(self, key, error);
+	if (blob == NULL)
 		return NULL;
-	}
 	if (blob->gtype != gtype) {
 		g_set_error(error,
 			    FWUPD_ERROR,
@@ -301,6 +306,38 @@ fu_device_event_lookup(FuDeviceEvent *self, const gchar *key, GType gtype, GErro
 	return blob->data;
 }
 
+/* blobs loaded from JSON are BASE-64 strings, so decode once and then keep the binary data */
+static GBytes *
+fu_device_event_lookup_bytes(FuDeviceEvent *self, const gchar *key, GError **error)
+{
+	FuDeviceEventBlob *blob = fu_device_event_lookup_blob(self, key, error);
+
+	if (blob == NULL)
+		return NULL;
+	if (blob->gtype == G_TYPE_STRING) {
+		const gchar *blobstr = (const gchar *)blob->data;
+		gsize bufsz = 0;
+		guchar *buf = NULL;
+
+		if (blobstr != NULL && blobstr[0] != '\0')
+			buf = g_base64_decode(blobstr, &bufsz);
+		if (blob->data_destroy != NULL)
+			blob->data_destroy(blob->data);
+		blob->gtype = G_TYPE_BYTES;
+		blob->data = g_bytes_new_take(buf, bufsz);
+		blob->data_destroy = (GDestroyNotify)g_bytes_unref;
+	}
+	if (blob->gtype != G_TYPE_BYTES) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_INVALID_DATA,
+			    "invalid event type for key %s",
+			    key);
+		return NULL;
+	}
+	return (GBytes *)blob->data;
+}
+
 /**
  * fu_device_event_get_str:
  * @self: a #FuDeviceEvent
@@ -362,21 +399,16 @@ fu_device_event_get_i64(FuDeviceEvent *self, const gchar *key, GError **error)
 GBytes *
 fu_device_event_get_bytes(FuDeviceEvent *self, const gchar *key, GError **error)
 {
-	const gchar *blobstr;
-	gsize bufsz = 0;
-	g_autofree guchar *buf = NULL;
+	GBytes *blob;
 
 	g_return_val_if_fail(FU_IS_DEVICE_EVENT(self), NULL);
 	g_return_val_if_fail(key != NULL, NULL);
 	g_return_val_if_fail(error == NULL || *error == NULL, NULL);
 
-	blobstr = fu_device_event_lookup(self, key, G_TYPE_STRING, error);
-	if (blobstr == NULL)
+	blob = fu_device_event_lookup_bytes(self, key, error);
+	if (blob == NULL)
 		return NULL;
-	if (blobstr[0] == '\0')
-		return g_bytes_new(NULL, 0);
-	buf = g_base64_decode(blobstr, &bufsz);
-	return g_bytes_new_take(g_steal_pointer(&buf), bufsz);
+	return g_bytes_ref(blob);
 }
 
 /**
@@ -402,21 +434,21 @@ fu_device_event_copy_data(FuDeviceEvent *self,
 			  gsize *actual_length,
 			  GError **error)
 {
-	const gchar *blobstr;
+	GBytes *blob;
+	const guint8 *buf_src;
 	gsize bufsz_src = 0;
-	g_autofree guchar *buf_src = NULL;
 
 	g_return_val_if_fail(FU_IS_DEVICE_EVENT(self), FALSE);
 	g_return_val_if_fail(key != NULL, FALSE);
 	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
 
-	blobstr = fu_device_event_lookup(self, key, G_TYPE_STRING, error);
-	if (blobstr == NULL)
+	blob = fu_device_event_lookup_bytes(self, key, error);
+	if (blob == NULL)
 		return FALSE;
-	buf_src = g_base64_decode(blobstr, &bufsz_src);
+	buf_src = g_bytes_get_data(blob, &bufsz_src);
 	if (actual_length != NULL)
 		*actual_length = bufsz_src;
-	if (buf != NULL)
+	if (buf != NULL && bufsz_src > 0)
 		return fu_memcpy_safe(buf, bufsz, 0x0, buf_src, bufsz_src, 0x0, bufsz_src, error);
 	return TRUE;
 }
@@ -439,7 +471,13 @@ fu_device_event_add_json(FwupdCodec *codec, JsonBuilder *builder, FwupdCodecFlag
 		if (blob->gtype == G_TYPE_INT) {
 			json_builder_set_member_name(builder, blob->key);
 			json_builder_add_int_value(builder, *((gint64 *)blob->data));
-		} else if (blob->gtype == G_TYPE_BYTES || blob->gtype == G_TYPE_STRING) {
+		} else if (blob->gtype == G_TYPE_BYTES) {
+			GBytes *bytes = (GBytes *)blob->data;
+			g_autofree gchar *str = g_base64_encode(g_bytes_get_data(bytes, NULL),
+								g_bytes_get_size(bytes));
+			json_builder_set_member_name(builder, blob->key);
+			json_builder_add_string_value(builder, str);
+		} else if (blob->gtype == G_TYPE_STRING) {
 			json_builder_set_member_name(builder, blob->key);
 			json_builder_add_string_value(builder, (const gchar *)blob->data);
 		} else {
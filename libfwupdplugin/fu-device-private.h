@@ -99,3 +99,5 @@ gboolean
 fu_device_from_json(FuDevice *self, JsonObject *json_object, GError **error) G_GNUC_NON_NULL(1, 2);
 gchar *
 fu_device_convert_version(FuDevice *self, guint64 version_raw, GError **error) G_GNUC_NON_NULL(1);
+gboolean
+fu_device_poll_is_paused(FuDevice *self) G_GNUC_NON_NULL(1);
@@ -18,6 +18,7 @@
 #include "fu-byte-array.h"
 #include "fu-bytes.h"
 #include "fu-chunk-array.h"
+#include "fu-context-private.h"
 #include "fu-device-event-private.h"
 #include "fu-device-poll-locker.h"
 #include "fu-device-private.h"
@@ -74,6 +75,8 @@ typedef struct {
 	GPtrArray *parent_physical_ids; /* (nullable) */
 	GPtrArray *parent_backend_ids;	/* (nullable) */
 	GPtrArray *events;		/* (nullable) (element-type FuDeviceEvent) */
+	GHashTable *events_by_id;	/* (nullable) (element-type utf-8 GArray) */
+	guint events_by_id_len;
 	guint event_idx;
 	guint remove_delay;    /* ms */
 	guint acquiesce_delay; /* ms */
@@ -81,6 +84,7 @@ typedef struct {
 	gint order;
 	guint priority;
 	guint poll_id;
+	guint poll_interval; /* ms */
 	gint poll_locker_cnt;
 	gboolean done_probe;
 	gboolean done_setup;
@@ -141,7 +145,13 @@ enum {
 	PROP_LAST
 };
 
-enum { SIGNAL_CHILD_ADDED, SIGNAL_CHILD_REMOVED, SIGNAL_REQUEST, SIGNAL_LAST };
+enum {
+	SIGNAL_CHILD_ADDED,
+	SIGNAL_CHILD_REMOVED,
+	SIGNAL_REQUEST,
+	SIGNAL_GUIDS_CHANGED,
+	SIGNAL_LAST
+};
 
 static guint signals[SIGNAL_LAST] = {0};
 
@@ -1330,6 +1340,15 @@ fu_device_poll(FuDevice *self, GError **error)
 	return TRUE;
 }
 
+/* private */
+gboolean
+fu_device_poll_is_paused(FuDevice *self)
+{
+	FuDevicePrivate *priv = GET_PRIVATE(self);
+	return fu_device_has_private_flag(self, FU_DEVICE_PRIVATE_FLAG_AUTO_PAUSE_POLLING) &&
+	       g_atomic_int_get(&priv->poll_locker_cnt) > 0;
+}
+
 static gboolean
 fu_device_poll_cb(gpointer user_data)
 {
@@ -1338,8 +1357,7 @@ fu_device_poll_cb(gpointer user_data)
 	g_autoptr(GError) error_local = NULL;
 
 	/* device is being detached, written, read, or attached */
-	if (fu_device_has_private_flag(self, FU_DEVICE_PRIVATE_FLAG_AUTO_PAUSE_POLLING) &&
-	    priv->poll_locker_cnt > 0) {
+	if (fu_device_poll_is_paused(self)) {
 		g_debug("ignoring poll callback as an action is in progress");
 		return G_SOURCE_CONTINUE;
 	}
@@ -1352,14 +1370,53 @@ fu_device_poll_cb(gpointer user_data)
 	return G_SOURCE_CONTINUE;
 }
 
+static void
+fu_device_poll_stop(FuDevice *self)
+{
+	FuDevicePrivate *priv = GET_PRIVATE(self);
+	if (priv->poll_id != 0) {
+		g_source_remove(priv->poll_id);
+		priv->poll_id = 0;
+	}
+	if (priv->ctx != NULL)
+		fu_poll_scheduler_remove(fu_context_get_poll_scheduler(priv->ctx), self);
+}
+
+static void
+fu_device_poll_start(FuDevice *self)
+{
+	FuDevicePrivate *priv = GET_PRIVATE(self);
+
+	if (priv->poll_interval == 0)
+		return;
+
+	/* share the wakeup with other devices using the same context */
+	if (priv->ctx != NULL && priv->poll_interval >= FU_POLL_SCHEDULER_TICK_MS) {
+		fu_poll_scheduler_add(fu_context_get_poll_scheduler(priv->ctx),
+				      self,
+				      priv->poll_interval);
+		return;
+	}
+	if (priv->poll_interval % 1000 == 0) {
+		priv->poll_id =
+		    g_timeout_add_seconds(priv->poll_interval / 1000, fu_device_poll_cb, self);
+	} else {
+		priv->poll_id = g_timeout_add(priv->poll_interval, fu_device_poll_cb, self);
+	}
+}
+
 /**
  * fu_device_set_poll_interval:
  * @self: a #FuPlugin
  * @interval: duration in ms, or 0 to disable
  *
  * Polls the hardware every interval period. If the subclassed `->poll()` method
- * returns %FALSE then a warning is printed to the console and the poll is
- * disabled until the next call to fu_device_set_poll_interval().
+ * returns %FALSE then the poll is retried less often, and if it keeps failing then a warning is
+ * printed to the console and the poll is disabled until the next call to
+ * fu_device_set_poll_interval().
+ *
+ * Devices with a context are polled by a scheduler shared with all other devices, so that devices
+ * with related intervals, or devices that share a parent, are polled in the same wakeup.
  *
  * Since: 1.1.2
  **/
@@ -1370,17 +1427,9 @@ fu_device_set_poll_interval(FuDevice *self, guint interval)
 
 	g_return_if_fail(FU_IS_DEVICE(self));
 
-	if (priv->poll_id != 0) {
-		g_source_remove(priv->poll_id);
-		priv->poll_id = 0;
-	}
-	if (interval == 0)
-		return;
-	if (interval % 1000 == 0) {
-		priv->poll_id = g_timeout_add_seconds(interval / 1000, fu_device_poll_cb, self);
-	} else {
-		priv->poll_id = g_timeout_add(interval, fu_device_poll_cb, self);
-	}
+	fu_device_poll_stop(self);
+	priv->poll_interval = interval;
+	fu_device_poll_start(self);
 }
 
 /**
@@ -3081,6 +3130,7 @@ fu_device_add_instance_id_full(FuDevice *self,
 			fwupd_device_add_instance_id(FWUPD_DEVICE(self), item->instance_id);
 		fwupd_device_add_guid(FWUPD_DEVICE(self), item->guid);
 	}
+	g_signal_emit(self, signals[SIGNAL_GUIDS_CHANGED], 0);
 }
 
 /**
@@ -5334,6 +5384,7 @@ fu_device_to_string_impl(FuDevice *self, guint idt, GString *str)
 	fwupd_codec_string_append(str, idt, "ProxyGuid", priv->proxy_guid);
 	fwupd_codec_string_append_int(str, idt, "RemoveDelay", priv->remove_delay);
 	fwupd_codec_string_append_int(str, idt, "AcquiesceDelay", priv->acquiesce_delay);
+	fwupd_codec_string_append_int(str, idt, "PollInterval", priv->poll_interval);
 	fwupd_codec_string_append(str, idt, "CustomFlags", priv->custom_flags);
 	if (priv->specialized_gtype != G_TYPE_INVALID)
 		fwupd_codec_string_append(str, idt, "GType", g_type_name(priv->specialized_gtype));
@@ -5568,8 +5619,12 @@ fu_device_set_context(FuDevice *self, FuContext *ctx)
 	}
 #endif
 
-	if (g_set_object(&priv->ctx, ctx))
-		g_object_notify(G_OBJECT(self), "context");
+	if (priv->ctx == ctx)
+		return;
+	fu_device_poll_stop(self);
+	g_set_object(&priv->ctx, ctx);
+	fu_device_poll_start(self);
+	g_object_notify(G_OBJECT(self), "context");
 }
 
 /**
@@ -6426,6 +6481,7 @@ fu_device_convert_instance_ids(FuDevice *self)
 				fwupd_device_add_instance_id(FWUPD_DEVICE(self), item->instance_id);
 			fwupd_device_add_guid(FWUPD_DEVICE(self), item->guid);
 		}
+		g_signal_emit(self, signals[SIGNAL_GUIDS_CHANGED], 0);
 	}
 
 	/* OEM specific hardware */
@@ -6828,12 +6884,15 @@ fu_device_incorporate(FuDevice *self, FuDevice *donor, FuDeviceIncorporateFlags
 
 	/* bitflags */
 	if (flag & FU_DEVICE_INCORPORATE_FLAG_BASECLASS) {
+		guint guids_len = fu_device_get_guids(self)->len;
 		fwupd_device_incorporate(FWUPD_DEVICE(self), FWUPD_DEVICE(donor));
 		if (fu_device_get_id(self) != NULL)
 			priv->device_id_valid = TRUE;
 		/* remove the baseclass-added serial number and GUIDs if set */
 		if (fu_device_has_private_flag_quark(self, quarks[QUARK_NO_SERIAL_NUMBER]))
 			fwupd_device_set_serial(FWUPD_DEVICE(self), NULL);
+		if (fu_device_get_guids(self)->len != guids_len)
+			g_signal_emit(self, signals[SIGNAL_GUIDS_CHANGED], 0);
 	}
 	if (flag & FU_DEVICE_INCORPORATE_FLAG_VENDOR) {
 		if (fu_device_get_vendor(self) == NULL && fu_device_get_vendor(donor) != NULL)
@@ -7966,6 +8025,42 @@ fu_device_ensure_events(FuDevice *self)
 	priv->events = g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
 }
 
+/* maps each event ID to the ascending array positions, so replay does not scan every event */
+static void
+fu_device_ensure_events_by_id(FuDevice *self)
+{
+	FuDevicePrivate *priv = GET_PRIVATE(self);
+
+	/* events were removed, so start again */
+	if (priv->events_by_id != NULL && priv->events_by_id_len > priv->events->len) {
+		g_clear_pointer(&priv->events_by_id, g_hash_table_unref);
+		priv->events_by_id_len = 0;
+	}
+	if (priv->events_by_id == NULL) {
+		priv->events_by_id = g_hash_table_new_full(g_str_hash,
+							   g_str_equal,
+							   g_free,
+							   (GDestroyNotify)g_array_unref);
+	}
+
+	/* index any events added since the last lookup */
+	for (guint i = priv->events_by_id_len; i < priv->events->len; i++) {
+		FuDeviceEvent *event = g_ptr_array_index(priv->events, i);
+		const gchar *id = fu_device_event_get_id(event);
+		GArray *positions;
+
+		if (id == NULL)
+			continue;
+		positions = g_hash_table_lookup(priv->events_by_id, id);
+		if (positions == NULL) {
+			positions = g_array_new(FALSE, FALSE, sizeof(guint));
+			g_hash_table_insert(priv->events_by_id, g_strdup(id), positions);
+		}
+		g_array_append_val(positions, i);
+	}
+	priv->events_by_id_len = priv->events->len;
+}
+
 /**
  * fu_device_add_event:
  * @self: a #FuDevice
@@ -8040,6 +8135,7 @@ FuDeviceEvent *
 fu_device_load_event(FuDevice *self, const gchar *id, GError **error)
 {
 	FuDevicePrivate *priv = GET_PRIVATE(self);
+	GArray *positions;
 	g_autofree gchar *id_hash = NULL;
 
 	g_return_val_if_fail(FU_IS_DEVICE(self), NULL);
@@ -8064,12 +8160,25 @@ fu_device_load_event(FuDevice *self, const gchar *id, GError **error)
 
 	/* look for the next event in the sequence */
 	id_hash = fu_device_event_build_id(id);
-	for (guint i = priv->event_idx; i < priv->events->len; i++) {
-		FuDeviceEvent *event = g_ptr_array_index(priv->events, i);
-		if (g_strcmp0(fu_device_event_get_id(event), id_hash) == 0) {
+	fu_device_ensure_events_by_id(self);
+	positions = g_hash_table_lookup(priv->events_by_id, id_hash);
+	if (positions != NULL) {
+		guint lo = 0;
+		guint hi = positions->len;
+
+		/* find the first position at or after the current index */
+		while (lo < hi) {
+			guint mid = lo + (hi - lo) / 2;
+			if (g_array_index(positions, guint, mid) < priv->event_idx)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		if (lo < positions->len) {
+			guint i = g_array_index(positions, guint, lo);
 			priv->event_idx = i + 1;
 			g_debug("found event with ID %s [%s]", id, id_hash);
-			return event;
+			return g_ptr_array_index(priv->events, i);
 		}
 	}
 
@@ -8136,6 +8245,8 @@ fu_device_clear_events(FuDevice *self)
 	if (priv->events == NULL)
 		return;
 	g_ptr_array_set_size(priv->events, 0);
+	g_clear_pointer(&priv->events_by_id, g_hash_table_unref);
+	priv->events_by_id_len = 0;
 	priv->event_idx = 0;
 }
 
@@ -8237,6 +8348,7 @@ fu_device_dispose(GObject *object)
 {
 	FuDevice *self = FU_DEVICE(object);
 	FuDevicePrivate *priv = GET_PRIVATE(self);
+	fu_device_poll_stop(self);
 	g_clear_object(&priv->ctx);
 	g_clear_object(&priv->target);
 	G_OBJECT_CLASS(fu_device_parent_class)->dispose(object);
@@ -8324,6 +8436,23 @@ fu_device_class_init(FuDeviceClass *klass)
 					       G_TYPE_NONE,
 					       1,
 					       FWUPD_TYPE_REQUEST);
+	/**
+	 * FuDevice::guids-changed:
+	 * @self: the #FuDevice instance that emitted the signal
+	 *
+	 * The ::guids-changed signal is emitted when a GUID or instance ID has been added.
+	 *
+	 * Since: 2.0.19
+	 **/
+	signals[SIGNAL_GUIDS_CHANGED] = g_signal_new("guids-changed",
+						     G_TYPE_FROM_CLASS(object_class),
+						     G_SIGNAL_RUN_LAST,
+						     0,
+						     NULL,
+						     NULL,
+						     g_cclosure_marshal_VOID__VOID,
+						     G_TYPE_NONE,
+						     0);
 
 	/**
 	 * FuDevice:physical-id:
@@ -8575,6 +8704,8 @@ fu_device_finalize(GObject *object)
 		g_ptr_array_unref(priv->parent_backend_ids);
 	if (priv->events != NULL)
 		g_ptr_array_unref(priv->events);
+	if (priv->events_by_id != NULL)
+		g_hash_table_unref(priv->events_by_id);
 	if (priv->retry_recs != NULL)
 		g_ptr_array_unref(priv->retry_recs);
 	if (priv->instance_ids != NULL)
@@ -9,6 +9,7 @@
 #include "config.h"
 
 #include <fwupd.h>
+#include <string.h>
 
 #include "fu-byte-array.h"
 #include "fu-efi-signature-list.h"
@@ -25,7 +26,15 @@
  * See also: [class@FuFirmware]
  */
 
-G_DEFINE_TYPE(FuEfiSignatureList, fu_efi_signature_list, FU_TYPE_FIRMWARE)
+typedef struct {
+	GArray *digests; /* (nullable) (element-type SHA256 digest), sorted */
+	guint digests_images_len;
+} FuEfiSignatureListPrivate;
+
+G_DEFINE_TYPE_WITH_PRIVATE(FuEfiSignatureList, fu_efi_signature_list, FU_TYPE_FIRMWARE)
+#define GET_PRIVATE(o) (fu_efi_signature_list_get_instance_private(o))
+
+#define FU_EFI_SIGNATURE_LIST_DIGEST_SIZE 32 /* SHA256 */
 
 const guint8 FU_EFI_SIGLIST_HEADER_MAGIC[] = {0x26, 0x16, 0xC4, 0xC1, 0x4C};
 
@@ -91,6 +100,120 @@ fu_efi_signature_list_get_newest(FuEfiSignatureList *self)
 	return g_steal_pointer(&sigs_newest);
 }
 
+static gint
+fu_efi_signature_list_digest_cmp(gconstpointer a, gconstpointer b)
+{
+	return memcmp(a, b, FU_EFI_SIGNATURE_LIST_DIGEST_SIZE);
+}
+
+static gboolean
+fu_efi_signature_list_digest_from_string(const gchar *checksum, guint8 *digest)
+{
+	if (strlen(checksum) != FU_EFI_SIGNATURE_LIST_DIGEST_SIZE * 2)
+		return FALSE;
+	for (guint i = 0; i < FU_EFI_SIGNATURE_LIST_DIGEST_SIZE; i++) {
+		gint hi = g_ascii_xdigit_value(checksum[i * 2]);
+		gint lo = g_ascii_xdigit_value(checksum[(i * 2) + 1]);
+		if (hi < 0 || lo < 0)
+			return FALSE;
+		digest[i] = (hi << 4) | lo;
+	}
+	return TRUE;
+}
+
+static gboolean
+fu_efi_signature_list_digests_add(FuEfiSignatureList *self, FuEfiSignature *sig, GError **error)
+{
+	FuEfiSignatureListPrivate *priv = GET_PRIVATE(self);
+	gsize digestsz = FU_EFI_SIGNATURE_LIST_DIGEST_SIZE;
+	guint8 digest[FU_EFI_SIGNATURE_LIST_DIGEST_SIZE] = {0x0};
+	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(GChecksum) csum = NULL;
+
+	blob = fu_firmware_get_bytes_with_patches(FU_FIRMWARE(sig), error);
+	if (blob == NULL)
+		return FALSE;
+
+	/* special case: this is *literally* a hash */
+	if (fu_efi_signature_get_kind(sig) == FU_EFI_SIGNATURE_KIND_SHA256 &&
+	    g_bytes_get_size(blob) == FU_EFI_SIGNATURE_LIST_DIGEST_SIZE) {
+		g_array_append_vals(priv->digests, g_bytes_get_data(blob, NULL), 1);
+		return TRUE;
+	}
+
+	/* fallback, as in fu_firmware_get_checksum() */
+	csum = g_checksum_new(G_CHECKSUM_SHA256);
+	g_checksum_update(csum, g_bytes_get_data(blob, NULL), g_bytes_get_size(blob));
+	g_checksum_get_digest(csum, digest, &digestsz);
+	g_array_append_vals(priv->digests, digest, 1);
+	return TRUE;
+}
+
+static gboolean
+fu_efi_signature_list_ensure_digests(FuEfiSignatureList *self, GError **error)
+{
+	FuEfiSignatureListPrivate *priv = GET_PRIVATE(self);
+	g_autoptr(GPtrArray) sigs = fu_firmware_get_images(FU_FIRMWARE(self));
+
+	/* already valid */
+	if (priv->digests != NULL && priv->digests_images_len == sigs->len)
+		return TRUE;
+
+	/* build a sorted array of the raw digests */
+	if (priv->digests != NULL)
+		g_array_unref(priv->digests);
+	priv->digests =
+	    g_array_sized_new(FALSE, FALSE, FU_EFI_SIGNATURE_LIST_DIGEST_SIZE, sigs->len);
+	priv->digests_images_len = sigs->len;
+	for (guint i = 0; i < sigs->len; i++) {
+		FuEfiSignature *sig = g_ptr_array_index(sigs, i);
+		if (!fu_efi_signature_list_digests_add(self, sig, error)) {
+			g_clear_pointer(&priv->digests, g_array_unref);
+			return FALSE;
+		}
+	}
+	g_array_sort(priv->digests, fu_efi_signature_list_digest_cmp);
+
+	/* success */
+	return TRUE;
+}
+
+/**
+ * fu_efi_signature_list_has_checksum:
+ * @self: a #FuEfiSignatureList
+ * @checksum: a SHA256 hash, e.g. `e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855`
+ *
+ * Finds out if any of the signatures have a specific SHA256 checksum, in the same way as
+ * fu_firmware_get_image_by_checksum() but using a sorted index of the raw digests.
+ *
+ * The index is rebuilt if the number of signatures changes.
+ *
+ * Returns: %TRUE if the checksum is present
+ *
+ * Since: 2.0.19
+ **/
+gboolean
+fu_efi_signature_list_has_checksum(FuEfiSignatureList *self, const gchar *checksum)
+{
+	FuEfiSignatureListPrivate *priv = GET_PRIVATE(self);
+	guint8 digest[FU_EFI_SIGNATURE_LIST_DIGEST_SIZE] = {0x0};
+	g_autoptr(GError) error_local = NULL;
+
+	g_return_val_if_fail(FU_IS_EFI_SIGNATURE_LIST(self), FALSE);
+	g_return_val_if_fail(checksum != NULL, FALSE);
+
+	if (!fu_efi_signature_list_digest_from_string(checksum, digest))
+		return FALSE;
+	if (!fu_efi_signature_list_ensure_digests(self, &error_local)) {
+		g_warning("failed to build digest index: %s", error_local->message);
+		return FALSE;
+	}
+	return g_array_binary_search(priv->digests,
+				     digest,
+				     fu_efi_signature_list_digest_cmp,
+				     NULL);
+}
+
 static gboolean
 fu_efi_signature_list_parse_list(FuEfiSignatureList *self,
 				 GInputStream *stream,
@@ -206,9 +329,13 @@ fu_efi_signature_list_parse(FuFirmware *firmware,
 			    GError **error)
 {
 	FuEfiSignatureList *self = FU_EFI_SIGNATURE_LIST(firmware);
+	FuEfiSignatureListPrivate *priv = GET_PRIVATE(self);
 	gsize offset = 0;
 	gsize streamsz = 0;
 
+	/* invalidate the index */
+	g_clear_pointer(&priv->digests, g_array_unref);
+
 	/* parse each EFI_SIGNATURE_LIST */
 	if (!fu_input_stream_size(stream, &streamsz, error))
 		return FALSE;
@@ -356,10 +483,22 @@ fu_efi_signature_list_new(void)
 	return g_object_new(FU_TYPE_EFI_SIGNATURE_LIST, NULL);
 }
 
+static void
+fu_efi_signature_list_finalize(GObject *obj)
+{
+	FuEfiSignatureList *self = FU_EFI_SIGNATURE_LIST(obj);
+	FuEfiSignatureListPrivate *priv = GET_PRIVATE(self);
+	if (priv->digests != NULL)
+		g_array_unref(priv->digests);
+	G_OBJECT_CLASS(fu_efi_signature_list_parent_class)->finalize(obj);
+}
+
 static void
 fu_efi_signature_list_class_init(FuEfiSignatureListClass *klass)
 {
+	GObjectClass *object_class = G_OBJECT_CLASS(klass);
 	FuFirmwareClass *firmware_class = FU_FIRMWARE_CLASS(klass);
+	object_class->finalize = fu_efi_signature_list_finalize;
 	firmware_class->validate = fu_efi_signature_list_validate;
 	firmware_class->parse = fu_efi_signature_list_parse;
 	firmware_class->write = fu_efi_signature_list_write;
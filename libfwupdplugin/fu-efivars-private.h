@@ -14,3 +14,12 @@ gboolean
 fu_efivars_set_boot_current(FuEfivars *self, guint16 idx, GError **error) G_GNUC_NON_NULL(1);
 gboolean
 fu_efivars_build_boot_order(FuEfivars *self, GError **error, ...) G_GNUC_NON_NULL(1);
+guint
+fu_efivars_get_cache_hits(FuEfivars *self) G_GNUC_NON_NULL(1);
+guint
+fu_efivars_get_cache_misses(FuEfivars *self) G_GNUC_NON_NULL(1);
+void
+fu_efivars_cache_invalidate(FuEfivars *self, const gchar *guid, const gchar *name)
+    G_GNUC_NON_NULL(1, 2, 3);
+void
+fu_efivars_cache_disable(FuEfivars *self) G_GNUC_NON_NULL(1);
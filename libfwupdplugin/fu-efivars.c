@@ -7,6 +7,8 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include "fwupd-error.h"
 
 #include "fu-byte-array.h"
@@ -17,7 +19,197 @@
 #include "fu-mem.h"
 #include "fu-pefile-firmware.h"
 
-G_DEFINE_TYPE(FuEfivars, fu_efivars, G_TYPE_OBJECT)
+typedef struct {
+	gchar *key;		 /* GUID-Name */
+	GBytes *blob;		 /* nullable, if the variable does not exist */
+	GError *error;		 /* nullable, only set if the variable does not exist */
+	FuEfiVariableAttrs attr; /* only valid if ->blob is set */
+} FuEfivarsCacheItem;
+
+typedef struct {
+	GMutex cache_mutex;
+	GHashTable *cache; /* (element-type utf8 FuEfivarsCacheItem) */
+	gboolean cache_disabled;
+	guint cache_generation;
+	guint cache_hits;
+	guint cache_misses;
+} FuEfivarsPrivate;
+
+G_DEFINE_TYPE_WITH_PRIVATE(FuEfivars, fu_efivars, G_TYPE_OBJECT)
+#define GET_PRIVATE(o) (fu_efivars_get_instance_private(o))
+
+static void
+fu_efivars_cache_item_free(FuEfivarsCacheItem *item)
+{
+	if (item->blob != NULL)
+		g_bytes_unref(item->blob);
+	if (item->error != NULL)
+		g_error_free(item->error);
+	g_free(item->key);
+	g_free(item);
+}
+
+static gchar *
+fu_efivars_cache_key(const gchar *guid, const gchar *name)
+{
+	return g_strdup_printf("%s-%s", guid, name);
+}
+
+/**
+ * fu_efivars_cache_invalidate: (skip):
+ **/
+void
+fu_efivars_cache_invalidate(FuEfivars *self, const gchar *guid, const gchar *name)
+{
+	FuEfivarsPrivate *priv = GET_PRIVATE(self);
+	g_autofree gchar *key = fu_efivars_cache_key(guid, name);
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new(&priv->cache_mutex);
+	priv->cache_generation++;
+	g_hash_table_remove(priv->cache, key);
+}
+
+static void
+fu_efivars_cache_invalidate_with_glob(FuEfivars *self, const gchar *guid, const gchar *name_glob)
+{
+	FuEfivarsPrivate *priv = GET_PRIVATE(self);
+	FuEfivarsCacheItem *item;
+	GHashTableIter iter;
+	gsize guidsz = strlen(guid);
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new(&priv->cache_mutex);
+
+	priv->cache_generation++;
+	g_hash_table_iter_init(&iter, priv->cache);
+	while (g_hash_table_iter_next(&iter, NULL, (gpointer *)&item)) {
+		if (strncmp(item->key, guid, guidsz) != 0 || item->key[guidsz] != '-')
+			continue;
+		if (g_pattern_match_simple(name_glob, item->key + guidsz + 1))
+			g_hash_table_iter_remove(&iter);
+	}
+}
+
+/**
+ * fu_efivars_cache_disable: (skip):
+ **/
+void
+fu_efivars_cache_disable(FuEfivars *self)
+{
+	FuEfivarsPrivate *priv = GET_PRIVATE(self);
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new(&priv->cache_mutex);
+	priv->cache_disabled = TRUE;
+	priv->cache_generation++;
+	g_hash_table_remove_all(priv->cache);
+}
+
+static void
+fu_efivars_cache_add(FuEfivars *self,
+		     guint cache_generation,
+		     const gchar *guid,
+		     const gchar *name,
+		     GBytes *blob,
+		     FuEfiVariableAttrs attr,
+		     const GError *error)
+{
+	FuEfivarsPrivate *priv = GET_PRIVATE(self);
+	FuEfivarsCacheItem *item;
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new(&priv->cache_mutex);
+
+	/* written or deleted while we were reading it */
+	if (priv->cache_disabled || cache_generation != priv->cache_generation)
+		return;
+	item = g_new0(FuEfivarsCacheItem, 1);
+	item->key = fu_efivars_cache_key(guid, name);
+	item->blob = blob != NULL ? g_bytes_ref(blob) : NULL;
+	item->error = error != NULL ? g_error_copy(error) : NULL;
+	item->attr = attr;
+	g_hash_table_replace(priv->cache, item->key, item);
+}
+
+/* returns a shared blob, or %NULL with @error set */
+static GBytes *
+fu_efivars_get_data_cached(FuEfivars *self,
+			   const gchar *guid,
+			   const gchar *name,
+			   FuEfiVariableAttrs *attr,
+			   GError **error)
+{
+	FuEfivarsClass *efivars_class = FU_EFIVARS_GET_CLASS(self);
+	FuEfivarsPrivate *priv = GET_PRIVATE(self);
+	FuEfiVariableAttrs attr_tmp = FU_EFI_VARIABLE_ATTR_NONE;
+	guint cache_generation;
+	gsize bufsz = 0;
+	guint8 *buf = NULL;
+	g_autofree gchar *key = fu_efivars_cache_key(guid, name);
+	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(GError) error_local = NULL;
+
+	if (efivars_class->get_data == NULL) {
+		g_set_error_literal(error, FWUPD_ERROR, FWUPD_ERROR_NOT_SUPPORTED, "not supported");
+		return NULL;
+	}
+
+	/* already read */
+	g_mutex_lock(&priv->cache_mutex);
+	if (g_hash_table_contains(priv->cache, key)) {
+		FuEfivarsCacheItem *item = g_hash_table_lookup(priv->cache, key);
+		priv->cache_hits++;
+		if (item->blob == NULL) {
+			g_propagate_error(error, g_error_copy(item->error));
+			g_mutex_unlock(&priv->cache_mutex);
+			return NULL;
+		}
+		if (attr != NULL)
+			*attr = item->attr;
+		blob = g_bytes_ref(item->blob);
+		g_mutex_unlock(&priv->cache_mutex);
+		return g_steal_pointer(&blob);
+	}
+	priv->cache_misses++;
+	cache_generation = priv->cache_generation;
+	g_mutex_unlock(&priv->cache_mutex);
+
+	/* read from the backend, without holding the lock */
+	if (!efivars_class->get_data(self, guid, name, &buf, &bufsz, &attr_tmp, &error_local)) {
+		if (g_error_matches(error_local, FWUPD_ERROR, FWUPD_ERROR_NOT_FOUND))
+			fu_efivars_cache_add(self,
+					     cache_generation,
+					     guid,
+					     name,
+					     NULL,
+					     attr_tmp,
+					     error_local);
+		g_propagate_error(error, g_steal_pointer(&error_local));
+		return NULL;
+	}
+	blob = g_bytes_new_take(buf, bufsz);
+	fu_efivars_cache_add(self, cache_generation, guid, name, blob, attr_tmp, NULL);
+	if (attr != NULL)
+		*attr = attr_tmp;
+	return g_steal_pointer(&blob);
+}
+
+/**
+ * fu_efivars_get_cache_hits: (skip):
+ **/
+guint
+fu_efivars_get_cache_hits(FuEfivars *self)
+{
+	FuEfivarsPrivate *priv = GET_PRIVATE(self);
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new(&priv->cache_mutex);
+	g_return_val_if_fail(FU_IS_EFIVARS(self), G_MAXUINT);
+	return priv->cache_hits;
+}
+
+/**
+ * fu_efivars_get_cache_misses: (skip):
+ **/
+guint
+fu_efivars_get_cache_misses(FuEfivars *self)
+{
+	FuEfivarsPrivate *priv = GET_PRIVATE(self);
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new(&priv->cache_mutex);
+	g_return_val_if_fail(FU_IS_EFIVARS(self), G_MAXUINT);
+	return priv->cache_misses;
+}
 
 /**
  * fu_efivars_supported:
@@ -62,6 +254,7 @@ gboolean
 fu_efivars_delete(FuEfivars *self, const gchar *guid, const gchar *name, GError **error)
 {
 	FuEfivarsClass *efivars_class = FU_EFIVARS_GET_CLASS(self);
+	gboolean ret;
 
 	g_return_val_if_fail(FU_IS_EFIVARS(self), FALSE);
 	g_return_val_if_fail(guid != NULL, FALSE);
@@ -72,7 +265,9 @@ fu_efivars_delete(FuEfivars *self, const gchar *guid, const gchar *name, GError
 		g_set_error_literal(error, FWUPD_ERROR, FWUPD_ERROR_NOT_SUPPORTED, "not supported");
 		return FALSE;
 	}
-	return efivars_class->delete(self, guid, name, error);
+	ret = efivars_class->delete(self, guid, name, error);
+	fu_efivars_cache_invalidate(self, guid, name);
+	return ret;
 }
 
 /**
@@ -95,6 +290,7 @@ fu_efivars_delete_with_glob(FuEfivars *self,
 			    GError **error)
 {
 	FuEfivarsClass *efivars_class = FU_EFIVARS_GET_CLASS(self);
+	gboolean ret;
 
 	g_return_val_if_fail(FU_IS_EFIVARS(self), FALSE);
 	g_return_val_if_fail(guid != NULL, FALSE);
@@ -105,7 +301,9 @@ fu_efivars_delete_with_glob(FuEfivars *self,
 		g_set_error_literal(error, FWUPD_ERROR, FWUPD_ERROR_NOT_SUPPORTED, "not supported");
 		return FALSE;
 	}
-	return efivars_class->delete_with_glob(self, guid, name_glob, error);
+	ret = efivars_class->delete_with_glob(self, guid, name_glob, error);
+	fu_efivars_cache_invalidate_with_glob(self, guid, name_glob);
+	return ret;
 }
 
 /**
@@ -124,10 +322,22 @@ gboolean
 fu_efivars_exists(FuEfivars *self, const gchar *guid, const gchar *name)
 {
 	FuEfivarsClass *efivars_class = FU_EFIVARS_GET_CLASS(self);
+	FuEfivarsPrivate *priv = GET_PRIVATE(self);
 
 	g_return_val_if_fail(FU_IS_EFIVARS(self), FALSE);
 	g_return_val_if_fail(guid != NULL, FALSE);
 
+	/* already read */
+	if (name != NULL) {
+		g_autofree gchar *key = fu_efivars_cache_key(guid, name);
+		g_autoptr(GMutexLocker) locker = g_mutex_locker_new(&priv->cache_mutex);
+		FuEfivarsCacheItem *item = g_hash_table_lookup(priv->cache, key);
+		if (item != NULL) {
+			priv->cache_hits++;
+			return item->blob != NULL;
+		}
+	}
+
 	if (efivars_class->exists == NULL)
 		return FALSE;
 	return efivars_class->exists(self, guid, name);
@@ -158,18 +368,21 @@ fu_efivars_get_data(FuEfivars *self,
 		    FuEfiVariableAttrs *attr,
 		    GError **error)
 {
-	FuEfivarsClass *efivars_class = FU_EFIVARS_GET_CLASS(self);
+	g_autoptr(GBytes) blob = NULL;
 
 	g_return_val_if_fail(FU_IS_EFIVARS(self), FALSE);
 	g_return_val_if_fail(guid != NULL, FALSE);
 	g_return_val_if_fail(name != NULL, FALSE);
 	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
 
-	if (efivars_class->get_data == NULL) {
-		g_set_error_literal(error, FWUPD_ERROR, FWUPD_ERROR_NOT_SUPPORTED, "not supported");
+	blob = fu_efivars_get_data_cached(self, guid, name, attr, error);
+	if (blob == NULL)
 		return FALSE;
-	}
-	return efivars_class->get_data(self, guid, name, data, data_sz, attr, error);
+	if (data != NULL)
+		*data = g_memdup2(g_bytes_get_data(blob, NULL), g_bytes_get_size(blob));
+	if (data_sz != NULL)
+		*data_sz = g_bytes_get_size(blob);
+	return TRUE;
 }
 
 /**
@@ -193,17 +406,12 @@ fu_efivars_get_data_bytes(FuEfivars *self,
 			  FuEfiVariableAttrs *attr,
 			  GError **error)
 {
-	guint8 *data = NULL;
-	gsize datasz = 0;
-
 	g_return_val_if_fail(FU_IS_EFIVARS(self), NULL);
 	g_return_val_if_fail(guid != NULL, NULL);
 	g_return_val_if_fail(name != NULL, NULL);
 	g_return_val_if_fail(error == NULL || *error == NULL, NULL);
 
-	if (!fu_efivars_get_data(self, guid, name, &data, &datasz, attr, error))
-		return NULL;
-	return g_bytes_new_take(data, datasz);
+	return fu_efivars_get_data_cached(self, guid, name, attr, error);
 }
 
 /**
@@ -343,6 +551,7 @@ fu_efivars_set_data(FuEfivars *self,
 		    GError **error)
 {
 	FuEfivarsClass *efivars_class = FU_EFIVARS_GET_CLASS(self);
+	gboolean ret;
 
 	g_return_val_if_fail(FU_IS_EFIVARS(self), FALSE);
 	g_return_val_if_fail(guid != NULL, FALSE);
@@ -354,7 +563,11 @@ fu_efivars_set_data(FuEfivars *self,
 		g_set_error_literal(error, FWUPD_ERROR, FWUPD_ERROR_NOT_SUPPORTED, "not supported");
 		return FALSE;
 	}
-	return efivars_class->set_data(self, guid, name, data, sz, attr, error);
+	ret = efivars_class->set_data(self, guid, name, data, sz, attr, error);
+
+	/* even on failure, as the variable may have been partially written */
+	fu_efivars_cache_invalidate(self, guid, name);
+	return ret;
 }
 
 /**
@@ -932,9 +1145,27 @@ fu_efivars_get_boot_entries(FuEfivars *self, GError **error)
 static void
 fu_efivars_init(FuEfivars *self)
 {
+	FuEfivarsPrivate *priv = GET_PRIVATE(self);
+	g_mutex_init(&priv->cache_mutex);
+	priv->cache = g_hash_table_new_full(g_str_hash,
+					    g_str_equal,
+					    NULL,
+					    (GDestroyNotify)fu_efivars_cache_item_free);
+}
+
+static void
+fu_efivars_finalize(GObject *object)
+{
+	FuEfivars *self = FU_EFIVARS(object);
+	FuEfivarsPrivate *priv = GET_PRIVATE(self);
+	g_hash_table_unref(priv->cache);
+	g_mutex_clear(&priv->cache_mutex);
+	G_OBJECT_CLASS(fu_efivars_parent_class)->finalize(object);
 }
 
 static void
 fu_efivars_class_init(FuEfivarsClass *klass)
 {
+	GObjectClass *object_class = G_OBJECT_CLASS(klass);
+	object_class->finalize = fu_efivars_finalize;
 }
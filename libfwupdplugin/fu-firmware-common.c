@@ -12,6 +12,34 @@
 #include "fu-mem.h"
 #include "fu-string.h"
 
+/* hex digits have bit 4 set so that invalid characters can be detected with a single AND */
+static const guint8 fu_firmware_strparse_lut[256] = {
+    ['0'] = 0x10, ['1'] = 0x11, ['2'] = 0x12, ['3'] = 0x13, ['4'] = 0x14, ['5'] = 0x15,
+    ['6'] = 0x16, ['7'] = 0x17, ['8'] = 0x18, ['9'] = 0x19, ['A'] = 0x1A, ['B'] = 0x1B,
+    ['C'] = 0x1C, ['D'] = 0x1D, ['E'] = 0x1E, ['F'] = 0x1F, ['a'] = 0x1A, ['b'] = 0x1B,
+    ['c'] = 0x1C, ['d'] = 0x1D, ['e'] = 0x1E, ['f'] = 0x1F,
+};
+
+/* the common case of only hex digits, anything else falls back to fu_strtoull() */
+static gboolean
+fu_firmware_strparse_fast(const gchar *data, gsize datasz, gsize offset, gsize n, guint64 *value)
+{
+	guint8 valid = 0x10;
+	guint64 valuetmp = 0;
+
+	if (offset > datasz || n > datasz - offset)
+		return FALSE;
+	for (gsize i = 0; i < n; i++) {
+		guint8 nibble = fu_firmware_strparse_lut[(guint8)data[offset + i]];
+		valid &= nibble;
+		valuetmp = (valuetmp << 4) | (nibble & 0x0F);
+	}
+	if (valid == 0)
+		return FALSE;
+	*value = valuetmp;
+	return TRUE;
+}
+
 /**
  * fu_firmware_strparse_uint4_safe:
  * @data: destination buffer
@@ -79,6 +107,11 @@ fu_firmware_strparse_uint8_safe(const gchar *data,
 {
 	gchar buffer[3] = {'\0'};
 	guint64 valuetmp = 0;
+	if (fu_firmware_strparse_fast(data, datasz, offset, sizeof(buffer) - 1, &valuetmp)) {
+		if (value != NULL)
+			*value = (guint8)valuetmp;
+		return TRUE;
+	}
 	if (!fu_memcpy_safe((guint8 *)buffer,
 			    sizeof(buffer),
 			    0x0, /* dst */
@@ -122,6 +155,11 @@ fu_firmware_strparse_uint16_safe(const gchar *data,
 {
 	gchar buffer[5] = {'\0'};
 	guint64 valuetmp = 0;
+	if (fu_firmware_strparse_fast(data, datasz, offset, sizeof(buffer) - 1, &valuetmp)) {
+		if (value != NULL)
+			*value = (guint16)valuetmp;
+		return TRUE;
+	}
 	if (!fu_memcpy_safe((guint8 *)buffer,
 			    sizeof(buffer),
 			    0x0, /* dst */
@@ -165,6 +203,11 @@ fu_firmware_strparse_uint24_safe(const gchar *data,
 {
 	gchar buffer[7] = {'\0'};
 	guint64 valuetmp = 0;
+	if (fu_firmware_strparse_fast(data, datasz, offset, sizeof(buffer) - 1, &valuetmp)) {
+		if (value != NULL)
+			*value = (guint32)valuetmp;
+		return TRUE;
+	}
 	if (!fu_memcpy_safe((guint8 *)buffer,
 			    sizeof(buffer),
 			    0x0, /* dst */
@@ -180,7 +223,7 @@ fu_firmware_strparse_uint24_safe(const gchar *data,
 		return FALSE;
 	}
 	if (value != NULL)
-		*value = (guint16)valuetmp;
+		*value = (guint32)valuetmp;
 	return TRUE;
 }
 
@@ -208,6 +251,11 @@ fu_firmware_strparse_uint32_safe(const gchar *data,
 {
 	gchar buffer[9] = {'\0'};
 	guint64 valuetmp = 0;
+	if (fu_firmware_strparse_fast(data, datasz, offset, sizeof(buffer) - 1, &valuetmp)) {
+		if (value != NULL)
+			*value = (guint32)valuetmp;
+		return TRUE;
+	}
 	if (!fu_memcpy_safe((guint8 *)buffer,
 			    sizeof(buffer),
 			    0x0, /* dst */
@@ -226,3 +274,56 @@ fu_firmware_strparse_uint32_safe(const gchar *data,
 		*value = (guint32)valuetmp;
 	return TRUE;
 }
+
+/**
+ * fu_firmware_strparse_hex_safe:
+ * @data: source buffer
+ * @datasz: size of @data, typically the same as `strlen(data)`
+ * @offset: offset in chars into @data to read
+ * @buf: (out caller-allocates) (array length=bufsz): destination buffer
+ * @bufsz: number of bytes to parse, which is half the number of chars
+ * @error: (nullable): optional return location for an error
+ *
+ * Parses a run of base 16 bytes from a string, e.g. the data section of an Intel HEX or
+ * S-record line.
+ *
+ * This is much faster than calling fu_firmware_strparse_uint8_safe() for each byte.
+ *
+ * Returns: %TRUE if parsed, %FALSE otherwise
+ *
+ * Since: 2.0.19
+ **/
+gboolean
+fu_firmware_strparse_hex_safe(const gchar *data,
+			      gsize datasz,
+			      gsize offset,
+			      guint8 *buf,
+			      gsize bufsz,
+			      GError **error)
+{
+	g_return_val_if_fail(data != NULL, FALSE);
+	g_return_val_if_fail(buf != NULL || bufsz == 0, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	/* fast path */
+	if (offset <= datasz && bufsz <= (datasz - offset) / 2) {
+		const guint8 *str = (const guint8 *)data + offset;
+		guint8 valid = 0x10;
+		for (gsize i = 0; i < bufsz; i++) {
+			guint8 hi = fu_firmware_strparse_lut[str[i * 2]];
+			guint8 lo = fu_firmware_strparse_lut[str[(i * 2) + 1]];
+			valid &= hi & lo;
+			buf[i] = (guint8)((hi << 4) | (lo & 0x0F));
+		}
+		if (valid != 0)
+			return TRUE;
+	}
+
+	/* slow path, which also sets a useful error */
+	for (gsize i = 0; i < bufsz; i++) {
+		gsize offset_tmp = offset + (i * 2);
+		if (!fu_firmware_strparse_uint8_safe(data, datasz, offset_tmp, &buf[i], error))
+			return FALSE;
+	}
+	return TRUE;
+}
@@ -13,6 +13,7 @@
 #include "fu-byte-array.h"
 #include "fu-firmware-common.h"
 #include "fu-ihex-firmware.h"
+#include "fu-input-stream.h"
 #include "fu-mem.h"
 #include "fu-string.h"
 
@@ -25,15 +26,37 @@
  */
 
 typedef struct {
-	GPtrArray *records;
+	GBytes *blob;	     /* source text */
+	GArray *tokens;	     /* of FuIhexFirmwareToken */
+	GByteArray *payload; /* data of every token, back to back */
+	GPtrArray *records;  /* of FuIhexFirmwareRecord, created on demand */
 	guint8 padding_value;
 } FuIhexFirmwarePrivate;
 
+/* a parsed line, pointing into ->blob and ->payload */
+typedef struct {
+	guint ln;
+	gsize line_offset;
+	gsize line_sz;
+	gsize payload_offset;
+	guint32 addr;
+	guint8 byte_cnt;
+	guint8 record_type;
+} FuIhexFirmwareToken;
+
 G_DEFINE_TYPE_WITH_PRIVATE(FuIhexFirmware, fu_ihex_firmware, FU_TYPE_FIRMWARE)
 #define GET_PRIVATE(o) (fu_ihex_firmware_get_instance_private(o))
 
 #define FU_IHEX_FIRMWARE_TOKENS_MAX 100000 /* lines */
 
+static void
+fu_ihex_firmware_record_free(FuIhexFirmwareRecord *rcd)
+{
+	g_string_free(rcd->buf, TRUE);
+	g_byte_array_unref(rcd->data);
+	g_free(rcd);
+}
+
 /**
  * fu_ihex_firmware_get_records:
  * @self: A #FuIhexFirmware
@@ -51,7 +74,31 @@ GPtrArray *
 fu_ihex_firmware_get_records(FuIhexFirmware *self)
 {
 	FuIhexFirmwarePrivate *priv = GET_PRIVATE(self);
+	const gchar *text;
+
 	g_return_val_if_fail(FU_IS_IHEX_FIRMWARE(self), NULL);
+
+	/* only the few plugins that need the raw lines pay for the allocations */
+	if (priv->records != NULL)
+		return priv->records;
+	priv->records = g_ptr_array_new_with_free_func((GFreeFunc)fu_ihex_firmware_record_free);
+	if (priv->blob == NULL)
+		return priv->records;
+	text = g_bytes_get_data(priv->blob, NULL);
+	for (guint i = 0; i < priv->tokens->len; i++) {
+		FuIhexFirmwareToken *tok = &g_array_index(priv->tokens, FuIhexFirmwareToken, i);
+		FuIhexFirmwareRecord *rcd = g_new0(FuIhexFirmwareRecord, 1);
+		rcd->ln = tok->ln;
+		rcd->buf = g_string_new_len(text + tok->line_offset, tok->line_sz);
+		rcd->byte_cnt = tok->byte_cnt;
+		rcd->addr = tok->addr;
+		rcd->record_type = tok->record_type;
+		rcd->data = g_byte_array_sized_new(tok->byte_cnt);
+		g_byte_array_append(rcd->data,
+				    priv->payload->data + tok->payload_offset,
+				    tok->byte_cnt);
+		g_ptr_array_add(priv->records, rcd);
+	}
 	return priv->records;
 }
 
@@ -75,149 +122,171 @@ fu_ihex_firmware_set_padding_value(FuIhexFirmware *self, guint8 padding_value)
 	priv->padding_value = padding_value;
 }
 
-static void
-fu_ihex_firmware_record_free(FuIhexFirmwareRecord *rcd)
-{
-	g_string_free(rcd->buf, TRUE);
-	g_byte_array_unref(rcd->data);
-	g_free(rcd);
-}
-
-G_DEFINE_AUTOPTR_CLEANUP_FUNC(FuIhexFirmwareRecord, fu_ihex_firmware_record_free)
-
-static FuIhexFirmwareRecord *
-fu_ihex_firmware_record_new(guint ln, const gchar *line, FuFirmwareParseFlags flags, GError **error)
+static gboolean
+fu_ihex_firmware_tokenize_line(FuIhexFirmware *self,
+			       FuIhexFirmwareToken *tok,
+			       const gchar *line,
+			       FuFirmwareParseFlags flags,
+			       GError **error)
 {
-	g_autoptr(FuIhexFirmwareRecord) rcd = NULL;
-	gsize linesz = strlen(line);
+	FuIhexFirmwarePrivate *priv = GET_PRIVATE(self);
+	gsize linesz = tok->line_sz;
 	guint line_end;
+	guint8 hdr[4] = {0};
 	guint16 addr16 = 0;
 
 	/* check starting token */
 	if (line[0] != ':') {
-		g_autofree gchar *strsafe = fu_strsafe(line, 5);
+		g_autofree gchar *tmp = g_strndup(line, MIN(linesz, 5));
+		g_autofree gchar *strsafe = fu_strsafe(tmp, 5);
 		if (strsafe != NULL) {
 			g_set_error(error,
 				    FWUPD_ERROR,
 				    FWUPD_ERROR_INVALID_FILE,
 				    "invalid starting token: %s",
 				    strsafe);
-			return NULL;
+			return FALSE;
 		}
 		g_set_error_literal(error,
 				    FWUPD_ERROR,
 				    FWUPD_ERROR_INVALID_FILE,
 				    "invalid starting token");
-		return NULL;
+		return FALSE;
 	}
 
 	/* length, 16-bit address, type */
-	rcd = g_new0(FuIhexFirmwareRecord, 1);
-	rcd->ln = ln;
-	rcd->data = g_byte_array_new();
-	rcd->buf = g_string_new(line);
-	if (!fu_firmware_strparse_uint8_safe(line, linesz, 1, &rcd->byte_cnt, error))
-		return NULL;
+	if (!fu_firmware_strparse_uint8_safe(line, linesz, 1, &tok->byte_cnt, error))
+		return FALSE;
 	if (!fu_firmware_strparse_uint16_safe(line, linesz, 3, &addr16, error))
-		return NULL;
-	rcd->addr = addr16;
-	if (!fu_firmware_strparse_uint8_safe(line, linesz, 7, &rcd->record_type, error))
-		return NULL;
+		return FALSE;
+	tok->addr = addr16;
+	if (!fu_firmware_strparse_uint8_safe(line, linesz, 7, &tok->record_type, error))
+		return FALSE;
 
 	/* position of checksum */
-	line_end = 9 + rcd->byte_cnt * 2;
-	if (line_end > (guint)rcd->buf->len) {
+	line_end = 9 + tok->byte_cnt * 2;
+	if (line_end > linesz) {
 		g_set_error(error,
 			    FWUPD_ERROR,
 			    FWUPD_ERROR_INVALID_FILE,
 			    "line malformed, length: %u",
 			    line_end);
-		return NULL;
+		return FALSE;
+	}
+
+	/* the checksum covers the header bytes too */
+	if ((flags & FU_FIRMWARE_PARSE_FLAG_IGNORE_CHECKSUM) == 0) {
+		if (!fu_firmware_strparse_hex_safe(line, linesz, 1, hdr, sizeof(hdr), error))
+			return FALSE;
 	}
 
+	/* decode straight into the shared payload buffer */
+	tok->payload_offset = priv->payload->len;
+	g_byte_array_set_size(priv->payload, priv->payload->len + tok->byte_cnt);
+	if (!fu_firmware_strparse_hex_safe(line,
+					   linesz,
+					   9,
+					   priv->payload->data + tok->payload_offset,
+					   tok->byte_cnt,
+					   error))
+		return FALSE;
+
 	/* verify checksum */
 	if ((flags & FU_FIRMWARE_PARSE_FLAG_IGNORE_CHECKSUM) == 0) {
 		guint8 checksum = 0;
-		for (guint i = 1; i < line_end + 2; i += 2) {
-			guint8 data_tmp = 0;
-			if (!fu_firmware_strparse_uint8_safe(line, linesz, i, &data_tmp, error))
-				return NULL;
-			checksum += data_tmp;
-		}
+		if (!fu_firmware_strparse_uint8_safe(line, linesz, line_end, &checksum, error))
+			return FALSE;
+		for (guint i = 0; i < sizeof(hdr); i++)
+			checksum += hdr[i];
+		for (guint i = 0; i < tok->byte_cnt; i++)
+			checksum += priv->payload->data[tok->payload_offset + i];
 		if (checksum != 0) {
 			g_set_error(error,
 				    FWUPD_ERROR,
 				    FWUPD_ERROR_INVALID_FILE,
 				    "invalid checksum (0x%02x)",
 				    checksum);
-			return NULL;
+			return FALSE;
 		}
 	}
-
-	/* add data */
-	for (guint i = 9; i < line_end; i += 2) {
-		guint8 tmp_c = 0;
-		if (!fu_firmware_strparse_uint8_safe(line, linesz, i, &tmp_c, error))
-			return NULL;
-		fu_byte_array_append_uint8(rcd->data, tmp_c);
-	}
-	return g_steal_pointer(&rcd);
+	return TRUE;
 }
 
-typedef struct {
-	FuIhexFirmware *self;
-	FuFirmwareParseFlags flags;
-} FuIhexFirmwareTokenHelper;
-
 static gboolean
-fu_ihex_firmware_tokenize_cb(GString *token, guint token_idx, gpointer user_data, GError **error)
+fu_ihex_firmware_tokenize(FuFirmware *firmware,
+			  GInputStream *stream,
+			  FuFirmwareParseFlags flags,
+			  GError **error)
 {
-	FuIhexFirmwareTokenHelper *helper = (FuIhexFirmwareTokenHelper *)user_data;
-	FuIhexFirmwarePrivate *priv = GET_PRIVATE(helper->self);
-	g_autoptr(FuIhexFirmwareRecord) rcd = NULL;
-
-	/* sanity check */
-	if (token_idx > FU_IHEX_FIRMWARE_TOKENS_MAX) {
-		g_set_error_literal(error,
-				    FWUPD_ERROR,
-				    FWUPD_ERROR_INVALID_DATA,
-				    "file has too many lines");
+	FuIhexFirmware *self = FU_IHEX_FIRMWARE(firmware);
+	FuIhexFirmwarePrivate *priv = GET_PRIVATE(self);
+	const gchar *text;
+	const gchar *nul;
+	gsize textsz = 0;
+	gsize offset = 0;
+	guint token_idx = 0;
+	g_autoptr(GBytes) blob = NULL;
+
+	/* read once and split in-place, stopping at the first NUL like fu_strsplit_stream() */
+	blob = fu_input_stream_read_bytes(stream, 0x0, G_MAXSIZE, NULL, error);
+	if (blob == NULL)
 		return FALSE;
-	}
+	text = g_bytes_get_data(blob, &textsz);
+	nul = memchr(text, '\0', textsz);
+	if (nul != NULL)
+		textsz = nul - text;
+	g_clear_pointer(&priv->records, g_ptr_array_unref);
+	g_array_set_size(priv->tokens, 0);
+	g_byte_array_set_size(priv->payload, 0);
+	g_clear_pointer(&priv->blob, g_bytes_unref);
+	priv->blob = g_steal_pointer(&blob);
+
+	while (offset <= textsz) {
+		const gchar *line = text + offset;
+		const gchar *eol = memchr(line, '\n', textsz - offset);
+		gsize tokensz = eol != NULL ? (gsize)(eol - line) : textsz - offset;
+		FuIhexFirmwareToken tok = {.line_offset = offset};
+
+		/* the next line */
+		offset += tokensz + 1;
+
+		/* sanity check is valid UTF-8 */
+		if (!g_utf8_validate_len(line, tokensz, NULL)) {
+			g_debug("ignoring invalid UTF-8 at offset 0x%x", (guint)tok.line_offset);
+			continue;
+		}
+		if (token_idx > FU_IHEX_FIRMWARE_TOKENS_MAX) {
+			g_set_error_literal(error,
+					    FWUPD_ERROR,
+					    FWUPD_ERROR_INVALID_DATA,
+					    "file has too many lines");
+			return FALSE;
+		}
+		tok.ln = ++token_idx;
 
-	/* remove WIN32 line endings */
-	g_strdelimit(token->str, "\r\x1a", '\0');
-	token->len = strlen(token->str);
+		/* remove WIN32 line endings */
+		while (tok.line_sz < tokensz && line[tok.line_sz] != '\r' &&
+		       line[tok.line_sz] != '\x1a')
+			tok.line_sz++;
 
-	/* ignore blank lines */
-	if (token->len == 0)
-		return TRUE;
+		/* ignore blank lines */
+		if (tok.line_sz == 0)
+			continue;
 
-	/* ignore comments */
-	if (g_str_has_prefix(token->str, ";"))
-		return TRUE;
+		/* ignore comments */
+		if (line[0] == ';')
+			continue;
 
-	/* parse record */
-	rcd = fu_ihex_firmware_record_new(token_idx + 1, token->str, helper->flags, error);
-	if (rcd == NULL) {
-		g_prefix_error(error, "invalid line %u: ", token_idx + 1);
-		return FALSE;
+		/* parse record */
+		if (!fu_ihex_firmware_tokenize_line(self, &tok, line, flags, error)) {
+			g_prefix_error(error, "invalid line %u: ", tok.ln);
+			return FALSE;
+		}
+		g_array_append_val(priv->tokens, tok);
 	}
-	g_ptr_array_add(priv->records, g_steal_pointer(&rcd));
 	return TRUE;
 }
 
-static gboolean
-fu_ihex_firmware_tokenize(FuFirmware *firmware,
-			  GInputStream *stream,
-			  FuFirmwareParseFlags flags,
-			  GError **error)
-{
-	FuIhexFirmware *self = FU_IHEX_FIRMWARE(firmware);
-	FuIhexFirmwareTokenHelper helper = {.self = self, .flags = flags};
-	return fu_strsplit_stream(stream, 0x0, "\n", fu_ihex_firmware_tokenize_cb, &helper, error);
-}
-
 static gboolean
 fu_ihex_firmware_parse(FuFirmware *firmware,
 		       GInputStream *stream,
@@ -233,22 +302,18 @@ fu_ihex_firmware_parse(FuFirmware *firmware,
 	guint32 img_addr = G_MAXUINT32;
 	guint32 seg_addr = 0x0;
 	g_autoptr(GBytes) img_bytes = NULL;
-	g_autoptr(GByteArray) buf = g_byte_array_new();
+	g_autoptr(GByteArray) buf = g_byte_array_sized_new(priv->payload->len);
 
 	/* parse records */
-	for (guint k = 0; k < priv->records->len; k++) {
-		FuIhexFirmwareRecord *rcd = g_ptr_array_index(priv->records, k);
+	for (guint k = 0; k < priv->tokens->len; k++) {
+		FuIhexFirmwareToken *rcd = &g_array_index(priv->tokens, FuIhexFirmwareToken, k);
+		const guint8 *data = priv->payload->data + rcd->payload_offset;
 		guint16 addr16 = 0;
 		guint32 addr = rcd->addr + seg_addr + abs_addr;
 		guint32 len_hole;
 
-		/* debug */
-		g_debug("%s:", fu_ihex_firmware_record_type_to_string(rcd->record_type));
-		g_debug("length:\t0x%02x", rcd->data->len);
-		g_debug("addr:\t0x%08x", addr);
-
 		/* sanity check */
-		if (rcd->record_type != FU_IHEX_FIRMWARE_RECORD_TYPE_EOF && rcd->data->len == 0) {
+		if (rcd->record_type != FU_IHEX_FIRMWARE_RECORD_TYPE_EOF && rcd->byte_cnt == 0) {
 			g_set_error(error,
 				    FWUPD_ERROR,
 				    FWUPD_ERROR_NOT_SUPPORTED,
@@ -269,7 +334,7 @@ fu_ihex_firmware_parse(FuFirmware *firmware,
 						    "cannot process data after EOF");
 				return FALSE;
 			}
-			if (rcd->data->len == 0) {
+			if (rcd->byte_cnt == 0) {
 				g_set_error_literal(error,
 						    FWUPD_ERROR,
 						    FWUPD_ERROR_INVALID_FILE,
@@ -309,10 +374,11 @@ fu_ihex_firmware_parse(FuFirmware *firmware,
 					addr_last + 1,
 					addr_last + len_hole - 1,
 					rcd->ln);
-				for (guint j = 1; j < len_hole; j++)
-					fu_byte_array_append_uint8(buf, priv->padding_value);
+				fu_byte_array_set_size(buf,
+						       buf->len + len_hole - 1,
+						       priv->padding_value);
 			}
-			addr_last = addr + rcd->data->len - 1;
+			addr_last = addr + rcd->byte_cnt - 1;
 			if (addr_last < addr) {
 				g_set_error(error,
 					    FWUPD_ERROR,
@@ -324,7 +390,7 @@ fu_ihex_firmware_parse(FuFirmware *firmware,
 			}
 
 			/* write into buf */
-			g_byte_array_append(buf, rcd->data->data, rcd->data->len);
+			g_byte_array_append(buf, data, rcd->byte_cnt);
 			break;
 		case FU_IHEX_FIRMWARE_RECORD_TYPE_EOF:
 			if (got_eof) {
@@ -338,8 +404,8 @@ fu_ihex_firmware_parse(FuFirmware *firmware,
 			got_eof = TRUE;
 			break;
 		case FU_IHEX_FIRMWARE_RECORD_TYPE_EXTENDED_LINEAR:
-			if (!fu_memread_uint16_safe(rcd->data->data,
-						    rcd->data->len,
+			if (!fu_memread_uint16_safe(data,
+						    rcd->byte_cnt,
 						    0x0,
 						    &addr16,
 						    G_BIG_ENDIAN,
@@ -349,8 +415,8 @@ fu_ihex_firmware_parse(FuFirmware *firmware,
 			g_debug("abs_addr:\t0x%02x on line %u", abs_addr, rcd->ln);
 			break;
 		case FU_IHEX_FIRMWARE_RECORD_TYPE_START_LINEAR:
-			if (!fu_memread_uint32_safe(rcd->data->data,
-						    rcd->data->len,
+			if (!fu_memread_uint32_safe(data,
+						    rcd->byte_cnt,
 						    0x0,
 						    &abs_addr,
 						    G_BIG_ENDIAN,
@@ -359,8 +425,8 @@ fu_ihex_firmware_parse(FuFirmware *firmware,
 			g_debug("abs_addr:\t0x%08x on line %u", abs_addr, rcd->ln);
 			break;
 		case FU_IHEX_FIRMWARE_RECORD_TYPE_EXTENDED_SEGMENT:
-			if (!fu_memread_uint16_safe(rcd->data->data,
-						    rcd->data->len,
+			if (!fu_memread_uint16_safe(data,
+						    rcd->byte_cnt,
 						    0x0,
 						    &addr16,
 						    G_BIG_ENDIAN,
@@ -372,8 +438,8 @@ fu_ihex_firmware_parse(FuFirmware *firmware,
 			break;
 		case FU_IHEX_FIRMWARE_RECORD_TYPE_START_SEGMENT:
 			/* initial content of the CS:IP registers */
-			if (!fu_memread_uint32_safe(rcd->data->data,
-						    rcd->data->len,
+			if (!fu_memread_uint32_safe(data,
+						    rcd->byte_cnt,
 						    0x0,
 						    &seg_addr,
 						    G_BIG_ENDIAN,
@@ -390,9 +456,9 @@ fu_ihex_firmware_parse(FuFirmware *firmware,
 						    "corrupt file");
 				return FALSE;
 			}
-			if (rcd->data->len > 0) {
+			if (rcd->byte_cnt > 0) {
 				g_autoptr(GBytes) data_sig =
-				    g_bytes_new(rcd->data->data, rcd->data->len);
+				    g_bytes_new(data, rcd->byte_cnt);
 				g_autoptr(FuFirmware) img_sig =
 				    fu_firmware_new_from_bytes(data_sig);
 				fu_firmware_set_id(img_sig, FU_FIRMWARE_ID_SIGNATURE);
@@ -532,7 +598,12 @@ fu_ihex_firmware_finalize(GObject *object)
 {
 	FuIhexFirmware *self = FU_IHEX_FIRMWARE(object);
 	FuIhexFirmwarePrivate *priv = GET_PRIVATE(self);
-	g_ptr_array_unref(priv->records);
+	if (priv->blob != NULL)
+		g_bytes_unref(priv->blob);
+	g_array_unref(priv->tokens);
+	g_byte_array_unref(priv->payload);
+	if (priv->records != NULL)
+		g_ptr_array_unref(priv->records);
 	G_OBJECT_CLASS(fu_ihex_firmware_parent_class)->finalize(object);
 }
 
@@ -541,7 +612,8 @@ fu_ihex_firmware_init(FuIhexFirmware *self)
 {
 	FuIhexFirmwarePrivate *priv = GET_PRIVATE(self);
 	priv->padding_value = 0x00; /* chosen as we can't write 0xffff to PIC14 */
-	priv->records = g_ptr_array_new_with_free_func((GFreeFunc)fu_ihex_firmware_record_free);
+	priv->tokens = g_array_new(FALSE, FALSE, sizeof(FuIhexFirmwareToken));
+	priv->payload = g_byte_array_new();
 	fu_firmware_add_flag(FU_FIRMWARE(self), FU_FIRMWARE_FLAG_HAS_CHECKSUM);
 	fu_firmware_set_images_max(FU_FIRMWARE(self), 10);
 }
@@ -8,7 +8,18 @@
 
 #include "config.h"
 
-#include "fu-chunk-array.h"
+#include <errno.h>
+#ifdef HAVE_GIO_UNIX
+#include <fcntl.h>
+#include <gio/gfiledescriptorbased.h>
+#include <gio/gunixinputstream.h>
+#include <unistd.h>
+#endif
+#ifdef HAVE_MMAN_H
+#include <sys/mman.h>
+#endif
+#include <sys/stat.h>
+
 #include "fu-crc-private.h"
 #include "fu-input-stream.h"
 #include "fu-mem-private.h"
@@ -474,6 +485,188 @@ fu_input_stream_compute_checksum(GInputStream *stream, GChecksumType checksum_ty
 	return g_strdup(g_checksum_get_string(csum));
 }
 
+#define FU_INPUT_STREAM_CHECKSUMS_BLOCKSZ 0x40000 /* bytes */
+
+typedef struct {
+	GPtrArray *csums;	  /* of GChecksum */
+	GAsyncQueue *queue_full;  /* of GByteArray, no-ref */
+	GAsyncQueue *queue_empty; /* of GByteArray, no-ref */
+} FuInputStreamChecksumsHelper;
+
+static void
+fu_input_stream_compute_checksums_update(GPtrArray *csums, const guint8 *buf, gsize bufsz)
+{
+	for (guint i = 0; i < csums->len; i++) {
+		GChecksum *csum = g_ptr_array_index(csums, i);
+		g_checksum_update(csum, buf, bufsz);
+	}
+}
+
+static gpointer
+fu_input_stream_compute_checksums_thread_cb(gpointer user_data)
+{
+	FuInputStreamChecksumsHelper *helper = (FuInputStreamChecksumsHelper *)user_data;
+
+	/* a zero sized buffer means there is nothing more to read */
+	while (TRUE) {
+		GByteArray *buf = g_async_queue_pop(helper->queue_full);
+		gsize bufsz = buf->len;
+		if (bufsz > 0)
+			fu_input_stream_compute_checksums_update(helper->csums, buf->data, bufsz);
+		g_async_queue_push(helper->queue_empty, buf);
+		if (bufsz == 0)
+			break;
+	}
+	return NULL;
+}
+
+/* composite streams can return less than requested, so keep reading until the block is full */
+static gboolean
+fu_input_stream_compute_checksums_read(GInputStream *stream,
+				       GByteArray *buf,
+				       gsize offset,
+				       gsize streamsz,
+				       GError **error)
+{
+	gsize bytes_read = 0;
+	g_byte_array_set_size(buf, MIN(streamsz - offset, FU_INPUT_STREAM_CHECKSUMS_BLOCKSZ));
+	if (!g_seekable_seek(G_SEEKABLE(stream), offset, G_SEEK_SET, NULL, error)) {
+		g_prefix_error(error, "seek to 0x%x: ", (guint)offset);
+		return FALSE;
+	}
+	if (!g_input_stream_read_all(stream, buf->data, buf->len, &bytes_read, NULL, error)) {
+		g_prefix_error(error, "failed read of 0x%x: ", (guint)buf->len);
+		return FALSE;
+	}
+	if (bytes_read != buf->len) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_READ,
+			    "requested 0x%x and got 0x%x",
+			    (guint)buf->len,
+			    (guint)bytes_read);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * fu_input_stream_compute_checksums:
+ * @stream: a #GInputStream
+ * @checksum_types: (array length=checksum_typesz): #GChecksumType values
+ * @checksum_typesz: number of @checksum_types
+ * @error: (nullable): optional return location for an error
+ *
+ * Generates several checksums of the entire stream, reading the stream only once.
+ *
+ * If the stream is larger than one block then the checksums are computed on a worker thread
+ * while the next block is being read.
+ *
+ * Returns: (transfer full): the hexadecimal representation of each checksum, in the same order
+ * as @checksum_types, or %NULL on error
+ *
+ * Since: 2.0.19
+ **/
+gchar **
+fu_input_stream_compute_checksums(GInputStream *stream,
+				  const GChecksumType *checksum_types,
+				  guint checksum_typesz,
+				  GError **error)
+{
+	FuInputStreamChecksumsHelper helper = {NULL};
+	gboolean ret = TRUE;
+	gsize offset = 0;
+	gsize streamsz = 0;
+	g_autoptr(GAsyncQueue) queue_empty = g_async_queue_new();
+	g_autoptr(GAsyncQueue) queue_full = g_async_queue_new();
+	g_autoptr(GError) error_thread = NULL;
+	g_autoptr(GPtrArray) bufs = g_ptr_array_new_with_free_func((GDestroyNotify)g_byte_array_unref);
+	g_autoptr(GPtrArray) csums = g_ptr_array_new_with_free_func((GDestroyNotify)g_checksum_free);
+	g_autoptr(GThread) thread = NULL;
+	g_auto(GStrv) checksums = NULL;
+
+	g_return_val_if_fail(G_IS_INPUT_STREAM(stream), NULL);
+	g_return_val_if_fail(checksum_types != NULL, NULL);
+	g_return_val_if_fail(error == NULL || *error == NULL, NULL);
+
+	for (guint i = 0; i < checksum_typesz; i++) {
+		GChecksum *csum = g_checksum_new(checksum_types[i]);
+		if (csum == NULL) {
+			g_set_error(error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_NOT_SUPPORTED,
+				    "checksum type %i not supported",
+				    checksum_types[i]);
+			return NULL;
+		}
+		g_ptr_array_add(csums, csum);
+	}
+	if (!fu_input_stream_size(stream, &streamsz, error))
+		return NULL;
+
+	/* one block at a time, or read the next block while the last one is hashed */
+	g_ptr_array_add(bufs, g_byte_array_sized_new(FU_INPUT_STREAM_CHECKSUMS_BLOCKSZ));
+	if (streamsz > FU_INPUT_STREAM_CHECKSUMS_BLOCKSZ) {
+		helper.csums = csums;
+		helper.queue_full = queue_full;
+		helper.queue_empty = queue_empty;
+		thread = g_thread_try_new("fu-input-stream-checksums",
+					  fu_input_stream_compute_checksums_thread_cb,
+					  &helper,
+					  &error_thread);
+		if (thread == NULL)
+			g_debug("computing checksums inline: %s", error_thread->message);
+	}
+	if (thread == NULL) {
+		GByteArray *buf = g_ptr_array_index(bufs, 0);
+		while (offset < streamsz) {
+			if (!fu_input_stream_compute_checksums_read(stream,
+								    buf,
+								    offset,
+								    streamsz,
+								    error))
+				return NULL;
+			fu_input_stream_compute_checksums_update(csums, buf->data, buf->len);
+			offset += buf->len;
+		}
+	} else {
+		g_ptr_array_add(bufs, g_byte_array_sized_new(FU_INPUT_STREAM_CHECKSUMS_BLOCKSZ));
+		for (guint i = 0; i < bufs->len; i++)
+			g_async_queue_push(queue_empty, g_ptr_array_index(bufs, i));
+		while (TRUE) {
+			GByteArray *buf = g_async_queue_pop(queue_empty);
+			if (ret && offset < streamsz) {
+				ret = fu_input_stream_compute_checksums_read(stream,
+									     buf,
+									     offset,
+									     streamsz,
+									     error);
+				if (ret) {
+					offset += buf->len;
+					g_async_queue_push(queue_full, buf);
+					continue;
+				}
+			}
+
+			/* stop the worker thread */
+			g_byte_array_set_size(buf, 0);
+			g_async_queue_push(queue_full, buf);
+			break;
+		}
+		g_thread_join(g_steal_pointer(&thread));
+		if (!ret)
+			return NULL;
+	}
+
+	/* success */
+	checksums = g_new0(gchar *, csums->len + 1);
+	for (guint i = 0; i < csums->len; i++) {
+		GChecksum *csum = g_ptr_array_index(csums, i);
+		checksums[i] = g_strdup(g_checksum_get_string(csum));
+	}
+	return g_steal_pointer(&checksums);
+}
+
 static gboolean
 fu_input_stream_compute_sum8_cb(const guint8 *buf, gsize bufsz, gpointer user_data, GError **error)
 {
@@ -663,6 +856,60 @@ fu_input_stream_compute_crc16(GInputStream *stream, FuCrcKind kind, guint16 *crc
 	return TRUE;
 }
 
+#define FU_INPUT_STREAM_CHUNKIFY_BLOCKSZ_MIN 0x8000   /* bytes */
+#define FU_INPUT_STREAM_CHUNKIFY_BLOCKSZ_MAX 0x100000 /* bytes */
+
+/* use larger blocks for larger streams, but always a power of two so that callbacks that
+ * require aligned data only ever see a short block at the very end */
+static gsize
+fu_input_stream_chunkify_get_blocksz(gsize streamsz)
+{
+	gsize blocksz = FU_INPUT_STREAM_CHUNKIFY_BLOCKSZ_MIN;
+	while (blocksz < FU_INPUT_STREAM_CHUNKIFY_BLOCKSZ_MAX && blocksz * 64 < streamsz)
+		blocksz *= 2;
+	return blocksz;
+}
+
+#if defined(HAVE_GIO_UNIX) && defined(HAVE_MMAN_H)
+static guint8 *
+fu_input_stream_chunkify_mmap(GInputStream *stream, gsize streamsz)
+{
+	gint fd = -1;
+	gpointer buf;
+	struct stat stbuf = {0};
+
+	/* only for local files that contain exactly the stream */
+	if (G_IS_UNIX_INPUT_STREAM(stream))
+		fd = g_unix_input_stream_get_fd(G_UNIX_INPUT_STREAM(stream));
+	else if (G_IS_FILE_DESCRIPTOR_BASED(stream))
+		fd = g_file_descriptor_based_get_fd(G_FILE_DESCRIPTOR_BASED(stream));
+	if (fd < 0 || streamsz == 0)
+		return NULL;
+	if (fstat(fd, &stbuf) != 0 || !S_ISREG(stbuf.st_mode) || (gsize)stbuf.st_size != streamsz)
+		return NULL;
+
+	/* another process truncating the file while it is mapped would raise SIGBUS */
+	if (stbuf.st_uid != geteuid()) {
+#ifdef F_GET_SEALS
+		gint seals = fcntl(fd, F_GET_SEALS);
+		if (seals == -1 || (seals & F_SEAL_SHRINK) == 0)
+			return NULL;
+#else
+		return NULL;
+#endif
+	}
+	buf = mmap(NULL, streamsz, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (buf == MAP_FAILED) {
+		g_debug("failed to mmap, falling back to read: %s", g_strerror(errno));
+		return NULL;
+	}
+#ifdef MADV_SEQUENTIAL
+	(void)madvise(buf, streamsz, MADV_SEQUENTIAL);
+#endif
+	return buf;
+}
+#endif
+
 /**
  * fu_input_stream_chunkify:
  * @stream: a #GInputStream
@@ -672,6 +919,10 @@ fu_input_stream_compute_crc16(GInputStream *stream, FuCrcKind kind, guint16 *crc
  *
  * Split the stream into blocks and calls a function on each chunk.
  *
+ * The same buffer is reused for every block, and local files are mapped into memory rather
+ * than copied where possible. The block size depends on the stream size, but is always a power
+ * of two and at least 32kB.
+ *
  * Returns: %TRUE for success
  *
  * Since: 2.0.0
@@ -682,25 +933,63 @@ fu_input_stream_chunkify(GInputStream *stream,
 			 gpointer user_data,
 			 GError **error)
 {
-	g_autoptr(FuChunkArray) chunks = NULL;
+	gsize blocksz;
+	gsize streamsz = 0;
+	g_autofree guint8 *buf = NULL;
 
 	g_return_val_if_fail(G_IS_INPUT_STREAM(stream), FALSE);
 	g_return_val_if_fail(func_cb != NULL, FALSE);
 	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
 
-	chunks = fu_chunk_array_new_from_stream(stream,
-						FU_CHUNK_ADDR_OFFSET_NONE,
-						FU_CHUNK_PAGESZ_NONE,
-						0x8000,
-						error);
-	if (chunks == NULL)
+	if (!fu_input_stream_size(stream, &streamsz, error))
 		return FALSE;
-	for (gsize i = 0; i < fu_chunk_array_length(chunks); i++) {
-		g_autoptr(FuChunk) chk = NULL;
-		chk = fu_chunk_array_index(chunks, i, error);
-		if (chk == NULL)
+	if (streamsz == 0)
+		return TRUE;
+	blocksz = fu_input_stream_chunkify_get_blocksz(streamsz);
+
+#if defined(HAVE_GIO_UNIX) && defined(HAVE_MMAN_H)
+	/* no copy at all */
+	buf = fu_input_stream_chunkify_mmap(stream, streamsz);
+	if (buf != NULL) {
+		gboolean ret = TRUE;
+		for (gsize offset = 0; ret && offset < streamsz; offset += blocksz) {
+			ret = func_cb(buf + offset,
+				      MIN(blocksz, streamsz - offset),
+				      user_data,
+				      error);
+		}
+		munmap(g_steal_pointer(&buf), streamsz);
+		return ret;
+	}
+#endif
+
+	/* read each block into the same buffer */
+	buf = g_malloc(MIN(blocksz, streamsz));
+	if (!g_seekable_seek(G_SEEKABLE(stream), 0x0, G_SEEK_SET, NULL, error)) {
+		g_prefix_error_literal(error, "seek to start: ");
+		return FALSE;
+	}
+	for (gsize offset = 0; offset < streamsz; offset += blocksz) {
+		gsize bufsz = MIN(blocksz, streamsz - offset);
+		gsize bytes_read = 0;
+		if (!g_input_stream_read_all(stream, buf, bufsz, &bytes_read, NULL, error)) {
+			g_prefix_error(error,
+				       "failed to get stream at 0x%x for 0x%x: ",
+				       (guint)offset,
+				       (guint)bufsz);
 			return FALSE;
-		if (!func_cb(fu_chunk_get_data(chk), fu_chunk_get_data_sz(chk), user_data, error))
+		}
+		if (bytes_read != bufsz) {
+			g_set_error(error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_READ,
+				    "requested 0x%x at 0x%x and got 0x%x",
+				    (guint)bufsz,
+				    (guint)offset,
+				    (guint)bytes_read);
+			return FALSE;
+		}
+		if (!func_cb(buf, bufsz, user_data, error))
 			return FALSE;
 	}
 	return TRUE;
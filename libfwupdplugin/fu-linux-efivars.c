@@ -23,11 +23,13 @@
 
 #include "fwupd-error.h"
 
+#include "fu-efivars-private.h"
 #include "fu-linux-efivars.h"
 #include "fu-path.h"
 
 struct _FuLinuxEfivars {
 	FuEfivars parent_instance;
+	GFileMonitor *monitor; /* of the whole directory, to invalidate the cache */
 };
 
 G_DEFINE_TYPE(FuLinuxEfivars, fu_linux_efivars, FU_TYPE_EFIVARS)
@@ -520,15 +522,67 @@ fu_linux_efivars_set_data(FuEfivars *efivars,
 	return TRUE;
 }
 
+/* the filename is Name-GUID */
+static void
+fu_linux_efivars_monitor_changed_cb(GFileMonitor *monitor,
+				    GFile *file,
+				    GFile *other_file,
+				    GFileMonitorEvent event_type,
+				    gpointer user_data)
+{
+	FuLinuxEfivars *self = FU_LINUX_EFIVARS(user_data);
+	gsize basenamesz;
+	g_autofree gchar *basename = g_file_get_basename(file);
+	g_autofree gchar *name = NULL;
+
+	basenamesz = strlen(basename);
+	if (basenamesz < 38 || basename[basenamesz - 37] != '-')
+		return;
+	name = g_strndup(basename, basenamesz - 37);
+
+	/* changed by something other than us, e.g. mokutil */
+	g_debug("%s changed, invalidating cache", basename);
+	fu_efivars_cache_invalidate(FU_EFIVARS(self), basename + basenamesz - 36, name);
+}
+
 static void
 fu_linux_efivars_init(FuLinuxEfivars *self)
 {
+	g_autofree gchar *efivarsdir = fu_linux_efivars_get_path();
+	g_autoptr(GFile) file = g_file_new_for_path(efivarsdir);
+	g_autoptr(GError) error_local = NULL;
+
+	/* one monitor for all the variables, rather than one per cached variable */
+	self->monitor = g_file_monitor_directory(file, G_FILE_MONITOR_NONE, NULL, &error_local);
+	if (self->monitor == NULL) {
+		g_debug("not caching efivars: %s", error_local->message);
+		fu_efivars_cache_disable(FU_EFIVARS(self));
+		return;
+	}
+	g_signal_connect(self->monitor,
+			 "changed",
+			 G_CALLBACK(fu_linux_efivars_monitor_changed_cb),
+			 self);
+}
+
+static void
+fu_linux_efivars_finalize(GObject *object)
+{
+	FuLinuxEfivars *self = FU_LINUX_EFIVARS(object);
+	if (self->monitor != NULL) {
+		g_signal_handlers_disconnect_by_data(self->monitor, self);
+		g_file_monitor_cancel(self->monitor);
+		g_object_unref(self->monitor);
+	}
+	G_OBJECT_CLASS(fu_linux_efivars_parent_class)->finalize(object);
 }
 
 static void
 fu_linux_efivars_class_init(FuLinuxEfivarsClass *klass)
 {
+	GObjectClass *object_class = G_OBJECT_CLASS(klass);
 	FuEfivarsClass *efivars_class = FU_EFIVARS_CLASS(klass);
+	object_class->finalize = fu_linux_efivars_finalize;
 	efivars_class->supported = fu_linux_efivars_supported;
 	efivars_class->space_used = fu_linux_efivars_space_used;
 	efivars_class->space_free = fu_linux_efivars_space_free;
@@ -43,6 +43,7 @@ typedef struct {
 	gboolean done_init;
 	GPtrArray *rules[FU_PLUGIN_RULE_LAST];
 	GPtrArray *devices; /* (nullable) (element-type FuDevice) */
+	GMutex devices_mutex; /* for @devices when added from a coldplug worker thread */
 	GHashTable *runtime_versions;
 	GHashTable *compile_versions;
 	FuContext *ctx;
@@ -496,8 +497,10 @@ fu_plugin_device_add(FuPlugin *self, FuDevice *device)
 	}
 
 	/* add to array */
+	g_mutex_lock(&priv->devices_mutex);
 	fu_plugin_ensure_devices(self);
 	g_ptr_array_add(priv->devices, g_object_ref(device));
+	g_mutex_unlock(&priv->devices_mutex);
 
 	/* proxy to device where required */
 	if (fu_plugin_has_flag(self, FWUPD_PLUGIN_FLAG_CLEAR_UPDATABLE)) {
@@ -612,8 +615,10 @@ fu_plugin_device_remove(FuPlugin *self, FuDevice *device)
 	g_signal_emit(self, signals[SIGNAL_DEVICE_REMOVED], 0, device);
 
 	/* remove from array */
+	g_mutex_lock(&priv->devices_mutex);
 	if (priv->devices != NULL)
 		g_ptr_array_remove(priv->devices, device);
+	g_mutex_unlock(&priv->devices_mutex);
 }
 
 /**
@@ -3045,6 +3050,7 @@ fu_plugin_init(FuPlugin *self)
 {
 	FuPluginPrivate *priv = GET_PRIVATE(self);
 	priv->device_gtype_default = G_TYPE_INVALID;
+	g_mutex_init(&priv->devices_mutex);
 }
 
 static void
@@ -3066,6 +3072,7 @@ fu_plugin_finalize(GObject *object)
 	}
 	if (priv->devices != NULL)
 		g_ptr_array_unref(priv->devices);
+	g_mutex_clear(&priv->devices_mutex);
 	if (priv->runtime_versions != NULL)
 		g_hash_table_unref(priv->runtime_versions);
 	if (priv->compile_versions != NULL)
@@ -0,0 +1,402 @@
+/*
+ * Copyright 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#define G_LOG_DOMAIN "FuPollScheduler"
+
+#include "config.h"
+
+#include "fu-device-private.h"
+#include "fu-poll-scheduler.h"
+
+/**
+ * FuPollScheduler:
+ *
+ * Polls devices using a single timer wheel, so that devices with related poll intervals share the
+ * same wakeup rather than each waking the process on their own phase.
+ *
+ * See also: [method@FuDevice.set_poll_interval]
+ */
+
+#define FU_POLL_SCHEDULER_SLOTS	       512 /* ticks, ~51s */
+#define FU_POLL_SCHEDULER_FAILURES_MAX 3
+
+typedef struct {
+	FuDevice *device; /* no-ref */
+	guint64 interval; /* ticks */
+	guint64 due;	  /* tick, or 0 if not in the wheel */
+	guint64 due_last; /* tick the last poll was due at */
+	guint failures;
+} FuPollSchedulerItem;
+
+struct _FuPollScheduler {
+	GObject parent_instance;
+	GMutex mutex; /* for items, slots and timeout, as devices are added from coldplug threads */
+	GHashTable *items; /* FuDevice:FuPollSchedulerItem */
+	GPtrArray *slots[FU_POLL_SCHEDULER_SLOTS]; /* element-type FuPollSchedulerItem, no-ref */
+	guint64 tick_last;			   /* last tick processed */
+	guint64 timeout_tick;
+	guint timeout_id;
+	GArray *wakeups; /* of gint64, monotonic us */
+};
+
+G_DEFINE_TYPE(FuPollScheduler, fu_poll_scheduler, G_TYPE_OBJECT)
+
+static guint64
+fu_poll_scheduler_get_tick(void)
+{
+	return g_get_monotonic_time() / (FU_POLL_SCHEDULER_TICK_MS * 1000);
+}
+
+/* devices sharing a parent or proxy also share a transport */
+static FuDevice *
+fu_poll_scheduler_get_group(FuDevice *device)
+{
+	FuDevice *parent = fu_device_get_parent_internal(device);
+	if (parent != NULL)
+		return parent;
+	if (fu_device_get_proxy_internal(device) != NULL)
+		return fu_device_get_proxy_internal(device);
+	return device;
+}
+
+static void
+fu_poll_scheduler_slot_remove(FuPollScheduler *self, FuPollSchedulerItem *item)
+{
+	if (item->due == 0)
+		return;
+	g_ptr_array_remove_fast(self->slots[item->due % FU_POLL_SCHEDULER_SLOTS], item);
+	item->due_last = item->due;
+	item->due = 0;
+}
+
+/* align to the interval so that devices with related intervals share the same wakeup, and
+ * never before the tick the device was polled early for */
+static void
+fu_poll_scheduler_slot_insert(FuPollScheduler *self, FuPollSchedulerItem *item, guint64 tick)
+{
+	guint64 interval = item->interval << MIN(item->failures, FU_POLL_SCHEDULER_FAILURES_MAX);
+	tick = MAX(tick, item->due_last);
+	item->due = ((tick / interval) + 1) * interval;
+	g_ptr_array_add(self->slots[item->due % FU_POLL_SCHEDULER_SLOTS], item);
+}
+
+static gboolean
+fu_poll_scheduler_timeout_cb(gpointer user_data);
+
+static void
+fu_poll_scheduler_rearm(FuPollScheduler *self)
+{
+	guint64 tick_now = fu_poll_scheduler_get_tick();
+	guint64 tick_next = tick_now + FU_POLL_SCHEDULER_SLOTS;
+	gint64 delay;
+
+	if (self->timeout_id != 0) {
+		g_source_remove(self->timeout_id);
+		self->timeout_id = 0;
+	}
+	if (g_hash_table_size(self->items) == 0)
+		return;
+
+	/* find the next occupied slot, ignoring items more than one rotation away */
+	for (guint64 tick = tick_now + 1; tick < tick_now + FU_POLL_SCHEDULER_SLOTS; tick++) {
+		GPtrArray *slot = self->slots[tick % FU_POLL_SCHEDULER_SLOTS];
+		for (guint i = 0; i < slot->len; i++) {
+			FuPollSchedulerItem *item = g_ptr_array_index(slot, i);
+			if (item->due <= tick) {
+				tick_next = tick;
+				break;
+			}
+		}
+		if (tick_next == tick)
+			break;
+	}
+	delay = ((gint64)tick_next * FU_POLL_SCHEDULER_TICK_MS * 1000 - g_get_monotonic_time()) /
+		1000;
+	self->timeout_tick = tick_next;
+	self->timeout_id =
+	    g_timeout_add((guint)MAX(delay, 0) + 1, fu_poll_scheduler_timeout_cb, self);
+}
+
+static gint
+fu_poll_scheduler_sort_cb(gconstpointer a, gconstpointer b)
+{
+	FuDevice *device1 = *((FuDevice **)a);
+	FuDevice *device2 = *((FuDevice **)b);
+	FuDevice *group1 = fu_poll_scheduler_get_group(device1);
+	FuDevice *group2 = fu_poll_scheduler_get_group(device2);
+
+	/* keep each group together, with the parent first */
+	if (group1 != group2)
+		return GPOINTER_TO_SIZE(group1) < GPOINTER_TO_SIZE(group2) ? -1 : 1;
+	if (device1 == group1)
+		return -1;
+	if (device2 == group2)
+		return 1;
+	return 0;
+}
+
+static gboolean
+fu_poll_scheduler_is_paused(FuDevice *device)
+{
+	FuDevice *group = fu_poll_scheduler_get_group(device);
+	if (fu_device_poll_is_paused(device))
+		return TRUE;
+	return group != device && fu_device_poll_is_paused(group);
+}
+
+static void
+fu_poll_scheduler_poll(FuPollScheduler *self, FuDevice *device, guint64 tick_now)
+{
+	FuPollSchedulerItem *item;
+	gboolean ret = TRUE;
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GMutexLocker) locker = NULL;
+
+	/* device is being detached, written, read, or attached */
+	if (fu_poll_scheduler_is_paused(device)) {
+		g_debug("ignoring poll callback as an action is in progress");
+	} else {
+		ret = fu_device_poll(device, &error_local);
+	}
+
+	/* the poll may have removed the device or set a new interval */
+	locker = g_mutex_locker_new(&self->mutex);
+	item = g_hash_table_lookup(self->items, device);
+	if (item == NULL || item->due != 0)
+		return;
+
+	/* back off devices that keep failing */
+	if (!ret) {
+		item->failures++;
+		if (item->failures >= FU_POLL_SCHEDULER_FAILURES_MAX) {
+			g_warning("disabling polling: %s", error_local->message);
+			g_hash_table_remove(self->items, device);
+			return;
+		}
+		g_debug("backing off polling: %s", error_local->message);
+	} else {
+		item->failures = 0;
+	}
+	fu_poll_scheduler_slot_insert(self, item, tick_now);
+}
+
+static gboolean
+fu_poll_scheduler_timeout_cb(gpointer user_data)
+{
+	FuPollScheduler *self = FU_POLL_SCHEDULER(user_data);
+	GHashTableIter iter;
+	FuPollSchedulerItem *item = NULL;
+	gint64 now = g_get_monotonic_time();
+	guint64 tick_now = fu_poll_scheduler_get_tick();
+	guint64 tick_start = self->tick_last + 1;
+	g_autoptr(GHashTable) groups = g_hash_table_new(NULL, NULL);
+	g_autoptr(GPtrArray) devices = g_ptr_array_new_with_free_func(g_object_unref);
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new(&self->mutex); /* unref devices after */
+
+	self->timeout_id = 0;
+
+	/* collect everything that expired since the last wakeup, visiting each slot at most once */
+	if (tick_now >= FU_POLL_SCHEDULER_SLOTS)
+		tick_start = MAX(tick_start, tick_now - FU_POLL_SCHEDULER_SLOTS + 1);
+	for (guint64 tick = tick_start; tick <= tick_now; tick++) {
+		GPtrArray *slot = self->slots[tick % FU_POLL_SCHEDULER_SLOTS];
+		for (guint i = 0; i < slot->len;) {
+			item = g_ptr_array_index(slot, i);
+			if (item->due > tick_now) {
+				i++;
+				continue;
+			}
+			g_ptr_array_remove_index_fast(slot, i);
+			item->due_last = item->due;
+			item->due = 0;
+			g_ptr_array_add(devices, g_object_ref(item->device));
+			g_hash_table_add(groups, fu_poll_scheduler_get_group(item->device));
+		}
+	}
+	self->tick_last = tick_now;
+
+	/* the transport is already awake, so also poll siblings that are due soon */
+	g_hash_table_iter_init(&iter, self->items);
+	while (g_hash_table_iter_next(&iter, NULL, (gpointer *)&item)) {
+		if (item->due == 0 || item->due - tick_now > item->interval / 4)
+			continue;
+		if (!g_hash_table_contains(groups, fu_poll_scheduler_get_group(item->device)))
+			continue;
+		fu_poll_scheduler_slot_remove(self, item);
+		g_ptr_array_add(devices, g_object_ref(item->device));
+	}
+
+	/* poll each group together, without the lock as the poll may add or remove devices */
+	g_ptr_array_sort(devices, fu_poll_scheduler_sort_cb);
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *device = g_ptr_array_index(devices, i);
+		gboolean ret;
+		ret = g_hash_table_contains(self->items, device);
+		g_mutex_unlock(&self->mutex);
+		if (ret)
+			fu_poll_scheduler_poll(self, device, tick_now);
+		g_mutex_lock(&self->mutex);
+	}
+
+	/* only keep the last minute */
+	g_array_append_val(self->wakeups, now);
+	while (self->wakeups->len > 0 &&
+	       g_array_index(self->wakeups, gint64, 0) < now - 60 * G_USEC_PER_SEC)
+		g_array_remove_index(self->wakeups, 0);
+	g_debug("polled %u devices in %u groups, %u wakeups in the last minute",
+		devices->len,
+		g_hash_table_size(groups),
+		self->wakeups->len);
+
+	fu_poll_scheduler_rearm(self);
+	return G_SOURCE_REMOVE;
+}
+
+static void
+fu_poll_scheduler_remove_item(FuPollScheduler *self, FuDevice *device)
+{
+	FuPollSchedulerItem *item = g_hash_table_lookup(self->items, device);
+	if (item == NULL)
+		return;
+	fu_poll_scheduler_slot_remove(self, item);
+	g_hash_table_remove(self->items, device);
+	if (g_hash_table_size(self->items) == 0 && self->timeout_id != 0) {
+		g_source_remove(self->timeout_id);
+		self->timeout_id = 0;
+	}
+}
+
+/**
+ * fu_poll_scheduler_add:
+ * @self: a #FuPollScheduler
+ * @device: a #FuDevice
+ * @interval: duration in ms
+ *
+ * Polls the device every interval period, rounded to the scheduler tick. If the device is already
+ * being polled then the interval is updated.
+ *
+ * Since: 2.0.19
+ **/
+void
+fu_poll_scheduler_add(FuPollScheduler *self, FuDevice *device, guint interval)
+{
+	FuPollSchedulerItem *item;
+	guint64 tick_now = fu_poll_scheduler_get_tick();
+	g_autoptr(GMutexLocker) locker = NULL;
+
+	g_return_if_fail(FU_IS_POLL_SCHEDULER(self));
+	g_return_if_fail(FU_IS_DEVICE(device));
+
+	locker = g_mutex_locker_new(&self->mutex);
+	fu_poll_scheduler_remove_item(self, device);
+	item = g_new0(FuPollSchedulerItem, 1);
+	if (g_hash_table_size(self->items) == 0)
+		self->tick_last = tick_now;
+	item->device = device;
+	item->interval =
+	    MAX((interval + FU_POLL_SCHEDULER_TICK_MS / 2) / FU_POLL_SCHEDULER_TICK_MS, 1);
+	g_hash_table_insert(self->items, device, item);
+	fu_poll_scheduler_slot_insert(self, item, tick_now);
+
+	/* the existing timeout fires early enough */
+	if (self->timeout_id != 0 && item->due >= self->timeout_tick)
+		return;
+	fu_poll_scheduler_rearm(self);
+}
+
+/**
+ * fu_poll_scheduler_remove:
+ * @self: a #FuPollScheduler
+ * @device: a #FuDevice
+ *
+ * Stops polling the device. It is safe to call this function on a device that is not polled.
+ *
+ * Since: 2.0.19
+ **/
+void
+fu_poll_scheduler_remove(FuPollScheduler *self, FuDevice *device)
+{
+	g_autoptr(GMutexLocker) locker = NULL;
+
+	g_return_if_fail(FU_IS_POLL_SCHEDULER(self));
+	g_return_if_fail(FU_IS_DEVICE(device));
+
+	locker = g_mutex_locker_new(&self->mutex);
+	fu_poll_scheduler_remove_item(self, device);
+}
+
+/**
+ * fu_poll_scheduler_get_wakeups:
+ * @self: a #FuPollScheduler
+ *
+ * Gets the number of times the scheduler woke up to poll devices in the last minute.
+ *
+ * Returns: integer
+ *
+ * Since: 2.0.19
+ **/
+guint
+fu_poll_scheduler_get_wakeups(FuPollScheduler *self)
+{
+	gint64 now = g_get_monotonic_time();
+	guint cnt = 0;
+	g_autoptr(GMutexLocker) locker = NULL;
+
+	g_return_val_if_fail(FU_IS_POLL_SCHEDULER(self), G_MAXUINT);
+
+	locker = g_mutex_locker_new(&self->mutex);
+	for (guint i = 0; i < self->wakeups->len; i++) {
+		if (g_array_index(self->wakeups, gint64, i) >= now - 60 * G_USEC_PER_SEC)
+			cnt++;
+	}
+	return cnt;
+}
+
+static void
+fu_poll_scheduler_init(FuPollScheduler *self)
+{
+	g_mutex_init(&self->mutex);
+	self->items = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+	for (guint i = 0; i < FU_POLL_SCHEDULER_SLOTS; i++)
+		self->slots[i] = g_ptr_array_new();
+	self->wakeups = g_array_new(FALSE, FALSE, sizeof(gint64));
+}
+
+static void
+fu_poll_scheduler_finalize(GObject *obj)
+{
+	FuPollScheduler *self = FU_POLL_SCHEDULER(obj);
+	if (self->timeout_id != 0)
+		g_source_remove(self->timeout_id);
+	for (guint i = 0; i < FU_POLL_SCHEDULER_SLOTS; i++)
+		g_ptr_array_unref(self->slots[i]);
+	g_hash_table_unref(self->items);
+	g_array_unref(self->wakeups);
+	g_mutex_clear(&self->mutex);
+	G_OBJECT_CLASS(fu_poll_scheduler_parent_class)->finalize(obj);
+}
+
+static void
+fu_poll_scheduler_class_init(FuPollSchedulerClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS(klass);
+	object_class->finalize = fu_poll_scheduler_finalize;
+}
+
+/**
+ * fu_poll_scheduler_new:
+ *
+ * Creates a new poll scheduler.
+ *
+ * Returns: (transfer full): a #FuPollScheduler
+ *
+ * Since: 2.0.19
+ **/
+FuPollScheduler *
+fu_poll_scheduler_new(void)
+{
+	return g_object_new(FU_TYPE_POLL_SCHEDULER, NULL);
+}
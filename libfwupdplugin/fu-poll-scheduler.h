@@ -0,0 +1,25 @@
+/*
+ * Copyright 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#pragma once
+
+#include "fu-device.h"
+
+#define FU_TYPE_POLL_SCHEDULER (fu_poll_scheduler_get_type())
+G_DECLARE_FINAL_TYPE(FuPollScheduler, fu_poll_scheduler, FU, POLL_SCHEDULER, GObject)
+
+/* intervals shorter than this are not worth coalescing */
+#define FU_POLL_SCHEDULER_TICK_MS 100
+
+FuPollScheduler *
+fu_poll_scheduler_new(void) G_GNUC_WARN_UNUSED_RESULT;
+void
+fu_poll_scheduler_add(FuPollScheduler *self, FuDevice *device, guint interval)
+    G_GNUC_NON_NULL(1, 2);
+void
+fu_poll_scheduler_remove(FuPollScheduler *self, FuDevice *device) G_GNUC_NON_NULL(1, 2);
+guint
+fu_poll_scheduler_get_wakeups(FuPollScheduler *self) G_GNUC_NON_NULL(1);
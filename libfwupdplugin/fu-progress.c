@@ -61,6 +61,7 @@ struct _FuProgress {
 	GObject parent_instance;
 	gchar *id;
 	gchar *name;
+	gchar *device_id;
 	FuProgressFlags flags;
 	guint percentage;
 	FwupdStatus status;
@@ -68,6 +69,7 @@ struct _FuProgress {
 	gboolean profile;
 	gboolean any_child_has_step_weighting;
 	gdouble duration; /* seconds */
+	gint64 time_start; /* monotonic, us */
 	gdouble global_fraction;
 	guint step_weighting;
 	GTimer *timer;
@@ -182,6 +184,47 @@ fu_progress_set_name(FuProgress *self, const gchar *name)
 	self->name = g_strdup(name);
 }
 
+/**
+ * fu_progress_get_device_id:
+ * @self: a #FuProgress
+ *
+ * Return the ID of the device this progress is operating on.
+ *
+ * Returns: device ID, or %NULL if unset
+ *
+ * Since: 2.0.19
+ **/
+const gchar *
+fu_progress_get_device_id(FuProgress *self)
+{
+	g_return_val_if_fail(FU_IS_PROGRESS(self), NULL);
+	return self->device_id;
+}
+
+/**
+ * fu_progress_set_device_id:
+ * @self: a #FuProgress
+ * @device_id: (nullable): a device ID, e.g. `362301da643102b9f38477387e2193e57abaa590`
+ *
+ * Sets the ID of the device this progress is operating on, which is included when exporting
+ * a trace.
+ *
+ * Since: 2.0.19
+ **/
+void
+fu_progress_set_device_id(FuProgress *self, const gchar *device_id)
+{
+	g_return_if_fail(FU_IS_PROGRESS(self));
+
+	/* not changed */
+	if (g_strcmp0(self->device_id, device_id) == 0)
+		return;
+
+	/* set device ID */
+	g_free(self->device_id);
+	self->device_id = g_strdup(device_id);
+}
+
 /**
  * fu_progress_get_status:
  * @self: a #FuProgress
@@ -407,8 +450,9 @@ fu_progress_set_percentage_full(FuProgress *self, gsize progress_done, gsize pro
  * @self: A #FuProgress
  * @profile: if profiling should be enabled
  *
- * This enables profiling of FuProgress. This may be useful in development,
- * but be warned; enabling profiling makes #FuProgress very slow.
+ * This enables profiling of FuProgress and any steps that have already been added.
+ * This may be useful in development, but be warned; enabling profiling makes #FuProgress
+ * very slow.
  *
  * Since: 1.7.0
  **/
@@ -417,6 +461,10 @@ fu_progress_set_profile(FuProgress *self, gboolean profile)
 {
 	g_return_if_fail(FU_IS_PROGRESS(self));
 	self->profile = profile;
+	for (guint i = 0; i < self->children->len; i++) {
+		FuProgress *child = g_ptr_array_index(self->children, i);
+		fu_progress_set_profile(child, profile);
+	}
 }
 
 /**
@@ -452,6 +500,7 @@ fu_progress_reset(FuProgress *self)
 	/* reset values */
 	self->step_now = 0;
 	self->percentage = G_MAXUINT;
+	self->time_start = g_get_monotonic_time();
 
 	/* only use the timer if profiling; it's expensive */
 	if (self->profile) {
@@ -903,9 +952,10 @@ fu_progress_step_done(FuProgress *self)
 	/* another */
 	self->step_now++;
 
-	/* update status */
+	/* update status, and the next step is now active */
 	if (self->step_now < self->children->len) {
 		FuProgress *child_tmp = g_ptr_array_index(self->children, self->step_now);
+		child_tmp->time_start = g_get_monotonic_time();
 		if (fu_progress_get_status(child_tmp) != FWUPD_STATUS_UNKNOWN)
 			fu_progress_set_status(self, fu_progress_get_status(child_tmp));
 	} else if (self->parent != NULL) {
@@ -1019,6 +1069,84 @@ fu_progress_traceback(FuProgress *self)
 	return g_string_free(g_steal_pointer(&str), FALSE);
 }
 
+static const gchar *
+fu_progress_get_trace_name(FuProgress *self)
+{
+	if (self->name != NULL)
+		return self->name;
+	if (self->id != NULL)
+		return self->id;
+	return fwupd_status_to_string(self->status);
+}
+
+static void
+fu_progress_add_trace_event(FuProgress *self, JsonBuilder *builder, const gchar *ph, gint64 ts)
+{
+	json_builder_begin_object(builder);
+	fwupd_codec_json_append(builder, "name", fu_progress_get_trace_name(self));
+	fwupd_codec_json_append(builder, "cat", "fwupd");
+	fwupd_codec_json_append(builder, "ph", ph);
+	fwupd_codec_json_append_int(builder, "ts", ts);
+	fwupd_codec_json_append_int(builder, "pid", 1);
+	fwupd_codec_json_append_int(builder, "tid", 1);
+	if (g_strcmp0(ph, "B") == 0) {
+		json_builder_set_member_name(builder, "args");
+		json_builder_begin_object(builder);
+		fwupd_codec_json_append(builder, "id", self->id);
+		fwupd_codec_json_append(builder, "device_id", self->device_id);
+		if (self->status != FWUPD_STATUS_UNKNOWN)
+			fwupd_codec_json_append(builder,
+						"status",
+						fwupd_status_to_string(self->status));
+		json_builder_end_object(builder);
+	}
+	json_builder_end_object(builder);
+}
+
+static gint64
+fu_progress_add_trace_events_cb(FuProgress *self, JsonBuilder *builder, gint64 ts_min)
+{
+	gint64 ts_start = MAX(self->time_start, ts_min);
+	gint64 ts_end = ts_start + (gint64)(self->duration * G_USEC_PER_SEC);
+	gint64 ts_child = ts_start;
+
+	/* spans have to be well nested, so siblings never overlap and the parent always encloses
+	 * the children, even if the parent is not finished */
+	fu_progress_add_trace_event(self, builder, "B", ts_start);
+	for (guint i = 0; i < self->children->len; i++) {
+		FuProgress *child = g_ptr_array_index(self->children, i);
+		if (child->flags & FU_PROGRESS_FLAG_NO_TRACEBACK)
+			continue;
+		if (child->children->len == 0 && fu_progress_get_duration(child) < 0.0001)
+			continue;
+		ts_child = fu_progress_add_trace_events_cb(child, builder, ts_child);
+	}
+	ts_end = MAX(ts_end, ts_child);
+	fu_progress_add_trace_event(self, builder, "E", ts_end);
+	return ts_end;
+}
+
+/**
+ * fu_progress_add_trace_events:
+ * @self: A #FuProgress
+ * @builder: a #JsonBuilder with an open array
+ *
+ * Adds nested begin and end events for this progress and all completed child steps, using the
+ * Chrome trace event format. The output can be loaded into Perfetto or `chrome://tracing`.
+ *
+ * Profiling has to be enabled using fu_progress_set_profile() for the step durations to be
+ * recorded.
+ *
+ * Since: 2.0.19
+ **/
+void
+fu_progress_add_trace_events(FuProgress *self, JsonBuilder *builder)
+{
+	g_return_if_fail(FU_IS_PROGRESS(self));
+	g_return_if_fail(JSON_IS_BUILDER(builder));
+	fu_progress_add_trace_events_cb(self, builder, 0);
+}
+
 static void
 fu_progress_add_string(FwupdCodec *codec, guint idt, GString *str)
 {
@@ -1030,6 +1158,7 @@ fu_progress_add_string(FwupdCodec *codec, guint idt, GString *str)
 
 	fwupd_codec_string_append(str, idt, "Id", self->id);
 	fwupd_codec_string_append(str, idt, "Name", self->name);
+	fwupd_codec_string_append(str, idt, "DeviceId", self->device_id);
 	if (self->percentage != G_MAXUINT)
 		fwupd_codec_string_append_int(str, idt, "Percentage", self->percentage);
 	if (self->status != FWUPD_STATUS_UNKNOWN)
@@ -1061,6 +1190,7 @@ fu_progress_init(FuProgress *self)
 	self->children = g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
 	self->duration = 0.f;
 	self->global_fraction = 1.f;
+	self->time_start = g_get_monotonic_time();
 }
 
 static void
@@ -1075,6 +1205,7 @@ fu_progress_finalize(GObject *object)
 	fu_progress_reset(self);
 	g_free(self->id);
 	g_free(self->name);
+	g_free(self->device_id);
 	g_ptr_array_unref(self->children);
 	g_timer_destroy(self->timer);
 	g_timer_destroy(self->timer_child);
@@ -24,6 +24,10 @@ const gchar *
 fu_progress_get_name(FuProgress *self) G_GNUC_NON_NULL(1);
 void
 fu_progress_set_name(FuProgress *self, const gchar *name) G_GNUC_NON_NULL(1, 2);
+const gchar *
+fu_progress_get_device_id(FuProgress *self) G_GNUC_NON_NULL(1);
+void
+fu_progress_set_device_id(FuProgress *self, const gchar *device_id) G_GNUC_NON_NULL(1);
 void
 fu_progress_add_flag(FuProgress *self, FuProgressFlags flag) G_GNUC_NON_NULL(1);
 void
@@ -67,3 +71,5 @@ void
 fu_progress_sleep(FuProgress *self, guint delay_ms) G_GNUC_NON_NULL(1);
 gchar *
 fu_progress_traceback(FuProgress *self) G_GNUC_NON_NULL(1);
+void
+fu_progress_add_trace_events(FuProgress *self, JsonBuilder *builder) G_GNUC_NON_NULL(1, 2);
@@ -78,8 +78,13 @@ struct _FuQuirks {
 	XbQuery *query_kv;
 	XbQuery *query_vs;
 	gboolean verbose;
+	GMutex cache_mutex;
+	GHashTable *cache_kv;	      /* guid:key → value, or FU_QUIRKS_CACHE_MISS */
+	GHashTable *cache_guid_miss; /* guid with no entries at all */
 #ifdef HAVE_SQLITE
 	sqlite3 *db;
+	sqlite3_stmt *stmt_kv;
+	sqlite3_stmt *stmt_vs;
 #endif
 };
 
@@ -89,6 +94,12 @@ G_DEFINE_TYPE(FuQuirks, fu_quirks, G_TYPE_OBJECT)
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(sqlite3_stmt, sqlite3_finalize);
 #endif
 
+/* used as the cached value when a key does not exist */
+#define FU_QUIRKS_CACHE_MISS ((gpointer) "")
+
+/* most devices add a dozen instance IDs, each looked up a few times during probe */
+#define FU_QUIRKS_CACHE_SIZE_MAX 8192
+
 static gchar *
 fu_quirks_build_group_key(const gchar *group)
 {
@@ -350,6 +361,64 @@ fu_quirks_strcasecmp_cb(gconstpointer a, gconstpointer b)
 	return g_ascii_strcasecmp(entry1, entry2);
 }
 
+static void
+fu_quirks_cache_invalidate(FuQuirks *self)
+{
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new(&self->cache_mutex);
+	g_hash_table_remove_all(self->cache_kv);
+	g_hash_table_remove_all(self->cache_guid_miss);
+}
+
+static gboolean
+fu_quirks_cache_lookup(FuQuirks *self, const gchar *cache_key, const gchar **value)
+{
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new(&self->cache_mutex);
+	return g_hash_table_lookup_extended(self->cache_kv, cache_key, NULL, (gpointer *)value);
+}
+
+static void
+fu_quirks_cache_add(FuQuirks *self, gchar *cache_key, const gchar *value)
+{
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new(&self->cache_mutex);
+	if (g_hash_table_size(self->cache_kv) > FU_QUIRKS_CACHE_SIZE_MAX)
+		g_hash_table_remove_all(self->cache_kv);
+	g_hash_table_insert(self->cache_kv,
+			    cache_key,
+			    value != NULL ? (gpointer)value : FU_QUIRKS_CACHE_MISS);
+}
+
+static gboolean
+fu_quirks_cache_has_guid_miss(FuQuirks *self, const gchar *guid)
+{
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new(&self->cache_mutex);
+	return g_hash_table_contains(self->cache_guid_miss, guid);
+}
+
+static void
+fu_quirks_cache_add_guid_miss(FuQuirks *self, const gchar *guid)
+{
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new(&self->cache_mutex);
+	if (g_hash_table_size(self->cache_guid_miss) > FU_QUIRKS_CACHE_SIZE_MAX)
+		g_hash_table_remove_all(self->cache_guid_miss);
+	g_hash_table_add(self->cache_guid_miss, g_strdup(guid));
+}
+
+#ifdef HAVE_SQLITE
+/* prepared once as every device does dozens of lookups -- reset by the caller after use */
+static sqlite3_stmt *
+fu_quirks_db_ensure_stmt(FuQuirks *self, sqlite3_stmt **stmt, const gchar *sql)
+{
+	if (*stmt != NULL)
+		return *stmt;
+	if (sqlite3_prepare_v3(self->db, sql, -1, SQLITE_PREPARE_PERSISTENT, stmt, NULL) !=
+	    SQLITE_OK) {
+		g_warning("failed to prepare SQL: %s", sqlite3_errmsg(self->db));
+		return NULL;
+	}
+	return *stmt;
+}
+#endif
+
 static gboolean
 fu_quirks_check_silo(FuQuirks *self, GError **error)
 {
@@ -364,6 +433,9 @@ fu_quirks_check_silo(FuQuirks *self, GError **error)
 	if (self->silo != NULL && xb_silo_is_valid(self->silo))
 		return TRUE;
 
+	/* anything cached may be stale */
+	fu_quirks_cache_invalidate(self);
+
 	/* system datadir */
 	builder = xb_builder_new();
 	datadir = fu_path_from_kind(FU_PATH_KIND_DATADIR_QUIRKS);
@@ -443,49 +515,35 @@ fu_quirks_check_silo(FuQuirks *self, GError **error)
 	return TRUE;
 }
 
-/**
- * fu_quirks_lookup_by_id:
- * @self: a #FuQuirks
- * @guid: GUID to lookup
- * @key: an ID to match the entry, e.g. `Name`
- *
- * Looks up an entry in the hardware database using a string value.
- *
- * Returns: (transfer none): values from the database, or %NULL if not found
- *
- * Since: 1.0.1
- **/
-const gchar *
-fu_quirks_lookup_by_id(FuQuirks *self, const gchar *guid, const gchar *key)
+static const gchar *
+fu_quirks_lookup_by_id_uncached(FuQuirks *self, const gchar *guid, const gchar *key)
 {
 	g_autoptr(GError) error = NULL;
 	g_autoptr(XbNode) n = NULL;
 	g_auto(XbQueryContext) context = XB_QUERY_CONTEXT_INIT();
 
-	g_return_val_if_fail(FU_IS_QUIRKS(self), NULL);
-	g_return_val_if_fail(guid != NULL, NULL);
-	g_return_val_if_fail(key != NULL, NULL);
-
 #ifdef HAVE_SQLITE
 	/* this is generated from usb.ids and other static sources */
 	if (self->db != NULL && (self->load_flags & FU_QUIRKS_LOAD_FLAG_NO_CACHE) == 0) {
-		g_autoptr(sqlite3_stmt) stmt = NULL;
-		if (sqlite3_prepare_v2(self->db,
-				       "SELECT key, value FROM quirks WHERE guid = ?1 "
-				       "AND key = ?2 LIMIT 1",
-				       -1,
-				       &stmt,
-				       NULL) != SQLITE_OK) {
-			g_warning("failed to prepare SQL: %s", sqlite3_errmsg(self->db));
+		g_autoptr(GMutexLocker) locker = g_mutex_locker_new(&self->cache_mutex);
+		const gchar *value = NULL;
+		sqlite3_stmt *stmt =
+		    fu_quirks_db_ensure_stmt(self,
+					     &self->stmt_kv,
+					     "SELECT key, value FROM quirks WHERE guid = ?1 "
+					     "AND key = ?2");
+		if (stmt == NULL)
 			return NULL;
-		}
 		sqlite3_bind_text(stmt, 1, guid, -1, SQLITE_STATIC);
 		sqlite3_bind_text(stmt, 2, key, -1, SQLITE_STATIC);
 		if (sqlite3_step(stmt) == SQLITE_ROW) {
-			const gchar *value = (const gchar *)sqlite3_column_text(stmt, 1);
-			if (value != NULL)
-				return g_intern_string(value);
+			const gchar *tmp = (const gchar *)sqlite3_column_text(stmt, 1);
+			if (tmp != NULL)
+				value = g_intern_string(tmp);
 		}
+		sqlite3_reset(stmt);
+		if (value != NULL)
+			return value;
 	}
 #endif
 
@@ -517,6 +575,46 @@ fu_quirks_lookup_by_id(FuQuirks *self, const gchar *guid, const gchar *key)
 	return xb_node_get_text(n);
 }
 
+/**
+ * fu_quirks_lookup_by_id:
+ * @self: a #FuQuirks
+ * @guid: GUID to lookup
+ * @key: an ID to match the entry, e.g. `Name`
+ *
+ * Looks up an entry in the hardware database using a string value.
+ *
+ * Returns: (transfer none): values from the database, or %NULL if not found
+ *
+ * Since: 1.0.1
+ **/
+const gchar *
+fu_quirks_lookup_by_id(FuQuirks *self, const gchar *guid, const gchar *key)
+{
+	const gchar *value = NULL;
+	g_autofree gchar *cache_key = NULL;
+
+	g_return_val_if_fail(FU_IS_QUIRKS(self), NULL);
+	g_return_val_if_fail(guid != NULL, NULL);
+	g_return_val_if_fail(key != NULL, NULL);
+
+	/* the silo has changed, so the cached values may be stale */
+	if (self->silo != NULL && !xb_silo_is_valid(self->silo))
+		fu_quirks_cache_invalidate(self);
+
+	/* nothing at all for this GUID */
+	if (fu_quirks_cache_has_guid_miss(self, guid))
+		return NULL;
+
+	/* looked up before, perhaps unsuccessfully */
+	cache_key = g_strdup_printf("%s:%s", guid, key);
+	if (fu_quirks_cache_lookup(self, cache_key, &value))
+		return value != FU_QUIRKS_CACHE_MISS ? value : NULL;
+
+	value = fu_quirks_lookup_by_id_uncached(self, guid, key);
+	fu_quirks_cache_add(self, g_steal_pointer(&cache_key), value);
+	return value;
+}
+
 /**
  * fu_quirks_lookup_by_id_iter:
  * @self: a #FuQuirks
@@ -538,6 +636,7 @@ fu_quirks_lookup_by_id_iter(FuQuirks *self,
 			    FuQuirksIter iter_cb,
 			    gpointer user_data)
 {
+	gboolean found_db = FALSE;
 	g_autoptr(GError) error = NULL;
 	g_autoptr(GPtrArray) results = NULL;
 	g_auto(XbQueryContext) context = XB_QUERY_CONTEXT_INIT();
@@ -546,38 +645,58 @@ fu_quirks_lookup_by_id_iter(FuQuirks *self,
 	g_return_val_if_fail(guid != NULL, FALSE);
 	g_return_val_if_fail(iter_cb != NULL, FALSE);
 
+	/* the silo has changed, so the cached values may be stale */
+	if (self->silo != NULL && !xb_silo_is_valid(self->silo))
+		fu_quirks_cache_invalidate(self);
+
+	/* most instance IDs have no quirks at all */
+	if (fu_quirks_cache_has_guid_miss(self, guid))
+		return FALSE;
+
 #ifdef HAVE_SQLITE
 	/* this is generated from usb.ids and other static sources */
 	if (self->db != NULL && (self->load_flags & FU_QUIRKS_LOAD_FLAG_NO_CACHE) == 0) {
-		g_autoptr(sqlite3_stmt) stmt = NULL;
-		if (key == NULL) {
-			if (sqlite3_prepare_v2(self->db,
-					       "SELECT key, value FROM quirks WHERE guid = ?1",
-					       -1,
-					       &stmt,
-					       NULL) != SQLITE_OK) {
-				g_warning("failed to prepare SQL: %s", sqlite3_errmsg(self->db));
-				return FALSE;
+		g_autoptr(GPtrArray) kvs = g_ptr_array_new_with_free_func(g_free);
+
+		/* do not call @iter_cb with the lock held */
+		{
+			g_autoptr(GMutexLocker) locker = g_mutex_locker_new(&self->cache_mutex);
+			sqlite3_stmt *stmt;
+			if (key == NULL) {
+				stmt = fu_quirks_db_ensure_stmt(
+				    self,
+				    &self->stmt_vs,
+				    "SELECT key, value FROM quirks WHERE guid = ?1");
+				if (stmt == NULL)
+					return FALSE;
+				sqlite3_bind_text(stmt, 1, guid, -1, SQLITE_STATIC);
+			} else {
+				stmt = fu_quirks_db_ensure_stmt(
+				    self,
+				    &self->stmt_kv,
+				    "SELECT key, value FROM quirks WHERE guid = ?1 "
+				    "AND key = ?2");
+				if (stmt == NULL)
+					return FALSE;
+				sqlite3_bind_text(stmt, 1, guid, -1, SQLITE_STATIC);
+				sqlite3_bind_text(stmt, 2, key, -1, SQLITE_STATIC);
 			}
-			sqlite3_bind_text(stmt, 1, guid, -1, SQLITE_STATIC);
-		} else {
-			if (sqlite3_prepare_v2(self->db,
-					       "SELECT key, value FROM quirks WHERE guid = ?1 "
-					       "AND key = ?2",
-					       -1,
-					       &stmt,
-					       NULL) != SQLITE_OK) {
-				g_warning("failed to prepare SQL: %s", sqlite3_errmsg(self->db));
-				return FALSE;
+			while (sqlite3_step(stmt) == SQLITE_ROW) {
+				g_ptr_array_add(kvs,
+						g_strdup((const gchar *)sqlite3_column_text(stmt, 0)));
+				g_ptr_array_add(kvs,
+						g_strdup((const gchar *)sqlite3_column_text(stmt, 1)));
 			}
-			sqlite3_bind_text(stmt, 1, guid, -1, SQLITE_STATIC);
-			sqlite3_bind_text(stmt, 2, key, -1, SQLITE_STATIC);
+			sqlite3_reset(stmt);
 		}
-		while (sqlite3_step(stmt) == SQLITE_ROW) {
-			const gchar *key_tmp = (const gchar *)sqlite3_column_text(stmt, 0);
-			const gchar *value = (const gchar *)sqlite3_column_text(stmt, 1);
-			iter_cb(self, key_tmp, value, FU_CONTEXT_QUIRK_SOURCE_DB, user_data);
+		for (guint i = 0; i + 1 < kvs->len; i += 2) {
+			iter_cb(self,
+				g_ptr_array_index(kvs, i),
+				g_ptr_array_index(kvs, i + 1),
+				FU_CONTEXT_QUIRK_SOURCE_DB,
+				user_data);
 		}
+		found_db = kvs->len > 0;
 	}
 #endif
 
@@ -603,8 +722,11 @@ fu_quirks_lookup_by_id_iter(FuQuirks *self,
 		results = xb_silo_query_with_context(self->silo, self->query_vs, &context, &error);
 	}
 	if (results == NULL) {
-		if (g_error_matches(error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND))
+		if (g_error_matches(error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND)) {
+			if (key == NULL && !found_db)
+				fu_quirks_cache_add_guid_miss(self, guid);
 			return FALSE;
+		}
 		if (g_error_matches(error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT))
 			return FALSE;
 		g_warning("failed to query: %s", error->message);
@@ -1001,6 +1123,7 @@ fu_quirks_load(FuQuirks *self, FuQuirksLoadFlags load_flags, GError **error)
 
 	self->load_flags = load_flags;
 	self->verbose = g_getenv("FWUPD_XMLB_VERBOSE") != NULL;
+	fu_quirks_cache_invalidate(self);
 
 #ifdef HAVE_SQLITE
 	if (self->db == NULL && (load_flags & FU_QUIRKS_LOAD_FLAG_NO_CACHE) == 0) {
@@ -1076,6 +1199,9 @@ fu_quirks_init(FuQuirks *self)
 {
 	self->possible_keys = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
 	self->invalid_keys = g_ptr_array_new_with_free_func(g_free);
+	self->cache_kv = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	self->cache_guid_miss = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	g_mutex_init(&self->cache_mutex);
 
 	/* built in */
 	fu_quirks_add_possible_key(self, FU_QUIRKS_BRANCH);
@@ -1133,11 +1259,18 @@ fu_quirks_finalize(GObject *obj)
 	if (self->silo != NULL)
 		g_object_unref(self->silo);
 #ifdef HAVE_SQLITE
+	if (self->stmt_kv != NULL)
+		sqlite3_finalize(self->stmt_kv);
+	if (self->stmt_vs != NULL)
+		sqlite3_finalize(self->stmt_vs);
 	if (self->db != NULL)
 		sqlite3_close(self->db);
 #endif
 	g_hash_table_unref(self->possible_keys);
 	g_ptr_array_unref(self->invalid_keys);
+	g_hash_table_unref(self->cache_kv);
+	g_hash_table_unref(self->cache_guid_miss);
+	g_mutex_clear(&self->cache_mutex);
 	G_OBJECT_CLASS(fu_quirks_parent_class)->finalize(obj);
 }
 
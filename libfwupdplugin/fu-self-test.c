@@ -20,6 +20,7 @@
 #include "fu-cab-firmware-private.h"
 #include "fu-config-private.h"
 #include "fu-context-private.h"
+#include "fu-crc-private.h"
 #include "fu-device-event-private.h"
 #include "fu-device-private.h"
 #include "fu-device-progress.h"
@@ -454,6 +455,44 @@ fu_common_crc_func(void)
 	g_assert_cmpint(fu_crc32(FU_CRC_KIND_B32_Q, buf, sizeof(buf)), ==, 0xE955C875);
 }
 
+static void
+fu_common_crc_tables_func(void)
+{
+	g_autofree guint8 *buf = g_malloc(1024 + 8);
+
+	for (guint i = 0; i < 1024 + 8; i++)
+		buf[i] = g_random_int_range(0x00, 0xFF + 1);
+
+	/* the table-driven step has to match the bitwise reference for every kind, length and
+	 * alignment, including a non-default initial value */
+	for (guint kind = FU_CRC_KIND_UNKNOWN + 1; kind < FU_CRC_KIND_LAST; kind++) {
+		guint bitwidth = fu_crc_get_bitwidth(kind);
+		guint32 init = g_random_int() & (G_MAXUINT32 >> (32 - bitwidth));
+		for (guint offset = 0; offset < 8; offset++) {
+			for (gsize bufsz = 0; bufsz <= 1024; bufsz += bufsz < 32 ? 1 : 31) {
+				guint32 crc_ref =
+				    fu_crc_step_bitwise(kind, buf + offset, bufsz, init);
+				if (bitwidth == 32) {
+					g_assert_cmpint(
+					    fu_crc32_step(kind, buf + offset, bufsz, init),
+					    ==,
+					    crc_ref);
+				} else if (bitwidth == 16) {
+					g_assert_cmpint(
+					    fu_crc16_step(kind, buf + offset, bufsz, init),
+					    ==,
+					    crc_ref);
+				} else {
+					g_assert_cmpint(
+					    fu_crc8_step(kind, buf + offset, bufsz, init),
+					    ==,
+					    crc_ref);
+				}
+			}
+		}
+	}
+}
+
 static void
 fu_common_guid_func(void)
 {
@@ -1669,6 +1708,16 @@ fu_plugin_quirks_func(void)
 	g_assert_cmpstr(tmp, ==, "clever");
 }
 
+static void
+fu_plugin_quirks_performance_iter_cb(FuQuirks *quirks,
+				     const gchar *key,
+				     const gchar *value,
+				     FuContextQuirkSource source,
+				     gpointer user_data)
+{
+	g_assert_not_reached();
+}
+
 static void
 fu_plugin_quirks_performance_func(void)
 {
@@ -1693,6 +1742,23 @@ fu_plugin_quirks_performance_func(void)
 		}
 	}
 	g_print("lookup=%.3fms ", g_timer_elapsed(timer, NULL) * 1000.f);
+
+	/* most instance IDs do not have any quirks */
+	g_timer_reset(timer);
+	for (guint j = 0; j < 1000; j++) {
+		const gchar *group = "00000000-0000-0000-0000-000000000000";
+		for (guint i = 0; keys[i] != NULL; i++) {
+			const gchar *tmp = fu_quirks_lookup_by_id(quirks, group, keys[i]);
+			g_assert_cmpstr(tmp, ==, NULL);
+		}
+		ret = fu_quirks_lookup_by_id_iter(quirks,
+						  group,
+						  NULL,
+						  fu_plugin_quirks_performance_iter_cb,
+						  NULL);
+		g_assert_false(ret);
+	}
+	g_print("miss=%.3fms ", g_timer_elapsed(timer, NULL) * 1000.f);
 }
 
 typedef struct {
@@ -1806,6 +1872,12 @@ fu_quirks_vendor_ids_func(void)
 	tmp = fu_quirks_lookup_by_id(quirks, guid5, FWUPD_RESULT_KEY_NAME);
 	g_assert_true(ret);
 	g_assert_cmpstr(tmp, ==, "AnyPoint (TM) Home Network 1.6 Mbps Wireless Adapter");
+
+	/* cached, and using the same prepared statement */
+	tmp = fu_quirks_lookup_by_id(quirks, guid1, "Vendor");
+	g_assert_cmpstr(tmp, ==, "Intel Corporation");
+	tmp = fu_quirks_lookup_by_id(quirks, guid2, "Vendor");
+	g_assert_cmpstr(tmp, ==, "Intel Corp.");
 }
 
 static void
@@ -2247,6 +2319,130 @@ fu_device_poll_func(void)
 	fu_test_loop_quit();
 }
 
+static gboolean
+fu_device_poll_scheduler_cb(FuDevice *device, GError **error)
+{
+	guint64 cnt = fu_device_get_metadata_integer(device, "cnt");
+	fu_device_set_metadata_integer(device, "cnt", cnt + 1);
+	if (fu_device_get_metadata_boolean(device, "fail")) {
+		g_set_error_literal(error, FWUPD_ERROR, FWUPD_ERROR_INTERNAL, "failed");
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static void
+fu_device_poll_scheduler_func(void)
+{
+	guint64 cnt_child;
+	guint64 cnt_parent;
+	g_autoptr(FuContext) ctx = fu_context_new();
+	g_autoptr(FuDevice) child = fu_device_new(ctx);
+	g_autoptr(FuDevice) device_fail = fu_device_new(ctx);
+	g_autoptr(FuDevice) parent = fu_device_new(ctx);
+	FuDeviceClass *klass = FU_DEVICE_GET_CLASS(parent);
+	FuPollScheduler *poll_scheduler = fu_context_get_poll_scheduler(ctx);
+
+	klass->poll = fu_device_poll_scheduler_cb;
+	fu_device_set_metadata_integer(parent, "cnt", 0);
+	fu_device_set_metadata_integer(child, "cnt", 0);
+	fu_device_set_metadata_integer(device_fail, "cnt", 0);
+	fu_device_set_metadata_boolean(device_fail, "fail", TRUE);
+	fu_device_add_child(parent, child);
+
+	/* related intervals share a wakeup */
+	fu_device_set_poll_interval(parent, 100);
+	fu_device_set_poll_interval(child, 200);
+	fu_device_set_poll_interval(device_fail, 100);
+	fu_test_loop_run_with_timeout(2000);
+	fu_test_loop_quit();
+	cnt_parent = fu_device_get_metadata_integer(parent, "cnt");
+	cnt_child = fu_device_get_metadata_integer(child, "cnt");
+	g_assert_cmpint(cnt_parent, >=, 5);
+	g_assert_cmpint(cnt_child, >=, 3);
+	g_assert_cmpint(fu_poll_scheduler_get_wakeups(poll_scheduler), <, cnt_parent + cnt_child);
+
+	/* backed off, and then disabled */
+	g_assert_cmpint(fu_device_get_metadata_integer(device_fail, "cnt"), ==, 3);
+
+	/* disable the poll manually */
+	fu_device_set_poll_interval(parent, 0);
+	fu_device_set_poll_interval(child, 0);
+	fu_test_loop_run_with_timeout(250);
+	fu_test_loop_quit();
+	g_assert_cmpint(fu_device_get_metadata_integer(parent, "cnt"), ==, cnt_parent);
+	g_assert_cmpint(fu_device_get_metadata_integer(child, "cnt"), ==, cnt_child);
+}
+
+static void
+fu_device_poll_scheduler_paused_func(void)
+{
+	g_autoptr(FuContext) ctx = fu_context_new();
+	g_autoptr(FuDevice) child = fu_device_new(ctx);
+	g_autoptr(FuDevice) parent = fu_device_new(ctx);
+	g_autoptr(FuDeviceLocker) locker = NULL;
+	g_autoptr(GError) error = NULL;
+	FuDeviceClass *klass = FU_DEVICE_GET_CLASS(parent);
+
+	klass->poll = fu_device_poll_scheduler_cb;
+	fu_device_set_metadata_integer(child, "cnt", 0);
+	fu_device_add_child(parent, child);
+
+	/* the child shares the transport, so is not polled while the parent is busy */
+	fu_device_add_private_flag(parent, FU_DEVICE_PRIVATE_FLAG_AUTO_PAUSE_POLLING);
+	locker = fu_device_poll_locker_new(parent, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(locker);
+	fu_device_set_poll_interval(child, 100);
+	fu_test_loop_run_with_timeout(500);
+	fu_test_loop_quit();
+	g_assert_cmpint(fu_device_get_metadata_integer(child, "cnt"), ==, 0);
+
+	/* the parent is idle again */
+	g_clear_object(&locker);
+	fu_test_loop_run_with_timeout(500);
+	fu_test_loop_quit();
+	g_assert_cmpint(fu_device_get_metadata_integer(child, "cnt"), >, 0);
+	fu_device_set_poll_interval(child, 0);
+}
+
+static void
+fu_device_poll_scheduler_siblings_func(void)
+{
+	guint64 cnt_child1;
+	guint64 cnt_child2;
+	g_autoptr(FuContext) ctx = fu_context_new();
+	g_autoptr(FuDevice) child1 = fu_device_new(ctx);
+	g_autoptr(FuDevice) child2 = fu_device_new(ctx);
+	g_autoptr(FuDevice) parent = fu_device_new(ctx);
+	FuDeviceClass *klass = FU_DEVICE_GET_CLASS(parent);
+	FuPollScheduler *poll_scheduler = fu_context_get_poll_scheduler(ctx);
+
+	klass->poll = fu_device_poll_scheduler_cb;
+	fu_device_set_metadata_integer(child1, "cnt", 0);
+	fu_device_set_metadata_integer(child2, "cnt", 0);
+	fu_device_add_child(parent, child1);
+	fu_device_add_child(parent, child2);
+
+	/* child2 is always due within a quarter of its interval of a child1 wakeup, so apart from
+	 * the very first poll it is polled in the same wakeup rather than on its own */
+	fu_device_set_poll_interval(child1, 3 * FU_POLL_SCHEDULER_TICK_MS);
+	fu_device_set_poll_interval(child2, 10 * FU_POLL_SCHEDULER_TICK_MS);
+	fu_test_loop_run_with_timeout(2500);
+	fu_test_loop_quit();
+	cnt_child1 = fu_device_get_metadata_integer(child1, "cnt");
+	cnt_child2 = fu_device_get_metadata_integer(child2, "cnt");
+	g_assert_cmpint(cnt_child1, >=, 5);
+	g_assert_cmpint(cnt_child2, >=, 2);
+	g_assert_cmpint(fu_poll_scheduler_get_wakeups(poll_scheduler), <=, cnt_child1 + 1);
+
+	/* polling early does not make the device due again at its original tick */
+	g_assert_cmpint(cnt_child2, <=, 3);
+
+	fu_device_set_poll_interval(child1, 0);
+	fu_device_set_poll_interval(child2, 0);
+}
+
 static void
 fu_device_func(void)
 {
@@ -2362,6 +2558,71 @@ fu_device_event_func(void)
 	g_assert_false(ret);
 }
 
+static void
+fu_device_event_replay_func(void)
+{
+	FuDeviceEvent *event;
+	guint8 buf[4] = {0};
+	gsize actual_length = 0;
+	g_autoptr(FuDevice) device = fu_device_new(NULL);
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GTimer) timer = g_timer_new();
+
+	/* interleave two IDs, with a lot of padding */
+	for (guint i = 0; i < 10000; i++) {
+		g_autofree gchar *id = g_strdup_printf("Ioctl:Request=0x%04x", i % 100);
+		g_autoptr(FuDeviceEvent) event_tmp = fu_device_event_new(id);
+		fu_device_event_set_data(event_tmp, "DataOut", (const guint8 *)&i, sizeof(i));
+		fu_device_add_event(device, event_tmp);
+	}
+
+	/* each load gets the next event in the sequence with that ID */
+	g_timer_reset(timer);
+	for (guint i = 0; i < 10000; i += 100) {
+		guint val = 0;
+		event = fu_device_load_event(device, "Ioctl:Request=0x0007", &error);
+		g_assert_no_error(error);
+		g_assert_nonnull(event);
+		actual_length = 0;
+		g_assert_true(fu_device_event_copy_data(event,
+							"DataOut",
+							(guint8 *)&val,
+							sizeof(val),
+							&actual_length,
+							&error));
+		g_assert_no_error(error);
+		g_assert_cmpint(actual_length, ==, sizeof(val));
+		g_assert_cmpint(val, ==, i + 7);
+	}
+	g_print("replay=%.3fms ", g_timer_elapsed(timer, NULL) * 1000.f);
+
+	/* skip forward, then wrap around to the beginning */
+	event = fu_device_load_event(device, "Ioctl:Request=0x0063", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(event);
+	event = fu_device_load_event(device, "Ioctl:Request=0x0000", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(event);
+	g_assert_true(fu_device_event_copy_data(event,
+						"DataOut",
+						buf,
+						sizeof(buf),
+						&actual_length,
+						&error));
+	g_assert_no_error(error);
+	g_assert_cmpint(fu_memread_uint32(buf, G_BYTE_ORDER), ==, 0);
+
+	/* events added after the first lookup are still found */
+	fu_device_clear_events(device);
+	fu_device_save_event(device, "Ioctl:Request=0xffff");
+	event = fu_device_load_event(device, "Ioctl:Request=0xffff", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(event);
+	event = fu_device_load_event(device, "Ioctl:Request=0x0007", &error);
+	g_assert_error(error, FWUPD_ERROR, FWUPD_ERROR_NOT_FOUND);
+	g_assert_null(event);
+}
+
 static void
 fu_device_event_uncompressed_func(void)
 {
@@ -3868,6 +4129,400 @@ fu_firmware_srec_tokenization_func(void)
 	g_assert_cmpint(rcd->buf->data[0], ==, 0x50);
 }
 
+/* the tokenizers as they were before the fast paths were added, including the hex parsing */
+static gboolean
+fu_firmware_strparse_legacy(const gchar *data,
+			    gsize datasz,
+			    gsize offset,
+			    gsize width,
+			    guint64 value_max,
+			    guint64 *value,
+			    GError **error)
+{
+	gchar buffer[9] = {'\0'};
+	if (!fu_memcpy_safe((guint8 *)buffer,
+			    sizeof(buffer),
+			    0x0, /* dst */
+			    (const guint8 *)data,
+			    datasz,
+			    offset, /* src */
+			    width,
+			    error))
+		return FALSE;
+	return fu_strtoull(buffer, value, 0, value_max, FU_INTEGER_BASE_16, error);
+}
+
+static gboolean
+fu_firmware_strparse_uint8_legacy(const gchar *data,
+				  gsize datasz,
+				  gsize offset,
+				  guint8 *value,
+				  GError **error)
+{
+	guint64 tmp = 0;
+	if (!fu_firmware_strparse_legacy(data, datasz, offset, 2, G_MAXUINT8, &tmp, error))
+		return FALSE;
+	*value = (guint8)tmp;
+	return TRUE;
+}
+
+static gboolean
+fu_firmware_strparse_uint16_legacy(const gchar *data,
+				   gsize datasz,
+				   gsize offset,
+				   guint16 *value,
+				   GError **error)
+{
+	guint64 tmp = 0;
+	if (!fu_firmware_strparse_legacy(data, datasz, offset, 4, G_MAXUINT16, &tmp, error))
+		return FALSE;
+	*value = (guint16)tmp;
+	return TRUE;
+}
+
+static gboolean
+fu_firmware_strparse_uint24_legacy(const gchar *data,
+				   gsize datasz,
+				   gsize offset,
+				   guint32 *value,
+				   GError **error)
+{
+	guint64 tmp = 0;
+	if (!fu_firmware_strparse_legacy(data, datasz, offset, 6, 0xFFFFFF, &tmp, error))
+		return FALSE;
+	*value = (guint32)tmp;
+	return TRUE;
+}
+
+static gboolean
+fu_firmware_strparse_uint32_legacy(const gchar *data,
+				   gsize datasz,
+				   gsize offset,
+				   guint32 *value,
+				   GError **error)
+{
+	guint64 tmp = 0;
+	if (!fu_firmware_strparse_legacy(data, datasz, offset, 8, G_MAXUINT32, &tmp, error))
+		return FALSE;
+	*value = (guint32)tmp;
+	return TRUE;
+}
+
+typedef struct {
+	GString *str;
+	FuFirmwareParseFlags flags;
+	gboolean got_eof;
+} FuFirmwareTokenizeLegacyHelper;
+
+static gboolean
+fu_firmware_ihex_tokenize_legacy_cb(GString *token,
+				    guint token_idx,
+				    gpointer user_data,
+				    GError **error)
+{
+	FuFirmwareTokenizeLegacyHelper *helper = (FuFirmwareTokenizeLegacyHelper *)user_data;
+	guint8 byte_cnt = 0;
+	guint8 record_type = 0;
+	guint8 checksum = 0;
+	guint16 addr16 = 0;
+	guint line_end;
+
+	if (token_idx > 100000) {
+		g_set_error_literal(error, FWUPD_ERROR, FWUPD_ERROR_INVALID_DATA, "too many");
+		return FALSE;
+	}
+	g_strdelimit(token->str, "\r\x1a", '\0');
+	token->len = strlen(token->str);
+	if (token->len == 0 || token->str[0] == ';')
+		return TRUE;
+	if (token->str[0] != ':') {
+		g_set_error_literal(error, FWUPD_ERROR, FWUPD_ERROR_INVALID_FILE, "token");
+		return FALSE;
+	}
+	if (!fu_firmware_strparse_uint8_legacy(token->str, token->len, 1, &byte_cnt, error))
+		return FALSE;
+	if (!fu_firmware_strparse_uint16_legacy(token->str, token->len, 3, &addr16, error))
+		return FALSE;
+	if (!fu_firmware_strparse_uint8_legacy(token->str, token->len, 7, &record_type, error))
+		return FALSE;
+	line_end = 9 + byte_cnt * 2;
+	if (line_end > token->len) {
+		g_set_error_literal(error, FWUPD_ERROR, FWUPD_ERROR_INVALID_FILE, "length");
+		return FALSE;
+	}
+	if ((helper->flags & FU_FIRMWARE_PARSE_FLAG_IGNORE_CHECKSUM) == 0) {
+		for (guint i = 1; i < line_end + 2; i += 2) {
+			guint8 tmp = 0;
+			if (!fu_firmware_strparse_uint8_legacy(token->str,
+								 token->len,
+								 i,
+								 &tmp,
+								 error))
+				return FALSE;
+			checksum += tmp;
+		}
+		if (checksum != 0) {
+			g_set_error_literal(error, FWUPD_ERROR, FWUPD_ERROR_INVALID_FILE, "csum");
+			return FALSE;
+		}
+	}
+	g_string_append_printf(helper->str,
+			       "%u:%s:%02x:%04x:%02x:",
+			       token_idx + 1,
+			       token->str,
+			       record_type,
+			       addr16,
+			       byte_cnt);
+	for (guint i = 9; i < line_end; i += 2) {
+		guint8 tmp = 0;
+		if (!fu_firmware_strparse_uint8_legacy(token->str, token->len, i, &tmp, error))
+			return FALSE;
+		g_string_append_printf(helper->str, "%02x", tmp);
+	}
+	g_string_append_c(helper->str, '\n');
+	return TRUE;
+}
+
+static gboolean
+fu_firmware_srec_tokenize_legacy_cb(GString *token,
+				    guint token_idx,
+				    gpointer user_data,
+				    GError **error)
+{
+	FuFirmwareTokenizeLegacyHelper *helper = (FuFirmwareTokenizeLegacyHelper *)user_data;
+	gboolean require_data = FALSE;
+	guint32 rec_addr32 = 0;
+	guint16 rec_addr16 = 0;
+	guint8 addrsz = 0;
+	guint8 rec_count = 0;
+	guint8 rec_kind;
+
+	if (token_idx > 100000) {
+		g_set_error_literal(error, FWUPD_ERROR, FWUPD_ERROR_INVALID_DATA, "too many");
+		return FALSE;
+	}
+	g_strdelimit(token->str, "\r\x1a", '\0');
+	token->len = strlen(token->str);
+	if (token->len == 0)
+		return TRUE;
+	if (token->str[0] != 'S' || token->len < 3) {
+		g_set_error_literal(error, FWUPD_ERROR, FWUPD_ERROR_INVALID_FILE, "token");
+		return FALSE;
+	}
+	rec_kind = token->str[1] - '0';
+	if (!fu_firmware_strparse_uint8_legacy(token->str, token->len, 2, &rec_count, error))
+		return FALSE;
+	if (rec_count * 2 != token->len - 4) {
+		g_set_error_literal(error, FWUPD_ERROR, FWUPD_ERROR_INVALID_FILE, "count");
+		return FALSE;
+	}
+	if ((helper->flags & FU_FIRMWARE_PARSE_FLAG_IGNORE_CHECKSUM) == 0) {
+		guint8 rec_csum = 0;
+		guint8 rec_csum_expected = 0;
+		for (guint8 i = 0; i < rec_count; i++) {
+			guint8 tmp = 0;
+			if (!fu_firmware_strparse_uint8_legacy(token->str,
+								 token->len,
+								 (i * 2) + 2,
+								 &tmp,
+								 error))
+				return FALSE;
+			rec_csum += tmp;
+		}
+		rec_csum ^= 0xff;
+		if (!fu_firmware_strparse_uint8_legacy(token->str,
+						       token->len,
+						       (rec_count * 2) + 2,
+						       &rec_csum_expected,
+						       error))
+			return FALSE;
+		if (rec_csum != rec_csum_expected) {
+			g_set_error_literal(error, FWUPD_ERROR, FWUPD_ERROR_INVALID_FILE, "csum");
+			return FALSE;
+		}
+	}
+	if (rec_kind == 0 || rec_kind == 1 || rec_kind == 5 || rec_kind == 9)
+		addrsz = 2;
+	else if (rec_kind == 2 || rec_kind == 6 || rec_kind == 8)
+		addrsz = 3;
+	else if (rec_kind == 3 || rec_kind == 7)
+		addrsz = 4;
+	if (addrsz == 0) {
+		g_set_error_literal(error, FWUPD_ERROR, FWUPD_ERROR_INVALID_FILE, "kind");
+		return FALSE;
+	}
+	require_data = rec_kind <= 3;
+	if (rec_kind == 5 || rec_kind == 7 || rec_kind == 8 || rec_kind == 9)
+		helper->got_eof = TRUE;
+	if (addrsz == 2) {
+		if (!fu_firmware_strparse_uint16_legacy(token->str,
+							token->len,
+							4,
+							&rec_addr16,
+							error))
+			return FALSE;
+		rec_addr32 = rec_addr16;
+	} else if (addrsz == 3) {
+		if (!fu_firmware_strparse_uint24_legacy(token->str,
+							token->len,
+							4,
+							&rec_addr32,
+							error))
+			return FALSE;
+	} else {
+		if (!fu_firmware_strparse_uint32_legacy(token->str,
+							token->len,
+							4,
+							&rec_addr32,
+							error))
+			return FALSE;
+	}
+	if (require_data && rec_count == addrsz) {
+		g_set_error_literal(error, FWUPD_ERROR, FWUPD_ERROR_INVALID_FILE, "data");
+		return FALSE;
+	}
+	g_string_append_printf(helper->str, "%u:%u:%08x:", token_idx + 1, rec_kind, rec_addr32);
+	if (rec_kind == 1 || rec_kind == 2 || rec_kind == 3) {
+		for (gsize i = 4 + (addrsz * 2); i <= rec_count * 2; i += 2) {
+			guint8 tmp = 0;
+			if (!fu_firmware_strparse_uint8_legacy(token->str,
+								 token->len,
+								 i,
+								 &tmp,
+								 error))
+				return FALSE;
+			g_string_append_printf(helper->str, "%02x", tmp);
+		}
+	}
+	g_string_append_c(helper->str, '\n');
+	return TRUE;
+}
+
+static GBytes *
+fu_firmware_tokenize_fuzz_mutate(GRand *rand, GBytes *blob)
+{
+	const gchar chars[] = {' ', '+', '-', 'x', '\r', '\n', '\0', '\x1a', '\xff', ';', ':', 'S'};
+	g_autoptr(GByteArray) buf = g_byte_array_new();
+
+	fu_byte_array_append_bytes(buf, blob);
+	for (gint i = g_rand_int_range(rand, 0, 4); i > 0 && buf->len > 0; i--) {
+		guint offset = g_rand_int_range(rand, 0, buf->len);
+		gchar chr = chars[g_rand_int_range(rand, 0, G_N_ELEMENTS(chars))];
+		switch (g_rand_int_range(rand, 0, 5)) {
+		case 0:
+			buf->data[offset] = chr;
+			break;
+		case 1:
+			g_byte_array_set_size(buf, buf->len + 1);
+			memmove(buf->data + offset + 1, buf->data + offset, buf->len - offset - 1);
+			buf->data[offset] = chr;
+			break;
+		case 2:
+			g_byte_array_remove_index(buf, offset);
+			break;
+		case 3:
+			g_byte_array_set_size(buf, offset);
+			break;
+		default:
+			buf->data[offset] = "0123456789ABCDEFabcdef"[g_rand_int_range(rand, 0, 22)];
+			break;
+		}
+	}
+	if (buf->len == 0)
+		fu_byte_array_append_uint8(buf, '\n');
+	return g_bytes_new(buf->data, buf->len);
+}
+
+static void
+fu_firmware_tokenize_fuzz_func(void)
+{
+	g_autoptr(GRand) rand = g_rand_new_with_seed(0xF00D);
+
+	for (guint i = 0; i < 5000; i++) {
+		gboolean is_ihex = i % 2 == 0;
+		gboolean ret;
+		gboolean ret_legacy;
+		FuFirmwareParseFlags flags = i % 4 < 2 ? FU_FIRMWARE_PARSE_FLAG_NONE
+						       : FU_FIRMWARE_PARSE_FLAG_IGNORE_CHECKSUM;
+		GPtrArray *records;
+		g_autoptr(FuFirmware) firmware_src = NULL;
+		g_autoptr(FuFirmware) firmware = NULL;
+		g_autoptr(GByteArray) payload = g_byte_array_new();
+		g_autoptr(GBytes) blob = NULL;
+		g_autoptr(GBytes) blob_src = NULL;
+		g_autoptr(GBytes) fw = NULL;
+		g_autoptr(GError) error = NULL;
+		g_autoptr(GError) error_legacy = NULL;
+		g_autoptr(GInputStream) stream = NULL;
+		g_autoptr(GInputStream) stream_legacy = NULL;
+		g_autoptr(GString) str = g_string_new(NULL);
+		g_autoptr(GString) str_legacy = g_string_new(NULL);
+		FuFirmwareTokenizeLegacyHelper helper = {.str = str_legacy, .flags = flags};
+
+		/* create a valid file */
+		firmware_src = is_ihex ? fu_ihex_firmware_new() : fu_srec_firmware_new();
+		for (gint j = g_rand_int_range(rand, 1, 80); j > 0; j--)
+			fu_byte_array_append_uint8(payload, g_rand_int_range(rand, 0, 0x100));
+		fw = g_bytes_new(payload->data, payload->len);
+		fu_firmware_set_bytes(firmware_src, fw);
+		fu_firmware_set_addr(firmware_src, g_rand_int_range(rand, 0, 0x30000));
+		blob_src = fu_firmware_write(firmware_src, &error);
+		g_assert_no_error(error);
+		g_assert_nonnull(blob_src);
+
+		/* corrupt it slightly */
+		blob = fu_firmware_tokenize_fuzz_mutate(rand, blob_src);
+		stream_legacy = g_memory_input_stream_new_from_bytes(blob);
+		ret_legacy = fu_strsplit_stream(stream_legacy,
+						0x0,
+						"\n",
+						is_ihex ? fu_firmware_ihex_tokenize_legacy_cb
+							: fu_firmware_srec_tokenize_legacy_cb,
+						&helper,
+						&error_legacy);
+		if (ret_legacy && !is_ihex && !helper.got_eof)
+			ret_legacy = FALSE;
+
+		/* both implementations have to agree */
+		firmware = is_ihex ? fu_ihex_firmware_new() : fu_srec_firmware_new();
+		stream = g_memory_input_stream_new_from_bytes(blob);
+		ret = fu_firmware_tokenize(firmware, stream, flags, &error);
+		g_assert_cmpint(ret, ==, ret_legacy);
+		if (!ret)
+			continue;
+		if (is_ihex) {
+			records = fu_ihex_firmware_get_records(FU_IHEX_FIRMWARE(firmware));
+			for (guint j = 0; j < records->len; j++) {
+				FuIhexFirmwareRecord *rcd = g_ptr_array_index(records, j);
+				g_string_append_printf(str,
+						       "%u:%s:%02x:%04x:%02x:",
+						       rcd->ln,
+						       rcd->buf->str,
+						       rcd->record_type,
+						       rcd->addr,
+						       rcd->byte_cnt);
+				for (guint k = 0; k < rcd->data->len; k++)
+					g_string_append_printf(str, "%02x", rcd->data->data[k]);
+				g_string_append_c(str, '\n');
+			}
+		} else {
+			records = fu_srec_firmware_get_records(FU_SREC_FIRMWARE(firmware));
+			for (guint j = 0; j < records->len; j++) {
+				FuSrecFirmwareRecord *rcd = g_ptr_array_index(records, j);
+				g_string_append_printf(str,
+						       "%u:%u:%08x:",
+						       rcd->ln,
+						       rcd->kind,
+						       rcd->addr);
+				for (guint k = 0; k < rcd->buf->len; k++)
+					g_string_append_printf(str, "%02x", rcd->buf->data[k]);
+				g_string_append_c(str, '\n');
+			}
+		}
+		g_assert_cmpstr(str->str, ==, str_legacy->str);
+	}
+}
+
 static void
 fu_firmware_build_func(void)
 {
@@ -4856,6 +5511,204 @@ fu_efivar_func(void)
 	g_assert_false(ret);
 }
 
+static void
+fu_efivar_cache_func(void)
+{
+	gboolean ret;
+	g_autoptr(FuEfivars) efivars = fu_dummy_efivars_new();
+	g_autoptr(GBytes) blob1 = NULL;
+	g_autoptr(GBytes) blob2 = NULL;
+	g_autoptr(GBytes) blob3 = NULL;
+	g_autoptr(GBytes) blob4 = NULL;
+	g_autoptr(GBytes) blob5 = NULL;
+	g_autoptr(GBytes) blob6 = NULL;
+	g_autoptr(GError) error = NULL;
+
+	ret = fu_efivars_set_data(efivars,
+				  FU_EFIVARS_GUID_EFI_GLOBAL,
+				  "Test",
+				  (guint8 *)"1",
+				  1,
+				  FU_EFI_VARIABLE_ATTR_NON_VOLATILE,
+				  &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+
+	/* first read goes to the backend, the second does not */
+	blob1 = fu_efivars_get_data_bytes(efivars,
+					  FU_EFIVARS_GUID_EFI_GLOBAL,
+					  "Test",
+					  NULL,
+					  &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(blob1);
+	blob2 = fu_efivars_get_data_bytes(efivars,
+					  FU_EFIVARS_GUID_EFI_GLOBAL,
+					  "Test",
+					  NULL,
+					  &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(blob2);
+	g_assert_true(fu_efivars_exists(efivars, FU_EFIVARS_GUID_EFI_GLOBAL, "Test"));
+	g_assert_cmpint(fu_efivars_get_cache_misses(efivars), ==, 1);
+	g_assert_cmpint(fu_efivars_get_cache_hits(efivars), ==, 2);
+
+	/* writing invalidates */
+	ret = fu_efivars_set_data(efivars,
+				  FU_EFIVARS_GUID_EFI_GLOBAL,
+				  "Test",
+				  (guint8 *)"2",
+				  1,
+				  FU_EFI_VARIABLE_ATTR_NON_VOLATILE,
+				  &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	blob3 = fu_efivars_get_data_bytes(efivars,
+					  FU_EFIVARS_GUID_EFI_GLOBAL,
+					  "Test",
+					  NULL,
+					  &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(blob3);
+	g_assert_cmpint(((const guint8 *)g_bytes_get_data(blob3, NULL))[0], ==, '2');
+	g_assert_cmpint(fu_efivars_get_cache_misses(efivars), ==, 2);
+
+	/* deleting invalidates, and missing variables are cached too */
+	ret = fu_efivars_delete_with_glob(efivars, FU_EFIVARS_GUID_EFI_GLOBAL, "Te*", &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	blob4 = fu_efivars_get_data_bytes(efivars,
+					  FU_EFIVARS_GUID_EFI_GLOBAL,
+					  "Test",
+					  NULL,
+					  &error);
+	g_assert_error(error, FWUPD_ERROR, FWUPD_ERROR_NOT_FOUND);
+	g_assert_null(blob4);
+	g_assert_false(fu_efivars_exists(efivars, FU_EFIVARS_GUID_EFI_GLOBAL, "Test"));
+	g_assert_cmpint(fu_efivars_get_cache_misses(efivars), ==, 3);
+	g_assert_cmpint(fu_efivars_get_cache_hits(efivars), ==, 3);
+	g_clear_error(&error);
+
+	/* deleting a single variable invalidates too */
+	ret = fu_efivars_set_data(efivars,
+				  FU_EFIVARS_GUID_EFI_GLOBAL,
+				  "Test",
+				  (guint8 *)"3",
+				  1,
+				  FU_EFI_VARIABLE_ATTR_NON_VOLATILE,
+				  &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	blob5 = fu_efivars_get_data_bytes(efivars,
+					  FU_EFIVARS_GUID_EFI_GLOBAL,
+					  "Test",
+					  NULL,
+					  &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(blob5);
+	g_assert_cmpint(fu_efivars_get_cache_misses(efivars), ==, 4);
+	ret = fu_efivars_delete(efivars, FU_EFIVARS_GUID_EFI_GLOBAL, "Test", &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	blob6 = fu_efivars_get_data_bytes(efivars,
+					  FU_EFIVARS_GUID_EFI_GLOBAL,
+					  "Test",
+					  NULL,
+					  &error);
+	g_assert_error(error, FWUPD_ERROR, FWUPD_ERROR_NOT_FOUND);
+	g_assert_null(blob6);
+	g_assert_cmpint(fu_efivars_get_cache_misses(efivars), ==, 5);
+}
+
+static void
+fu_efivar_cache_boot_entry_func(void)
+{
+	guint cache_hits;
+	g_autoptr(FuEfivars) efivars = fu_efivars_new();
+	g_autoptr(FuEfiLoadOption) loadopt1 = NULL;
+	g_autoptr(FuEfiLoadOption) loadopt2 = NULL;
+	g_autoptr(GError) error = NULL;
+
+	/* the blob is only read once */
+	loadopt1 = fu_efivars_get_boot_entry(efivars, 0x0001, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(loadopt1);
+	cache_hits = fu_efivars_get_cache_hits(efivars);
+	loadopt2 = fu_efivars_get_boot_entry(efivars, 0x0001, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(loadopt2);
+	g_assert_cmpint(fu_efivars_get_cache_hits(efivars), ==, cache_hits + 1);
+
+	/* but each caller gets their own object to modify */
+	g_assert_true(loadopt1 != loadopt2);
+	g_assert_cmpstr(fu_firmware_get_id(FU_FIRMWARE(loadopt2)), ==, "Fedora");
+	fu_firmware_set_id(FU_FIRMWARE(loadopt1), "Modified");
+	g_clear_object(&loadopt2);
+	loadopt2 = fu_efivars_get_boot_entry(efivars, 0x0001, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(loadopt2);
+	g_assert_cmpstr(fu_firmware_get_id(FU_FIRMWARE(loadopt2)), ==, "Fedora");
+}
+
+static GBytes *
+fu_efivar_cache_monitor_get_data(FuEfivars *efivars)
+{
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GBytes) blob =
+	    fu_efivars_get_data_bytes(efivars, FU_EFIVARS_GUID_EFI_GLOBAL, "Test", NULL, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(blob);
+	return g_steal_pointer(&blob);
+}
+
+static void
+fu_efivar_cache_monitor_func(void)
+{
+	gboolean ret;
+	const guint8 buf1[] = {0x07, 0x00, 0x00, 0x00, '1'};
+	const guint8 buf2[] = {0x07, 0x00, 0x00, 0x00, '2'};
+	g_autofree gchar *fn = NULL;
+	g_autofree gchar *testdatadir = g_test_build_filename(G_TEST_DIST, "tests", NULL);
+	g_autoptr(FuEfivars) efivars = NULL;
+	g_autoptr(GBytes) blob1 = NULL;
+	g_autoptr(GBytes) blob2 = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GTimer) timer = g_timer_new();
+
+	(void)g_setenv("FWUPD_SYSFSFWDIR", "/tmp/fwupd-self-test/sys/firmware", TRUE);
+	fn = g_strdup_printf("/tmp/fwupd-self-test/sys/firmware/efi/efivars/Test-%s",
+			     FU_EFIVARS_GUID_EFI_GLOBAL);
+	ret = fu_path_mkdir_parent(fn, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	ret = g_file_set_contents(fn, (const gchar *)buf1, sizeof(buf1), &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+
+	/* read into the cache */
+	efivars = fu_efivars_new();
+	blob1 = fu_efivar_cache_monitor_get_data(efivars);
+	g_assert_cmpint(((const guint8 *)g_bytes_get_data(blob1, NULL))[0], ==, '1');
+	g_clear_pointer(&blob1, g_bytes_unref);
+	blob1 = fu_efivar_cache_monitor_get_data(efivars);
+	g_assert_cmpint(fu_efivars_get_cache_misses(efivars), ==, 1);
+
+	/* changed by another process, which the directory monitor notices */
+	ret = g_file_set_contents(fn, (const gchar *)buf2, sizeof(buf2), &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	while (fu_efivars_get_cache_misses(efivars) == 1 && g_timer_elapsed(timer, NULL) < 5.f) {
+		g_main_context_iteration(NULL, FALSE);
+		g_clear_pointer(&blob2, g_bytes_unref);
+		blob2 = fu_efivar_cache_monitor_get_data(efivars);
+		g_usleep(10 * 1000);
+	}
+	g_assert_cmpint(fu_efivars_get_cache_misses(efivars), ==, 2);
+	g_assert_cmpint(((const guint8 *)g_bytes_get_data(blob2, NULL))[0], ==, '2');
+
+	(void)g_setenv("FWUPD_SYSFSFWDIR", testdatadir, TRUE);
+}
+
 static void
 fu_efivar_boot_func(void)
 {
@@ -6018,6 +6871,69 @@ fu_progress_global_fraction_func(void)
 	fu_progress_finished(progress);
 }
 
+static void
+fu_progress_trace_func(void)
+{
+	FuProgress *child;
+	JsonArray *json_array;
+	JsonObject *json_obj;
+	gint64 ts_last = 0;
+	gint64 ts[10] = {0};
+	const gchar *ph_expected[] = {"B", "B", "B", "E", "B", "E", "E", "B", "E", "E"};
+	g_autoptr(FuProgress) progress = fu_progress_new(G_STRLOC);
+	g_autoptr(JsonBuilder) builder = json_builder_new();
+	g_autoptr(JsonNode) json_root = NULL;
+
+	fu_progress_set_profile(progress, TRUE);
+	fu_progress_add_step(progress, FWUPD_STATUS_LOADING, 50, "first");
+	fu_progress_add_step(progress, FWUPD_STATUS_DEVICE_WRITE, 50, "second");
+
+	/* nested steps */
+	child = fu_progress_get_child(progress);
+	fu_progress_set_id(child, G_STRLOC);
+	fu_progress_set_device_id(child, "362301da643102b9f38477387e2193e57abaa590");
+	fu_progress_set_steps(child, 2);
+	g_usleep(10 * 1000);
+	fu_progress_step_done(child);
+	g_usleep(10 * 1000);
+	fu_progress_step_done(child);
+	fu_progress_step_done(progress);
+	g_usleep(10 * 1000);
+	fu_progress_step_done(progress);
+
+	json_builder_begin_array(builder);
+	fu_progress_add_trace_events(progress, builder);
+	json_builder_end_array(builder);
+	json_root = json_builder_get_root(builder);
+	json_array = json_node_get_array(json_root);
+	g_assert_cmpint(json_array_get_length(json_array), ==, G_N_ELEMENTS(ph_expected));
+	for (guint i = 0; i < json_array_get_length(json_array); i++) {
+		json_obj = json_array_get_object_element(json_array, i);
+		g_assert_cmpstr(json_object_get_string_member(json_obj, "ph"), ==, ph_expected[i]);
+		ts[i] = json_object_get_int_member(json_obj, "ts");
+		g_assert_cmpint(ts[i], >=, ts_last);
+		ts_last = ts[i];
+	}
+
+	/* the first step starts with the parent, and each later step when the previous is done */
+	g_assert_cmpint(ts[1] - ts[0], <, 10 * 1000);
+	g_assert_cmpint(ts[4] - ts[2], >=, 10 * 1000);
+	g_assert_cmpint(ts[5] - ts[4], >=, 10 * 1000);
+	g_assert_cmpint(ts[6] - ts[1], >=, 20 * 1000);
+	g_assert_cmpint(ts[7] - ts[1], >=, 20 * 1000);
+	g_assert_cmpint(ts[8] - ts[7], >=, 10 * 1000);
+
+	/* step names and device IDs */
+	json_obj = json_array_get_object_element(json_array, 1);
+	g_assert_cmpstr(json_object_get_string_member(json_obj, "name"), ==, "first");
+	json_obj = json_object_get_object_member(json_obj, "args");
+	g_assert_cmpstr(json_object_get_string_member(json_obj, "device_id"),
+			==,
+			"362301da643102b9f38477387e2193e57abaa590");
+	json_obj = json_array_get_object_element(json_array, 7);
+	g_assert_cmpstr(json_object_get_string_member(json_obj, "name"), ==, "second");
+}
+
 static void
 fu_progress_child_finished(void)
 {
@@ -6595,6 +7511,137 @@ fu_input_stream_chunkify_func(void)
 	g_assert_cmpint(crc32, ==, fu_crc32(FU_CRC_KIND_B32_STANDARD, buf->data, buf->len));
 }
 
+static void
+fu_input_stream_chunkify_performance_func(void)
+{
+	gboolean ret;
+	gint fd;
+	gsize bufsz = 32 * 1024 * 1024;
+	guint8 sum8_chunks = 0;
+	guint8 sum8_file = 0;
+	guint8 sum8_stream = 0;
+	g_autofree gchar *filename = NULL;
+	g_autofree guint8 *buf = g_malloc(bufsz);
+	g_autoptr(FuChunkArray) chunks = NULL;
+	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GInputStream) stream = NULL;
+	g_autoptr(GInputStream) stream_file = NULL;
+	g_autoptr(GTimer) timer = g_timer_new();
+
+	for (gsize i = 0; i < bufsz; i++)
+		buf[i] = i * 7;
+	blob = g_bytes_new_take(g_steal_pointer(&buf), bufsz);
+	stream = g_memory_input_stream_new_from_bytes(blob);
+
+	/* a new FuChunk and GBytes for every 32kB */
+	chunks = fu_chunk_array_new_from_stream(stream,
+						FU_CHUNK_ADDR_OFFSET_NONE,
+						FU_CHUNK_PAGESZ_NONE,
+						0x8000,
+						&error);
+	g_assert_no_error(error);
+	g_assert_nonnull(chunks);
+	for (guint i = 0; i < fu_chunk_array_length(chunks); i++) {
+		g_autoptr(FuChunk) chk = fu_chunk_array_index(chunks, i, &error);
+		g_assert_no_error(error);
+		g_assert_nonnull(chk);
+		sum8_chunks += fu_sum8(fu_chunk_get_data(chk), fu_chunk_get_data_sz(chk));
+	}
+	g_print("chunks=%u:%.3fms ",
+		fu_chunk_array_length(chunks),
+		g_timer_elapsed(timer, NULL) * 1000.f);
+
+	/* one reused buffer */
+	g_timer_reset(timer);
+	ret = fu_input_stream_compute_sum8(stream, &sum8_stream, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	g_assert_cmpint(sum8_stream, ==, sum8_chunks);
+	g_print("stream=%.3fms ", g_timer_elapsed(timer, NULL) * 1000.f);
+
+	/* mapped local file */
+	fd = g_file_open_tmp("fwupd-chunkify-XXXXXX", &filename, &error);
+	g_assert_no_error(error);
+	g_assert_cmpint(fd, >=, 0);
+	g_close(fd, NULL);
+	ret = g_file_set_contents(filename, g_bytes_get_data(blob, NULL), bufsz, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	stream_file = fu_input_stream_from_path(filename, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(stream_file);
+	g_timer_reset(timer);
+	ret = fu_input_stream_compute_sum8(stream_file, &sum8_file, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	g_assert_cmpint(sum8_file, ==, sum8_chunks);
+	g_print("file=%.3fms ", g_timer_elapsed(timer, NULL) * 1000.f);
+	(void)g_unlink(filename);
+}
+
+static void
+fu_input_stream_checksums_func(void)
+{
+	GChecksumType checksum_types[] = {G_CHECKSUM_SHA1, G_CHECKSUM_SHA256, G_CHECKSUM_SHA512};
+	gsize bufszs[] = {0x10, 0x80000, 0x80001};
+
+	for (guint i = 0; i < G_N_ELEMENTS(bufszs); i++) {
+		g_autoptr(GByteArray) buf = g_byte_array_new();
+		g_autoptr(GBytes) blob = NULL;
+		g_autoptr(GError) error = NULL;
+		g_autoptr(GInputStream) stream = NULL;
+		g_auto(GStrv) checksums = NULL;
+
+		for (guint j = 0; j < bufszs[i]; j++)
+			fu_byte_array_append_uint8(buf, j);
+		blob = g_bytes_new(buf->data, buf->len);
+		stream = g_memory_input_stream_new_from_bytes(blob);
+		checksums = fu_input_stream_compute_checksums(stream,
+							      checksum_types,
+							      G_N_ELEMENTS(checksum_types),
+							      &error);
+		g_assert_no_error(error);
+		g_assert_nonnull(checksums);
+		g_assert_cmpint(g_strv_length(checksums), ==, G_N_ELEMENTS(checksum_types));
+		for (guint j = 0; j < G_N_ELEMENTS(checksum_types); j++) {
+			g_autofree gchar *checksum =
+			    g_compute_checksum_for_bytes(checksum_types[j], blob);
+			g_assert_cmpstr(checksums[j], ==, checksum);
+		}
+	}
+}
+
+static void
+fu_input_stream_checksums_performance_func(void)
+{
+	GChecksumType checksum_types[] = {G_CHECKSUM_SHA1, G_CHECKSUM_SHA256, G_CHECKSUM_SHA512};
+	g_autoptr(GBytes) blob = g_bytes_new_take(g_malloc0(256 * 1024 * 1024), 256 * 1024 * 1024);
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GInputStream) stream = g_memory_input_stream_new_from_bytes(blob);
+	g_autoptr(GTimer) timer = g_timer_new();
+	g_auto(GStrv) checksums = NULL;
+
+	/* one pass per checksum */
+	for (guint i = 0; i < G_N_ELEMENTS(checksum_types); i++) {
+		g_autofree gchar *checksum =
+		    fu_input_stream_compute_checksum(stream, checksum_types[i], &error);
+		g_assert_no_error(error);
+		g_assert_nonnull(checksum);
+	}
+	g_print("single=%.3fms ", g_timer_elapsed(timer, NULL) * 1000.f);
+
+	/* one pass for all checksums */
+	g_timer_reset(timer);
+	checksums = fu_input_stream_compute_checksums(stream,
+						      checksum_types,
+						      G_N_ELEMENTS(checksum_types),
+						      &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(checksums);
+	g_print("multi=%.3fms ", g_timer_elapsed(timer, NULL) * 1000.f);
+}
+
 static void
 fu_lzma_func(void)
 {
@@ -6757,6 +7804,62 @@ fu_plugin_efi_signature_list_func(void)
 	g_assert_cmpint(fu_firmware_get_version_raw(FU_FIRMWARE(sig)), ==, 2024);
 }
 
+static void
+fu_plugin_efi_signature_list_checksum_func(void)
+{
+	gboolean ret;
+	g_autoptr(FuFirmware) img = NULL;
+	g_autoptr(FuFirmware) siglist = fu_efi_signature_list_new();
+	g_autoptr(GError) error = NULL;
+	const gchar *xml =
+	    "<firmware gtype=\"FuEfiSignatureList\">\n"
+	    "  <firmware gtype=\"FuEfiSignature\">\n"
+	    "    <kind>sha256</kind>\n"
+	    "    <owner>77fa9abd-0359-4d32-bd60-28f4e78f784b</owner>\n"
+	    "    <checksum>819ebd0aeb8f0b73d237a02d9344ad1fd6fae6ad763cacf1694a6d13c1986cde"
+	    "</checksum>\n"
+	    "  </firmware>\n"
+	    "  <firmware gtype=\"FuEfiSignature\">\n"
+	    "    <kind>sha256</kind>\n"
+	    "    <owner>77fa9abd-0359-4d32-bd60-28f4e78f784b</owner>\n"
+	    "    <checksum>418ad44c79e3fddd6a0574b24fcf0fb8fee4b3ff2be635d21a5c0852bdea635c"
+	    "</checksum>\n"
+	    "  </firmware>\n"
+	    "</firmware>\n";
+
+	ret = fu_firmware_build_from_xml(siglist, xml, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+
+	/* uses the sorted index */
+	g_assert_true(fu_efi_signature_list_has_checksum(
+	    FU_EFI_SIGNATURE_LIST(siglist),
+	    "418ad44c79e3fddd6a0574b24fcf0fb8fee4b3ff2be635d21a5c0852bdea635c"));
+	g_assert_true(fu_efi_signature_list_has_checksum(
+	    FU_EFI_SIGNATURE_LIST(siglist),
+	    "819EBD0AEB8F0B73D237A02D9344AD1FD6FAE6AD763CACF1694A6D13C1986CDE"));
+	g_assert_false(fu_efi_signature_list_has_checksum(
+	    FU_EFI_SIGNATURE_LIST(siglist),
+	    "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"));
+	g_assert_false(fu_efi_signature_list_has_checksum(FU_EFI_SIGNATURE_LIST(siglist), "dead"));
+
+	/* same result as the slow path */
+	img = fu_firmware_get_image_by_checksum(
+	    siglist,
+	    "418ad44c79e3fddd6a0574b24fcf0fb8fee4b3ff2be635d21a5c0852bdea635c",
+	    &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(img);
+
+	/* index is rebuilt when a signature is removed */
+	ret = fu_firmware_remove_image(siglist, img, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	g_assert_false(fu_efi_signature_list_has_checksum(
+	    FU_EFI_SIGNATURE_LIST(siglist),
+	    "418ad44c79e3fddd6a0574b24fcf0fb8fee4b3ff2be635d21a5c0852bdea635c"));
+}
+
 static void
 fu_device_possible_plugin_func(void)
 {
@@ -6889,6 +7992,142 @@ fu_cab_checksum_func(void)
 	}
 }
 
+static void
+fu_cab_lazy_func(void)
+{
+	gboolean ret;
+	g_autoptr(FuCabFirmware) cab1 = fu_cab_firmware_new();
+	g_autoptr(FuCabFirmware) cab2 = fu_cab_firmware_new();
+	g_autoptr(GByteArray) buf = g_byte_array_new();
+	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(GBytes) blob_img1 = NULL;
+	g_autoptr(GBytes) blob_img2 = NULL;
+	g_autoptr(GBytes) blob_tmp = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GInputStream) stream = NULL;
+	g_autoptr(FuFirmware) img1 = FU_FIRMWARE(fu_cab_image_new());
+	g_autoptr(FuFirmware) img2 = FU_FIRMWARE(fu_cab_image_new());
+	g_autoptr(FuFirmware) img_tmp = NULL;
+
+	/* spans lots of CFDATA blocks */
+	for (guint i = 0; i < 0x40000; i++)
+		fu_byte_array_append_uint8(buf, (i * i) >> 7);
+	blob_img1 = g_bytes_new(buf->data, 0x30000);
+	blob_img2 = g_bytes_new(buf->data + 0x30000, buf->len - 0x30000);
+	fu_firmware_set_id(img1, "img1.bin");
+	fu_firmware_set_bytes(img1, blob_img1);
+	ret = fu_firmware_add_image(FU_FIRMWARE(cab1), img1, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	fu_firmware_set_id(img2, "img2.bin");
+	fu_firmware_set_bytes(img2, blob_img2);
+	ret = fu_firmware_add_image(FU_FIRMWARE(cab1), img2, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	fu_cab_firmware_set_compressed(cab1, TRUE);
+	blob = fu_firmware_write(FU_FIRMWARE(cab1), &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(blob);
+
+	/* parsing checks the data but does not keep any of it */
+	stream = g_memory_input_stream_new_from_bytes(blob);
+	ret = fu_firmware_parse_stream(FU_FIRMWARE(cab2),
+				       stream,
+				       0x0,
+				       FU_FIRMWARE_PARSE_FLAG_CACHE_STREAM,
+				       &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	g_assert_true(fu_cab_firmware_get_compressed(cab2));
+
+	/* read the second image first, so that the first has to restart the inflate */
+	img_tmp = fu_firmware_get_image_by_id(FU_FIRMWARE(cab2), "img2.bin", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(img_tmp);
+	blob_tmp = fu_firmware_get_bytes(img_tmp, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(blob_tmp);
+	g_assert_true(g_bytes_equal(blob_tmp, blob_img2));
+	g_clear_pointer(&blob_tmp, g_bytes_unref);
+	g_clear_object(&img_tmp);
+	img_tmp = fu_firmware_get_image_by_id(FU_FIRMWARE(cab2), "img1.bin", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(img_tmp);
+	blob_tmp = fu_firmware_get_bytes(img_tmp, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(blob_tmp);
+	g_assert_true(g_bytes_equal(blob_tmp, blob_img1));
+}
+
+static void
+fu_cab_corrupt_func(void)
+{
+	gboolean ret;
+	guint32 off_cfdata = 0;
+	g_autoptr(FuCabFirmware) cab1 = fu_cab_firmware_new();
+	g_autoptr(FuCabFirmware) cab2 = fu_cab_firmware_new();
+	g_autoptr(FuCabFirmware) cab3 = fu_cab_firmware_new();
+	g_autoptr(FuFirmware) img = FU_FIRMWARE(fu_cab_image_new());
+	g_autoptr(GByteArray) buf = g_byte_array_new();
+	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(GBytes) blob_img = NULL;
+	g_autoptr(GBytes) blob_trunc = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GInputStream) stream = NULL;
+	g_autoptr(GInputStream) stream_trunc = NULL;
+
+	for (guint i = 0; i < 0x20000; i++)
+		fu_byte_array_append_uint8(buf, (i * i) >> 7);
+	blob_img = g_bytes_new(buf->data, buf->len);
+	fu_firmware_set_id(img, "img.bin");
+	fu_firmware_set_bytes(img, blob_img);
+	ret = fu_firmware_add_image(FU_FIRMWARE(cab1), img, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	fu_cab_firmware_set_compressed(cab1, TRUE);
+	blob = fu_firmware_write(FU_FIRMWARE(cab1), &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(blob);
+
+	/* a truncated archive fails without any image being read */
+	blob_trunc = g_bytes_new_from_bytes(blob, 0, g_bytes_get_size(blob) - 0x100);
+	stream_trunc = g_memory_input_stream_new_from_bytes(blob_trunc);
+	ret = fu_firmware_parse_stream(FU_FIRMWARE(cab2),
+				       stream_trunc,
+				       0x0,
+				       FU_FIRMWARE_PARSE_FLAG_CACHE_STREAM,
+				       &error);
+	g_assert_nonnull(error);
+	g_assert_false(ret);
+	g_clear_error(&error);
+
+	/* the CFFOLDER follows the 0x24 byte CFHEADER, and the first CFDATA is then
+	 * followed by the CK signature and a deflate block type that does not exist */
+	g_byte_array_set_size(buf, 0);
+	fu_byte_array_append_bytes(buf, blob);
+	ret = fu_memread_uint32_safe(buf->data,
+				     buf->len,
+				     0x24,
+				     &off_cfdata,
+				     G_LITTLE_ENDIAN,
+				     &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	g_assert_cmpint(off_cfdata + 0x8 + 0x3, <, buf->len);
+	g_assert_cmpint(buf->data[off_cfdata + 0x8], ==, 'C');
+	g_assert_cmpint(buf->data[off_cfdata + 0x9], ==, 'K');
+	buf->data[off_cfdata + 0xA] = 0xFF;
+	stream = g_memory_input_stream_new_from_data(buf->data, buf->len, NULL);
+	ret = fu_firmware_parse_stream(FU_FIRMWARE(cab3),
+				       stream,
+				       0x0,
+				       FU_FIRMWARE_PARSE_FLAG_CACHE_STREAM |
+					   FU_FIRMWARE_PARSE_FLAG_IGNORE_CHECKSUM,
+				       &error);
+	g_assert_error(error, FWUPD_ERROR, FWUPD_ERROR_NOT_SUPPORTED);
+	g_assert_false(ret);
+}
+
 static void
 fu_efi_lz77_decompressor_func(void)
 {
@@ -7360,10 +8599,19 @@ main(int argc, char **argv)
 	(void)g_setenv("CACHE_DIRECTORY", "/tmp/fwupd-self-test/cache", TRUE);
 
 	g_test_add_func("/fwupd/cab{checksum}", fu_cab_checksum_func);
+	g_test_add_func("/fwupd/cab{lazy}", fu_cab_lazy_func);
+	g_test_add_func("/fwupd/cab{corrupt}", fu_cab_corrupt_func);
 	g_test_add_func("/fwupd/efi-lz77{decompressor}", fu_efi_lz77_decompressor_func);
 	g_test_add_func("/fwupd/input-stream", fu_input_stream_func);
 	g_test_add_func("/fwupd/input-stream{sum-overflow}", fu_input_stream_sum_overflow_func);
 	g_test_add_func("/fwupd/input-stream{chunkify}", fu_input_stream_chunkify_func);
+	if (g_test_slow())
+		g_test_add_func("/fwupd/input-stream{chunkify-performance}",
+				fu_input_stream_chunkify_performance_func);
+	g_test_add_func("/fwupd/input-stream{checksums}", fu_input_stream_checksums_func);
+	if (g_test_slow())
+		g_test_add_func("/fwupd/input-stream{checksums-performance}",
+				fu_input_stream_checksums_performance_func);
 	g_test_add_func("/fwupd/input-stream{find}", fu_input_stream_find_func);
 	g_test_add_func("/fwupd/partial-input-stream", fu_partial_input_stream_func);
 	g_test_add_func("/fwupd/partial-input-stream{closed-base}",
@@ -7393,6 +8641,7 @@ main(int argc, char **argv)
 	g_test_add_func("/fwupd/progress{no-equal}", fu_progress_non_equal_steps_func);
 	g_test_add_func("/fwupd/progress{finish}", fu_progress_finish_func);
 	g_test_add_func("/fwupd/progress{global-fraction}", fu_progress_global_fraction_func);
+	g_test_add_func("/fwupd/progress{trace}", fu_progress_trace_func);
 	g_test_add_func("/fwupd/bios-attrs{load}", fu_bios_settings_load_func);
 	g_test_add_func("/fwupd/security-attrs{hsi}", fu_security_attrs_hsi_func);
 	g_test_add_func("/fwupd/security-attrs{compare}", fu_security_attrs_compare_func);
@@ -7422,6 +8671,7 @@ main(int argc, char **argv)
 	g_test_add_func("/fwupd/common{bitwise}", fu_common_bitwise_func);
 	g_test_add_func("/fwupd/common{byte-array}", fu_common_byte_array_func);
 	g_test_add_func("/fwupd/common{crc}", fu_common_crc_func);
+	g_test_add_func("/fwupd/common{crc-tables}", fu_common_crc_tables_func);
 	g_test_add_func("/fwupd/common{guid}", fu_common_guid_func);
 	g_test_add_func("/fwupd/common{string-append-kv}", fu_string_append_func);
 	g_test_add_func("/fwupd/common{version-guess-format}", fu_version_guess_format_func);
@@ -7447,9 +8697,14 @@ main(int argc, char **argv)
 	g_test_add_func("/fwupd/efi-load-option{hive}", fu_efi_load_option_hive_func);
 	g_test_add_func("/fwupd/efi-x509-signature", fu_plugin_efi_x509_signature_func);
 	g_test_add_func("/fwupd/efi-signature-list", fu_plugin_efi_signature_list_func);
+	g_test_add_func("/fwupd/efi-signature-list{checksum}",
+			fu_plugin_efi_signature_list_checksum_func);
 	g_test_add_func("/fwupd/efi-variable-authentication2",
 			fu_plugin_efi_variable_authentication2_func);
 	g_test_add_func("/fwupd/efivar", fu_efivar_func);
+	g_test_add_func("/fwupd/efivar{cache}", fu_efivar_cache_func);
+	g_test_add_func("/fwupd/efivar{cache-boot-entry}", fu_efivar_cache_boot_entry_func);
+	g_test_add_func("/fwupd/efivar{cache-monitor}", fu_efivar_cache_monitor_func);
 	g_test_add_func("/fwupd/efivar{bootxxxx}", fu_efivar_boot_func);
 	g_test_add_func("/fwupd/hwids", fu_hwids_func);
 	g_test_add_func("/fwupd/context{flags}", fu_context_flags_func);
@@ -7482,6 +8737,7 @@ main(int argc, char **argv)
 	g_test_add_func("/fwupd/firmware{ihex-signed}", fu_firmware_ihex_signed_func);
 	g_test_add_func("/fwupd/firmware{srec-tokenization}", fu_firmware_srec_tokenization_func);
 	g_test_add_func("/fwupd/firmware{srec}", fu_firmware_srec_func);
+	g_test_add_func("/fwupd/firmware{tokenize-fuzz}", fu_firmware_tokenize_fuzz_func);
 	g_test_add_func("/fwupd/firmware{fdt}", fu_firmware_fdt_func);
 	g_test_add_func("/fwupd/firmware{fit}", fu_firmware_fit_func);
 	g_test_add_func("/fwupd/firmware{ifwi-cpd}", fu_firmware_ifwi_cpd_func);
@@ -7504,6 +8760,7 @@ main(int argc, char **argv)
 	g_test_add_func("/fwupd/device{event}", fu_device_event_func);
 	g_test_add_func("/fwupd/device{event-uncompressed}", fu_device_event_uncompressed_func);
 	g_test_add_func("/fwupd/device{event-donor}", fu_device_event_donor_func);
+	g_test_add_func("/fwupd/device{event-replay}", fu_device_event_replay_func);
 	g_test_add_func("/fwupd/device{vfuncs}", fu_device_vfuncs_func);
 	g_test_add_func("/fwupd/device{instance-ids}", fu_device_instance_ids_func);
 	g_test_add_func("/fwupd/device{composite-id}", fu_device_composite_id_func);
@@ -7521,6 +8778,14 @@ main(int argc, char **argv)
 			fu_device_incorporate_descendant_func);
 	if (g_test_slow())
 		g_test_add_func("/fwupd/device{poll}", fu_device_poll_func);
+	if (g_test_slow())
+		g_test_add_func("/fwupd/device{poll-scheduler}", fu_device_poll_scheduler_func);
+	if (g_test_slow())
+		g_test_add_func("/fwupd/device{poll-scheduler-paused}",
+				fu_device_poll_scheduler_paused_func);
+	if (g_test_slow())
+		g_test_add_func("/fwupd/device{poll-scheduler-siblings}",
+				fu_device_poll_scheduler_siblings_func);
 	g_test_add_func("/fwupd/device-locker{success}", fu_device_locker_func);
 	g_test_add_func("/fwupd/device-locker{fail}", fu_device_locker_fail_func);
 	g_test_add_func("/fwupd/device{name}", fu_device_name_func);
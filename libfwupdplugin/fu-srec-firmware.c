@@ -13,6 +13,7 @@
 #include "fu-byte-array.h"
 #include "fu-chunk-array.h"
 #include "fu-firmware-common.h"
+#include "fu-input-stream.h"
 #include "fu-srec-firmware.h"
 #include "fu-string.h"
 
@@ -25,16 +26,34 @@
  */
 
 typedef struct {
-	GPtrArray *records;
+	GArray *tokens;	     /* of FuSrecFirmwareToken */
+	GByteArray *payload; /* data of every token, back to back */
+	GPtrArray *records;  /* of FuSrecFirmwareRecord, created on demand */
 	guint32 addr_min;
 	guint32 addr_max;
 } FuSrecFirmwarePrivate;
 
+/* a parsed line, pointing into ->payload */
+typedef struct {
+	guint ln;
+	FuFirmareSrecRecordKind kind;
+	guint32 addr;
+	gsize payload_offset;
+	gsize payload_sz;
+} FuSrecFirmwareToken;
+
 G_DEFINE_TYPE_WITH_PRIVATE(FuSrecFirmware, fu_srec_firmware, FU_TYPE_FIRMWARE)
 #define GET_PRIVATE(o) (fu_srec_firmware_get_instance_private(o))
 
 #define FU_SREC_FIRMWARE_TOKENS_MAX 100000 /* lines */
 
+static void
+fu_srec_firmware_record_free(FuSrecFirmwareRecord *rcd)
+{
+	g_byte_array_unref(rcd->buf);
+	g_free(rcd);
+}
+
 /**
  * fu_srec_firmware_get_records:
  * @self: A #FuSrecFirmware
@@ -52,7 +71,22 @@ GPtrArray *
 fu_srec_firmware_get_records(FuSrecFirmware *self)
 {
 	FuSrecFirmwarePrivate *priv = GET_PRIVATE(self);
+
 	g_return_val_if_fail(FU_IS_SREC_FIRMWARE(self), NULL);
+
+	/* only the few plugins that need the raw records pay for the allocations */
+	if (priv->records != NULL)
+		return priv->records;
+	priv->records = g_ptr_array_new_with_free_func((GFreeFunc)fu_srec_firmware_record_free);
+	for (guint i = 0; i < priv->tokens->len; i++) {
+		FuSrecFirmwareToken *tok = &g_array_index(priv->tokens, FuSrecFirmwareToken, i);
+		FuSrecFirmwareRecord *rcd;
+		rcd = fu_srec_firmware_record_new(tok->ln, tok->kind, tok->addr);
+		g_byte_array_append(rcd->buf,
+				    priv->payload->data + tok->payload_offset,
+				    tok->payload_sz);
+		g_ptr_array_add(priv->records, rcd);
+	}
 	return priv->records;
 }
 
@@ -90,18 +124,6 @@ fu_srec_firmware_set_addr_max(FuSrecFirmware *self, guint32 addr_max)
 	priv->addr_max = addr_max;
 }
 
-static void
-fu_srec_firmware_record_free(FuSrecFirmwareRecord *rcd)
-{
-	g_byte_array_unref(rcd->buf);
-	g_free(rcd);
-}
-
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Wunused-function"
-G_DEFINE_AUTOPTR_CLEANUP_FUNC(FuSrecFirmwareRecord, fu_srec_firmware_record_free);
-#pragma clang diagnostic pop
-
 /**
  * fu_srec_firmware_record_new: (skip):
  * @ln: unsigned integer
@@ -157,106 +179,80 @@ fu_srec_firmware_record_get_type(void)
 	return type_id;
 }
 
-typedef struct {
-	FuSrecFirmware *self;
-	FuFirmwareParseFlags flags;
-	gboolean got_eof;
-} FuSrecFirmwareTokenHelper;
-
 static gboolean
-fu_srec_firmware_tokenize_cb(GString *token, guint token_idx, gpointer user_data, GError **error)
+fu_srec_firmware_tokenize_line(FuSrecFirmware *self,
+			       guint ln,
+			       const gchar *line,
+			       gsize linesz,
+			       FuFirmwareParseFlags flags,
+			       gboolean *got_eof,
+			       GError **error)
 {
-	FuSrecFirmwareTokenHelper *helper = (FuSrecFirmwareTokenHelper *)user_data;
-	FuSrecFirmwarePrivate *priv = GET_PRIVATE(helper->self);
-	g_autoptr(FuSrecFirmwareRecord) rcd = NULL;
+	FuSrecFirmwarePrivate *priv = GET_PRIVATE(self);
+	FuSrecFirmwareToken tok = {.ln = ln};
 	gboolean require_data = FALSE;
-	guint32 rec_addr32;
 	guint16 rec_addr16;
 	guint8 addrsz = 0; /* bytes */
 	guint8 rec_count;  /* words */
 	guint8 rec_kind;
 
-	/* sanity check */
-	if (token_idx > FU_SREC_FIRMWARE_TOKENS_MAX) {
-		g_set_error_literal(error,
-				    FWUPD_ERROR,
-				    FWUPD_ERROR_INVALID_DATA,
-				    "file has too many lines");
-		return FALSE;
-	}
-
-	/* remove WIN32 line endings */
-	g_strdelimit(token->str, "\r\x1a", '\0');
-	token->len = strlen(token->str);
-
-	/* ignore blank lines */
-	if (token->len == 0)
-		return TRUE;
-
 	/* check starting token */
-	if (token->str[0] != 'S' || token->len < 3) {
-		g_autofree gchar *strsafe = fu_strsafe(token->str, 3);
+	if (line[0] != 'S' || linesz < 3) {
+		g_autofree gchar *tmp = g_strndup(line, MIN(linesz, 3));
+		g_autofree gchar *strsafe = fu_strsafe(tmp, 3);
 		if (strsafe != NULL) {
 			g_set_error(error,
 				    FWUPD_ERROR,
 				    FWUPD_ERROR_INVALID_FILE,
 				    "invalid starting token, got '%s' at line %u",
 				    strsafe,
-				    token_idx + 1);
+				    ln);
 			return FALSE;
 		}
 		g_set_error(error,
 			    FWUPD_ERROR,
 			    FWUPD_ERROR_INVALID_FILE,
 			    "invalid starting token at line %u",
-			    token_idx + 1);
+			    ln);
 		return FALSE;
 	}
 
 	/* kind, count, address, (data), checksum, linefeed */
-	rec_kind = token->str[1] - '0';
-	if (!fu_firmware_strparse_uint8_safe(token->str, token->len, 2, &rec_count, error))
+	rec_kind = line[1] - '0';
+	if (!fu_firmware_strparse_uint8_safe(line, linesz, 2, &rec_count, error))
 		return FALSE;
-	if (rec_count * 2 != token->len - 4) {
+	if (rec_count * 2 != linesz - 4) {
 		g_set_error(error,
 			    FWUPD_ERROR,
 			    FWUPD_ERROR_INVALID_FILE,
 			    "count incomplete at line %u, "
 			    "length %u, expected %u",
-			    token_idx + 1,
-			    (guint)token->len - 4,
+			    ln,
+			    (guint)linesz - 4,
 			    (guint)rec_count * 2);
 		return FALSE;
 	}
 
 	/* checksum check */
-	if ((helper->flags & FU_FIRMWARE_PARSE_FLAG_IGNORE_CHECKSUM) == 0) {
+	if ((flags & FU_FIRMWARE_PARSE_FLAG_IGNORE_CHECKSUM) == 0) {
+		guint8 buf[G_MAXUINT8 + 1] = {0};
 		guint8 rec_csum = 0;
 		guint8 rec_csum_expected;
-		for (guint8 i = 0; i < rec_count; i++) {
-			guint8 csum_tmp = 0;
-			if (!fu_firmware_strparse_uint8_safe(token->str,
-							     token->len,
-							     (i * 2) + 2,
-							     &csum_tmp,
-							     error))
-				return FALSE;
-			rec_csum += csum_tmp;
-		}
-		rec_csum ^= 0xff;
-		if (!fu_firmware_strparse_uint8_safe(token->str,
-						     token->len,
-						     (rec_count * 2) + 2,
-						     &rec_csum_expected,
-						     error))
+
+		/* the count, address and data, and then the checksum */
+		if (!fu_firmware_strparse_hex_safe(line, linesz, 2, buf, rec_count + 1, error))
 			return FALSE;
+		for (guint8 i = 0; i < rec_count; i++)
+			rec_csum += buf[i];
+		rec_csum ^= 0xff;
+		rec_csum_expected = buf[rec_count];
 		if (rec_csum != rec_csum_expected) {
 			g_set_error(error,
 				    FWUPD_ERROR,
 				    FWUPD_ERROR_INVALID_FILE,
 				    "checksum incorrect line %u, "
 				    "expected %02x, got %02x",
-				    token_idx + 1,
+				    ln,
 				    rec_csum_expected,
 				    rec_csum);
 			return FALSE;
@@ -280,68 +276,52 @@ fu_srec_firmware_tokenize_cb(GString *token, guint token_idx, gpointer user_data
 		break;
 	case FU_FIRMWARE_SREC_RECORD_KIND_S5_COUNT_16:
 		addrsz = 2;
-		helper->got_eof = TRUE;
+		*got_eof = TRUE;
 		break;
 	case FU_FIRMWARE_SREC_RECORD_KIND_S6_COUNT_24:
 		addrsz = 3;
 		break;
 	case FU_FIRMWARE_SREC_RECORD_KIND_S7_COUNT_32:
 		addrsz = 4;
-		helper->got_eof = TRUE;
+		*got_eof = TRUE;
 		break;
 	case FU_FIRMWARE_SREC_RECORD_KIND_S8_TERMINATION_24:
 		addrsz = 3;
-		helper->got_eof = TRUE;
+		*got_eof = TRUE;
 		break;
 	case FU_FIRMWARE_SREC_RECORD_KIND_S9_TERMINATION_16:
 		addrsz = 2;
-		helper->got_eof = TRUE;
+		*got_eof = TRUE;
 		break;
 	default:
 		g_set_error(error,
 			    FWUPD_ERROR,
 			    FWUPD_ERROR_INVALID_FILE,
 			    "invalid srec record type S%c at line %u",
-			    token->str[1],
-			    token_idx + 1);
+			    line[1],
+			    ln);
 		return FALSE;
 	}
+	tok.kind = rec_kind;
 
 	/* parse address */
 	switch (addrsz) {
 	case 2:
-		if (!fu_firmware_strparse_uint16_safe(token->str,
-						      token->len,
-						      4,
-						      &rec_addr16,
-						      error))
+		if (!fu_firmware_strparse_uint16_safe(line, linesz, 4, &rec_addr16, error))
 			return FALSE;
-		rec_addr32 = rec_addr16;
+		tok.addr = rec_addr16;
 		break;
 	case 3:
-		if (!fu_firmware_strparse_uint24_safe(token->str,
-						      token->len,
-						      4,
-						      &rec_addr32,
-						      error))
+		if (!fu_firmware_strparse_uint24_safe(line, linesz, 4, &tok.addr, error))
 			return FALSE;
 		break;
 	case 4:
-		if (!fu_firmware_strparse_uint32_safe(token->str,
-						      token->len,
-						      4,
-						      &rec_addr32,
-						      error))
+		if (!fu_firmware_strparse_uint32_safe(line, linesz, 4, &tok.addr, error))
 			return FALSE;
 		break;
 	default:
 		g_assert_not_reached();
 	}
-	g_debug("line %03u S%u addr:0x%04x datalen:0x%02x",
-		token_idx + 1,
-		rec_kind,
-		rec_addr32,
-		(guint)rec_count - addrsz - 1);
 	if (require_data && rec_count == addrsz) {
 		g_set_error(error,
 			    FWUPD_ERROR,
@@ -351,21 +331,20 @@ fu_srec_firmware_tokenize_cb(GString *token, guint token_idx, gpointer user_data
 		return FALSE;
 	}
 
-	/* data */
-	rcd = fu_srec_firmware_record_new(token_idx + 1, rec_kind, rec_addr32);
+	/* decode straight into the shared payload buffer */
+	tok.payload_offset = priv->payload->len;
 	if (rec_kind == 1 || rec_kind == 2 || rec_kind == 3) {
-		for (gsize i = 4 + (addrsz * 2); i <= rec_count * 2; i += 2) {
-			guint8 tmp = 0;
-			if (!fu_firmware_strparse_uint8_safe(token->str,
-							     token->len,
-							     i,
-							     &tmp,
-							     error))
-				return FALSE;
-			fu_byte_array_append_uint8(rcd->buf, tmp);
-		}
+		tok.payload_sz = rec_count - addrsz - 1;
+		g_byte_array_set_size(priv->payload, priv->payload->len + tok.payload_sz);
+		if (!fu_firmware_strparse_hex_safe(line,
+						   linesz,
+						   4 + (addrsz * 2),
+						   priv->payload->data + tok.payload_offset,
+						   tok.payload_sz,
+						   error))
+			return FALSE;
 	}
-	g_ptr_array_add(priv->records, g_steal_pointer(&rcd));
+	g_array_append_val(priv->tokens, tok);
 	return TRUE;
 }
 
@@ -376,14 +355,70 @@ fu_srec_firmware_tokenize(FuFirmware *firmware,
 			  GError **error)
 {
 	FuSrecFirmware *self = FU_SREC_FIRMWARE(firmware);
-	FuSrecFirmwareTokenHelper helper = {.self = self, .flags = flags, .got_eof = FALSE};
+	FuSrecFirmwarePrivate *priv = GET_PRIVATE(self);
+	const gchar *text;
+	const gchar *nul;
+	gboolean got_eof = FALSE;
+	gsize textsz = 0;
+	gsize offset = 0;
+	guint token_idx = 0;
+	g_autoptr(GBytes) blob = NULL;
+
+	/* read once and split in-place, stopping at the first NUL like fu_strsplit_stream() */
+	blob = fu_input_stream_read_bytes(stream, 0x0, G_MAXSIZE, NULL, error);
+	if (blob == NULL)
+		return FALSE;
+	text = g_bytes_get_data(blob, &textsz);
+	nul = memchr(text, '\0', textsz);
+	if (nul != NULL)
+		textsz = nul - text;
+	g_clear_pointer(&priv->records, g_ptr_array_unref);
+	g_array_set_size(priv->tokens, 0);
+	g_byte_array_set_size(priv->payload, 0);
 
 	/* parse records */
-	if (!fu_strsplit_stream(stream, 0x0, "\n", fu_srec_firmware_tokenize_cb, &helper, error))
-		return FALSE;
+	while (offset <= textsz) {
+		const gchar *line = text + offset;
+		const gchar *eol = memchr(line, '\n', textsz - offset);
+		gsize tokensz = eol != NULL ? (gsize)(eol - line) : textsz - offset;
+		gsize linesz = 0;
+
+		/* the next line */
+		offset += tokensz + 1;
+
+		/* sanity check is valid UTF-8 */
+		if (!g_utf8_validate_len(line, tokensz, NULL)) {
+			g_debug("ignoring invalid UTF-8 at offset 0x%x", (guint)(line - text));
+			continue;
+		}
+		if (token_idx > FU_SREC_FIRMWARE_TOKENS_MAX) {
+			g_set_error_literal(error,
+					    FWUPD_ERROR,
+					    FWUPD_ERROR_INVALID_DATA,
+					    "file has too many lines");
+			return FALSE;
+		}
+		token_idx++;
+
+		/* remove WIN32 line endings */
+		while (linesz < tokensz && line[linesz] != '\r' && line[linesz] != '\x1a')
+			linesz++;
+
+		/* ignore blank lines */
+		if (linesz == 0)
+			continue;
+		if (!fu_srec_firmware_tokenize_line(self,
+						    token_idx,
+						    line,
+						    linesz,
+						    flags,
+						    &got_eof,
+						    error))
+			return FALSE;
+	}
 
 	/* no EOF */
-	if (!helper.got_eof) {
+	if (!got_eof) {
 		g_set_error_literal(error,
 				    FWUPD_ERROR,
 				    FWUPD_ERROR_INVALID_FILE,
@@ -406,11 +441,12 @@ fu_srec_firmware_parse(FuFirmware *firmware,
 	guint32 addr32_last = 0;
 	guint32 img_address = 0;
 	g_autoptr(GBytes) img_bytes = NULL;
-	g_autoptr(GByteArray) outbuf = g_byte_array_new();
+	g_autoptr(GByteArray) outbuf = g_byte_array_sized_new(priv->payload->len);
 
 	/* parse records */
-	for (guint j = 0; j < priv->records->len; j++) {
-		FuSrecFirmwareRecord *rcd = g_ptr_array_index(priv->records, j);
+	for (guint j = 0; j < priv->tokens->len; j++) {
+		FuSrecFirmwareToken *rcd = &g_array_index(priv->tokens, FuSrecFirmwareToken, j);
+		const guint8 *data = priv->payload->data + rcd->payload_offset;
 
 		/* header */
 		if (rcd->kind == FU_FIRMWARE_SREC_RECORD_KIND_S0_HEADER) {
@@ -427,8 +463,8 @@ fu_srec_firmware_parse(FuFirmware *firmware,
 			}
 
 			/* could be anything, lets assume text */
-			for (guint i = 0; i < rcd->buf->len; i++) {
-				gchar tmp = rcd->buf->data[i];
+			for (guint i = 0; i < rcd->payload_sz; i++) {
+				gchar tmp = data[i];
 				if (!g_ascii_isgraph(tmp))
 					break;
 				g_string_append_c(modname, tmp);
@@ -511,15 +547,16 @@ fu_srec_firmware_parse(FuFirmware *firmware,
 						addr32_last + 1,
 						addr32_last + len_hole - 1,
 						rcd->ln);
-					for (guint i = 0; i < len_hole; i++)
-						fu_byte_array_append_uint8(outbuf, 0xff);
+					fu_byte_array_set_size(outbuf,
+							       outbuf->len + len_hole,
+							       0xff);
 				}
 
 				/* add data */
-				g_byte_array_append(outbuf, rcd->buf->data, rcd->buf->len);
+				g_byte_array_append(outbuf, data, rcd->payload_sz);
 				if (img_address == 0x0)
 					img_address = rcd->addr;
-				addr32_last = rcd->addr + rcd->buf->len;
+				addr32_last = rcd->addr + rcd->payload_sz;
 				if (addr32_last < rcd->addr) {
 					g_set_error(error,
 						    FWUPD_ERROR,
@@ -656,7 +693,10 @@ fu_srec_firmware_finalize(GObject *object)
 {
 	FuSrecFirmware *self = FU_SREC_FIRMWARE(object);
 	FuSrecFirmwarePrivate *priv = GET_PRIVATE(self);
-	g_ptr_array_unref(priv->records);
+	g_array_unref(priv->tokens);
+	g_byte_array_unref(priv->payload);
+	if (priv->records != NULL)
+		g_ptr_array_unref(priv->records);
 	G_OBJECT_CLASS(fu_srec_firmware_parent_class)->finalize(object);
 }
 
@@ -664,7 +704,8 @@ static void
 fu_srec_firmware_init(FuSrecFirmware *self)
 {
 	FuSrecFirmwarePrivate *priv = GET_PRIVATE(self);
-	priv->records = g_ptr_array_new_with_free_func((GFreeFunc)fu_srec_firmware_record_free);
+	priv->tokens = g_array_new(FALSE, FALSE, sizeof(FuSrecFirmwareToken));
+	priv->payload = g_byte_array_new();
 	fu_firmware_add_flag(FU_FIRMWARE(self), FU_FIRMWARE_FLAG_HAS_CHECKSUM);
 }
 
@@ -49,6 +49,7 @@ typedef struct {
 	FuIoChannelOpenFlags open_flags;
 	GHashTable *properties;
 	gboolean properties_valid;
+	GHashTable *sysfs_attrs; /* (nullable) attr:value, only for immutable attributes */
 } FuUdevDevicePrivate;
 
 G_DEFINE_TYPE_WITH_PRIVATE(FuUdevDevice, fu_udev_device, FU_TYPE_DEVICE);
@@ -81,8 +82,11 @@ void
 fu_udev_device_emit_changed(FuUdevDevice *self)
 {
 	g_autoptr(GError) error = NULL;
+	FuUdevDevicePrivate *priv = GET_PRIVATE(self);
 	g_return_if_fail(FU_IS_UDEV_DEVICE(self));
 	g_debug("FuUdevDevice emit changed");
+	if (priv->sysfs_attrs != NULL)
+		g_hash_table_remove_all(priv->sysfs_attrs);
 	if (!fu_device_rescan(FU_DEVICE(self), &error))
 		g_debug("%s", error->message);
 	g_signal_emit(self, signals[SIGNAL_CHANGED], 0);
@@ -625,6 +629,8 @@ fu_udev_device_invalidate(FuDevice *device)
 	FuUdevDevicePrivate *priv = GET_PRIVATE(self);
 	priv->properties_valid = FALSE;
 	g_hash_table_remove_all(priv->properties);
+	if (priv->sysfs_attrs != NULL)
+		g_hash_table_remove_all(priv->sysfs_attrs);
 }
 
 static void
@@ -1845,6 +1851,27 @@ fu_udev_device_list_sysfs(FuUdevDevice *self, GError **error)
 	return g_steal_pointer(&attrs);
 }
 
+/* these never change for the lifetime of the kernel device, and are read by lots of plugins */
+static gboolean
+fu_udev_device_sysfs_attr_is_immutable(const gchar *attr)
+{
+	const gchar *attrs[] = {
+	    "class",
+	    "device",
+	    "idProduct",
+	    "idVendor",
+	    "modalias",
+	    "subsystem_device",
+	    "subsystem_vendor",
+	    "vendor",
+	};
+	for (guint i = 0; i < G_N_ELEMENTS(attrs); i++) {
+		if (g_strcmp0(attr, attrs[i]) == 0)
+			return TRUE;
+	}
+	return FALSE;
+}
+
 /**
  * fu_udev_device_read_sysfs:
  * @self: a #FuUdevDevice
@@ -1861,6 +1888,7 @@ fu_udev_device_list_sysfs(FuUdevDevice *self, GError **error)
 gchar *
 fu_udev_device_read_sysfs(FuUdevDevice *self, const gchar *attr, guint timeout_ms, GError **error)
 {
+	FuUdevDevicePrivate *priv = GET_PRIVATE(self);
 	FuDeviceEvent *event = NULL;
 	g_autofree gchar *event_id = NULL;
 	g_autofree gchar *path = NULL;
@@ -1891,6 +1919,16 @@ fu_udev_device_read_sysfs(FuUdevDevice *self, const gchar *attr, guint timeout_m
 	if (event_id != NULL)
 		event = fu_device_save_event(FU_DEVICE(self), event_id);
 
+	/* read previously */
+	if (priv->sysfs_attrs != NULL) {
+		const gchar *value_tmp = g_hash_table_lookup(priv->sysfs_attrs, attr);
+		if (value_tmp != NULL) {
+			if (event != NULL)
+				fu_device_event_set_str(event, "Data", value_tmp);
+			return g_strdup(value_tmp);
+		}
+	}
+
 	/* open the file */
 	if (fu_udev_device_get_sysfs_path(self) == NULL) {
 		g_set_error_literal(error,
@@ -1930,6 +1968,15 @@ fu_udev_device_read_sysfs(FuUdevDevice *self, const gchar *attr, guint timeout_m
 	if (event != NULL)
 		fu_device_event_set_str(event, "Data", value);
 
+	/* save for next time */
+	if (fu_udev_device_sysfs_attr_is_immutable(attr)) {
+		if (priv->sysfs_attrs == NULL) {
+			priv->sysfs_attrs =
+			    g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+		}
+		g_hash_table_insert(priv->sysfs_attrs, g_strdup(attr), g_strdup(value));
+	}
+
 	/* success */
 	return g_steal_pointer(&value);
 }
@@ -2523,6 +2570,8 @@ fu_udev_device_finalize(GObject *object)
 	FuUdevDevicePrivate *priv = GET_PRIVATE(self);
 
 	g_hash_table_unref(priv->properties);
+	if (priv->sysfs_attrs != NULL)
+		g_hash_table_unref(priv->sysfs_attrs);
 	g_free(priv->subsystem);
 	g_free(priv->devtype);
 	g_free(priv->bind_id);
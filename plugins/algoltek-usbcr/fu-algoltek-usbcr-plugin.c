@@ -27,6 +27,7 @@ fu_algoltek_usbcr_plugin_constructed(GObject *obj)
 	FuPlugin *plugin = FU_PLUGIN(obj);
 	fu_plugin_add_device_udev_subsystem(plugin, "block:disk");
 	fu_plugin_add_device_gtype(plugin, FU_TYPE_ALGOLTEK_USBCR_DEVICE);
+	fu_plugin_add_flag(plugin, FWUPD_PLUGIN_FLAG_THREAD_SAFE);
 	fu_plugin_add_firmware_gtype(plugin, NULL, FU_TYPE_ALGOLTEK_USBCR_FIRMWARE);
 }
 
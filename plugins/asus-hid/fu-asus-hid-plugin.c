@@ -31,6 +31,7 @@ fu_asus_hid_plugin_constructed(GObject *obj)
 	fu_context_add_quirk_key(ctx, "AsusHidNumMcu");
 	fu_plugin_add_firmware_gtype(plugin, NULL, FU_TYPE_ASUS_HID_FIRMWARE);
 	fu_plugin_add_udev_subsystem(plugin, "hidraw");
+	fu_plugin_add_flag(plugin, FWUPD_PLUGIN_FLAG_THREAD_SAFE);
 }
 
 static void
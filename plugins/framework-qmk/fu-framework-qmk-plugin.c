@@ -26,6 +26,7 @@ fu_framework_qmk_plugin_constructed(GObject *obj)
 	FuPlugin *plugin = FU_PLUGIN(obj);
 	fu_plugin_add_device_gtype(plugin, FU_TYPE_FRAMEWORK_QMK_DEVICE);
 	fu_plugin_add_udev_subsystem(plugin, "hidraw");
+	fu_plugin_add_flag(plugin, FWUPD_PLUGIN_FLAG_THREAD_SAFE);
 }
 
 static void
@@ -30,6 +30,7 @@ fu_legion_hid_plugin_constructed(GObject *obj)
 	fu_plugin_add_firmware_gtype(plugin, NULL, FU_TYPE_LEGION_HID_FIRMWARE);
 	fu_plugin_add_device_gtype(plugin, FU_TYPE_LEGION_HID_CHILD);
 	fu_plugin_set_device_gtype_default(plugin, FU_TYPE_LEGION_HID_DEVICE);
+	fu_plugin_add_flag(plugin, FWUPD_PLUGIN_FLAG_THREAD_SAFE);
 }
 
 static void
@@ -29,6 +29,7 @@ fu_nvme_plugin_constructed(GObject *obj)
 	fu_context_add_quirk_key(ctx, "NvmeSerialSuffixChars");
 	fu_plugin_add_device_udev_subsystem(plugin, "nvme");
 	fu_plugin_add_device_gtype(plugin, FU_TYPE_NVME_DEVICE);
+	fu_plugin_add_flag(plugin, FWUPD_PLUGIN_FLAG_THREAD_SAFE);
 }
 
 static void
@@ -17,6 +17,8 @@
 #include "fu-redfish-smbios.h"
 #include "fu-redfish-smc-device.h"
 
+#define FU_REDFISH_BACKEND_REQUESTS_INFLIGHT_MAX 8
+
 struct _FuRedfishBackend {
 	FuBackend parent_instance;
 	gchar *hostname;
@@ -35,7 +37,7 @@ struct _FuRedfishBackend {
 	gint64 max_image_size; /* bytes */
 	gchar *system_id;
 	GType device_gtype;
-	GHashTable *request_cache; /* str:GByteArray */
+	GHashTable *request_cache; /* str:FuRedfishRequestCacheItem */
 	CURLSH *curlsh;
 };
 
@@ -152,14 +154,12 @@ fu_redfish_backend_coldplug_collection(FuRedfishBackend *self,
 				       GError **error)
 {
 	JsonArray *members = json_object_get_array_member(collection, "Members");
-	for (guint i = 0; i < json_array_get_length(members); i++) {
-		JsonObject *json_obj;
-		JsonObject *member_id;
-		const gchar *member_uri;
-		g_autoptr(FuRedfishRequest) request = fu_redfish_backend_request_new(self);
+	g_autoptr(GPtrArray) requests = g_ptr_array_new_with_free_func(g_object_unref);
+	g_autoptr(GPtrArray) paths = g_ptr_array_new();
 
-		member_id = json_array_get_object_element(members, i);
-		member_uri = json_object_get_string_member(member_id, "@odata.id");
+	for (guint i = 0; i < json_array_get_length(members); i++) {
+		JsonObject *member_id = json_array_get_object_element(members, i);
+		const gchar *member_uri = json_object_get_string_member(member_id, "@odata.id");
 		if (member_uri == NULL) {
 			g_set_error_literal(error,
 					    FWUPD_ERROR,
@@ -167,26 +167,119 @@ fu_redfish_backend_coldplug_collection(FuRedfishBackend *self,
 					    "no @odata.id string");
 			return FALSE;
 		}
+		g_ptr_array_add(requests, fu_redfish_backend_request_new(self));
+		g_ptr_array_add(paths, (gpointer)member_uri);
+	}
 
-		/* create the device for the member */
-		if (!fu_redfish_request_perform(request,
-						member_uri,
-						FU_REDFISH_REQUEST_PERFORM_FLAG_LOAD_JSON,
-						error))
-			return FALSE;
-		json_obj = fu_redfish_request_get_json_object(request);
+	/* get all the members at once, as each round-trip to the BMC is slow */
+	if (!fu_redfish_request_perform_many(requests,
+					     paths,
+					     FU_REDFISH_BACKEND_REQUESTS_INFLIGHT_MAX,
+					     FU_REDFISH_REQUEST_PERFORM_FLAG_LOAD_JSON,
+					     error))
+		return FALSE;
+
+	/* create the device for each member, in order */
+	for (guint i = 0; i < requests->len; i++) {
+		FuRedfishRequest *request = g_ptr_array_index(requests, i);
+		JsonObject *json_obj = fu_redfish_request_get_json_object(request);
 		if (!fu_redfish_backend_coldplug_member(self, json_obj, error))
 			return FALSE;
 	}
 	return TRUE;
 }
 
+static gchar *
+fu_redfish_backend_get_cache_filename(FuRedfishBackend *self)
+{
+	g_autofree gchar *basename = g_strdup_printf("%s-%u.gvariant", self->hostname, self->port);
+	g_strdelimit(basename, "/:[]", '_');
+	return fu_path_build(FU_PATH_KIND_CACHEDIR_PKG, "redfish", basename, NULL);
+}
+
+/* entries are stale as the BMC may have changed since, but can be revalidated using the ETag */
+static void
+fu_redfish_backend_cache_load(FuRedfishBackend *self)
+{
+	GVariant *data = NULL;
+	GVariantIter iter;
+	const gchar *etag = NULL;
+	const gchar *path = NULL;
+	g_autofree gchar *filename = fu_redfish_backend_get_cache_filename(self);
+	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GVariant) value = NULL;
+
+	if (g_hash_table_size(self->request_cache) > 0)
+		return;
+	if (!g_file_test(filename, G_FILE_TEST_EXISTS))
+		return;
+	blob = fu_bytes_get_contents(filename, &error_local);
+	if (blob == NULL) {
+		g_debug("failed to load request cache: %s", error_local->message);
+		return;
+	}
+	value = g_variant_ref_sink(
+	    g_variant_new_from_bytes(G_VARIANT_TYPE("a{s(say)}"), blob, FALSE));
+	g_variant_iter_init(&iter, value);
+	while (g_variant_iter_next(&iter, "{&s(&s@ay)}", &path, &etag, &data)) {
+		FuRedfishRequestCacheItem *item;
+		gsize bufsz = 0;
+		const guint8 *buf = g_variant_get_fixed_array(data, &bufsz, sizeof(guint8));
+		g_autoptr(GByteArray) buf_tmp = g_byte_array_new();
+
+		g_byte_array_append(buf_tmp, buf, bufsz);
+		item = fu_redfish_request_cache_item_new(buf_tmp, etag);
+		item->stale = TRUE;
+		g_hash_table_insert(self->request_cache, g_strdup(path), item);
+		g_variant_unref(data);
+	}
+	g_debug("loaded %u cached requests from %s",
+		g_hash_table_size(self->request_cache),
+		filename);
+}
+
+static gboolean
+fu_redfish_backend_cache_save(FuRedfishBackend *self, GError **error)
+{
+	GHashTableIter iter;
+	GVariantBuilder builder;
+	gpointer key = NULL;
+	gpointer value = NULL;
+	g_autofree gchar *filename = fu_redfish_backend_get_cache_filename(self);
+	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(GVariant) variant = NULL;
+
+	/* only responses with an ETag can be revalidated */
+	g_variant_builder_init(&builder, G_VARIANT_TYPE("a{s(say)}"));
+	g_hash_table_iter_init(&iter, self->request_cache);
+	while (g_hash_table_iter_next(&iter, &key, &value)) {
+		FuRedfishRequestCacheItem *item = (FuRedfishRequestCacheItem *)value;
+		if (item->etag == NULL)
+			continue;
+		g_variant_builder_add(&builder,
+				      "{s(s@ay)}",
+				      (const gchar *)key,
+				      item->etag,
+				      g_variant_new_fixed_array(G_VARIANT_TYPE_BYTE,
+								item->buf->data,
+								item->buf->len,
+								sizeof(guint8)));
+	}
+	variant = g_variant_ref_sink(g_variant_builder_end(&builder));
+	blob = g_variant_get_data_as_bytes(variant);
+	if (!fu_path_mkdir_parent(filename, error))
+		return FALSE;
+	return fu_bytes_set_contents(filename, blob, error);
+}
+
 static gboolean
 fu_redfish_backend_coldplug_inventory(FuRedfishBackend *self, JsonObject *inventory, GError **error)
 {
 	JsonObject *json_obj;
 	const gchar *collection_uri;
 	g_autoptr(FuRedfishRequest) request = fu_redfish_backend_request_new(self);
+	g_autoptr(GError) error_local = NULL;
 
 	if (inventory == NULL) {
 		g_set_error_literal(error,
@@ -205,13 +298,20 @@ fu_redfish_backend_coldplug_inventory(FuRedfishBackend *self, JsonObject *invent
 		return FALSE;
 	}
 
+	/* revalidate anything we got the last time the daemon was running */
+	fu_redfish_backend_cache_load(self);
+
 	if (!fu_redfish_request_perform(request,
 					collection_uri,
 					FU_REDFISH_REQUEST_PERFORM_FLAG_LOAD_JSON,
 					error))
 		return FALSE;
 	json_obj = fu_redfish_request_get_json_object(request);
-	return fu_redfish_backend_coldplug_collection(self, json_obj, error);
+	if (!fu_redfish_backend_coldplug_collection(self, json_obj, error))
+		return FALSE;
+	if (!fu_redfish_backend_cache_save(self, &error_local))
+		g_debug("failed to save request cache: %s", error_local->message);
+	return TRUE;
 }
 
 static void
@@ -591,7 +691,19 @@ static void
 fu_redfish_backend_invalidate(FuBackend *backend)
 {
 	FuRedfishBackend *self = FU_REDFISH_BACKEND(backend);
-	g_hash_table_remove_all(self->request_cache);
+	GHashTableIter iter;
+	gpointer value = NULL;
+
+	/* keep the payloads so they can be revalidated cheaply using the ETag */
+	g_hash_table_iter_init(&iter, self->request_cache);
+	while (g_hash_table_iter_next(&iter, NULL, &value)) {
+		FuRedfishRequestCacheItem *item = (FuRedfishRequestCacheItem *)value;
+		if (item->etag == NULL) {
+			g_hash_table_iter_remove(&iter);
+			continue;
+		}
+		item->stale = TRUE;
+	}
 }
 
 void
@@ -712,14 +824,16 @@ fu_redfish_backend_init(FuRedfishBackend *self)
 {
 	self->use_https = TRUE;
 	self->device_gtype = FU_TYPE_REDFISH_DEVICE;
-	self->request_cache = g_hash_table_new_full(g_str_hash,
-						    g_str_equal,
-						    g_free,
-						    (GDestroyNotify)g_byte_array_unref);
+	self->request_cache =
+	    g_hash_table_new_full(g_str_hash,
+				  g_str_equal,
+				  g_free,
+				  (GDestroyNotify)fu_redfish_request_cache_item_free);
 	self->curlsh = curl_share_init();
 	curl_share_setopt(self->curlsh, CURLSHOPT_SHARE, CURL_LOCK_DATA_COOKIE);
 	curl_share_setopt(self->curlsh, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
 	curl_share_setopt(self->curlsh, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+	curl_share_setopt(self->curlsh, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
 }
 
 FuRedfishBackend *
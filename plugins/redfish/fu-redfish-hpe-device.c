@@ -16,8 +16,6 @@ struct _FuRedfishHpeDevice {
 
 G_DEFINE_TYPE(FuRedfishHpeDevice, fu_redfish_hpe_device, FU_TYPE_REDFISH_DEVICE)
 
-typedef struct curl_slist _curl_slist;
-G_DEFINE_AUTOPTR_CLEANUP_FUNC(_curl_slist, curl_slist_free_all)
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(curl_mime, curl_mime_free)
 
 static gboolean
@@ -208,9 +206,9 @@ fu_redfish_hpe_device_write_firmware(FuDevice *device,
 	CURL *curl;
 	const gchar *sessionkey;
 	curl_mimepart *part;
+	g_autofree gchar *auth_token = NULL;
 	g_autofree gchar *sessionkey_kv = NULL;
 	g_autoptr(curl_mime) mime = NULL;
-	g_autoptr(_curl_slist) hs = NULL;
 	g_autoptr(FuRedfishRequest) request = NULL;
 	g_autoptr(GBytes) fw = NULL;
 	g_autoptr(GString) json_str = g_string_new(NULL);
@@ -276,13 +274,13 @@ fu_redfish_hpe_device_write_firmware(FuDevice *device,
 	(void)curl_mime_filename(part, "firmware.fwpkg");
 	(void)curl_mime_data(part, g_bytes_get_data(fw, NULL), g_bytes_get_size(fw));
 
-	(void)curl_easy_setopt(curl, CURLOPT_MIMEPOST, mime);
+	fu_redfish_request_set_mime(request, mime);
 
 	sessionkey_kv = g_strconcat("sessionKey=", sessionkey, NULL);
 	(void)curl_easy_setopt(curl, CURLOPT_COOKIE, sessionkey_kv);
 
-	hs = curl_slist_append(hs, g_strconcat("X-Auth-Token: ", sessionkey, NULL));
-	(void)curl_easy_setopt(curl, CURLOPT_HTTPHEADER, hs);
+	auth_token = g_strconcat("X-Auth-Token: ", sessionkey, NULL);
+	fu_redfish_request_add_header(request, auth_token);
 	fu_progress_step_done(progress);
 
 	if (!fu_redfish_request_perform(request,
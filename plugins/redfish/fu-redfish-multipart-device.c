@@ -129,7 +129,7 @@ fu_redfish_multipart_device_write_firmware(FuDevice *device,
 
 	(void)curl_mime_data(part, g_bytes_get_data(fw, NULL), g_bytes_get_size(fw));
 
-	(void)curl_easy_setopt(curl, CURLOPT_MIMEPOST, mime);
+	fu_redfish_request_set_mime(request, mime);
 	(void)curl_easy_setopt(curl,
 			       CURLOPT_HEADERFUNCTION,
 			       fu_redfish_multipart_device_location_headers_callback);
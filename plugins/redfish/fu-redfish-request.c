@@ -16,7 +16,12 @@ struct _FuRedfishRequest {
 	glong status_code;
 	JsonParser *json_parser;
 	JsonObject *json_obj;
-	GHashTable *cache; /* nullable */
+	GHashTable *cache; /* nullable, str:FuRedfishRequestCacheItem */
+	gchar *path;
+	gchar *etag; /* from the response */
+	struct curl_slist *headers;
+	struct curl_slist *headers_conditional; /* nullable, @headers and If-None-Match */
+	gboolean custom_request;		/* not a plain GET, so never cached */
 };
 
 G_DEFINE_TYPE(FuRedfishRequest, fu_redfish_request, G_TYPE_OBJECT)
@@ -24,6 +29,23 @@ G_DEFINE_TYPE(FuRedfishRequest, fu_redfish_request, G_TYPE_OBJECT)
 typedef gchar curlptr;
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(curlptr, curl_free)
 
+FuRedfishRequestCacheItem *
+fu_redfish_request_cache_item_new(GByteArray *buf, const gchar *etag)
+{
+	FuRedfishRequestCacheItem *item = g_new0(FuRedfishRequestCacheItem, 1);
+	item->buf = g_byte_array_ref(buf);
+	item->etag = g_strdup(etag);
+	return item;
+}
+
+void
+fu_redfish_request_cache_item_free(FuRedfishRequestCacheItem *item)
+{
+	g_byte_array_unref(item->buf);
+	g_free(item->etag);
+	g_free(item);
+}
+
 JsonObject *
 fu_redfish_request_get_json_object(FuRedfishRequest *self)
 {
@@ -146,37 +168,72 @@ fu_redfish_request_load_json(FuRedfishRequest *self, GByteArray *buf, GError **e
 	return TRUE;
 }
 
-gboolean
-fu_redfish_request_perform(FuRedfishRequest *self,
+static gboolean
+fu_redfish_request_load_buf(FuRedfishRequest *self,
+			    GByteArray *buf,
+			    FuRedfishRequestPerformFlags flags,
+			    GError **error)
+{
+	if (flags & FU_REDFISH_REQUEST_PERFORM_FLAG_LOAD_JSON)
+		return fu_redfish_request_load_json(self, buf, error);
+
+	/* copy, as CURLOPT_WRITEDATA points at self->buf */
+	g_byte_array_set_size(self->buf, 0);
+	g_byte_array_append(self->buf, buf->data, buf->len);
+	return TRUE;
+}
+
+/* returns TRUE if the request was satisfied from the cache without using the network */
+static gboolean
+fu_redfish_request_prepare(FuRedfishRequest *self,
 			   const gchar *path,
 			   FuRedfishRequestPerformFlags flags,
+			   gboolean *done,
 			   GError **error)
 {
-	CURLcode res;
-	g_autofree gchar *str = NULL;
-	g_autoptr(curlptr) uri_str = NULL;
+	FuRedfishRequestCacheItem *item = NULL;
 
-	g_return_val_if_fail(FU_IS_REDFISH_REQUEST(self), FALSE);
-	g_return_val_if_fail(path != NULL, FALSE);
-	g_return_val_if_fail(self->status_code == 0, FALSE);
-	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+	g_free(self->path);
+	self->path = g_strdup(path);
+	g_clear_pointer(&self->etag, g_free);
 
 	/* already in cache? */
-	if (flags & FU_REDFISH_REQUEST_PERFORM_FLAG_USE_CACHE && self->cache != NULL) {
-		GByteArray *buf = g_hash_table_lookup(self->cache, path);
-		if (buf != NULL) {
-			if (flags & FU_REDFISH_REQUEST_PERFORM_FLAG_LOAD_JSON)
-				return fu_redfish_request_load_json(self, buf, error);
-			g_byte_array_unref(self->buf);
-			self->buf = g_byte_array_ref(buf);
-			return TRUE;
-		}
+	if (self->cache != NULL && !self->custom_request)
+		item = g_hash_table_lookup(self->cache, path);
+	if (item != NULL && !item->stale && flags & FU_REDFISH_REQUEST_PERFORM_FLAG_USE_CACHE) {
+		*done = TRUE;
+		return fu_redfish_request_load_buf(self, item->buf, flags, error);
 	}
 
-	/* do request */
+	/* ask the server to only send the payload if it has changed */
+	g_clear_pointer(&self->headers_conditional, curl_slist_free_all);
+	if (item != NULL && item->etag != NULL) {
+		g_autofree gchar *hdr = g_strdup_printf("If-None-Match: %s", item->etag);
+		for (struct curl_slist *l = self->headers; l != NULL; l = l->next) {
+			self->headers_conditional =
+			    curl_slist_append(self->headers_conditional, l->data);
+		}
+		self->headers_conditional = curl_slist_append(self->headers_conditional, hdr);
+		(void)curl_easy_setopt(self->curl, CURLOPT_HTTPHEADER, self->headers_conditional);
+	} else {
+		(void)curl_easy_setopt(self->curl, CURLOPT_HTTPHEADER, self->headers);
+	}
 	(void)curl_url_set(self->uri, CURLUPART_PATH, path, 0);
+	*done = FALSE;
+	return TRUE;
+}
+
+static gboolean
+fu_redfish_request_process(FuRedfishRequest *self,
+			   CURLcode res,
+			   FuRedfishRequestPerformFlags flags,
+			   GError **error)
+{
+	FuRedfishRequestCacheItem *item = NULL;
+	g_autofree gchar *str = NULL;
+	g_autoptr(curlptr) uri_str = NULL;
+
 	(void)curl_url_get(self->uri, CURLUPART_URL, &uri_str, 0);
-	res = curl_easy_perform(self->curl);
 	curl_easy_getinfo(self->curl, CURLINFO_RESPONSE_CODE, &self->status_code);
 	str = g_strndup((const gchar *)self->buf->data, self->buf->len);
 	g_debug("%s: %s [%li]", uri_str, str, self->status_code);
@@ -201,6 +258,14 @@ fu_redfish_request_perform(FuRedfishRequest *self,
 		return FALSE;
 	}
 
+	/* not modified since the cached copy */
+	if (self->cache != NULL && !self->custom_request)
+		item = g_hash_table_lookup(self->cache, self->path);
+	if (item != NULL && fu_redfish_request_get_status_code(self) == 304) {
+		item->stale = FALSE;
+		return fu_redfish_request_load_buf(self, item->buf, flags, error);
+	}
+
 	/* load JSON */
 	if (flags & FU_REDFISH_REQUEST_PERFORM_FLAG_LOAD_JSON && self->buf->len > 0) {
 		if (!fu_redfish_request_load_json(self, self->buf, error)) {
@@ -210,15 +275,166 @@ fu_redfish_request_perform(FuRedfishRequest *self,
 	}
 
 	/* save to cache */
-	if (self->cache != NULL)
-		g_hash_table_insert(self->cache, g_strdup(path), g_byte_array_ref(self->buf));
+	if (self->cache != NULL && !self->custom_request) {
+		g_autoptr(GByteArray) buf = g_byte_array_new();
+		g_byte_array_append(buf, self->buf->data, self->buf->len);
+		g_hash_table_insert(self->cache,
+				    g_strdup(self->path),
+				    fu_redfish_request_cache_item_new(buf, self->etag));
+	}
 
 	/* success */
 	return TRUE;
 }
 
-typedef struct curl_slist _curl_slist;
-G_DEFINE_AUTOPTR_CLEANUP_FUNC(_curl_slist, curl_slist_free_all)
+gboolean
+fu_redfish_request_perform(FuRedfishRequest *self,
+			   const gchar *path,
+			   FuRedfishRequestPerformFlags flags,
+			   GError **error)
+{
+	gboolean done = FALSE;
+
+	g_return_val_if_fail(FU_IS_REDFISH_REQUEST(self), FALSE);
+	g_return_val_if_fail(path != NULL, FALSE);
+	g_return_val_if_fail(self->status_code == 0, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	if (!fu_redfish_request_prepare(self, path, flags, &done, error))
+		return FALSE;
+	if (done)
+		return TRUE;
+	return fu_redfish_request_process(self, curl_easy_perform(self->curl), flags, error);
+}
+
+/* performs GET requests concurrently, reusing connections and multiplexing if possible */
+gboolean
+fu_redfish_request_perform_many(GPtrArray *requests,
+				GPtrArray *paths,
+				guint max_inflight,
+				FuRedfishRequestPerformFlags flags,
+				GError **error)
+{
+	CURLM *multi;
+	gboolean ret = TRUE;
+	guint inflight = 0;
+	guint idx = 0;
+	g_autoptr(GPtrArray) pending = g_ptr_array_new();
+
+	g_return_val_if_fail(requests != NULL, FALSE);
+	g_return_val_if_fail(paths != NULL, FALSE);
+	g_return_val_if_fail(requests->len == paths->len, FALSE);
+	g_return_val_if_fail(max_inflight > 0, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	/* satisfy what we can from the cache */
+	for (guint i = 0; i < requests->len; i++) {
+		FuRedfishRequest *self = g_ptr_array_index(requests, i);
+		const gchar *path = g_ptr_array_index(paths, i);
+		gboolean done = FALSE;
+
+		g_return_val_if_fail(FU_IS_REDFISH_REQUEST(self), FALSE);
+		g_return_val_if_fail(self->status_code == 0, FALSE);
+		if (!fu_redfish_request_prepare(self, path, flags, &done, error))
+			return FALSE;
+		if (!done)
+			g_ptr_array_add(pending, self);
+	}
+	if (pending->len == 0)
+		return TRUE;
+
+	/* keep a bounded number of transfers in flight */
+	multi = curl_multi_init();
+	(void)curl_multi_setopt(multi, CURLMOPT_PIPELINING, (glong)CURLPIPE_MULTIPLEX);
+	(void)curl_multi_setopt(multi, CURLMOPT_MAX_HOST_CONNECTIONS, (glong)max_inflight);
+	while (ret) {
+		CURLMcode mc;
+		CURLMsg *msg;
+		gint msgs_left = 0;
+		gint running = 0;
+
+		while (inflight < max_inflight && idx < pending->len) {
+			FuRedfishRequest *self = g_ptr_array_index(pending, idx++);
+			(void)curl_easy_setopt(self->curl, CURLOPT_PRIVATE, self);
+			(void)curl_multi_add_handle(multi, self->curl);
+			inflight++;
+		}
+		mc = curl_multi_perform(multi, &running);
+		if (mc != CURLM_OK) {
+			g_set_error(error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_INTERNAL,
+				    "failed to perform requests: %s",
+				    curl_multi_strerror(mc));
+			ret = FALSE;
+			break;
+		}
+		while ((msg = curl_multi_info_read(multi, &msgs_left)) != NULL) {
+			FuRedfishRequest *self = NULL;
+			if (msg->msg != CURLMSG_DONE)
+				continue;
+			(void)curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, &self);
+			(void)curl_multi_remove_handle(multi, msg->easy_handle);
+			inflight--;
+			if (!fu_redfish_request_process(self, msg->data.result, flags, error)) {
+				ret = FALSE;
+				break;
+			}
+		}
+		if (inflight == 0 && idx == pending->len)
+			break;
+		if (ret && running > 0) {
+			mc = curl_multi_wait(multi, NULL, 0, 1000, NULL);
+			if (mc != CURLM_OK) {
+				g_set_error(error,
+					    FWUPD_ERROR,
+					    FWUPD_ERROR_INTERNAL,
+					    "failed to wait for requests: %s",
+					    curl_multi_strerror(mc));
+				ret = FALSE;
+			}
+		}
+	}
+
+	/* abandon anything still in flight; a no-op for handles already removed */
+	for (guint i = 0; i < idx; i++) {
+		FuRedfishRequest *self = g_ptr_array_index(pending, i);
+		(void)curl_multi_remove_handle(multi, self->curl);
+	}
+	curl_multi_cleanup(multi);
+	return ret;
+}
+
+/* the header is kept for every later request, and sent along with any conditional headers */
+void
+fu_redfish_request_add_header(FuRedfishRequest *self, const gchar *header)
+{
+	g_return_if_fail(FU_IS_REDFISH_REQUEST(self));
+	g_return_if_fail(header != NULL);
+	self->headers = curl_slist_append(self->headers, header);
+	(void)curl_easy_setopt(self->curl, CURLOPT_HTTPHEADER, self->headers);
+}
+
+/* the data is not copied, and the response is never cached */
+void
+fu_redfish_request_set_postfields(FuRedfishRequest *self, const gchar *data, gsize datasz)
+{
+	g_return_if_fail(FU_IS_REDFISH_REQUEST(self));
+	g_return_if_fail(data != NULL);
+	self->custom_request = TRUE;
+	(void)curl_easy_setopt(self->curl, CURLOPT_POSTFIELDS, data);
+	(void)curl_easy_setopt(self->curl, CURLOPT_POSTFIELDSIZE, (long)datasz);
+}
+
+/* the response is never cached */
+void
+fu_redfish_request_set_mime(FuRedfishRequest *self, curl_mime *mime)
+{
+	g_return_if_fail(FU_IS_REDFISH_REQUEST(self));
+	g_return_if_fail(mime != NULL);
+	self->custom_request = TRUE;
+	(void)curl_easy_setopt(self->curl, CURLOPT_MIMEPOST, mime);
+}
 
 static void
 fu_redfish_request_reset(FuRedfishRequest *self)
@@ -237,7 +453,6 @@ fu_redfish_request_perform_full(FuRedfishRequest *self,
 				GError **error)
 {
 	g_autofree gchar *etag_header = NULL;
-	g_autoptr(_curl_slist) hs = NULL;
 	g_autoptr(GString) str = g_string_new(NULL);
 	g_autoptr(JsonGenerator) json_generator = json_generator_new();
 	g_autoptr(JsonNode) json_root = NULL;
@@ -277,12 +492,10 @@ fu_redfish_request_perform_full(FuRedfishRequest *self,
 
 	/* patch */
 	(void)curl_easy_setopt(self->curl, CURLOPT_CUSTOMREQUEST, request);
-	(void)curl_easy_setopt(self->curl, CURLOPT_POSTFIELDS, str->str);
-	(void)curl_easy_setopt(self->curl, CURLOPT_POSTFIELDSIZE, (long)str->len);
-	hs = curl_slist_append(hs, "Content-Type: application/json");
+	fu_redfish_request_set_postfields(self, str->str, str->len);
+	fu_redfish_request_add_header(self, "Content-Type: application/json");
 	if (etag_header != NULL)
-		hs = curl_slist_append(hs, etag_header);
-	(void)curl_easy_setopt(self->curl, CURLOPT_HTTPHEADER, hs);
+		fu_redfish_request_add_header(self, etag_header);
 	return fu_redfish_request_perform(self, path, flags, error);
 }
 
@@ -295,6 +508,18 @@ fu_redfish_request_write_cb(char *ptr, size_t size, size_t nmemb, void *userdata
 	return realsize;
 }
 
+static size_t
+fu_redfish_request_header_cb(char *ptr, size_t size, size_t nmemb, void *userdata)
+{
+	FuRedfishRequest *self = FU_REDFISH_REQUEST(userdata);
+	gsize realsize = size * nmemb;
+	if (realsize > 5 && g_ascii_strncasecmp(ptr, "ETag:", 5) == 0) {
+		g_free(self->etag);
+		self->etag = g_strstrip(g_strndup(ptr + 5, realsize - 5));
+	}
+	return realsize;
+}
+
 void
 fu_redfish_request_set_cache(FuRedfishRequest *self, GHashTable *cache)
 {
@@ -321,6 +546,8 @@ fu_redfish_request_init(FuRedfishRequest *self)
 	self->json_parser = json_parser_new();
 	(void)curl_easy_setopt(self->curl, CURLOPT_WRITEFUNCTION, fu_redfish_request_write_cb);
 	(void)curl_easy_setopt(self->curl, CURLOPT_WRITEDATA, self->buf);
+	(void)curl_easy_setopt(self->curl, CURLOPT_HEADERFUNCTION, fu_redfish_request_header_cb);
+	(void)curl_easy_setopt(self->curl, CURLOPT_HEADERDATA, self);
 }
 
 static void
@@ -329,6 +556,12 @@ fu_redfish_request_finalize(GObject *object)
 	FuRedfishRequest *self = FU_REDFISH_REQUEST(object);
 	if (self->cache != NULL)
 		g_hash_table_unref(self->cache);
+	if (self->headers != NULL)
+		curl_slist_free_all(self->headers);
+	if (self->headers_conditional != NULL)
+		curl_slist_free_all(self->headers_conditional);
+	g_free(self->path);
+	g_free(self->etag);
 	g_object_unref(self->json_parser);
 	g_byte_array_unref(self->buf);
 	curl_easy_cleanup(self->curl);
@@ -15,18 +15,42 @@
 #define FU_TYPE_REDFISH_REQUEST (fu_redfish_request_get_type())
 G_DECLARE_FINAL_TYPE(FuRedfishRequest, fu_redfish_request, FU, REDFISH_REQUEST, GObject)
 
+typedef struct {
+	GByteArray *buf;
+	gchar *etag;	/* nullable */
+	gboolean stale; /* needs revalidating with the server before use */
+} FuRedfishRequestCacheItem;
+
+FuRedfishRequestCacheItem *
+fu_redfish_request_cache_item_new(GByteArray *buf, const gchar *etag);
+void
+fu_redfish_request_cache_item_free(FuRedfishRequestCacheItem *item);
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(FuRedfishRequestCacheItem, fu_redfish_request_cache_item_free)
+
 gboolean
 fu_redfish_request_perform(FuRedfishRequest *self,
 			   const gchar *path,
 			   FuRedfishRequestPerformFlags flags,
 			   GError **error);
 gboolean
+fu_redfish_request_perform_many(GPtrArray *requests,
+				GPtrArray *paths,
+				guint max_inflight,
+				FuRedfishRequestPerformFlags flags,
+				GError **error);
+gboolean
 fu_redfish_request_perform_full(FuRedfishRequest *self,
 				const gchar *path,
 				const gchar *request,
 				JsonBuilder *builder,
 				FuRedfishRequestPerformFlags flags,
 				GError **error);
+void
+fu_redfish_request_add_header(FuRedfishRequest *self, const gchar *header);
+void
+fu_redfish_request_set_postfields(FuRedfishRequest *self, const gchar *data, gsize datasz);
+void
+fu_redfish_request_set_mime(FuRedfishRequest *self, curl_mime *mime);
 JsonObject *
 fu_redfish_request_get_json_object(FuRedfishRequest *self);
 CURL *
@@ -98,7 +98,6 @@ fu_redfish_smc_device_start_update(FuRedfishSmcDevice *self, FuProgress *progres
 {
 	FuRedfishBackend *backend;
 	JsonObject *json_obj;
-	CURL *curl;
 	const gchar *location = NULL;
 	g_autoptr(FuRedfishRequest) request = NULL;
 	g_autoptr(GError) error_local = NULL;
@@ -107,8 +106,7 @@ fu_redfish_smc_device_start_update(FuRedfishSmcDevice *self, FuProgress *progres
 	if (backend == NULL)
 		return FALSE;
 	request = fu_redfish_backend_request_new(backend);
-	curl = fu_redfish_request_get_curl(request);
-	(void)curl_easy_setopt(curl, CURLOPT_POSTFIELDS, "");
+	fu_redfish_request_set_postfields(request, "", 0);
 
 	if (!fu_redfish_request_perform(
 		request,
@@ -184,7 +182,7 @@ fu_redfish_smc_device_write_firmware(FuDevice *device,
 	(void)curl_mime_filename(part, "firmware.bin");
 	(void)curl_mime_data(part, g_bytes_get_data(fw, NULL), g_bytes_get_size(fw));
 
-	(void)curl_easy_setopt(curl, CURLOPT_MIMEPOST, mime);
+	fu_redfish_request_set_mime(request, mime);
 
 	fu_progress_set_status(progress, FWUPD_STATUS_DEVICE_WRITE);
 	if (!fu_redfish_request_perform(request,
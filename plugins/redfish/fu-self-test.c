@@ -6,6 +6,8 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include "fu-config-private.h"
 #include "fu-context-private.h"
 #include "fu-device-private.h"
@@ -16,6 +18,7 @@
 #include "fu-redfish-common.h"
 #include "fu-redfish-network.h"
 #include "fu-redfish-plugin.h"
+#include "fu-redfish-request.h"
 #include "fu-redfish-smc-device.h"
 #include "fu-redfish-struct.h"
 
@@ -25,6 +28,7 @@ typedef struct {
 	FuPlugin *unlicensed_plugin;
 	FuPlugin *hpe_plugin;
 	FuPlugin *dell_plugin;
+	FuPlugin *inventory_plugin;
 } FuTest;
 
 static void
@@ -141,6 +145,26 @@ fu_test_self_init(FuTest *self)
 		g_assert_no_error(error);
 		g_assert_true(ret);
 	}
+
+	/* BMC with a large inventory */
+	g_clear_error(&error);
+	self->inventory_plugin = fu_plugin_new_from_gtype(fu_redfish_plugin_get_type(), ctx);
+	ret = fu_plugin_runner_startup(self->inventory_plugin, progress, &error);
+	if (g_error_matches(error, FWUPD_ERROR, FWUPD_ERROR_INVALID_FILE)) {
+		g_test_skip("no redfish.py running");
+	} else {
+		g_assert_no_error(error);
+		g_assert_true(ret);
+		fu_redfish_plugin_set_credentials(self->inventory_plugin,
+						  "inventory_username",
+						  "password2");
+		ret = fu_redfish_plugin_reload(self->inventory_plugin, progress, &error);
+		g_assert_no_error(error);
+		g_assert_true(ret);
+		ret = fu_plugin_runner_coldplug(self->inventory_plugin, progress, &error);
+		g_assert_no_error(error);
+		g_assert_true(ret);
+	}
 }
 
 static void
@@ -458,6 +482,220 @@ fu_test_redfish_dell_devices_func(gconstpointer user_data)
 	    fu_device_has_guid(dev, "REDFISH\\VENDOR_Lenovo&SYSTEMID_0C60&SOFTWAREID_UEFI-AFE1-6"));
 }
 
+static void
+fu_test_redfish_inventory_devices_func(gconstpointer user_data)
+{
+	FuTest *self = (FuTest *)user_data;
+	GPtrArray *devices;
+
+	devices = fu_plugin_get_devices(self->inventory_plugin);
+	g_assert_nonnull(devices);
+	if (devices->len == 0) {
+		g_test_skip("no redfish support");
+		return;
+	}
+
+	/* the BMC, the BIOS and the synthetic items fetched concurrently */
+	g_assert_cmpint(devices->len, ==, 2 + 100);
+}
+
+typedef struct {
+	GSocket *socket;
+	guint requests;
+	guint not_modified;
+	gboolean post_ok;
+} FuTestRedfishServer;
+
+/* a stand-in BMC that sends an ETag with every GET, and honours If-None-Match */
+static gpointer
+fu_test_redfish_server_thread_cb(gpointer user_data)
+{
+	FuTestRedfishServer *server = (FuTestRedfishServer *)user_data;
+
+	for (guint i = 0; i < server->requests; i++) {
+		gchar buf[4096] = {'\0'};
+		gsize bufsz = 0;
+		g_autofree gchar *body = NULL;
+		g_autofree gchar *hdr = NULL;
+		g_auto(GStrv) split = NULL;
+		g_autoptr(GError) error = NULL;
+		g_autoptr(GSocket) socket = NULL;
+		g_autoptr(GSocketConnection) conn = NULL;
+		GInputStream *istream;
+		GOutputStream *ostream;
+
+		socket = g_socket_accept(server->socket, NULL, &error);
+		g_assert_no_error(error);
+		g_assert_nonnull(socket);
+		conn = g_socket_connection_factory_create_connection(socket);
+		istream = g_io_stream_get_input_stream(G_IO_STREAM(conn));
+		ostream = g_io_stream_get_output_stream(G_IO_STREAM(conn));
+
+		/* the request headers, and any small body */
+		while (g_strstr_len(buf, bufsz, "\r\n\r\n") == NULL) {
+			gssize rc = g_input_stream_read(istream,
+							buf + bufsz,
+							sizeof(buf) - bufsz - 1,
+							NULL,
+							&error);
+			g_assert_no_error(error);
+			g_assert_cmpint(rc, >, 0);
+			bufsz += rc;
+		}
+		split = g_strsplit(buf, " ", 3);
+		g_assert_cmpint(g_strv_length(split), ==, 3);
+
+		if (g_str_has_prefix(buf, "POST ")) {
+			server->post_ok =
+			    g_strstr_len(buf, bufsz, "X-Auth-Token: secret\r\n") != NULL &&
+			    g_strstr_len(buf, bufsz, "If-None-Match:") == NULL;
+			body = g_strdup("{\"Id\": \"posted\"}");
+			hdr = g_strdup_printf("HTTP/1.1 200 OK\r\n"
+					      "Content-Type: application/json\r\n"
+					      "Content-Length: %u\r\n"
+					      "Connection: close\r\n\r\n",
+					      (guint)strlen(body));
+		} else if (g_strstr_len(buf, bufsz, "If-None-Match: \"v1\"\r\n") != NULL) {
+			server->not_modified++;
+			hdr = g_strdup("HTTP/1.1 304 Not Modified\r\n"
+				       "ETag: \"v1\"\r\n"
+				       "Connection: close\r\n\r\n");
+		} else {
+			body = g_strdup_printf("{\"Id\": \"%s\"}", split[1]);
+			hdr = g_strdup_printf("HTTP/1.1 200 OK\r\n"
+					      "Content-Type: application/json\r\n"
+					      "Content-Length: %u\r\n"
+					      "ETag: \"v1\"\r\n"
+					      "Connection: close\r\n\r\n",
+					      (guint)strlen(body));
+		}
+		(void)g_output_stream_write_all(ostream, hdr, strlen(hdr), NULL, NULL, &error);
+		g_assert_no_error(error);
+		if (body != NULL) {
+			(void)g_output_stream_write_all(ostream,
+							body,
+							strlen(body),
+							NULL,
+							NULL,
+							&error);
+			g_assert_no_error(error);
+		}
+		(void)g_io_stream_close(G_IO_STREAM(conn), NULL, NULL);
+	}
+	return NULL;
+}
+
+static FuRedfishRequest *
+fu_test_redfish_request_new(GHashTable *cache, guint16 port)
+{
+	FuRedfishRequest *request = g_object_new(FU_TYPE_REDFISH_REQUEST, NULL);
+	CURLU *uri = fu_redfish_request_get_uri(request);
+	g_autofree gchar *port_str = g_strdup_printf("%u", port);
+
+	(void)curl_url_set(uri, CURLUPART_SCHEME, "http", 0);
+	(void)curl_url_set(uri, CURLUPART_HOST, "127.0.0.1", 0);
+	(void)curl_url_set(uri, CURLUPART_PORT, port_str, 0);
+	(void)curl_easy_setopt(fu_redfish_request_get_curl(request), CURLOPT_CURLU, uri);
+	fu_redfish_request_set_cache(request, cache);
+	return request;
+}
+
+static void
+fu_test_redfish_request_cache_func(void)
+{
+	FuRedfishRequestCacheItem *item;
+	FuTestRedfishServer server = {.requests = 16 + 16 + 1};
+	GHashTableIter iter;
+	gboolean ret;
+	gpointer value = NULL;
+	guint16 port;
+	g_autoptr(FuRedfishRequest) request_post = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GHashTable) cache = NULL;
+	g_autoptr(GInetAddress) inet_address = NULL;
+	g_autoptr(GPtrArray) paths = g_ptr_array_new_with_free_func(g_free);
+	g_autoptr(GSocketAddress) address = NULL;
+	g_autoptr(GSocketAddress) address_local = NULL;
+	g_autoptr(GThread) thread = NULL;
+
+	/* listen on an ephemeral loopback port */
+	server.socket = g_socket_new(G_SOCKET_FAMILY_IPV4,
+				     G_SOCKET_TYPE_STREAM,
+				     G_SOCKET_PROTOCOL_TCP,
+				     &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(server.socket);
+	inet_address = g_inet_address_new_loopback(G_SOCKET_FAMILY_IPV4);
+	address = g_inet_socket_address_new(inet_address, 0);
+	ret = g_socket_bind(server.socket, address, TRUE, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	ret = g_socket_listen(server.socket, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	address_local = g_socket_get_local_address(server.socket, &error);
+	g_assert_no_error(error);
+	port = g_inet_socket_address_get_port(G_INET_SOCKET_ADDRESS(address_local));
+	thread = g_thread_new("self-test-redfish", fu_test_redfish_server_thread_cb, &server);
+
+	cache = g_hash_table_new_full(g_str_hash,
+				      g_str_equal,
+				      g_free,
+				      (GDestroyNotify)fu_redfish_request_cache_item_free);
+	for (guint i = 0; i < 16; i++)
+		g_ptr_array_add(paths, g_strdup_printf("/redfish/v1/Item%u", i));
+
+	/* everything is downloaded, and more than one transfer is in flight */
+	for (guint round = 0; round < 2; round++) {
+		g_autoptr(GPtrArray) requests = g_ptr_array_new_with_free_func(g_object_unref);
+		for (guint i = 0; i < paths->len; i++)
+			g_ptr_array_add(requests, fu_test_redfish_request_new(cache, port));
+		ret = fu_redfish_request_perform_many(requests,
+						      paths,
+						      4,
+						      FU_REDFISH_REQUEST_PERFORM_FLAG_LOAD_JSON,
+						      &error);
+		g_assert_no_error(error);
+		g_assert_true(ret);
+		for (guint i = 0; i < requests->len; i++) {
+			FuRedfishRequest *request = g_ptr_array_index(requests, i);
+			JsonObject *json_obj = fu_redfish_request_get_json_object(request);
+			g_assert_nonnull(json_obj);
+			g_assert_cmpstr(json_object_get_string_member(json_obj, "Id"),
+					==,
+					g_ptr_array_index(paths, i));
+		}
+		g_assert_cmpint(g_hash_table_size(cache), ==, paths->len);
+
+		/* the next round has to revalidate everything with the BMC */
+		g_hash_table_iter_init(&iter, cache);
+		while (g_hash_table_iter_next(&iter, NULL, &value)) {
+			item = (FuRedfishRequestCacheItem *)value;
+			g_assert_cmpstr(item->etag, ==, "\"v1\"");
+			item->stale = TRUE;
+		}
+	}
+	g_assert_cmpint(server.not_modified, ==, paths->len);
+
+	/* a POST keeps the headers set by the caller, and is not conditional or cached */
+	request_post = fu_test_redfish_request_new(cache, port);
+	fu_redfish_request_add_header(request_post, "X-Auth-Token: secret");
+	fu_redfish_request_set_postfields(request_post, "{}", 2);
+	ret = fu_redfish_request_perform(request_post,
+					 g_ptr_array_index(paths, 0),
+					 FU_REDFISH_REQUEST_PERFORM_FLAG_LOAD_JSON,
+					 &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	g_assert_true(server.post_ok);
+	item = g_hash_table_lookup(cache, g_ptr_array_index(paths, 0));
+	g_assert_nonnull(item);
+	g_assert_null(g_strstr_len((const gchar *)item->buf->data, item->buf->len, "posted"));
+
+	(void)g_thread_join(g_steal_pointer(&thread));
+	g_object_unref(server.socket);
+}
+
 static void
 fu_test_redfish_hpe_update_func(gconstpointer user_data)
 {
@@ -621,6 +859,8 @@ fu_test_self_free(FuTest *self)
 		g_object_unref(self->hpe_plugin);
 	if (self->dell_plugin != NULL)
 		g_object_unref(self->dell_plugin);
+	if (self->inventory_plugin != NULL)
+		g_object_unref(self->inventory_plugin);
 	g_free(self);
 }
 
@@ -633,6 +873,7 @@ int
 main(int argc, char **argv)
 {
 	g_autoptr(FuTest) self = g_new0(FuTest, 1);
+	g_autofree gchar *cachedir = NULL;
 	g_autofree gchar *smbios_data_fn = NULL;
 	g_autofree gchar *testdatadir = NULL;
 
@@ -648,6 +889,11 @@ main(int argc, char **argv)
 	(void)g_setenv("CONFIGURATION_DIRECTORY", testdatadir, TRUE);
 	(void)g_setenv("FWUPD_SYSFSFWATTRIBDIR", testdatadir, TRUE);
 
+	/* the request cache is persisted */
+	cachedir = g_test_build_filename(G_TEST_BUILT, "tests", "cache", NULL);
+	(void)g_mkdir_with_parents(cachedir, 0700);
+	(void)g_setenv("CACHE_DIRECTORY", cachedir, TRUE);
+
 	g_log_set_fatal_mask(NULL, G_LOG_LEVEL_ERROR | G_LOG_LEVEL_CRITICAL);
 	fu_test_self_init(self);
 	g_test_add_func("/redfish/ipmi", fu_test_redfish_ipmi_func);
@@ -656,6 +902,7 @@ main(int argc, char **argv)
 	g_test_add_func("/redfish/common{lenovo}", fu_test_redfish_common_lenovo_func);
 	g_test_add_func("/redfish/network{mac_addr}", fu_test_redfish_network_mac_addr_func);
 	g_test_add_func("/redfish/network{vid_pid}", fu_test_redfish_network_vid_pid_func);
+	g_test_add_func("/redfish/request{cache}", fu_test_redfish_request_cache_func);
 	g_test_add_data_func("/redfish/unlicensed_plugin{devices}",
 			     self,
 			     fu_test_redfish_unlicensed_devices_func);
@@ -669,5 +916,8 @@ main(int argc, char **argv)
 			     self,
 			     fu_test_redfish_dell_devices_func);
 	g_test_add_data_func("/redfish/plugin{update}", self, fu_test_redfish_update_func);
+	g_test_add_data_func("/redfish/inventory_plugin{devices}",
+			     self,
+			     fu_test_redfish_inventory_devices_func);
 	return g_test_run();
 }
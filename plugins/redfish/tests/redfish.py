@@ -6,6 +6,7 @@
 # SPDX-License-Identifier: LGPL-2.1-or-later
 
 import json
+import os
 
 from flask import Flask, Response, request
 
@@ -15,20 +16,44 @@ HARDCODED_SMC_USERNAME = "smc_username"
 HARDCODED_UNL_USERNAME = "unlicensed_username"
 HARDCODED_HPE_USERNAME = "hpe_username"
 HARDCODED_DELL_USERNAME = "dell_username"
+HARDCODED_INVENTORY_USERNAME = "inventory_username"
 HARDCODED_USERNAMES = {
     "username2",
     HARDCODED_SMC_USERNAME,
     HARDCODED_UNL_USERNAME,
     HARDCODED_HPE_USERNAME,
     HARDCODED_DELL_USERNAME,
+    HARDCODED_INVENTORY_USERNAME,
 }
 HARDCODED_PASSWORD = "password2"
 
+# add synthetic items to the firmware inventory, e.g. REDFISH_INVENTORY_SIZE=500
+INVENTORY_SIZE = int(os.environ.get("REDFISH_INVENTORY_SIZE", "0"))
+INVENTORY_SIZE_TEST = 100
+
 app._percentage545: int = 0
 app._percentage546: int = 0
 app._hpeupdatestate: str = "Idle"
 
 
+def _conditional(res: dict):
+    resp = Response(json.dumps(res), status=200, mimetype="application/json")
+    resp.add_etag()
+    return resp.make_conditional(request)
+
+
+def _inventory_size() -> int:
+    if request.authorization["username"] == HARDCODED_INVENTORY_USERNAME:
+        return INVENTORY_SIZE_TEST
+    return INVENTORY_SIZE
+
+
+def _check_post():
+    if "If-None-Match" in request.headers:
+        return _failure("conditional POST")
+    return None
+
+
 def _failure(msg: str, status=400):
     res = {
         "error": {"message": msg},
@@ -161,9 +186,30 @@ def firmware_inventory():
             {"@odata.id": "/redfish/v1/UpdateService/FirmwareInventory/BMC"},
             {"@odata.id": "/redfish/v1/UpdateService/FirmwareInventory/BIOS"},
         ],
-        "Members@odata.count": 2,
     }
-    return Response(json.dumps(res), status=200, mimetype="application/json")
+    for idx in range(_inventory_size()):
+        res["Members"].append(
+            {"@odata.id": f"/redfish/v1/UpdateService/FirmwareInventory/Synthetic{idx}"}
+        )
+    res["Members@odata.count"] = len(res["Members"])
+    return _conditional(res)
+
+
+@app.route("/redfish/v1/UpdateService/FirmwareInventory/Synthetic<int:idx>")
+def firmware_inventory_synthetic(idx: int):
+    if idx >= _inventory_size():
+        return _failure("not found", status=404)
+    res = {
+        "@odata.id": f"/redfish/v1/UpdateService/FirmwareInventory/Synthetic{idx}",
+        "@odata.type": "#SoftwareInventory.v1_2_3.SoftwareInventory",
+        "Id": f"Synthetic{idx}",
+        "Name": f"Contoso Synthetic Firmware {idx}",
+        "Manufacturer": "Contoso",
+        "SoftwareId": f"00000000-0000-0000-0000-{idx:012}",
+        "Updateable": True,
+        "Version": "1.2.3",
+    }
+    return _conditional(res)
 
 
 @app.route("/redfish/v1/UpdateService/FirmwareInventory/BMC")
@@ -201,7 +247,7 @@ def firmware_inventory_bmc():
 
     if request.authorization["username"] == HARDCODED_DELL_USERNAME:
         res["Oem"] = {"Dell": {"DellSoftwareInventory": {"Status": "Installed"}}}
-    return Response(json.dumps(res), status=200, mimetype="application/json")
+    return _conditional(res)
 
 
 @app.route("/redfish/v1/Managers/BMC")
@@ -273,7 +319,7 @@ def firmware_inventory_bios():
         res["Manufacturer"] = "SMCI"
     else:
         res["Manufacturer"] = "Contoso"
-    return Response(json.dumps(res), status=200, mimetype="application/json")
+    return _conditional(res)
 
 
 @app.route("/redfish/v1/SessionService/Sessions", methods=["POST"])
@@ -426,6 +472,9 @@ def fwupdate_smc_query():
 
 @app.route("/FWUpdate-smc", methods=["POST"])
 def fwupdate_smc():
+    failure = _check_post()
+    if failure:
+        return failure
     data = json.loads(request.form["UpdateParameters"])
     if data["@Redfish.OperationApplyTime"] != "OnStartUpdateRequest":
         return _failure("apply invalid")
@@ -485,8 +534,13 @@ def fwupdate_smc():
 @app.route("/FWUpdate-hpe", methods=["POST"])
 def fwupdate_hpe():
     print(request.form)
+    failure = _check_post()
+    if failure:
+        return failure
     if not request.form["sessionKey"]:
         return _failure("no sessionKey", status=401)
+    if request.headers.get("X-Auth-Token") != request.form["sessionKey"]:
+        return _failure("no X-Auth-Token", status=401)
 
     data = json.loads(request.form["parameters"])
 
@@ -505,6 +559,9 @@ def fwupdate_hpe():
 
 @app.route("/FWUpdate", methods=["POST"])
 def fwupdate():
+    failure = _check_post()
+    if failure:
+        return failure
     data = json.loads(request.form["UpdateParameters"])
     if data["@Redfish.OperationApplyTime"] != "Immediate":
         return _failure("apply invalid")
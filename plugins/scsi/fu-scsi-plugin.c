@@ -29,6 +29,7 @@ fu_scsi_plugin_constructed(GObject *obj)
 	fu_context_add_quirk_key(ctx, "ScsiWriteBufferSize");
 	fu_plugin_add_device_udev_subsystem(plugin, "block:disk");
 	fu_plugin_add_device_gtype(plugin, FU_TYPE_SCSI_DEVICE);
+	fu_plugin_add_flag(plugin, FWUPD_PLUGIN_FLAG_THREAD_SAFE);
 }
 
 static void
@@ -176,6 +176,8 @@ fu_test_plugin_write_firmware(FuPlugin *plugin,
 	guint64 delay_write_ms = 0;
 	guint64 delay_verify_ms = 0;
 	guint64 delay_request_ms = 0;
+	g_autofree gchar *write_start_str = NULL;
+	g_autofree gchar *write_end_str = NULL;
 
 	if (!fu_plugin_get_config_value_boolean(plugin, "WriteSupported")) {
 		g_set_error_literal(error,
@@ -244,10 +246,16 @@ fu_test_plugin_write_firmware(FuPlugin *plugin,
 			return FALSE;
 		}
 	}
+	write_start_str = g_strdup_printf("%" G_GINT64_FORMAT, g_get_monotonic_time());
 	for (guint i = 0; i <= delay_write_ms; i++) {
 		fu_device_sleep(device, 1);
 		fu_progress_set_percentage_full(progress, i, delay_write_ms);
 	}
+	write_end_str = g_strdup_printf("%" G_GINT64_FORMAT, g_get_monotonic_time());
+
+	/* for the self tests only, to check that devices were written at the same time */
+	fu_device_set_metadata(device, "write-start", write_start_str);
+	fu_device_set_metadata(device, "write-end", write_end_str);
 	fu_progress_set_status(progress, FWUPD_STATUS_DEVICE_VERIFY);
 	verify_delay_str = fu_plugin_get_config_value(plugin, "VerifyDelay");
 	if (verify_delay_str != NULL) {
@@ -386,6 +394,7 @@ static void
 fu_test_plugin_init(FuTestPlugin *self)
 {
 	fu_plugin_add_flag(FU_PLUGIN(self), FWUPD_PLUGIN_FLAG_TEST_ONLY);
+	fu_plugin_add_flag(FU_PLUGIN(self), FWUPD_PLUGIN_FLAG_THREAD_SAFE);
 }
 
 static void
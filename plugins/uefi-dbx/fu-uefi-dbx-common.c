@@ -39,6 +39,19 @@ fu_uefi_dbx_get_efi_arch(void)
 	return NULL;
 }
 
+typedef struct {
+	gchar *filename;
+	gchar *checksum; /* (nullable) */
+} FuUefiDbxFileItem;
+
+static void
+fu_uefi_dbx_file_item_free(FuUefiDbxFileItem *item)
+{
+	g_free(item->filename);
+	g_free(item->checksum);
+	g_free(item);
+}
+
 static gchar *
 fu_uefi_dbx_get_authenticode_hash(const gchar *fn, GError **error)
 {
@@ -49,34 +62,65 @@ fu_uefi_dbx_get_authenticode_hash(const gchar *fn, GError **error)
 	return fu_firmware_get_checksum(firmware, G_CHECKSUM_SHA256, error);
 }
 
-static gboolean
-fu_uefi_dbx_signature_list_validate_filename(FuContext *ctx,
-					     FuEfiSignatureList *siglist,
-					     const gchar *fn,
-					     FuFirmwareParseFlags flags,
-					     GError **error)
+/* runs in a worker thread */
+static void
+fu_uefi_dbx_file_item_hash_cb(gpointer data, gpointer user_data)
 {
-	g_autofree gchar *checksum = NULL;
-	g_autoptr(FuFirmware) img = NULL;
+	FuUefiDbxFileItem *item = (FuUefiDbxFileItem *)data;
 	g_autoptr(GError) error_local = NULL;
 
-	/* get checksum of file */
-	checksum = fu_uefi_dbx_get_authenticode_hash(fn, &error_local);
-	if (checksum == NULL) {
-		g_debug("failed to get checksum for %s: %s", fn, error_local->message);
+	item->checksum = fu_uefi_dbx_get_authenticode_hash(item->filename, &error_local);
+	if (item->checksum == NULL)
+		g_debug("failed to get checksum for %s: %s", item->filename, error_local->message);
+}
+
+static gboolean
+fu_uefi_dbx_file_items_hash(GPtrArray *items, GError **error)
+{
+	GThreadPool *pool;
+	guint threads = MIN(g_get_num_processors(), items->len);
+
+	/* not worth starting threads */
+	if (threads <= 1) {
+		for (guint i = 0; i < items->len; i++)
+			fu_uefi_dbx_file_item_hash_cb(g_ptr_array_index(items, i), NULL);
 		return TRUE;
 	}
 
+	/* PE files are parsed independently, so hash all of them at once */
+	pool = g_thread_pool_new(fu_uefi_dbx_file_item_hash_cb, NULL, threads, TRUE, error);
+	if (pool == NULL)
+		return FALSE;
+	for (guint i = 0; i < items->len; i++) {
+		if (!g_thread_pool_push(pool, g_ptr_array_index(items, i), error)) {
+			g_thread_pool_free(pool, FALSE, TRUE);
+			return FALSE;
+		}
+	}
+	g_thread_pool_free(pool, FALSE, TRUE);
+
+	/* success */
+	return TRUE;
+}
+
+static gboolean
+fu_uefi_dbx_signature_list_validate_item(FuEfiSignatureList *siglist,
+					 FuUefiDbxFileItem *item,
+					 GError **error)
+{
+	/* failed to get checksum */
+	if (item->checksum == NULL)
+		return TRUE;
+
 	/* authenticode signature is present in dbx! */
-	g_debug("fn=%s, checksum=%s", fn, checksum);
-	img = fu_firmware_get_image_by_checksum(FU_FIRMWARE(siglist), checksum, NULL);
-	if (img != NULL) {
+	g_debug("fn=%s, checksum=%s", item->filename, item->checksum);
+	if (fu_efi_signature_list_has_checksum(siglist, item->checksum)) {
 		g_set_error(error,
 			    FWUPD_ERROR,
 			    FWUPD_ERROR_NEEDS_USER_ACTION,
 			    "%s Authenticode checksum [%s] is present in dbx",
-			    fn,
-			    checksum);
+			    item->filename,
+			    item->checksum);
 		return FALSE;
 	}
 
@@ -91,6 +135,8 @@ fu_uefi_dbx_signature_list_validate(FuContext *ctx,
 				    GError **error)
 {
 	g_autoptr(GPtrArray) files = NULL;
+	g_autoptr(GPtrArray) items =
+	    g_ptr_array_new_with_free_func((GDestroyNotify)fu_uefi_dbx_file_item_free);
 	g_autoptr(GError) error_local = NULL;
 
 	files = fu_context_get_esp_files(ctx,
@@ -106,12 +152,17 @@ fu_uefi_dbx_signature_list_validate(FuContext *ctx,
 	}
 	for (guint i = 0; i < files->len; i++) {
 		FuFirmware *firmware = g_ptr_array_index(files, i);
-		if (!fu_uefi_dbx_signature_list_validate_filename(
-			ctx,
-			siglist,
-			fu_firmware_get_filename(firmware),
-			flags,
-			error))
+		FuUefiDbxFileItem *item = g_new0(FuUefiDbxFileItem, 1);
+		item->filename = g_strdup(fu_firmware_get_filename(firmware));
+		g_ptr_array_add(items, item);
+	}
+	if (!fu_uefi_dbx_file_items_hash(items, error))
+		return FALSE;
+
+	/* check in the same order as the ESP files */
+	for (guint i = 0; i < items->len; i++) {
+		FuUefiDbxFileItem *item = g_ptr_array_index(items, i);
+		if (!fu_uefi_dbx_signature_list_validate_item(siglist, item, error))
 			return FALSE;
 	}
 	return TRUE;
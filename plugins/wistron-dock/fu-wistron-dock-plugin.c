@@ -19,6 +19,7 @@ static void
 fu_wistron_dock_plugin_init(FuWistronDockPlugin *self)
 {
 	fu_plugin_add_flag(FU_PLUGIN(self), FWUPD_PLUGIN_FLAG_MUTABLE_ENUMERATION);
+	fu_plugin_add_flag(FU_PLUGIN(self), FWUPD_PLUGIN_FLAG_THREAD_SAFE);
 }
 
 static void
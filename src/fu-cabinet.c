@@ -108,7 +108,11 @@ fu_cabinet_parse_release(FuCabinet *self,
 {
 	const gchar *csum_filename = NULL;
 	gsize streamsz = 0;
+	guint checksum_typesz = 0;
+	guint csum_idx = G_MAXUINT;
+	GChecksumType checksum_types[3] = {0};
 	g_autofree gchar *basename = NULL;
+	g_auto(GStrv) checksums = NULL;
 	g_autoptr(FuFirmware) img_blob = NULL;
 	g_autoptr(GInputStream) stream = NULL;
 	g_autoptr(GError) error_local2 = NULL;
@@ -204,30 +208,48 @@ fu_cabinet_parse_release(FuCabinet *self,
 		xb_node_set_data(release, "fwupd::ReleaseSize", blob_sz);
 	}
 
-	/* set if unspecified, but error out if specified and incorrect */
+	/* the jcat file signed the *checksum of the payload*, not the payload itself */
+	item = jcat_file_get_item_by_id(self->jcat_file, basename, NULL);
+	if (item != NULL && jcat_item_has_target(item)) {
+		checksum_types[checksum_typesz++] = G_CHECKSUM_SHA256;
+		checksum_types[checksum_typesz++] = G_CHECKSUM_SHA512;
+	}
 	if (csum_tmp != NULL && xb_node_get_text(csum_tmp) != NULL) {
-		const gchar *checksum_old = xb_node_get_text(csum_tmp);
-		GChecksumType checksum_type = fwupd_checksum_guess_kind(checksum_old);
-		g_autofree gchar *checksum = NULL;
-		checksum = fu_input_stream_compute_checksum(stream, checksum_type, error);
-		if (checksum == NULL)
+		GChecksumType checksum_type = fwupd_checksum_guess_kind(xb_node_get_text(csum_tmp));
+		for (guint i = 0; i < checksum_typesz; i++) {
+			if (checksum_types[i] == checksum_type)
+				csum_idx = i;
+		}
+		if (csum_idx == G_MAXUINT) {
+			csum_idx = checksum_typesz;
+			checksum_types[checksum_typesz++] = checksum_type;
+		}
+	}
+
+	/* read the payload only once for all the checksums */
+	if (checksum_typesz > 0) {
+		checksums = fu_input_stream_compute_checksums(stream,
+							      checksum_types,
+							      checksum_typesz,
+							      error);
+		if (checksums == NULL)
 			return FALSE;
-		if (g_strcmp0(checksum, checksum_old) != 0) {
+	}
+
+	/* set if unspecified, but error out if specified and incorrect */
+	if (csum_idx != G_MAXUINT) {
+		if (g_strcmp0(checksums[csum_idx], xb_node_get_text(csum_tmp)) != 0) {
 			g_set_error(error,
 				    FWUPD_ERROR,
 				    FWUPD_ERROR_INVALID_FILE,
 				    "contents checksum invalid, expected %s, got %s",
-				    checksum,
+				    checksums[csum_idx],
 				    xb_node_get_text(csum_tmp));
 			return FALSE;
 		}
 	}
 
-	/* the jcat file signed the *checksum of the payload*, not the payload itself */
-	item = jcat_file_get_item_by_id(self->jcat_file, basename, NULL);
 	if (item != NULL && jcat_item_has_target(item)) {
-		g_autofree gchar *checksum_sha256 = NULL;
-		g_autofree gchar *checksum_sha512 = NULL;
 		g_autoptr(GError) error_local = NULL;
 		g_autoptr(GPtrArray) results = NULL;
 		g_autoptr(JcatBlob) blob_target_sha256 = NULL;
@@ -235,19 +257,11 @@ fu_cabinet_parse_release(FuCabinet *self,
 		g_autoptr(JcatItem) item_target = jcat_item_new(basename);
 
 		/* add SHA-256 */
-		checksum_sha256 =
-		    fu_input_stream_compute_checksum(stream, G_CHECKSUM_SHA256, error);
-		if (checksum_sha256 == NULL)
-			return FALSE;
-		blob_target_sha256 = jcat_blob_new_utf8(JCAT_BLOB_KIND_SHA256, checksum_sha256);
+		blob_target_sha256 = jcat_blob_new_utf8(JCAT_BLOB_KIND_SHA256, checksums[0]);
 		jcat_item_add_blob(item_target, blob_target_sha256);
 
 		/* add SHA-512 */
-		checksum_sha512 =
-		    fu_input_stream_compute_checksum(stream, G_CHECKSUM_SHA512, error);
-		if (checksum_sha512 == NULL)
-			return FALSE;
-		blob_target_sha512 = jcat_blob_new_utf8(JCAT_BLOB_KIND_SHA512, checksum_sha512);
+		blob_target_sha512 = jcat_blob_new_utf8(JCAT_BLOB_KIND_SHA512, checksums[1]);
 		jcat_item_add_blob(item_target, blob_target_sha512);
 
 		results =
@@ -957,6 +971,9 @@ fu_cabinet_parse(FuFirmware *firmware,
 
 	/* decompress and calculate container hashes */
 	if (stream != NULL) {
+		GChecksumType checksum_types[] = {G_CHECKSUM_SHA1, G_CHECKSUM_SHA256};
+		g_auto(GStrv) checksums = NULL;
+
 		if ((flags & FU_FIRMWARE_PARSE_FLAG_CACHE_STREAM) == 0 &&
 		    (flags & FU_FIRMWARE_PARSE_FLAG_CACHE_BLOB) == 0) {
 			g_set_error_literal(
@@ -970,14 +987,14 @@ fu_cabinet_parse(FuFirmware *firmware,
 		if (!FU_FIRMWARE_CLASS(fu_cabinet_parent_class)
 			 ->parse(firmware, stream, flags, error))
 			return FALSE;
-		self->container_checksum =
-		    fu_input_stream_compute_checksum(stream, G_CHECKSUM_SHA1, error);
-		if (self->container_checksum == NULL)
-			return FALSE;
-		self->container_checksum_alt =
-		    fu_input_stream_compute_checksum(stream, G_CHECKSUM_SHA256, error);
-		if (self->container_checksum_alt == NULL)
+		checksums = fu_input_stream_compute_checksums(stream,
+							      checksum_types,
+							      G_N_ELEMENTS(checksum_types),
+							      error);
+		if (checksums == NULL)
 			return FALSE;
+		self->container_checksum = g_strdup(checksums[0]);
+		self->container_checksum_alt = g_strdup(checksums[1]);
 	}
 
 	/* build xmlb silo */
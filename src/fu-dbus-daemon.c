@@ -22,6 +22,7 @@
 #include "fu-context-private.h"
 #include "fu-dbus-daemon.h"
 #include "fu-device-private.h"
+#include "fu-device-signal-list.h"
 #include "fu-engine-helper.h"
 #include "fu-engine-requirements.h"
 #include "fu-polkit-authority.h"
@@ -44,6 +45,7 @@ struct _FuDbusDaemon {
 	guint percentage;   /* last emitted */
 	guint owner_id;
 	GPtrArray *system_inhibits;
+	FuDeviceSignalList *device_signals;
 };
 
 G_DEFINE_TYPE(FuDbusDaemon, fu_dbus_daemon, FU_TYPE_DAEMON)
@@ -67,12 +69,14 @@ fu_dbus_daemon_engine_changed_cb(FuEngine *engine, FuDbusDaemon *self)
 static void
 fu_dbus_daemon_engine_device_added_cb(FuEngine *engine, FuDevice *device, FuDbusDaemon *self)
 {
-	GVariant *val;
+	g_autoptr(GVariant) val = NULL;
 
 	/* not yet connected */
 	if (self->connection == NULL)
 		return;
-	val = fwupd_codec_to_variant(FWUPD_CODEC(device), FWUPD_CODEC_FLAG_NONE);
+
+	/* used to work out what changed */
+	val = fu_device_signal_list_added(self->device_signals, device);
 	g_dbus_connection_emit_signal(self->connection,
 				      NULL,
 				      FWUPD_DBUS_PATH,
@@ -86,12 +90,15 @@ fu_dbus_daemon_engine_device_added_cb(FuEngine *engine, FuDevice *device, FuDbus
 static void
 fu_dbus_daemon_engine_device_removed_cb(FuEngine *engine, FuDevice *device, FuDbusDaemon *self)
 {
-	GVariant *val;
+	g_autoptr(GVariant) val = NULL;
 
 	/* not yet connected */
 	if (self->connection == NULL)
 		return;
-	val = fwupd_codec_to_variant(FWUPD_CODEC(device), FWUPD_CODEC_FLAG_NONE);
+
+	/* never send a pending DeviceChanged after DeviceRemoved */
+	val = fu_device_signal_list_get_variant(self->device_signals, device);
+	fu_device_signal_list_removed(self->device_signals, device);
 	g_dbus_connection_emit_signal(self->connection,
 				      NULL,
 				      FWUPD_DBUS_PATH,
@@ -102,23 +109,79 @@ fu_dbus_daemon_engine_device_removed_cb(FuEngine *engine, FuDevice *device, FuDb
 	fu_daemon_schedule_housekeeping(FU_DAEMON(self));
 }
 
+static gboolean
+fu_dbus_daemon_client_wants_device_properties_changed(FuClient *client)
+{
+	return (fu_client_get_feature_flags(client) &
+		FWUPD_FEATURE_FLAG_DEVICE_PROPERTIES_CHANGED) > 0;
+}
+
 static void
-fu_dbus_daemon_engine_device_changed_cb(FuEngine *engine, FuDevice *device, FuDbusDaemon *self)
+fu_dbus_daemon_device_signals_changed_cb(FuDeviceSignalList *device_signals,
+					 FuDevice *device,
+					 GVariant *val,
+					 GVariant *parameters,
+					 FuDbusDaemon *self)
 {
-	GVariant *val;
+	gboolean any_properties_changed = FALSE;
+	g_autoptr(GPtrArray) clients = NULL;
+
+	/* nobody wants just the changed properties, so broadcast the whole device */
+	if (self->client_list != NULL)
+		clients = fu_client_list_get_all(self->client_list);
+	for (guint i = 0; clients != NULL && i < clients->len; i++) {
+		FuClient *client = g_ptr_array_index(clients, i);
+		if (fu_dbus_daemon_client_wants_device_properties_changed(client)) {
+			any_properties_changed = TRUE;
+			break;
+		}
+	}
+	if (!any_properties_changed) {
+		g_dbus_connection_emit_signal(self->connection,
+					      NULL,
+					      FWUPD_DBUS_PATH,
+					      FWUPD_DBUS_INTERFACE,
+					      "DeviceChanged",
+					      g_variant_new_tuple(&val, 1),
+					      NULL);
+		fu_daemon_schedule_housekeeping(FU_DAEMON(self));
+		return;
+	}
+
+	/* every client calls SetHints when connecting, so each gets exactly one of the signals */
+	for (guint i = 0; i < clients->len; i++) {
+		FuClient *client = g_ptr_array_index(clients, i);
+		if (fu_dbus_daemon_client_wants_device_properties_changed(client)) {
+			g_dbus_connection_emit_signal(self->connection,
+						      fu_client_get_sender(client),
+						      FWUPD_DBUS_PATH,
+						      FWUPD_DBUS_INTERFACE,
+						      "DevicePropertiesChanged",
+						      parameters,
+						      NULL);
+		} else {
+			g_dbus_connection_emit_signal(self->connection,
+						      fu_client_get_sender(client),
+						      FWUPD_DBUS_PATH,
+						      FWUPD_DBUS_INTERFACE,
+						      "DeviceChanged",
+						      g_variant_new_tuple(&val, 1),
+						      NULL);
+		}
+	}
+	fu_daemon_schedule_housekeeping(FU_DAEMON(self));
+}
 
+static void
+fu_dbus_daemon_engine_device_changed_cb(FuEngine *engine, FuDevice *device, FuDbusDaemon *self)
+{
 	/* not yet connected */
 	if (self->connection == NULL)
 		return;
-	val = fwupd_codec_to_variant(FWUPD_CODEC(device), FWUPD_CODEC_FLAG_NONE);
-	g_dbus_connection_emit_signal(self->connection,
-				      NULL,
-				      FWUPD_DBUS_PATH,
-				      FWUPD_DBUS_INTERFACE,
-				      "DeviceChanged",
-				      g_variant_new_tuple(&val, 1),
-				      NULL);
-	fu_daemon_schedule_housekeeping(FU_DAEMON(self));
+	fu_device_signal_list_set_delay(
+	    self->device_signals,
+	    fu_engine_config_get_device_changed_delay(fu_engine_get_config(engine)));
+	fu_device_signal_list_changed(self->device_signals, device);
 }
 
 static void
@@ -1521,6 +1584,22 @@ fu_dbus_daemon_method_get_upgrades(FuDbusDaemon *self,
 	    fwupd_codec_array_to_variant(releases, FWUPD_CODEC_FLAG_NONE));
 }
 
+static void
+fu_dbus_daemon_method_get_upgrades_all(FuDbusDaemon *self,
+				       GVariant *parameters,
+				       FuEngineRequest *request,
+				       GDBusMethodInvocation *invocation)
+{
+	FuEngine *engine = fu_daemon_get_engine(FU_DAEMON(self));
+	guint64 include = 0;
+	guint64 exclude = 0;
+	g_autoptr(GHashTable) upgrades = NULL;
+
+	g_variant_get(parameters, "(tt)", &include, &exclude);
+	upgrades = fu_engine_get_upgrades_all(engine, request, include, exclude);
+	g_dbus_method_invocation_return_value(invocation, fu_engine_upgrades_to_variant(upgrades));
+}
+
 static void
 fu_dbus_daemon_method_get_remotes(FuDbusDaemon *self,
 				  GVariant *parameters,
@@ -2545,6 +2624,7 @@ fu_dbus_daemon_method_call(GDBusConnection *connection,
 	    {"SelfSign", fu_dbus_daemon_method_self_sign},
 	    {"GetDowngrades", fu_dbus_daemon_method_get_downgrades},
 	    {"GetUpgrades", fu_dbus_daemon_method_get_upgrades},
+	    {"GetUpgradesAll", fu_dbus_daemon_method_get_upgrades_all},
 	    {"GetRemotes", fu_dbus_daemon_method_get_remotes},
 	    {"GetHistory", fu_dbus_daemon_method_get_history},
 	    {"GetHostSecurityAttrs", fu_dbus_daemon_method_get_host_security_attrs},
@@ -3010,6 +3090,11 @@ fu_dbus_daemon_init(FuDbusDaemon *self)
 	self->status = FWUPD_STATUS_IDLE;
 	self->system_inhibits =
 	    g_ptr_array_new_with_free_func((GDestroyNotify)fu_dbus_daemon_system_inhibit_free);
+	self->device_signals = fu_device_signal_list_new();
+	g_signal_connect(self->device_signals,
+			 "changed",
+			 G_CALLBACK(fu_dbus_daemon_device_signals_changed_cb),
+			 self);
 }
 
 static void
@@ -3018,6 +3103,7 @@ fu_dbus_daemon_finalize(GObject *obj)
 	FuDbusDaemon *self = FU_DBUS_DAEMON(obj);
 
 	g_ptr_array_unref(self->system_inhibits);
+	g_object_unref(self->device_signals);
 	if (self->client_list != NULL)
 		g_object_unref(self->client_list);
 	if (self->owner_id > 0)
@@ -33,6 +33,12 @@ struct _FuDeviceList {
 	GObject parent_instance;
 	GPtrArray *devices; /* of FuDeviceItem */
 	GRWLock devices_mutex;
+	GHashTable *guid_index;	      /* (element-type utf8 GPtrArray) of FuDeviceItem */
+	GHashTable *connection_index; /* (element-type utf8 GPtrArray) of FuDeviceItem */
+	GPtrArray *id_index;	      /* of FuDeviceListIdEntry, sorted by ID */
+	GHashTable *wfr_items;	      /* (element-type FuDeviceItem) waiting for replug */
+	GMutex wfr_mutex;
+	GCond wfr_cond;
 };
 
 enum { SIGNAL_ADDED, SIGNAL_REMOVED, SIGNAL_CHANGED, SIGNAL_LAST };
@@ -51,8 +57,16 @@ typedef struct {
 	FuDevice *device_old;
 	FuDeviceList *self; /* no ref */
 	guint remove_id;
+	GPtrArray *guid_keys;	    /* (element-type utf8) as currently indexed */
+	GPtrArray *connection_keys; /* (element-type utf8) as currently indexed */
+	GPtrArray *id_keys;	    /* (element-type utf8) as currently indexed */
 } FuDeviceItem;
 
+typedef struct {
+	gchar *id;
+	FuDeviceItem *item; /* no ref */
+} FuDeviceListIdEntry;
+
 static void
 fu_device_list_codec_iface_init(FwupdCodecInterface *iface);
 
@@ -244,6 +258,291 @@ fu_device_list_get_active(FuDeviceList *self)
 	return devices;
 }
 
+static void
+fu_device_list_id_entry_free(FuDeviceListIdEntry *entry)
+{
+	g_free(entry->id);
+	g_free(entry);
+}
+
+/* returns the index of the first entry that is not less than @id */
+static guint
+fu_device_list_id_index_lower_bound(FuDeviceList *self, const gchar *id)
+{
+	guint lo = 0;
+	guint hi = self->id_index->len;
+	while (lo < hi) {
+		guint mid = lo + (hi - lo) / 2;
+		FuDeviceListIdEntry *entry = g_ptr_array_index(self->id_index, mid);
+		if (g_strcmp0(entry->id, id) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+static void
+fu_device_list_id_index_add(FuDeviceList *self, const gchar *id, FuDeviceItem *item)
+{
+	FuDeviceListIdEntry *entry = g_new0(FuDeviceListIdEntry, 1);
+	entry->id = g_strdup(id);
+	entry->item = item;
+	g_ptr_array_insert(self->id_index, fu_device_list_id_index_lower_bound(self, id), entry);
+}
+
+static void
+fu_device_list_id_index_remove(FuDeviceList *self, const gchar *id, FuDeviceItem *item)
+{
+	for (guint i = fu_device_list_id_index_lower_bound(self, id); i < self->id_index->len;
+	     i++) {
+		FuDeviceListIdEntry *entry = g_ptr_array_index(self->id_index, i);
+		if (g_strcmp0(entry->id, id) != 0)
+			break;
+		if (entry->item == item) {
+			g_ptr_array_remove_index(self->id_index, i);
+			return;
+		}
+	}
+}
+
+static void
+fu_device_list_hash_index_add(GHashTable *index, const gchar *key, FuDeviceItem *item)
+{
+	GPtrArray *items = g_hash_table_lookup(index, key);
+	if (items == NULL) {
+		items = g_ptr_array_new();
+		g_hash_table_insert(index, g_strdup(key), items);
+	}
+	if (!g_ptr_array_find(items, item, NULL))
+		g_ptr_array_add(items, item);
+}
+
+static void
+fu_device_list_hash_index_remove(GHashTable *index, const gchar *key, FuDeviceItem *item)
+{
+	GPtrArray *items = g_hash_table_lookup(index, key);
+	if (items == NULL)
+		return;
+	g_ptr_array_remove(items, item);
+	if (items->len == 0)
+		g_hash_table_remove(index, key);
+}
+
+static gchar *
+fu_device_list_connection_key(const gchar *physical_id, const gchar *logical_id)
+{
+	return g_strdup_printf("%s\n%s", physical_id, logical_id != NULL ? logical_id : "");
+}
+
+static void
+fu_device_list_keys_add(GPtrArray *keys, const gchar *key)
+{
+	if (key == NULL)
+		return;
+	if (g_ptr_array_find_with_equal_func(keys, key, g_str_equal, NULL))
+		return;
+	g_ptr_array_add(keys, g_strdup(key));
+}
+
+static void
+fu_device_list_item_collect_keys(FuDevice *device,
+				 GPtrArray *guid_keys,
+				 GPtrArray *connection_keys,
+				 GPtrArray *id_keys)
+{
+	GPtrArray *guids;
+	g_autoptr(GPtrArray) counterpart_guids = NULL;
+
+	if (device == NULL)
+		return;
+
+	/* everything fu_device_list_get_by_guids_removed() can match on */
+	guids = fu_device_get_guids(device);
+	for (guint i = 0; i < guids->len; i++)
+		fu_device_list_keys_add(guid_keys, g_ptr_array_index(guids, i));
+	counterpart_guids = fu_device_get_counterpart_guids(device);
+	for (guint i = 0; i < counterpart_guids->len; i++)
+		fu_device_list_keys_add(guid_keys, g_ptr_array_index(counterpart_guids, i));
+
+	if (fu_device_get_physical_id(device) != NULL) {
+		g_autofree gchar *key =
+		    fu_device_list_connection_key(fu_device_get_physical_id(device),
+						  fu_device_get_logical_id(device));
+		fu_device_list_keys_add(connection_keys, key);
+	}
+
+	fu_device_list_keys_add(id_keys, fu_device_get_id(device));
+	fu_device_list_keys_add(id_keys, fu_device_get_equivalent_id(device));
+}
+
+/* the items in each index are only candidates, and always have to be checked again */
+static void
+fu_device_list_item_reindex_unlocked(FuDeviceList *self, FuDeviceItem *item)
+{
+	g_autoptr(GPtrArray) guid_keys = g_ptr_array_new_with_free_func(g_free);
+	g_autoptr(GPtrArray) connection_keys = g_ptr_array_new_with_free_func(g_free);
+	g_autoptr(GPtrArray) id_keys = g_ptr_array_new_with_free_func(g_free);
+
+	fu_device_list_item_collect_keys(item->device, guid_keys, connection_keys, id_keys);
+	fu_device_list_item_collect_keys(item->device_old, guid_keys, connection_keys, id_keys);
+
+	/* only change what is different so the existing order is preserved */
+	for (guint i = 0; i < item->guid_keys->len; i++) {
+		const gchar *key = g_ptr_array_index(item->guid_keys, i);
+		if (!g_ptr_array_find_with_equal_func(guid_keys, key, g_str_equal, NULL))
+			fu_device_list_hash_index_remove(self->guid_index, key, item);
+	}
+	for (guint i = 0; i < guid_keys->len; i++)
+		fu_device_list_hash_index_add(self->guid_index, g_ptr_array_index(guid_keys, i), item);
+	for (guint i = 0; i < item->connection_keys->len; i++) {
+		const gchar *key = g_ptr_array_index(item->connection_keys, i);
+		if (!g_ptr_array_find_with_equal_func(connection_keys, key, g_str_equal, NULL))
+			fu_device_list_hash_index_remove(self->connection_index, key, item);
+	}
+	for (guint i = 0; i < connection_keys->len; i++) {
+		fu_device_list_hash_index_add(self->connection_index,
+					      g_ptr_array_index(connection_keys, i),
+					      item);
+	}
+	for (guint i = 0; i < item->id_keys->len; i++) {
+		const gchar *key = g_ptr_array_index(item->id_keys, i);
+		if (!g_ptr_array_find_with_equal_func(id_keys, key, g_str_equal, NULL))
+			fu_device_list_id_index_remove(self, key, item);
+	}
+	for (guint i = 0; i < id_keys->len; i++) {
+		const gchar *key = g_ptr_array_index(id_keys, i);
+		if (!g_ptr_array_find_with_equal_func(item->id_keys, key, g_str_equal, NULL))
+			fu_device_list_id_index_add(self, key, item);
+	}
+
+	g_ptr_array_unref(item->guid_keys);
+	item->guid_keys = g_steal_pointer(&guid_keys);
+	g_ptr_array_unref(item->connection_keys);
+	item->connection_keys = g_steal_pointer(&connection_keys);
+	g_ptr_array_unref(item->id_keys);
+	item->id_keys = g_steal_pointer(&id_keys);
+}
+
+static void
+fu_device_list_item_reindex(FuDeviceList *self, FuDeviceItem *item)
+{
+	g_rw_lock_writer_lock(&self->devices_mutex);
+	fu_device_list_item_reindex_unlocked(self, item);
+	g_rw_lock_writer_unlock(&self->devices_mutex);
+}
+
+static void
+fu_device_list_item_unindex_unlocked(FuDeviceList *self, FuDeviceItem *item)
+{
+	for (guint i = 0; i < item->guid_keys->len; i++) {
+		fu_device_list_hash_index_remove(self->guid_index,
+						 g_ptr_array_index(item->guid_keys, i),
+						 item);
+	}
+	for (guint i = 0; i < item->connection_keys->len; i++) {
+		fu_device_list_hash_index_remove(self->connection_index,
+						 g_ptr_array_index(item->connection_keys, i),
+						 item);
+	}
+	for (guint i = 0; i < item->id_keys->len; i++)
+		fu_device_list_id_index_remove(self, g_ptr_array_index(item->id_keys, i), item);
+	g_ptr_array_set_size(item->guid_keys, 0);
+	g_ptr_array_set_size(item->connection_keys, 0);
+	g_ptr_array_set_size(item->id_keys, 0);
+}
+
+static void
+fu_device_list_device_notify_cb(FuDevice *device, GParamSpec *pspec, gpointer user_data)
+{
+	FuDeviceItem *item = (FuDeviceItem *)user_data;
+	fu_device_list_item_reindex(item->self, item);
+}
+
+static void
+fu_device_list_device_guids_changed_cb(FuDevice *device, gpointer user_data)
+{
+	FuDeviceItem *item = (FuDeviceItem *)user_data;
+	fu_device_list_item_reindex(item->self, item);
+}
+
+static void
+fu_device_list_item_watch_device(FuDeviceItem *item, FuDevice *device)
+{
+	const gchar *notify_names[] = {"notify::id",
+				       "notify::equivalent-id",
+				       "notify::physical-id",
+				       "notify::logical-id",
+				       NULL};
+	if (device == NULL)
+		return;
+	for (guint i = 0; notify_names[i] != NULL; i++) {
+		g_signal_connect(FU_DEVICE(device),
+				 notify_names[i],
+				 G_CALLBACK(fu_device_list_device_notify_cb),
+				 item);
+	}
+	g_signal_connect(FU_DEVICE(device),
+			 "guids-changed",
+			 G_CALLBACK(fu_device_list_device_guids_changed_cb),
+			 item);
+}
+
+static void
+fu_device_list_item_unwatch(FuDeviceItem *item)
+{
+	if (item->device != NULL)
+		g_signal_handlers_disconnect_by_data(item->device, item);
+	if (item->device_old != NULL)
+		g_signal_handlers_disconnect_by_data(item->device_old, item);
+}
+
+/* keeps the set of items waiting for replug up to date, waking any waiter when it empties */
+static void
+fu_device_list_item_check_wfr(FuDeviceList *self, FuDeviceItem *item, gboolean wfr)
+{
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new(&self->wfr_mutex);
+	if (wfr) {
+		g_hash_table_add(self->wfr_items, item);
+		return;
+	}
+	if (!g_hash_table_remove(self->wfr_items, item))
+		return;
+	if (g_hash_table_size(self->wfr_items) == 0) {
+		g_cond_broadcast(&self->wfr_cond);
+		g_main_context_wakeup(NULL);
+	}
+}
+
+static void
+fu_device_list_item_update_wfr(FuDeviceItem *item)
+{
+	gboolean wfr = item->device != NULL &&
+		       fu_device_has_flag(item->device, FWUPD_DEVICE_FLAG_WAIT_FOR_REPLUG) &&
+		       !fu_device_has_flag(item->device, FWUPD_DEVICE_FLAG_EMULATED);
+	fu_device_list_item_check_wfr(item->self, item, wfr);
+}
+
+static void
+fu_device_list_device_flags_notify_cb(FuDevice *device, GParamSpec *pspec, gpointer user_data)
+{
+	FuDeviceItem *item = (FuDeviceItem *)user_data;
+	fu_device_list_item_update_wfr(item);
+}
+
+static void
+fu_device_list_item_watch(FuDeviceItem *item)
+{
+	fu_device_list_item_watch_device(item, item->device);
+	fu_device_list_item_watch_device(item, item->device_old);
+	if (item->device != NULL) {
+		g_signal_connect(FU_DEVICE(item->device),
+				 "notify::flags",
+				 G_CALLBACK(fu_device_list_device_flags_notify_cb),
+				 item);
+	}
+}
+
 static FuDeviceItem *
 fu_device_list_find_by_device(FuDeviceList *self, FuDevice *device)
 {
@@ -265,15 +564,24 @@ fu_device_list_find_by_device(FuDeviceList *self, FuDevice *device)
 static FuDeviceItem *
 fu_device_list_find_by_guid(FuDeviceList *self, const gchar *guid)
 {
+	GPtrArray *items;
+	g_autofree gchar *guid_tmp = NULL;
 	g_autoptr(GRWLockReaderLocker) locker = g_rw_lock_reader_locker_new(&self->devices_mutex);
 	g_return_val_if_fail(locker != NULL, NULL);
-	for (guint i = 0; i < self->devices->len; i++) {
-		FuDeviceItem *item = g_ptr_array_index(self->devices, i);
+
+	/* the index is keyed by GUID, but callers can also use an instance ID */
+	if (!fwupd_guid_is_valid(guid))
+		guid_tmp = fwupd_guid_hash_string(guid);
+	items = g_hash_table_lookup(self->guid_index, guid_tmp != NULL ? guid_tmp : guid);
+	if (items == NULL)
+		return NULL;
+	for (guint i = 0; i < items->len; i++) {
+		FuDeviceItem *item = g_ptr_array_index(items, i);
 		if (fu_device_has_guid(item->device, guid))
 			return item;
 	}
-	for (guint i = 0; i < self->devices->len; i++) {
-		FuDeviceItem *item = g_ptr_array_index(self->devices, i);
+	for (guint i = 0; i < items->len; i++) {
+		FuDeviceItem *item = g_ptr_array_index(items, i);
 		if (item->device_old == NULL)
 			continue;
 		if (fu_device_has_guid(item->device_old, guid))
@@ -287,21 +595,27 @@ fu_device_list_find_by_connection(FuDeviceList *self,
 				  const gchar *physical_id,
 				  const gchar *logical_id)
 {
+	GPtrArray *items;
+	g_autofree gchar *key = NULL;
 	g_autoptr(GRWLockReaderLocker) locker = NULL;
 	if (physical_id == NULL)
 		return NULL;
 	locker = g_rw_lock_reader_locker_new(&self->devices_mutex);
 	g_return_val_if_fail(locker != NULL, NULL);
-	for (guint i = 0; i < self->devices->len; i++) {
-		FuDeviceItem *item_tmp = g_ptr_array_index(self->devices, i);
+	key = fu_device_list_connection_key(physical_id, logical_id);
+	items = g_hash_table_lookup(self->connection_index, key);
+	if (items == NULL)
+		return NULL;
+	for (guint i = 0; i < items->len; i++) {
+		FuDeviceItem *item_tmp = g_ptr_array_index(items, i);
 		FuDevice *device = item_tmp->device;
 		if (device != NULL &&
 		    g_strcmp0(fu_device_get_physical_id(device), physical_id) == 0 &&
 		    g_strcmp0(fu_device_get_logical_id(device), logical_id) == 0)
 			return item_tmp;
 	}
-	for (guint i = 0; i < self->devices->len; i++) {
-		FuDeviceItem *item_tmp = g_ptr_array_index(self->devices, i);
+	for (guint i = 0; i < items->len; i++) {
+		FuDeviceItem *item_tmp = g_ptr_array_index(items, i);
 		FuDevice *device = item_tmp->device_old;
 		if (device != NULL &&
 		    g_strcmp0(fu_device_get_physical_id(device), physical_id) == 0 &&
@@ -327,6 +641,7 @@ static GPtrArray *
 fu_device_list_filter_by_id(FuDeviceList *self, const gchar *device_id, GError **error)
 {
 	gsize device_id_len;
+	g_autoptr(GPtrArray) candidates = g_ptr_array_new();
 	g_autoptr(GPtrArray) items = g_ptr_array_new();
 
 	g_return_val_if_fail(device_id != NULL, NULL);
@@ -342,8 +657,19 @@ fu_device_list_filter_by_id(FuDeviceList *self, const gchar *device_id, GError *
 		return NULL;
 	}
 	g_rw_lock_reader_lock(&self->devices_mutex);
-	for (guint i = 0; i < self->devices->len; i++) {
-		FuDeviceItem *item_tmp = g_ptr_array_index(self->devices, i);
+
+	/* all the IDs sharing the prefix are next to each other */
+	for (guint i = fu_device_list_id_index_lower_bound(self, device_id);
+	     i < self->id_index->len;
+	     i++) {
+		FuDeviceListIdEntry *entry = g_ptr_array_index(self->id_index, i);
+		if (strncmp(entry->id, device_id, device_id_len) != 0)
+			break;
+		if (!g_ptr_array_find(candidates, entry->item, NULL))
+			g_ptr_array_add(candidates, entry->item);
+	}
+	for (guint i = 0; i < candidates->len; i++) {
+		FuDeviceItem *item_tmp = g_ptr_array_index(candidates, i);
 		const gchar *ids[] = {fu_device_get_id(item_tmp->device),
 				      fu_device_get_equivalent_id(item_tmp->device),
 				      NULL};
@@ -354,16 +680,15 @@ fu_device_list_filter_by_id(FuDeviceList *self, const gchar *device_id, GError *
 			}
 		}
 	}
-	g_rw_lock_reader_unlock(&self->devices_mutex);
 	if (items->len > 0) {
+		g_rw_lock_reader_unlock(&self->devices_mutex);
 		g_ptr_array_sort(items, fu_device_list_item_sort_by_priority_cb);
 		return g_steal_pointer(&items);
 	}
 
 	/* only search old devices if we didn't find the active device */
-	g_rw_lock_reader_lock(&self->devices_mutex);
-	for (guint i = 0; i < self->devices->len; i++) {
-		FuDeviceItem *item_tmp = g_ptr_array_index(self->devices, i);
+	for (guint i = 0; i < candidates->len; i++) {
+		FuDeviceItem *item_tmp = g_ptr_array_index(candidates, i);
 		const gchar *ids[3] = {NULL};
 		if (item_tmp->device_old == NULL)
 			continue;
@@ -445,12 +770,13 @@ fu_device_list_get_by_guids_removed(FuDeviceList *self, GPtrArray *guids)
 {
 	g_autoptr(GRWLockReaderLocker) locker = g_rw_lock_reader_locker_new(&self->devices_mutex);
 	g_return_val_if_fail(locker != NULL, NULL);
-	for (guint i = 0; i < self->devices->len; i++) {
-		FuDeviceItem *item = g_ptr_array_index(self->devices, i);
-		if (item->remove_id == 0)
-			continue;
-		for (guint j = 0; j < guids->len; j++) {
-			const gchar *guid = g_ptr_array_index(guids, j);
+	for (guint j = 0; j < guids->len; j++) {
+		const gchar *guid = g_ptr_array_index(guids, j);
+		GPtrArray *items = g_hash_table_lookup(self->guid_index, guid);
+		for (guint i = 0; items != NULL && i < items->len; i++) {
+			FuDeviceItem *item = g_ptr_array_index(items, i);
+			if (item->remove_id == 0)
+				continue;
 			if (fu_device_has_guid(item->device, guid) ||
 			    fu_device_has_instance_id(item->device,
 						      guid,
@@ -459,14 +785,15 @@ fu_device_list_get_by_guids_removed(FuDeviceList *self, GPtrArray *guids)
 				return item;
 		}
 	}
-	for (guint i = 0; i < self->devices->len; i++) {
-		FuDeviceItem *item = g_ptr_array_index(self->devices, i);
-		if (item->device_old == NULL)
-			continue;
-		if (item->remove_id == 0)
-			continue;
-		for (guint j = 0; j < guids->len; j++) {
-			const gchar *guid = g_ptr_array_index(guids, j);
+	for (guint j = 0; j < guids->len; j++) {
+		const gchar *guid = g_ptr_array_index(guids, j);
+		GPtrArray *items = g_hash_table_lookup(self->guid_index, guid);
+		for (guint i = 0; items != NULL && i < items->len; i++) {
+			FuDeviceItem *item = g_ptr_array_index(items, i);
+			if (item->device_old == NULL)
+				continue;
+			if (item->remove_id == 0)
+				continue;
 			if (fu_device_has_guid(item->device_old, guid) ||
 			    fu_device_has_instance_id(item->device_old,
 						      guid,
@@ -628,6 +955,9 @@ fu_device_list_remove_all(FuDeviceList *self)
 
 	g_rw_lock_writer_lock(&self->devices_mutex);
 	g_ptr_array_set_size(self->devices, 0);
+	g_hash_table_remove_all(self->guid_index);
+	g_hash_table_remove_all(self->connection_index);
+	g_ptr_array_set_size(self->id_index, 0);
 	g_rw_lock_writer_unlock(&self->devices_mutex);
 }
 
@@ -676,7 +1006,9 @@ fu_device_list_item_set_device_old(FuDeviceItem *item, FuDevice *device)
 {
 	fu_device_set_parent(device, NULL);
 	fu_device_remove_children(device);
+	fu_device_list_item_unwatch(item);
 	g_set_object(&item->device_old, device);
+	fu_device_list_item_watch(item);
 }
 
 /* this should never be required, and yet here we are */
@@ -689,7 +1021,10 @@ fu_device_list_item_set_device(FuDeviceItem *item, FuDevice *device)
 	if (device != NULL) {
 		g_object_weak_ref(G_OBJECT(device), fu_device_list_item_finalized_cb, item);
 	}
+	fu_device_list_item_unwatch(item);
 	g_set_object(&item->device, device);
+	fu_device_list_item_watch(item);
+	fu_device_list_item_update_wfr(item);
 }
 
 static void
@@ -810,6 +1145,7 @@ fu_device_list_replace(FuDeviceList *self, FuDeviceItem *item, FuDevice *device)
 	/* assign the new device */
 	fu_device_list_item_set_device_old(item, item->device);
 	fu_device_list_item_set_device(item, device);
+	fu_device_list_item_reindex(self, item);
 	fu_device_list_emit_device_changed(self, device);
 
 	/* debug */
@@ -874,8 +1210,10 @@ fu_device_list_add(FuDeviceList *self, FuDevice *device)
 					      device,
 					      FU_DEVICE_INCORPORATE_FLAG_UPDATE_ERROR |
 						  FU_DEVICE_INCORPORATE_FLAG_UPDATE_ERROR);
+			fu_device_list_item_unwatch(item);
 			g_set_object(&item->device_old, item->device);
 			fu_device_list_item_set_device(item, device);
+			fu_device_list_item_reindex(self, item);
 			fu_device_list_clear_wait_for_replug(self, item);
 			fu_device_list_emit_device_changed(self, device);
 			return;
@@ -944,9 +1282,13 @@ fu_device_list_add(FuDeviceList *self, FuDevice *device)
 	/* add helper */
 	item = g_new0(FuDeviceItem, 1);
 	item->self = self; /* no ref */
+	item->guid_keys = g_ptr_array_new_with_free_func(g_free);
+	item->connection_keys = g_ptr_array_new_with_free_func(g_free);
+	item->id_keys = g_ptr_array_new_with_free_func(g_free);
 	fu_device_list_item_set_device(item, device);
 	g_rw_lock_writer_lock(&self->devices_mutex);
 	g_ptr_array_add(self->devices, item);
+	fu_device_list_item_reindex_unlocked(self, item);
 	g_rw_lock_writer_unlock(&self->devices_mutex);
 	fu_device_list_emit_device_added(self, device);
 }
@@ -980,16 +1322,33 @@ fu_device_list_get_by_guid(FuDeviceList *self, const gchar *guid, GError **error
 static GPtrArray *
 fu_device_list_get_wait_for_replug(FuDeviceList *self)
 {
+	GHashTableIter iter;
+	gpointer key;
 	GPtrArray *devices = g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
-	for (guint i = 0; i < self->devices->len; i++) {
-		FuDeviceItem *item_tmp = g_ptr_array_index(self->devices, i);
-		if (fu_device_has_flag(item_tmp->device, FWUPD_DEVICE_FLAG_WAIT_FOR_REPLUG) &&
-		    !fu_device_has_flag(item_tmp->device, FWUPD_DEVICE_FLAG_EMULATED))
-			g_ptr_array_add(devices, g_object_ref(item_tmp->device));
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new(&self->wfr_mutex);
+
+	g_hash_table_iter_init(&iter, self->wfr_items);
+	while (g_hash_table_iter_next(&iter, &key, NULL)) {
+		FuDeviceItem *item_tmp = (FuDeviceItem *)key;
+		g_ptr_array_add(devices, g_object_ref(item_tmp->device));
 	}
 	return devices;
 }
 
+static gboolean
+fu_device_list_wait_for_replug_done(FuDeviceList *self)
+{
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new(&self->wfr_mutex);
+	return g_hash_table_size(self->wfr_items) == 0;
+}
+
+static gboolean
+fu_device_list_wait_for_replug_timeout_cb(gpointer user_data)
+{
+	/* only used to wake up the main context */
+	return G_SOURCE_CONTINUE;
+}
+
 /**
  * fu_device_list_wait_for_replug:
  * @self: a device list
@@ -1006,8 +1365,8 @@ fu_device_list_get_wait_for_replug(FuDeviceList *self)
 gboolean
 fu_device_list_wait_for_replug(FuDeviceList *self, GError **error)
 {
+	gint64 deadline;
 	guint remove_delay = 0;
-	g_autoptr(GTimer) timer = g_timer_new();
 	g_autoptr(GPtrArray) devices_wfr1 = NULL;
 	g_autoptr(GPtrArray) devices_wfr2 = NULL;
 
@@ -1039,16 +1398,30 @@ fu_device_list_wait_for_replug(FuDeviceList *self, GError **error)
 	}
 
 	/* time to unplug and then re-plug */
-	do {
-		g_autoptr(GPtrArray) devices_wfr_tmp = NULL;
-		g_usleep(1000);
-		while (g_main_context_iteration(NULL, FALSE)) {
-			/* nothing needs to be done here */
-		};
-		devices_wfr_tmp = fu_device_list_get_wait_for_replug(self);
-		if (devices_wfr_tmp->len == 0)
-			break;
-	} while (g_timer_elapsed(timer, NULL) * 1000.f < remove_delay);
+	deadline = g_get_monotonic_time() + (gint64)remove_delay * 1000;
+	if (g_main_context_acquire(NULL)) {
+		g_autoptr(GSource) source = g_timeout_source_new(remove_delay);
+
+		/* dispatch events until the last device comes back, or the timeout fires */
+		g_source_set_callback(source,
+				      fu_device_list_wait_for_replug_timeout_cb,
+				      NULL,
+				      NULL);
+		g_source_attach(source, NULL);
+		while (!fu_device_list_wait_for_replug_done(self) &&
+		       g_get_monotonic_time() < deadline)
+			g_main_context_iteration(NULL, TRUE);
+		g_source_destroy(source);
+		g_main_context_release(NULL);
+	} else {
+		g_autoptr(GMutexLocker) locker = g_mutex_locker_new(&self->wfr_mutex);
+
+		/* another thread is dispatching the events, so wait to be signalled */
+		while (g_hash_table_size(self->wfr_items) > 0) {
+			if (!g_cond_wait_until(&self->wfr_cond, &self->wfr_mutex, deadline))
+				break;
+		}
+	}
 
 	/* check that no other devices are still waiting for replug */
 	devices_wfr2 = fu_device_list_get_wait_for_replug(self);
@@ -1112,14 +1485,19 @@ fu_device_list_get_by_id(FuDeviceList *self, const gchar *device_id, GError **er
 	return g_object_ref(item->device);
 }
 
+/* called with the writer lock held, or when the list is being destroyed */
 static void
 fu_device_list_item_free(FuDeviceItem *item)
 {
 	if (item->remove_id != 0)
 		g_source_remove(item->remove_id);
-	if (item->device_old != NULL)
-		g_object_unref(item->device_old);
+	fu_device_list_item_unwatch(item);
+	fu_device_list_item_unindex_unlocked(item->self, item);
+	g_clear_object(&item->device_old);
 	fu_device_list_item_set_device(item, NULL);
+	g_ptr_array_unref(item->guid_keys);
+	g_ptr_array_unref(item->connection_keys);
+	g_ptr_array_unref(item->id_keys);
 	g_free(item);
 }
 
@@ -1207,7 +1585,15 @@ static void
 fu_device_list_init(FuDeviceList *self)
 {
 	self->devices = g_ptr_array_new_with_free_func((GDestroyNotify)fu_device_list_item_free);
+	self->guid_index =
+	    g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)g_ptr_array_unref);
+	self->connection_index =
+	    g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)g_ptr_array_unref);
+	self->id_index = g_ptr_array_new_with_free_func((GDestroyNotify)fu_device_list_id_entry_free);
+	self->wfr_items = g_hash_table_new(g_direct_hash, g_direct_equal);
 	g_rw_lock_init(&self->devices_mutex);
+	g_mutex_init(&self->wfr_mutex);
+	g_cond_init(&self->wfr_cond);
 }
 
 static void
@@ -1217,6 +1603,12 @@ fu_device_list_finalize(GObject *obj)
 
 	g_rw_lock_clear(&self->devices_mutex);
 	g_ptr_array_unref(self->devices);
+	g_hash_table_unref(self->guid_index);
+	g_hash_table_unref(self->connection_index);
+	g_ptr_array_unref(self->id_index);
+	g_hash_table_unref(self->wfr_items);
+	g_mutex_clear(&self->wfr_mutex);
+	g_cond_clear(&self->wfr_cond);
 
 	G_OBJECT_CLASS(fu_device_list_parent_class)->finalize(obj);
 }
@@ -0,0 +1,325 @@
+/*
+ * Copyright 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#define G_LOG_DOMAIN "FuDeviceSignalList"
+
+#include "config.h"
+
+#include "fu-device-signal-list.h"
+
+struct _FuDeviceSignalList {
+	GObject parent_instance;
+	GHashTable *hash; /* (element-type utf8 FuDeviceSignalListItem) */
+	GThread *thread;  /* the only thread allowed to use the hash and the timeout */
+	guint delay_ms;
+	guint timeout_id;
+};
+
+typedef struct {
+	FuDevice *device;	  /* (nullable): pending DeviceChanged */
+	FuDevice *device_watched; /* (nullable): the device @val_cache was built from */
+	gulong notify_id;
+	gint notified;	     /* atomic, as devices can notify from worker threads */
+	GVariant *val;	     /* (nullable): as last sent */
+	GVariant *val_cache; /* (nullable): the current state, until the device changes */
+	gint64 sent_usec;
+} FuDeviceSignalListItem;
+
+G_DEFINE_TYPE(FuDeviceSignalList, fu_device_signal_list, G_TYPE_OBJECT)
+
+enum { SIGNAL_CHANGED, SIGNAL_LAST };
+
+static guint signals[SIGNAL_LAST] = {0};
+
+static void
+fu_device_signal_list_item_free(FuDeviceSignalListItem *item)
+{
+	if (item->device_watched != NULL) {
+		g_signal_handler_disconnect(item->device_watched, item->notify_id);
+		g_object_unref(item->device_watched);
+	}
+	if (item->device != NULL)
+		g_object_unref(item->device);
+	if (item->val != NULL)
+		g_variant_unref(item->val);
+	if (item->val_cache != NULL)
+		g_variant_unref(item->val_cache);
+	g_free(item);
+}
+
+static void
+fu_device_signal_list_item_notify_cb(FuDevice *device,
+				     GParamSpec *pspec,
+				     FuDeviceSignalListItem *item)
+{
+	g_atomic_int_set(&item->notified, TRUE);
+}
+
+/* the cached variant is only valid for the device object it was built from */
+static void
+fu_device_signal_list_item_watch(FuDeviceSignalListItem *item, FuDevice *device)
+{
+	if (item->device_watched == device)
+		return;
+	if (item->device_watched != NULL) {
+		g_signal_handler_disconnect(item->device_watched, item->notify_id);
+		g_object_unref(item->device_watched);
+	}
+	item->device_watched = g_object_ref(device);
+	item->notify_id = g_signal_connect(FU_DEVICE(device),
+					   "notify",
+					   G_CALLBACK(fu_device_signal_list_item_notify_cb),
+					   item);
+	g_clear_pointer(&item->val_cache, g_variant_unref);
+}
+
+/* only serializes the device again if it has changed since the last time */
+static GVariant *
+fu_device_signal_list_item_ensure_variant(FuDeviceSignalListItem *item)
+{
+	if (g_atomic_int_exchange(&item->notified, FALSE))
+		g_clear_pointer(&item->val_cache, g_variant_unref);
+	if (item->val_cache == NULL) {
+		item->val_cache = g_variant_ref_sink(
+		    fwupd_codec_to_variant(FWUPD_CODEC(item->device_watched),
+					   FWUPD_CODEC_FLAG_NONE));
+	}
+	return item->val_cache;
+}
+
+static FuDeviceSignalListItem *
+fu_device_signal_list_ensure_item(FuDeviceSignalList *self, const gchar *device_id)
+{
+	FuDeviceSignalListItem *item = g_hash_table_lookup(self->hash, device_id);
+	if (item == NULL) {
+		item = g_new0(FuDeviceSignalListItem, 1);
+		g_hash_table_insert(self->hash, g_strdup(device_id), item);
+	}
+	return item;
+}
+
+/* returns FALSE if nothing changed */
+static gboolean
+fu_device_signal_list_variant_diff(GVariant *val_old,
+				   GVariant *val,
+				   GVariantBuilder *builder,
+				   GVariantBuilder *invalidated_builder)
+{
+	gboolean changed = FALSE;
+	const gchar *key;
+	GVariant *value;
+	GVariantIter iter;
+
+	/* new or different values */
+	g_variant_iter_init(&iter, val);
+	while (g_variant_iter_loop(&iter, "{&sv}", &key, &value)) {
+		g_autoptr(GVariant) value_old = NULL;
+		if (val_old != NULL)
+			value_old = g_variant_lookup_value(val_old, key, NULL);
+		if (value_old != NULL && g_variant_equal(value_old, value))
+			continue;
+		g_variant_builder_add(builder, "{sv}", key, value);
+		changed = TRUE;
+	}
+
+	/* removed keys */
+	if (val_old != NULL) {
+		g_variant_iter_init(&iter, val_old);
+		while (g_variant_iter_loop(&iter, "{&sv}", &key, &value)) {
+			g_autoptr(GVariant) value_new = g_variant_lookup_value(val, key, NULL);
+			if (value_new != NULL)
+				continue;
+			g_variant_builder_add(invalidated_builder, "s", key);
+			changed = TRUE;
+		}
+	}
+	return changed;
+}
+
+static void
+fu_device_signal_list_flush_item(FuDeviceSignalList *self,
+				 const gchar *device_id,
+				 FuDeviceSignalListItem *item)
+{
+	GVariant *val;
+	GVariantBuilder builder;
+	GVariantBuilder invalidated_builder;
+	g_autoptr(FuDevice) device = g_steal_pointer(&item->device);
+	g_autoptr(GVariant) parameters = NULL;
+
+	/* nothing pending */
+	if (device == NULL)
+		return;
+
+	/* only send the signal if something actually changed */
+	val = fu_device_signal_list_item_ensure_variant(item);
+	if (val == item->val)
+		return;
+	g_variant_builder_init(&builder, G_VARIANT_TYPE_VARDICT);
+	g_variant_builder_init(&invalidated_builder, G_VARIANT_TYPE("as"));
+	if (!fu_device_signal_list_variant_diff(item->val, val, &builder, &invalidated_builder)) {
+		g_variant_builder_clear(&builder);
+		g_variant_builder_clear(&invalidated_builder);
+		return;
+	}
+	parameters = g_variant_ref_sink(
+	    g_variant_new("(sa{sv}as)", device_id, &builder, &invalidated_builder));
+
+	/* save for next time */
+	if (item->val != NULL)
+		g_variant_unref(item->val);
+	item->val = g_variant_ref(val);
+	item->sent_usec = g_get_monotonic_time();
+	g_signal_emit(self, signals[SIGNAL_CHANGED], 0, device, val, parameters);
+}
+
+static gboolean
+fu_device_signal_list_timeout_cb(gpointer user_data)
+{
+	FuDeviceSignalList *self = FU_DEVICE_SIGNAL_LIST(user_data);
+	GHashTableIter iter;
+	gpointer key;
+	gpointer value;
+
+	self->timeout_id = 0;
+	g_hash_table_iter_init(&iter, self->hash);
+	while (g_hash_table_iter_next(&iter, &key, &value))
+		fu_device_signal_list_flush_item(self, key, value);
+	return G_SOURCE_REMOVE;
+}
+
+void
+fu_device_signal_list_set_delay(FuDeviceSignalList *self, guint delay_ms)
+{
+	g_return_if_fail(FU_IS_DEVICE_SIGNAL_LIST(self));
+	self->delay_ms = delay_ms;
+}
+
+/* records the device as sent so later changes are compared to it, returning the variant */
+GVariant *
+fu_device_signal_list_added(FuDeviceSignalList *self, FuDevice *device)
+{
+	FuDeviceSignalListItem *item;
+	GVariant *val;
+
+	g_return_val_if_fail(FU_IS_DEVICE_SIGNAL_LIST(self), NULL);
+	g_return_val_if_fail(FU_IS_DEVICE(device), NULL);
+	g_return_val_if_fail(self->thread == g_thread_self(), NULL);
+
+	item = fu_device_signal_list_ensure_item(self, fu_device_get_id(device));
+	fu_device_signal_list_item_watch(item, device);
+	val = fu_device_signal_list_item_ensure_variant(item);
+	g_clear_object(&item->device);
+	if (item->val != NULL)
+		g_variant_unref(item->val);
+	item->val = g_variant_ref(val);
+	return g_variant_ref(val);
+}
+
+/* the current state of the device, reusing the last variant if nothing has changed */
+GVariant *
+fu_device_signal_list_get_variant(FuDeviceSignalList *self, FuDevice *device)
+{
+	FuDeviceSignalListItem *item;
+
+	g_return_val_if_fail(FU_IS_DEVICE_SIGNAL_LIST(self), NULL);
+	g_return_val_if_fail(FU_IS_DEVICE(device), NULL);
+	g_return_val_if_fail(self->thread == g_thread_self(), NULL);
+
+	item = fu_device_signal_list_ensure_item(self, fu_device_get_id(device));
+	fu_device_signal_list_item_watch(item, device);
+	return g_variant_ref(fu_device_signal_list_item_ensure_variant(item));
+}
+
+/* drops any pending change */
+void
+fu_device_signal_list_removed(FuDeviceSignalList *self, FuDevice *device)
+{
+	g_return_if_fail(FU_IS_DEVICE_SIGNAL_LIST(self));
+	g_return_if_fail(FU_IS_DEVICE(device));
+	g_return_if_fail(self->thread == g_thread_self());
+	g_hash_table_remove(self->hash, fu_device_get_id(device));
+}
+
+void
+fu_device_signal_list_changed(FuDeviceSignalList *self, FuDevice *device)
+{
+	FuDeviceSignalListItem *item;
+
+	g_return_if_fail(FU_IS_DEVICE_SIGNAL_LIST(self));
+	g_return_if_fail(FU_IS_DEVICE(device));
+	g_return_if_fail(self->thread == g_thread_self());
+
+	/* always use the latest device, which may have been replugged */
+	item = fu_device_signal_list_ensure_item(self, fu_device_get_id(device));
+	fu_device_signal_list_item_watch(item, device);
+	g_set_object(&item->device, device);
+
+	/* several device setters do not notify, so a change that was not preceded by a notify
+	 * cannot use the cached variant */
+	if (!g_atomic_int_get(&item->notified))
+		g_clear_pointer(&item->val_cache, g_variant_unref);
+
+	/* the install blocks the main loop, so send now if the last signal was long enough ago,
+	 * otherwise coalesce into the next frame */
+	if (g_get_monotonic_time() - item->sent_usec >= (gint64)self->delay_ms * 1000) {
+		fu_device_signal_list_flush_item(self, fu_device_get_id(device), item);
+		return;
+	}
+	if (self->timeout_id == 0) {
+		self->timeout_id =
+		    g_timeout_add(self->delay_ms, fu_device_signal_list_timeout_cb, self);
+	}
+}
+
+static void
+fu_device_signal_list_init(FuDeviceSignalList *self)
+{
+	self->thread = g_thread_self();
+	self->hash = g_hash_table_new_full(g_str_hash,
+					   g_str_equal,
+					   g_free,
+					   (GDestroyNotify)fu_device_signal_list_item_free);
+}
+
+static void
+fu_device_signal_list_finalize(GObject *obj)
+{
+	FuDeviceSignalList *self = FU_DEVICE_SIGNAL_LIST(obj);
+
+	if (self->timeout_id != 0)
+		g_source_remove(self->timeout_id);
+	g_hash_table_unref(self->hash);
+
+	G_OBJECT_CLASS(fu_device_signal_list_parent_class)->finalize(obj);
+}
+
+static void
+fu_device_signal_list_class_init(FuDeviceSignalListClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS(klass);
+	object_class->finalize = fu_device_signal_list_finalize;
+
+	signals[SIGNAL_CHANGED] = g_signal_new("changed",
+					       G_TYPE_FROM_CLASS(object_class),
+					       G_SIGNAL_RUN_LAST,
+					       0,
+					       NULL,
+					       NULL,
+					       g_cclosure_marshal_generic,
+					       G_TYPE_NONE,
+					       3,
+					       FU_TYPE_DEVICE,
+					       G_TYPE_VARIANT,
+					       G_TYPE_VARIANT);
+}
+
+/* must only be used from the thread that created it, as the timeout uses the default context */
+FuDeviceSignalList *
+fu_device_signal_list_new(void)
+{
+	return g_object_new(FU_TYPE_DEVICE_SIGNAL_LIST, NULL);
+}
@@ -0,0 +1,25 @@
+/*
+ * Copyright 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#pragma once
+
+#include <fwupdplugin.h>
+
+#define FU_TYPE_DEVICE_SIGNAL_LIST (fu_device_signal_list_get_type())
+G_DECLARE_FINAL_TYPE(FuDeviceSignalList, fu_device_signal_list, FU, DEVICE_SIGNAL_LIST, GObject)
+
+FuDeviceSignalList *
+fu_device_signal_list_new(void);
+void
+fu_device_signal_list_set_delay(FuDeviceSignalList *self, guint delay_ms) G_GNUC_NON_NULL(1);
+GVariant *
+fu_device_signal_list_added(FuDeviceSignalList *self, FuDevice *device) G_GNUC_NON_NULL(1, 2);
+GVariant *
+fu_device_signal_list_get_variant(FuDeviceSignalList *self, FuDevice *device) G_GNUC_NON_NULL(1, 2);
+void
+fu_device_signal_list_removed(FuDeviceSignalList *self, FuDevice *device) G_GNUC_NON_NULL(1, 2);
+void
+fu_device_signal_list_changed(FuDeviceSignalList *self, FuDevice *device) G_GNUC_NON_NULL(1, 2);
@@ -23,6 +23,7 @@ struct _FuEngineConfig {
 	GArray *trusted_uids;	      /* (element-type guint64) */
 	gchar *host_bkc;
 	gchar *esp_location;
+	gchar *trace_file;
 };
 
 G_DEFINE_TYPE(FuEngineConfig, fu_engine_config, FU_TYPE_CONFIG)
@@ -121,6 +122,7 @@ fu_engine_config_reload(FuEngineConfig *self)
 	g_autofree gchar *domains = NULL;
 	g_autofree gchar *host_bkc = NULL;
 	g_autofree gchar *esp_location = NULL;
+	g_autofree gchar *trace_file = NULL;
 
 	/* get disabled devices */
 	g_ptr_array_set_size(self->disabled_devices, 0);
@@ -188,6 +190,12 @@ fu_engine_config_reload(FuEngineConfig *self)
 		self->esp_location = g_string_free(g_steal_pointer(&esp_location_tmp), FALSE);
 	}
 
+	/* optional location to write a trace of the daemon startup and installs */
+	g_clear_pointer(&self->trace_file, g_free);
+	trace_file = fu_config_get_value(FU_CONFIG(self), "fwupd", "TraceFile");
+	if (trace_file != NULL && trace_file[0] != '\0')
+		self->trace_file = g_steal_pointer(&trace_file);
+
 	/* get trusted uids */
 	g_array_set_size(self->trusted_uids, 0);
 	uids = fu_config_get_value_strv(FU_CONFIG(self), "fwupd", "TrustedUids");
@@ -299,6 +307,24 @@ fu_engine_config_get_approved_firmware(FuEngineConfig *self)
 	return self->approved_firmware;
 }
 
+guint
+fu_engine_config_get_coldplug_threads(FuEngineConfig *self)
+{
+	return fu_config_get_value_u64(FU_CONFIG(self), "fwupd", "ColdplugThreads");
+}
+
+guint
+fu_engine_config_get_install_threads(FuEngineConfig *self)
+{
+	return fu_config_get_value_u64(FU_CONFIG(self), "fwupd", "InstallThreads");
+}
+
+guint
+fu_engine_config_get_device_changed_delay(FuEngineConfig *self)
+{
+	return fu_config_get_value_u64(FU_CONFIG(self), "fwupd", "DeviceChangedDelay");
+}
+
 gboolean
 fu_engine_config_get_update_motd(FuEngineConfig *self)
 {
@@ -397,6 +423,13 @@ fu_engine_config_get_esp_location(FuEngineConfig *self)
 	return self->esp_location;
 }
 
+const gchar *
+fu_engine_config_get_trace_file(FuEngineConfig *self)
+{
+	g_return_val_if_fail(FU_IS_ENGINE_CONFIG(self), NULL);
+	return self->trace_file;
+}
+
 static gchar *
 fu_engine_config_archive_size_max_default(void)
 {
@@ -430,6 +463,8 @@ fu_engine_config_init(FuEngineConfig *self)
 	fu_engine_config_set_default(self, "ApprovedFirmware", NULL);
 	fu_engine_config_set_default(self, "ArchiveSizeMax", archive_size_max_default);
 	fu_engine_config_set_default(self, "BlockedFirmware", NULL);
+	fu_engine_config_set_default(self, "ColdplugThreads", "0");
+	fu_engine_config_set_default(self, "DeviceChangedDelay", "50"); /* ms */
 	fu_engine_config_set_default(self, "DisabledDevices", NULL);
 	fu_engine_config_set_default(self, "DisabledPlugins", "");
 	fu_engine_config_set_default(self, "EnumerateAllDevices", "false");
@@ -440,6 +475,7 @@ fu_engine_config_init(FuEngineConfig *self)
 	fu_engine_config_set_default(self, "IgnoreEfivarsFreeSpace", "false");
 	fu_engine_config_set_default(self, "IgnorePower", "false");
 	fu_engine_config_set_default(self, "IgnoreRequirements", "false");
+	fu_engine_config_set_default(self, "InstallThreads", "0");
 	fu_engine_config_set_default(self, "OnlyTrusted", "true");
 	fu_engine_config_set_default(self, "P2pPolicy", FU_DEFAULT_P2P_POLICY);
 	fu_engine_config_set_default(self, "ReleaseDedupe", "true");
@@ -448,6 +484,7 @@ fu_engine_config_init(FuEngineConfig *self)
 	fu_engine_config_set_default(self, "OnlyTrustPostQuantumSignatures", "false");
 	fu_engine_config_set_default(self, "ShowDevicePrivate", "true");
 	fu_engine_config_set_default(self, "TestDevices", "false");
+	fu_engine_config_set_default(self, "TraceFile", NULL);
 	fu_engine_config_set_default(self, "TrustedReports", "VendorId=$OEM");
 	fu_engine_config_set_default(self, "TrustedUids", NULL);
 	fu_engine_config_set_default(self, "UpdateMotd", "true");
@@ -469,6 +506,7 @@ fu_engine_config_finalize(GObject *obj)
 	g_array_unref(self->trusted_uids);
 	g_free(self->host_bkc);
 	g_free(self->esp_location);
+	g_free(self->trace_file);
 
 	G_OBJECT_CLASS(fu_engine_config_parent_class)->finalize(obj);
 }
@@ -19,6 +19,12 @@ guint64
 fu_engine_config_get_archive_size_max(FuEngineConfig *self) G_GNUC_NON_NULL(1);
 guint
 fu_engine_config_get_idle_timeout(FuEngineConfig *self) G_GNUC_NON_NULL(1);
+guint
+fu_engine_config_get_coldplug_threads(FuEngineConfig *self) G_GNUC_NON_NULL(1);
+guint
+fu_engine_config_get_install_threads(FuEngineConfig *self) G_GNUC_NON_NULL(1);
+guint
+fu_engine_config_get_device_changed_delay(FuEngineConfig *self) G_GNUC_NON_NULL(1);
 GPtrArray *
 fu_engine_config_get_disabled_devices(FuEngineConfig *self) G_GNUC_NON_NULL(1);
 GPtrArray *
@@ -64,3 +70,5 @@ const gchar *
 fu_engine_config_get_host_bkc(FuEngineConfig *self) G_GNUC_NON_NULL(1);
 const gchar *
 fu_engine_config_get_esp_location(FuEngineConfig *self) G_GNUC_NON_NULL(1);
+const gchar *
+fu_engine_config_get_trace_file(FuEngineConfig *self) G_GNUC_NON_NULL(1);
@@ -284,6 +284,48 @@ fu_engine_update_devices_file(FuEngine *self, GError **error)
 	return g_file_set_contents(target, data, (gssize)len, error);
 }
 
+void
+fu_engine_trace_add_progress(JsonArray *events, FuProgress *progress, guint tid)
+{
+	JsonArray *json_array;
+	g_autoptr(JsonBuilder) builder = json_builder_new();
+	g_autoptr(JsonNode) root = NULL;
+
+	json_builder_begin_array(builder);
+	fu_progress_add_trace_events(progress, builder);
+	json_builder_end_array(builder);
+	root = json_builder_get_root(builder);
+	json_array = json_node_get_array(root);
+	for (guint i = 0; i < json_array_get_length(json_array); i++) {
+		JsonNode *json_node = json_array_dup_element(json_array, i);
+		json_object_set_int_member(json_node_get_object(json_node), "tid", tid);
+		json_array_add_element(events, json_node);
+	}
+}
+
+gboolean
+fu_engine_trace_save(JsonArray *events, const gchar *filename, GError **error)
+{
+	g_autoptr(JsonBuilder) builder = json_builder_new();
+	g_autoptr(JsonGenerator) generator = json_generator_new();
+	g_autoptr(JsonNode) root = NULL;
+
+	json_builder_begin_object(builder);
+	json_builder_set_member_name(builder, "traceEvents");
+	json_builder_add_value(builder, json_node_init_array(json_node_alloc(), events));
+	fwupd_codec_json_append(builder, "displayTimeUnit", "ms");
+	json_builder_end_object(builder);
+
+	root = json_builder_get_root(builder);
+	json_generator_set_root(generator, root);
+	if (!json_generator_to_file(generator, filename, error)) {
+		fwupd_error_convert(error);
+		g_prefix_error(error, "failed to write %s: ", filename);
+		return FALSE;
+	}
+	return TRUE;
+}
+
 static void
 fu_engine_integrity_add_measurement(GHashTable *self, const gchar *id, GBytes *blob)
 {
@@ -409,6 +451,33 @@ fu_engine_integrity_to_string(GHashTable *self)
 	return fu_strjoin("\n", array);
 }
 
+/* as returned by GetUpgradesAll, mapping the device ID to the releases */
+GVariant *
+fu_engine_upgrades_to_variant(GHashTable *upgrades)
+{
+	GHashTableIter iter;
+	gpointer key;
+	gpointer value;
+	GVariantBuilder builder;
+
+	g_variant_builder_init(&builder, G_VARIANT_TYPE("a{saa{sv}}"));
+	g_hash_table_iter_init(&iter, upgrades);
+	while (g_hash_table_iter_next(&iter, &key, &value)) {
+		GPtrArray *releases = (GPtrArray *)value;
+		GVariantBuilder builder_releases;
+
+		g_variant_builder_init(&builder_releases, G_VARIANT_TYPE("aa{sv}"));
+		for (guint i = 0; i < releases->len; i++) {
+			FwupdCodec *codec = FWUPD_CODEC(g_ptr_array_index(releases, i));
+			g_variant_builder_add_value(&builder_releases,
+						    fwupd_codec_to_variant(codec,
+									   FWUPD_CODEC_FLAG_NONE));
+		}
+		g_variant_builder_add(&builder, "{saa{sv}}", (const gchar *)key, &builder_releases);
+	}
+	return g_variant_new("(a{saa{sv}})", &builder);
+}
+
 static const GError *
 fu_engine_error_array_find(GPtrArray *errors, FwupdError error_code)
 {
@@ -13,11 +13,21 @@ fu_engine_update_motd(FuEngine *self, GError **error) G_GNUC_NON_NULL(1);
 gboolean
 fu_engine_update_devices_file(FuEngine *self, GError **error) G_GNUC_NON_NULL(1);
 
+void
+fu_engine_trace_add_progress(JsonArray *events, FuProgress *progress, guint tid)
+    G_GNUC_NON_NULL(1, 2);
+gboolean
+fu_engine_trace_save(JsonArray *events, const gchar *filename, GError **error)
+    G_GNUC_NON_NULL(1, 2);
+
 GHashTable *
 fu_engine_integrity_new(FuContext *ctx, GError **error);
 gchar *
 fu_engine_integrity_to_string(GHashTable *self);
 
+GVariant *
+fu_engine_upgrades_to_variant(GHashTable *upgrades) G_GNUC_NON_NULL(1);
+
 GError *
 fu_engine_error_array_get_best(GPtrArray *errors);
 gchar *
@@ -76,6 +76,13 @@ fu_engine_request_add_flag(FuEngineRequest *self, FuEngineRequestFlags flag)
 	self->flags |= flag;
 }
 
+FuEngineRequestFlags
+fu_engine_request_get_flags(FuEngineRequest *self)
+{
+	g_return_val_if_fail(FU_IS_ENGINE_REQUEST(self), FU_ENGINE_REQUEST_FLAG_NONE);
+	return self->flags;
+}
+
 gboolean
 fu_engine_request_has_flag(FuEngineRequest *self, FuEngineRequestFlags flag)
 {
@@ -0,0 +1,363 @@
+/*
+ * Copyright 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#define G_LOG_DOMAIN "FuEngine"
+
+#include "config.h"
+
+#include "fu-engine-silo.h"
+
+struct _FuEngineSilo {
+	GObject parent_instance;
+	gchar *id;
+	gchar *checksum; /* (nullable) */
+	XbSilo *silo;
+	XbQuery *query_component_by_guid;
+	XbQuery *query_container_checksum1; /* container checksum -> release */
+	XbQuery *query_container_checksum2; /* artifact checksum -> release */
+	XbQuery *query_tag_by_guid_version;
+	GPtrArray *search_queries; /* (element-type XbQuery) */
+	GPtrArray *guids;	   /* (element-type utf8) */
+	GHashTable *guids_hash;	   /* (element-type utf8 utf8) */
+};
+
+G_DEFINE_TYPE(FuEngineSilo, fu_engine_silo, G_TYPE_OBJECT)
+
+const gchar *
+fu_engine_silo_get_id(FuEngineSilo *self)
+{
+	g_return_val_if_fail(FU_IS_ENGINE_SILO(self), NULL);
+	return self->id;
+}
+
+const gchar *
+fu_engine_silo_get_checksum(FuEngineSilo *self)
+{
+	g_return_val_if_fail(FU_IS_ENGINE_SILO(self), NULL);
+	return self->checksum;
+}
+
+void
+fu_engine_silo_set_checksum(FuEngineSilo *self, const gchar *checksum)
+{
+	g_return_if_fail(FU_IS_ENGINE_SILO(self));
+
+	/* not changed */
+	if (g_strcmp0(self->checksum, checksum) == 0)
+		return;
+
+	g_free(self->checksum);
+	self->checksum = g_strdup(checksum);
+}
+
+XbSilo *
+fu_engine_silo_get_silo(FuEngineSilo *self)
+{
+	g_return_val_if_fail(FU_IS_ENGINE_SILO(self), NULL);
+	return self->silo;
+}
+
+XbQuery *
+fu_engine_silo_get_query_component_by_guid(FuEngineSilo *self)
+{
+	g_return_val_if_fail(FU_IS_ENGINE_SILO(self), NULL);
+	return self->query_component_by_guid;
+}
+
+XbQuery *
+fu_engine_silo_get_query_container_checksum1(FuEngineSilo *self)
+{
+	g_return_val_if_fail(FU_IS_ENGINE_SILO(self), NULL);
+	return self->query_container_checksum1;
+}
+
+XbQuery *
+fu_engine_silo_get_query_container_checksum2(FuEngineSilo *self)
+{
+	g_return_val_if_fail(FU_IS_ENGINE_SILO(self), NULL);
+	return self->query_container_checksum2;
+}
+
+XbQuery *
+fu_engine_silo_get_query_tag_by_guid_version(FuEngineSilo *self)
+{
+	g_return_val_if_fail(FU_IS_ENGINE_SILO(self), NULL);
+	return self->query_tag_by_guid_version;
+}
+
+GPtrArray *
+fu_engine_silo_get_search_queries(FuEngineSilo *self)
+{
+	g_return_val_if_fail(FU_IS_ENGINE_SILO(self), NULL);
+	return self->search_queries;
+}
+
+/* all the GUIDs this silo can affect, used to limit what devices get refreshed */
+GPtrArray *
+fu_engine_silo_get_guids(FuEngineSilo *self)
+{
+	g_return_val_if_fail(FU_IS_ENGINE_SILO(self), NULL);
+	return self->guids;
+}
+
+gboolean
+fu_engine_silo_has_guid(FuEngineSilo *self, const gchar *guid)
+{
+	g_return_val_if_fail(FU_IS_ENGINE_SILO(self), FALSE);
+	g_return_val_if_fail(guid != NULL, FALSE);
+	return g_hash_table_contains(self->guids_hash, guid);
+}
+
+static void
+fu_engine_silo_add_guids_for_xpath(FuEngineSilo *self, const gchar *xpath)
+{
+	g_autoptr(GPtrArray) nodes = xb_silo_query(self->silo, xpath, 0, NULL);
+	if (nodes == NULL)
+		return;
+	for (guint i = 0; i < nodes->len; i++) {
+		XbNode *n = g_ptr_array_index(nodes, i);
+		const gchar *guid = xb_node_get_text(n);
+		if (guid == NULL || g_hash_table_contains(self->guids_hash, guid))
+			continue;
+		g_hash_table_add(self->guids_hash, g_strdup(guid));
+		g_ptr_array_add(self->guids, g_strdup(guid));
+	}
+}
+
+static gboolean
+fu_engine_silo_search_query_append(FuEngineSilo *self, const gchar *xpath, GError **error)
+{
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(XbQuery) query = NULL;
+
+	/* prepare tag query with bound GUID parameter */
+	query = xb_query_new_full(self->silo, xpath, XB_QUERY_FLAG_OPTIMIZE, &error_local);
+	if (query == NULL) {
+		if (g_error_matches(error_local, G_IO_ERROR, G_IO_ERROR_NOT_FOUND) ||
+		    g_error_matches(error_local, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT)) {
+			g_debug("ignoring prepared query %s: %s", xpath, error_local->message);
+			return TRUE;
+		}
+		g_propagate_error(error, g_steal_pointer(&error_local));
+		fwupd_error_convert(error);
+		return FALSE;
+	}
+	g_ptr_array_add(self->search_queries, g_steal_pointer(&query));
+
+	/* success */
+	return TRUE;
+}
+
+static gboolean
+fu_engine_silo_search_query_create(FuEngineSilo *self, GError **error)
+{
+	/* we get one for free, add build the others */
+	g_ptr_array_add(self->search_queries, g_object_ref(self->query_component_by_guid));
+	if (!fu_engine_silo_search_query_append(self,
+						"components/component/id[text()=?]/..",
+						error))
+		return FALSE;
+	if (!fu_engine_silo_search_query_append(self,
+						"components/component/name[text()~=?]/..",
+						error))
+		return FALSE;
+	if (!fu_engine_silo_search_query_append(
+		self,
+		"components/component/developer_name[text()~=?]/..",
+		error))
+		return FALSE;
+	if (!fu_engine_silo_search_query_append(self,
+						"components/component/releases/release/artifacts/"
+						"artifact/filename[text()=?]/../../../../..",
+						error))
+		return FALSE;
+	if (!fu_engine_silo_search_query_append(self,
+						"components/component/releases/release/artifacts/"
+						"artifact/checksum[text()=?]/../../../../..",
+						error))
+		return FALSE;
+	if (!fu_engine_silo_search_query_append(
+		self,
+		"components/component/releases/release/issues/issue[text()=?]/../../../..",
+		error))
+		return FALSE;
+	if (!fu_engine_silo_search_query_append(
+		self,
+		"components/component/custom/value[@key='LVFS::UpdateProtocol'][text()=?]/../..",
+		error))
+		return FALSE;
+
+	/* success */
+	return TRUE;
+}
+
+static gboolean
+fu_engine_silo_create_index_components(FuEngineSilo *self, GError **error)
+{
+	g_autoptr(GPtrArray) components = NULL;
+	g_autoptr(GError) error_container_checksum1 = NULL;
+	g_autoptr(GError) error_container_checksum2 = NULL;
+
+	/* print what we've got */
+	components = xb_silo_query(self->silo, "components/component[@type='firmware']", 0, NULL);
+	if (components == NULL)
+		return TRUE;
+	g_info("%u components now in %s silo", components->len, self->id);
+
+	/* build the index */
+	if (!xb_silo_query_build_index(self->silo, "components/component", "type", error)) {
+		fwupd_error_convert(error);
+		return FALSE;
+	}
+	if (!xb_silo_query_build_index(self->silo,
+				       "components/component[@type='firmware']/provides/firmware",
+				       "type",
+				       error)) {
+		fwupd_error_convert(error);
+		return FALSE;
+	}
+	if (!xb_silo_query_build_index(self->silo,
+				       "components/component/provides/firmware",
+				       NULL,
+				       error)) {
+		fwupd_error_convert(error);
+		return FALSE;
+	}
+	if (!xb_silo_query_build_index(self->silo,
+				       "components/component[@type='firmware']/tags/tag",
+				       "namespace",
+				       error)) {
+		fwupd_error_convert(error);
+		return FALSE;
+	}
+
+	/* create prepared queries to save time later */
+	self->query_component_by_guid =
+	    xb_query_new_full(self->silo,
+			      "components/component/provides/firmware[@type=$'flashed'][text()=?]/"
+			      "../..",
+			      XB_QUERY_FLAG_OPTIMIZE,
+			      error);
+	if (self->query_component_by_guid == NULL) {
+		g_prefix_error_literal(error, "failed to prepare query: ");
+		return FALSE;
+	}
+
+	/* old-style <checksum target="container"> and new-style <artifact> */
+	self->query_container_checksum1 =
+	    xb_query_new_full(self->silo,
+			      "components/component[@type='firmware']/releases/release/"
+			      "checksum[@target='container'][text()=?]/..",
+			      XB_QUERY_FLAG_OPTIMIZE,
+			      &error_container_checksum1);
+	if (self->query_container_checksum1 == NULL)
+		g_debug("ignoring prepared query: %s", error_container_checksum1->message);
+	self->query_container_checksum2 =
+	    xb_query_new_full(self->silo,
+			      "components/component[@type='firmware']/releases/release/"
+			      "artifacts/artifact[@type='binary']/checksum[text()=?]/"
+			      "../../..",
+			      XB_QUERY_FLAG_OPTIMIZE,
+			      &error_container_checksum2);
+	if (self->query_container_checksum2 == NULL)
+		g_debug("ignoring prepared query: %s", error_container_checksum2->message);
+
+	/* build all the search queries */
+	return fu_engine_silo_search_query_create(self, error);
+}
+
+static gboolean
+fu_engine_silo_create_index(FuEngineSilo *self, GError **error)
+{
+	g_autoptr(GError) error_tag_by_guid_version = NULL;
+
+	/* only remotes have firmware components */
+	if (!fu_engine_silo_create_index_components(self, error))
+		return FALSE;
+
+	/* prepare tag query with bound GUID parameter, only local.d has these */
+	self->query_tag_by_guid_version =
+	    xb_query_new_full(self->silo,
+			      "local/components/component[@merge='append']/provides/"
+			      "firmware[text()=?]/../../releases/release[@version=?]/../../"
+			      "tags/tag",
+			      XB_QUERY_FLAG_OPTIMIZE,
+			      &error_tag_by_guid_version);
+	if (self->query_tag_by_guid_version == NULL)
+		g_debug("ignoring prepared query: %s", error_tag_by_guid_version->message);
+
+	/* so we know which devices to refresh when this silo changes */
+	fu_engine_silo_add_guids_for_xpath(self,
+					   "components/component/provides/"
+					   "firmware[@type='flashed']");
+	fu_engine_silo_add_guids_for_xpath(self, "local/components/component/provides/firmware");
+
+	/* success */
+	return TRUE;
+}
+
+static void
+fu_engine_silo_init(FuEngineSilo *self)
+{
+	self->search_queries = g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
+	self->guids = g_ptr_array_new_with_free_func(g_free);
+	self->guids_hash = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+}
+
+static void
+fu_engine_silo_finalize(GObject *obj)
+{
+	FuEngineSilo *self = FU_ENGINE_SILO(obj);
+	g_free(self->id);
+	g_free(self->checksum);
+	if (self->silo != NULL)
+		g_object_unref(self->silo);
+	if (self->query_component_by_guid != NULL)
+		g_object_unref(self->query_component_by_guid);
+	if (self->query_container_checksum1 != NULL)
+		g_object_unref(self->query_container_checksum1);
+	if (self->query_container_checksum2 != NULL)
+		g_object_unref(self->query_container_checksum2);
+	if (self->query_tag_by_guid_version != NULL)
+		g_object_unref(self->query_tag_by_guid_version);
+	g_ptr_array_unref(self->search_queries);
+	g_ptr_array_unref(self->guids);
+	g_hash_table_unref(self->guids_hash);
+	G_OBJECT_CLASS(fu_engine_silo_parent_class)->finalize(obj);
+}
+
+static void
+fu_engine_silo_class_init(FuEngineSiloClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS(klass);
+	object_class->finalize = fu_engine_silo_finalize;
+}
+
+/**
+ * fu_engine_silo_new:
+ * @id: a remote ID, or `local` for the client-side metadata
+ * @silo: a #XbSilo
+ * @error: (nullable): optional return location for an error
+ *
+ * Creates the indexes and prepared queries for one compiled remote silo.
+ *
+ * Returns: (transfer full): a #FuEngineSilo, or %NULL on error
+ **/
+FuEngineSilo *
+fu_engine_silo_new(const gchar *id, XbSilo *silo, GError **error)
+{
+	g_autoptr(FuEngineSilo) self = g_object_new(FU_TYPE_ENGINE_SILO, NULL);
+
+	g_return_val_if_fail(id != NULL, NULL);
+	g_return_val_if_fail(XB_IS_SILO(silo), NULL);
+	g_return_val_if_fail(error == NULL || *error == NULL, NULL);
+
+	self->id = g_strdup(id);
+	self->silo = g_object_ref(silo);
+	if (!fu_engine_silo_create_index(self, error))
+		return NULL;
+	return g_steal_pointer(&self);
+}
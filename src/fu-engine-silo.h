@@ -0,0 +1,37 @@
+/*
+ * Copyright 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#pragma once
+
+#include <fwupdplugin.h>
+
+#define FU_TYPE_ENGINE_SILO (fu_engine_silo_get_type())
+G_DECLARE_FINAL_TYPE(FuEngineSilo, fu_engine_silo, FU, ENGINE_SILO, GObject)
+
+FuEngineSilo *
+fu_engine_silo_new(const gchar *id, XbSilo *silo, GError **error) G_GNUC_NON_NULL(1, 2);
+const gchar *
+fu_engine_silo_get_id(FuEngineSilo *self) G_GNUC_NON_NULL(1);
+const gchar *
+fu_engine_silo_get_checksum(FuEngineSilo *self) G_GNUC_NON_NULL(1);
+void
+fu_engine_silo_set_checksum(FuEngineSilo *self, const gchar *checksum) G_GNUC_NON_NULL(1);
+XbSilo *
+fu_engine_silo_get_silo(FuEngineSilo *self) G_GNUC_NON_NULL(1);
+XbQuery *
+fu_engine_silo_get_query_component_by_guid(FuEngineSilo *self) G_GNUC_NON_NULL(1);
+XbQuery *
+fu_engine_silo_get_query_container_checksum1(FuEngineSilo *self) G_GNUC_NON_NULL(1);
+XbQuery *
+fu_engine_silo_get_query_container_checksum2(FuEngineSilo *self) G_GNUC_NON_NULL(1);
+XbQuery *
+fu_engine_silo_get_query_tag_by_guid_version(FuEngineSilo *self) G_GNUC_NON_NULL(1);
+GPtrArray *
+fu_engine_silo_get_search_queries(FuEngineSilo *self) G_GNUC_NON_NULL(1);
+GPtrArray *
+fu_engine_silo_get_guids(FuEngineSilo *self) G_GNUC_NON_NULL(1);
+gboolean
+fu_engine_silo_has_guid(FuEngineSilo *self, const gchar *guid) G_GNUC_NON_NULL(1, 2);
@@ -13,6 +13,7 @@
 #ifdef HAVE_GIO_UNIX
 #include <gio/gunixinputstream.h>
 #endif
+#include <glib/gstdio.h>
 #ifdef HAVE_PASSIM
 #include <passim.h>
 #endif
@@ -48,6 +49,7 @@
 #include "fu-engine-helper.h"
 #include "fu-engine-request.h"
 #include "fu-engine-requirements.h"
+#include "fu-engine-silo.h"
 #include "fu-engine.h"
 #include "fu-history.h"
 #include "fu-idle.h"
@@ -84,6 +86,9 @@
 
 #define FU_ENGINE_UPDATE_MOTD_DELAY 5 /* s */
 
+/* the daemon may run for a long time, so only the most recent trace events are kept */
+#define FU_ENGINE_TRACE_EVENTS_MAX 100000
+
 #define FU_ENGINE_MAX_METADATA_SIZE  0x2000000 /* 32MB */
 #define FU_ENGINE_MAX_SIGNATURE_SIZE 0x100000  /* 1MB */
 
@@ -103,17 +108,19 @@ struct _FuEngine {
 	FuEngineConfig *config;
 	FuRemoteList *remote_list;
 	FuDeviceList *device_list;
-	gboolean write_history;
+	gint write_history; /* atomic, as devices may be installed in parallel */
 	gboolean host_emulation;
 	guint percentage;
 	FuHistory *history;
 	FuIdle *idle;
-	XbSilo *silo;
-	XbQuery *query_component_by_guid;
-	XbQuery *query_container_checksum1; /* container checksum -> release */
-	XbQuery *query_container_checksum2; /* artifact checksum -> release */
-	XbQuery *query_tag_by_guid_version;
-	GPtrArray *search_queries; /* (element-type XbQuery) */
+	GPtrArray *silos;	    /* (element-type FuEngineSilo) */
+	GHashTable *releases_cache; /* (element-type str GPtrArray) */
+	guint releases_cache_hits;
+	gint releases_cache_generation;
+	gint device_generation; /* atomic */
+	guint md_refresh_cnt;
+	guint metainfo_convert_cnt;
+	gint coldplug_worker_cnt; /* atomic */
 	FuPluginList *plugin_list;
 	GPtrArray *plugin_filter;
 	FuContext *ctx;
@@ -133,6 +140,8 @@ struct _FuEngine {
 	guint emulator_write_cnt;
 	guint emulator_composite_cnt;
 	FuEngineLoadFlags load_flags;
+	JsonArray *trace_events; /* (nullable) */
+	GThread *thread_main;	 /* no-ref, signals are only emitted from here */
 #ifdef HAVE_PASSIM
 	PassimClient *passim_client;
 #endif
@@ -220,6 +229,96 @@ fu_engine_emit_changed(FuEngine *self)
 		g_info("failed to update list of devices: %s", error->message);
 }
 
+typedef enum {
+	FU_ENGINE_DEFERRED_KIND_STATUS_CHANGED,
+	FU_ENGINE_DEFERRED_KIND_DEVICE_CHANGED,
+	FU_ENGINE_DEFERRED_KIND_DEVICE_LIST_ADDED,
+	FU_ENGINE_DEFERRED_KIND_DEVICE_LIST_REMOVED,
+	FU_ENGINE_DEFERRED_KIND_DEVICE_LIST_CHANGED,
+} FuEngineDeferredKind;
+
+typedef struct {
+	FuEngine *self;
+	FuEngineDeferredKind kind;
+	FuDevice *device; /* nullable */
+	FwupdStatus status;
+} FuEngineDeferredHelper;
+
+static void
+fu_engine_emit_device_changed_safe(FuEngine *self, FuDevice *device);
+static void
+fu_engine_set_status(FuEngine *self, FwupdStatus status);
+static void
+fu_engine_device_added_cb(FuDeviceList *device_list, FuDevice *device, FuEngine *self);
+static void
+fu_engine_device_removed_cb(FuDeviceList *device_list, FuDevice *device, FuEngine *self);
+static void
+fu_engine_device_changed_cb(FuDeviceList *device_list, FuDevice *device, FuEngine *self);
+static void
+fu_engine_releases_cache_invalidate(FuEngine *self);
+
+static void
+fu_engine_deferred_helper_free(FuEngineDeferredHelper *helper)
+{
+	g_object_unref(helper->self);
+	if (helper->device != NULL)
+		g_object_unref(helper->device);
+	g_free(helper);
+}
+
+static gboolean
+fu_engine_deferred_cb(gpointer user_data)
+{
+	FuEngineDeferredHelper *helper = (FuEngineDeferredHelper *)user_data;
+	FuEngine *self = helper->self;
+
+	switch (helper->kind) {
+	case FU_ENGINE_DEFERRED_KIND_STATUS_CHANGED:
+		fu_engine_set_status(self, helper->status);
+		break;
+	case FU_ENGINE_DEFERRED_KIND_DEVICE_CHANGED:
+		fu_engine_emit_device_changed_safe(self, helper->device);
+		break;
+	case FU_ENGINE_DEFERRED_KIND_DEVICE_LIST_ADDED:
+		fu_engine_device_added_cb(self->device_list, helper->device, self);
+		break;
+	case FU_ENGINE_DEFERRED_KIND_DEVICE_LIST_REMOVED:
+		fu_engine_device_removed_cb(self->device_list, helper->device, self);
+		break;
+	case FU_ENGINE_DEFERRED_KIND_DEVICE_LIST_CHANGED:
+		fu_engine_device_changed_cb(self->device_list, helper->device, self);
+		break;
+	default:
+		break;
+	}
+	return G_SOURCE_REMOVE;
+}
+
+/* devices installed in parallel call back from the worker threads, but the signal handlers
+ * and the caches they invalidate are only safe to use from the thread that owns the engine */
+static gboolean
+fu_engine_defer_to_main_thread(FuEngine *self,
+			       FuEngineDeferredKind kind,
+			       FuDevice *device,
+			       FwupdStatus status)
+{
+	FuEngineDeferredHelper *helper;
+
+	if (g_thread_self() == self->thread_main)
+		return FALSE;
+	helper = g_new0(FuEngineDeferredHelper, 1);
+	helper->self = g_object_ref(self);
+	helper->kind = kind;
+	helper->device = device != NULL ? g_object_ref(device) : NULL;
+	helper->status = status;
+	g_main_context_invoke_full(NULL,
+				   G_PRIORITY_DEFAULT,
+				   fu_engine_deferred_cb,
+				   helper,
+				   (GDestroyNotify)fu_engine_deferred_helper_free);
+	return TRUE;
+}
+
 static void
 fu_engine_emit_device_changed_safe(FuEngine *self, FuDevice *device)
 {
@@ -227,6 +326,13 @@ fu_engine_emit_device_changed_safe(FuEngine *self, FuDevice *device)
 	if ((self->load_flags & FU_ENGINE_LOAD_FLAG_READY) == 0)
 		return;
 
+	/* emitted from a worker thread */
+	if (fu_engine_defer_to_main_thread(self,
+					   FU_ENGINE_DEFERRED_KIND_DEVICE_CHANGED,
+					   device,
+					   FWUPD_STATUS_UNKNOWN))
+		return;
+
 	/* invalidate host security attributes */
 	fu_security_attrs_remove_all(self->host_security_attrs);
 	g_signal_emit(self, signals[SIGNAL_DEVICE_CHANGED], 0, device);
@@ -257,6 +363,13 @@ fu_engine_get_context(FuEngine *self)
 static void
 fu_engine_set_status(FuEngine *self, FwupdStatus status)
 {
+	/* emitted from a worker thread */
+	if (fu_engine_defer_to_main_thread(self,
+					   FU_ENGINE_DEFERRED_KIND_STATUS_CHANGED,
+					   NULL,
+					   status))
+		return;
+
 	/* emit changed */
 	g_signal_emit(self, signals[SIGNAL_STATUS_CHANGED], 0, status);
 }
@@ -264,6 +377,7 @@ fu_engine_set_status(FuEngine *self, FwupdStatus status)
 static void
 fu_engine_generic_notify_cb(FuDevice *device, GParamSpec *pspec, FuEngine *self)
 {
+	fu_engine_releases_cache_invalidate(self);
 	if (fu_idle_has_inhibit(self->idle, FU_IDLE_INHIBIT_SIGNALS) &&
 	    !g_hash_table_contains(self->device_changed_allowlist, fu_device_get_id(device))) {
 		g_debug("suppressing notification from %s as transaction is in progress",
@@ -330,7 +444,7 @@ fu_engine_device_equivalent_id_notify_cb(FuDevice *device, GParamSpec *pspec, Fu
 static void
 fu_engine_history_notify_cb(FuDevice *device, GParamSpec *pspec, FuEngine *self)
 {
-	if (self->write_history) {
+	if (g_atomic_int_get(&self->write_history)) {
 		g_autoptr(GError) error_local = NULL;
 		if (!fu_history_modify_device(self->history, device, &error_local)) {
 			if (g_error_matches(error_local, FWUPD_ERROR, FWUPD_ERROR_NOT_FOUND)) {
@@ -345,6 +459,13 @@ fu_engine_history_notify_cb(FuDevice *device, GParamSpec *pspec, FuEngine *self)
 	fu_engine_emit_device_changed(self, fu_device_get_id(device));
 }
 
+static void
+fu_engine_device_version_notify_cb(FuDevice *device, GParamSpec *pspec, FuEngine *self)
+{
+	/* the requirements of other devices may depend on this version */
+	fu_engine_releases_cache_invalidate(self);
+}
+
 static void
 fu_engine_device_request_cb(FuDevice *device, FwupdRequest *request, FuEngine *self)
 {
@@ -366,6 +487,9 @@ fu_engine_watch_device(FuEngine *self, FuDevice *device)
 	if (device_old != NULL) {
 		g_signal_handlers_disconnect_by_func(device_old, fu_engine_generic_notify_cb, self);
 		g_signal_handlers_disconnect_by_func(device_old, fu_engine_history_notify_cb, self);
+		g_signal_handlers_disconnect_by_func(device_old,
+						     fu_engine_device_version_notify_cb,
+						     self);
 		g_signal_handlers_disconnect_by_func(device_old, fu_engine_device_request_cb, self);
 	}
 	g_signal_connect(FU_DEVICE(device),
@@ -392,6 +516,10 @@ fu_engine_watch_device(FuEngine *self, FuDevice *device)
 			 "notify::update-error",
 			 G_CALLBACK(fu_engine_history_notify_cb),
 			 self);
+	g_signal_connect(FU_DEVICE(device),
+			 "notify::version",
+			 G_CALLBACK(fu_engine_device_version_notify_cb),
+			 self);
 	g_signal_connect(FU_DEVICE(device),
 			 "notify::equivalent-id",
 			 G_CALLBACK(fu_engine_device_equivalent_id_notify_cb),
@@ -522,9 +650,22 @@ fu_engine_ensure_context_flag_save_events(FuEngine *self)
 	fu_context_add_flag(self->ctx, FU_CONTEXT_FLAG_SAVE_EVENTS);
 }
 
+/* this is called from worker threads too, so the cache is only flushed on the next lookup */
+static void
+fu_engine_releases_cache_invalidate(FuEngine *self)
+{
+	g_atomic_int_inc(&self->device_generation);
+}
+
 static void
 fu_engine_device_added_cb(FuDeviceList *device_list, FuDevice *device, FuEngine *self)
 {
+	if (fu_engine_defer_to_main_thread(self,
+					   FU_ENGINE_DEFERRED_KIND_DEVICE_LIST_ADDED,
+					   device,
+					   FWUPD_STATUS_UNKNOWN))
+		return;
+	fu_engine_releases_cache_invalidate(self);
 	fu_engine_watch_device(self, device);
 	fu_engine_ensure_device_problem_priority(self, device);
 	fu_engine_ensure_device_power_inhibit(self, device);
@@ -549,6 +690,12 @@ fu_engine_device_runner_device_removed(FuEngine *self, FuDevice *device)
 static void
 fu_engine_device_removed_cb(FuDeviceList *device_list, FuDevice *device, FuEngine *self)
 {
+	if (fu_engine_defer_to_main_thread(self,
+					   FU_ENGINE_DEFERRED_KIND_DEVICE_LIST_REMOVED,
+					   device,
+					   FWUPD_STATUS_UNKNOWN))
+		return;
+	fu_engine_releases_cache_invalidate(self);
 	fu_engine_device_runner_device_removed(self, device);
 	fu_engine_acquiesce_reset(self);
 	g_signal_handlers_disconnect_by_data(device, self);
@@ -558,28 +705,31 @@ fu_engine_device_removed_cb(FuDeviceList *device_list, FuDevice *device, FuEngin
 static void
 fu_engine_device_changed_cb(FuDeviceList *device_list, FuDevice *device, FuEngine *self)
 {
+	if (fu_engine_defer_to_main_thread(self,
+					   FU_ENGINE_DEFERRED_KIND_DEVICE_LIST_CHANGED,
+					   device,
+					   FWUPD_STATUS_UNKNOWN))
+		return;
+	fu_engine_releases_cache_invalidate(self);
 	fu_engine_watch_device(self, device);
 	fu_engine_emit_device_changed(self, fu_device_get_id(device));
 	fu_engine_acquiesce_reset(self);
 }
 
-/* add any client-side BKC tags */
 static gboolean
-fu_engine_add_local_release_metadata(FuEngine *self, FuRelease *release, GError **error)
+fu_engine_add_local_release_metadata_silo(FuEngine *self,
+					  FuEngineSilo *engine_silo,
+					  FuRelease *release,
+					  GPtrArray *guids,
+					  GError **error)
 {
-	FuDevice *dev = fu_release_get_device(release);
-	GPtrArray *guids;
-
-	/* no device matched */
-	if (dev == NULL)
-		return TRUE;
+	XbQuery *query = fu_engine_silo_get_query_tag_by_guid_version(engine_silo);
 
 	/* not set up */
-	if (self->query_tag_by_guid_version == NULL)
+	if (query == NULL)
 		return TRUE;
 
 	/* use prepared query for each GUID */
-	guids = fu_device_get_guids(dev);
 	for (guint i = 0; i < guids->len; i++) {
 		const gchar *guid = g_ptr_array_index(guids, i);
 		g_autoptr(GError) error_local = NULL;
@@ -592,8 +742,8 @@ fu_engine_add_local_release_metadata(FuEngine *self, FuRelease *release, GError
 					   1,
 					   fu_release_get_version(release),
 					   NULL);
-		tags = xb_silo_query_with_context(self->silo,
-						  self->query_tag_by_guid_version,
+		tags = xb_silo_query_with_context(fu_engine_silo_get_silo(engine_silo),
+						  query,
 						  &context,
 						  &error_local);
 		if (tags == NULL) {
@@ -614,6 +764,31 @@ fu_engine_add_local_release_metadata(FuEngine *self, FuRelease *release, GError
 	return TRUE;
 }
 
+/* add any client-side BKC tags */
+static gboolean
+fu_engine_add_local_release_metadata(FuEngine *self, FuRelease *release, GError **error)
+{
+	FuDevice *dev = fu_release_get_device(release);
+
+	/* no device matched */
+	if (dev == NULL)
+		return TRUE;
+
+	/* only the local.d silo has a prepared query */
+	for (guint i = 0; i < self->silos->len; i++) {
+		FuEngineSilo *engine_silo = g_ptr_array_index(self->silos, i);
+		if (!fu_engine_add_local_release_metadata_silo(self,
+							       engine_silo,
+							       release,
+							       fu_device_get_guids(dev),
+							       error))
+			return FALSE;
+	}
+
+	/* success */
+	return TRUE;
+}
+
 /* private, for self tests */
 void
 fu_engine_add_remote(FuEngine *self, FwupdRemote *remote)
@@ -764,53 +939,98 @@ fu_engine_load_release(FuEngine *self,
 	return TRUE;
 }
 
+static gboolean
+fu_engine_has_components(FuEngine *self)
+{
+	for (guint i = 0; i < self->silos->len; i++) {
+		FuEngineSilo *engine_silo = g_ptr_array_index(self->silos, i);
+		if (fu_engine_silo_get_query_component_by_guid(engine_silo) != NULL)
+			return TRUE;
+	}
+	return FALSE;
+}
+
+typedef XbQuery *(*FuEngineSiloQueryFunc)(FuEngineSilo *engine_silo);
+
+/* runs the prepared query on each remote silo in turn, concatenating the results */
+static GPtrArray *
+fu_engine_query_silos(FuEngine *self,
+		      FuEngineSiloQueryFunc query_func,
+		      XbQueryContext *context,
+		      GError **error)
+{
+	g_autoptr(GPtrArray) results = g_ptr_array_new_with_free_func(g_object_unref);
+
+	for (guint i = 0; i < self->silos->len; i++) {
+		FuEngineSilo *engine_silo = g_ptr_array_index(self->silos, i);
+		XbQuery *query = query_func(engine_silo);
+		g_autoptr(GError) error_local = NULL;
+		g_autoptr(GPtrArray) nodes = NULL;
+
+		if (query == NULL)
+			continue;
+		nodes = xb_silo_query_with_context(fu_engine_silo_get_silo(engine_silo),
+						   query,
+						   context,
+						   &error_local);
+		if (nodes == NULL) {
+			if (g_error_matches(error_local, G_IO_ERROR, G_IO_ERROR_NOT_FOUND) ||
+			    g_error_matches(error_local, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT))
+				continue;
+			g_propagate_error(error, g_steal_pointer(&error_local));
+			fwupd_error_convert(error);
+			return NULL;
+		}
+		g_ptr_array_extend_and_steal(results, g_steal_pointer(&nodes));
+	}
+	if (results->len == 0) {
+		g_set_error_literal(error, FWUPD_ERROR, FWUPD_ERROR_NOT_FOUND, "no results");
+		return NULL;
+	}
+	return g_steal_pointer(&results);
+}
+
 /* finds the releases for all firmware in the silo that matches this
  * container or artifact checksum */
 static GPtrArray *
 fu_engine_get_releases_for_container_checksum(FuEngine *self, const gchar *csum)
 {
+	g_autoptr(GPtrArray) rels1 = NULL;
 	g_auto(XbQueryContext) context = XB_QUERY_CONTEXT_INIT();
-	xb_value_bindings_bind_str(xb_query_context_get_bindings(&context), 0, csum, NULL);
-	if (self->query_container_checksum1 != NULL) {
-		g_autoptr(GPtrArray) rels =
-		    xb_silo_query_with_context(self->silo,
-					       self->query_container_checksum1,
-					       &context,
-					       NULL);
-		if (rels != NULL)
-			return g_steal_pointer(&rels);
-	}
-	if (self->query_container_checksum2 != NULL) {
-		g_autoptr(GPtrArray) rels =
-		    xb_silo_query_with_context(self->silo,
-					       self->query_container_checksum2,
-					       &context,
-					       NULL);
-		if (rels != NULL)
-			return g_steal_pointer(&rels);
-	}
 
-	/* failed */
-	return NULL;
+	xb_value_bindings_bind_str(xb_query_context_get_bindings(&context), 0, csum, NULL);
+	rels1 = fu_engine_query_silos(self,
+				      fu_engine_silo_get_query_container_checksum1,
+				      &context,
+				      NULL);
+	if (rels1 != NULL)
+		return g_steal_pointer(&rels1);
+	return fu_engine_query_silos(self,
+				     fu_engine_silo_get_query_container_checksum2,
+				     &context,
+				     NULL);
 }
 
 /* does this exist in any enabled remote */
 gchar *
 fu_engine_get_remote_id_for_stream(FuEngine *self, GInputStream *stream)
 {
-	GChecksumType checksum_types[] = {G_CHECKSUM_SHA256, G_CHECKSUM_SHA1, 0};
+	GChecksumType checksum_types[] = {G_CHECKSUM_SHA256, G_CHECKSUM_SHA1};
+	g_auto(GStrv) checksums = NULL;
 
 	g_return_val_if_fail(FU_IS_ENGINE(self), NULL);
 	g_return_val_if_fail(G_IS_INPUT_STREAM(stream), NULL);
 
-	for (guint i = 0; checksum_types[i] != 0; i++) {
-		g_autofree gchar *csum = NULL;
+	checksums = fu_input_stream_compute_checksums(stream,
+						      checksum_types,
+						      G_N_ELEMENTS(checksum_types),
+						      NULL);
+	if (checksums == NULL)
+		return NULL;
+	for (guint i = 0; checksums[i] != NULL; i++) {
 		g_autoptr(GPtrArray) rels = NULL;
 
-		csum = fu_input_stream_compute_checksum(stream, checksum_types[i], NULL);
-		if (csum == NULL)
-			continue;
-		rels = fu_engine_get_releases_for_container_checksum(self, csum);
+		rels = fu_engine_get_releases_for_container_checksum(self, checksums[i]);
 		if (rels == NULL)
 			continue;
 		for (guint j = 0; j < rels->len; j++) {
@@ -895,6 +1115,7 @@ fu_engine_modify_config(FuEngine *self,
 		    "ArchiveSizeMax",
 		    "ApprovedFirmware",
 		    "BlockedFirmware",
+		    "DeviceChangedDelay",
 		    "DisabledDevices",
 		    "DisabledPlugins",
 		    "EnumerateAllDevices",
@@ -1443,27 +1664,32 @@ fu_engine_verify_update(FuEngine *self,
 static XbNode *
 fu_engine_get_component_by_guid(FuEngine *self, const gchar *guid)
 {
-	g_autoptr(GError) error_local = NULL;
-	g_autoptr(XbNode) component = NULL;
 	g_auto(XbQueryContext) context = XB_QUERY_CONTEXT_INIT();
 
-	/* no components in silo */
-	if (self->query_component_by_guid == NULL)
-		return NULL;
-
 	xb_query_context_set_flags(&context, XB_QUERY_FLAG_USE_INDEXES);
 	xb_value_bindings_bind_str(xb_query_context_get_bindings(&context), 0, guid, NULL);
-	component = xb_silo_query_first_with_context(self->silo,
-						     self->query_component_by_guid,
-						     &context,
-						     &error_local);
-	if (component == NULL) {
-		if (!g_error_matches(error_local, G_IO_ERROR, G_IO_ERROR_NOT_FOUND) &&
-		    !g_error_matches(error_local, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT))
-			g_warning("ignoring: %s", error_local->message);
-		return NULL;
+	for (guint i = 0; i < self->silos->len; i++) {
+		FuEngineSilo *engine_silo = g_ptr_array_index(self->silos, i);
+		XbQuery *query = fu_engine_silo_get_query_component_by_guid(engine_silo);
+		g_autoptr(GError) error_local = NULL;
+		g_autoptr(XbNode) component = NULL;
+
+		/* no components in silo, or GUID not provided by this remote */
+		if (query == NULL || !fu_engine_silo_has_guid(engine_silo, guid))
+			continue;
+		component = xb_silo_query_first_with_context(fu_engine_silo_get_silo(engine_silo),
+							     query,
+							     &context,
+							     &error_local);
+		if (component == NULL) {
+			if (!g_error_matches(error_local, G_IO_ERROR, G_IO_ERROR_NOT_FOUND) &&
+			    !g_error_matches(error_local, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT))
+				g_warning("ignoring: %s", error_local->message);
+			continue;
+		}
+		return g_steal_pointer(&component);
 	}
-	return g_object_ref(component);
+	return NULL;
 }
 
 XbNode *
@@ -1526,14 +1752,18 @@ fu_engine_verify_from_local_metadata(FuEngine *self, FuDevice *device, GError **
 }
 
 static XbNode *
-fu_engine_verify_from_system_metadata(FuEngine *self, FuDevice *device, GError **error)
+fu_engine_verify_from_system_metadata_silo(FuEngine *self,
+					   FuEngineSilo *engine_silo,
+					   FuDevice *device,
+					   GError **error)
 {
 	FwupdVersionFormat fmt = fu_device_get_version_format(device);
 	GPtrArray *guids = fu_device_get_guids(device);
+	XbSilo *silo = fu_engine_silo_get_silo(engine_silo);
 	g_autoptr(XbQuery) query = NULL;
 
 	/* prepare query with bound GUID parameter */
-	query = xb_query_new_full(self->silo,
+	query = xb_query_new_full(silo,
 				  "components/component[@type='firmware']/"
 				  "provides/firmware[@type='flashed'][text()=?]/"
 				  "../../releases/release",
@@ -1553,7 +1783,7 @@ fu_engine_verify_from_system_metadata(FuEngine *self, FuDevice *device, GError *
 
 		/* bind GUID and then query */
 		xb_value_bindings_bind_str(xb_query_context_get_bindings(&context), 0, guid, NULL);
-		releases = xb_silo_query_with_context(self->silo, query, &context, &error_local);
+		releases = xb_silo_query_with_context(silo, query, &context, &error_local);
 		if (releases == NULL) {
 			if (g_error_matches(error_local, G_IO_ERROR, G_IO_ERROR_NOT_FOUND) ||
 			    g_error_matches(error_local, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT)) {
@@ -1578,6 +1808,35 @@ fu_engine_verify_from_system_metadata(FuEngine *self, FuDevice *device, GError *
 	return NULL;
 }
 
+static XbNode *
+fu_engine_verify_from_system_metadata(FuEngine *self, FuDevice *device, GError **error)
+{
+	for (guint i = 0; i < self->silos->len; i++) {
+		FuEngineSilo *engine_silo = g_ptr_array_index(self->silos, i);
+		g_autoptr(GError) error_local = NULL;
+		g_autoptr(XbNode) rel = NULL;
+
+		/* no firmware components */
+		if (fu_engine_silo_get_query_component_by_guid(engine_silo) == NULL)
+			continue;
+		rel = fu_engine_verify_from_system_metadata_silo(self,
+								 engine_silo,
+								 device,
+								 &error_local);
+		if (rel == NULL) {
+			if (g_error_matches(error_local, FWUPD_ERROR, FWUPD_ERROR_NOT_FOUND))
+				continue;
+			g_propagate_error(error, g_steal_pointer(&error_local));
+			return NULL;
+		}
+		return g_steal_pointer(&rel);
+	}
+
+	/* not found */
+	g_set_error_literal(error, FWUPD_ERROR, FWUPD_ERROR_NOT_FOUND, "failed to find release");
+	return NULL;
+}
+
 /**
  * fu_engine_verify:
  * @self: a #FuEngine
@@ -2339,6 +2598,255 @@ fu_engine_install_release_version_check(FuEngine *self,
 	return TRUE;
 }
 
+typedef struct {
+	FuEngine *self;
+	FuRelease *release;
+	FuProgress *progress;
+	FuProgress *progress_batch;
+	GPtrArray *jobs; /* no-ref */
+	FwupdInstallFlags flags;
+	GError *error;
+	gint *pending;
+	gint percentage; /* atomic */
+} FuEngineInstallJob;
+
+static void
+fu_engine_install_job_free(FuEngineInstallJob *job)
+{
+	g_object_unref(job->release);
+	g_object_unref(job->progress);
+	if (job->error != NULL)
+		g_error_free(job->error);
+	g_free(job);
+}
+
+/* the root device of the device and its proxy, as devices sharing either are never parallel */
+static void
+fu_engine_install_release_add_roots(FuRelease *release, GPtrArray *roots)
+{
+	FuDevice *device = fu_release_get_device(release);
+	g_ptr_array_add(roots, fu_device_get_root(device));
+	g_ptr_array_add(roots, fu_device_get_root(fu_device_get_proxy_with_fallback(device)));
+}
+
+static gboolean
+fu_engine_install_release_is_concurrent(FuEngine *self, FuRelease *release)
+{
+	FuDevice *device = fu_release_get_device(release);
+	FuPlugin *plugin;
+
+	/* the emulator records a single stream of events */
+	if (fu_device_has_flag(device, FWUPD_DEVICE_FLAG_EMULATED))
+		return FALSE;
+	if (fu_context_has_flag(self->ctx, FU_CONTEXT_FLAG_SAVE_EVENTS))
+		return FALSE;
+	plugin = fu_plugin_list_find_by_name(self->plugin_list, fu_device_get_plugin(device), NULL);
+	if (plugin == NULL || !fu_plugin_has_flag(plugin, FWUPD_PLUGIN_FLAG_THREAD_SAFE))
+		return FALSE;
+	return TRUE;
+}
+
+/*
+ * Splits the already sorted releases into batches that can be installed at the same time.
+ *
+ * Devices that share a root device (which includes parent/child relationships and any
+ * install-parent-first ordering) or a proxy are always in different batches, as are devices
+ * with a different install order.
+ */
+static GPtrArray *
+fu_engine_install_releases_get_batches(FuEngine *self, GPtrArray *releases)
+{
+	guint threads = fu_engine_config_get_install_threads(self->config);
+	g_autoptr(GPtrArray) batches =
+	    g_ptr_array_new_with_free_func((GDestroyNotify)g_ptr_array_unref);
+	g_autoptr(GPtrArray) roots = g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
+	GPtrArray *batch = NULL;
+
+	for (guint i = 0; i < releases->len; i++) {
+		FuRelease *release = g_ptr_array_index(releases, i);
+		g_autoptr(GPtrArray) roots_tmp =
+		    g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
+		gboolean can_join = FALSE;
+
+		fu_engine_install_release_add_roots(release, roots_tmp);
+		if (threads > 1 && batch != NULL && batch->len < threads &&
+		    fu_engine_install_release_is_concurrent(self, release) &&
+		    fu_engine_install_release_is_concurrent(self, g_ptr_array_index(batch, 0))) {
+			FuRelease *release_first = g_ptr_array_index(batch, 0);
+			can_join = fu_device_get_order(fu_release_get_device(release)) ==
+				   fu_device_get_order(fu_release_get_device(release_first));
+			for (guint j = 0; can_join && j < roots_tmp->len; j++) {
+				if (g_ptr_array_find(roots, g_ptr_array_index(roots_tmp, j), NULL))
+					can_join = FALSE;
+			}
+		}
+		if (!can_join) {
+			batch = g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
+			g_ptr_array_add(batches, batch);
+			g_ptr_array_set_size(roots, 0);
+		}
+		g_ptr_array_add(batch, g_object_ref(release));
+		g_ptr_array_extend_and_steal(roots, g_steal_pointer(&roots_tmp));
+	}
+	return g_steal_pointer(&batches);
+}
+
+static void
+fu_engine_trace_ensure_profile(FuEngine *self, FuProgress *progress)
+{
+	if (fu_engine_config_get_trace_file(self->config) != NULL)
+		fu_progress_set_profile(progress, TRUE);
+}
+
+/* devices installed at the same time use a different @tid so the spans do not overlap */
+static void
+fu_engine_trace_add_progress_and_save(FuEngine *self, FuProgress *progress, guint tid)
+{
+	const gchar *filename = fu_engine_config_get_trace_file(self->config);
+	g_autoptr(GError) error_local = NULL;
+
+	if (filename == NULL)
+		return;
+	if (self->trace_events != NULL &&
+	    json_array_get_length(self->trace_events) > FU_ENGINE_TRACE_EVENTS_MAX) {
+		g_debug("discarding old trace events");
+		g_clear_pointer(&self->trace_events, json_array_unref);
+	}
+	if (self->trace_events == NULL)
+		self->trace_events = json_array_new();
+	fu_engine_trace_add_progress(self->trace_events, progress, tid);
+	if (!fu_engine_trace_save(self->trace_events, filename, &error_local))
+		g_warning("failed to save trace: %s", error_local->message);
+}
+
+static void
+fu_engine_install_job_cb(gpointer data, gpointer user_data)
+{
+	FuEngineInstallJob *job = (FuEngineInstallJob *)data;
+	if (!fu_engine_install_release(job->self,
+				       job->release,
+				       job->progress,
+				       job->flags,
+				       &job->error))
+		fu_progress_finished(job->progress);
+	if (g_atomic_int_dec_and_test(job->pending))
+		g_main_context_wakeup(NULL);
+}
+
+static gboolean
+fu_engine_install_batch_progress_cb(gpointer user_data)
+{
+	GPtrArray *jobs = (GPtrArray *)user_data;
+	FuEngineInstallJob *job_first = g_ptr_array_index(jobs, 0);
+	guint percentage = 0;
+
+	/* the batch is as complete as the average device */
+	for (guint i = 0; i < jobs->len; i++) {
+		FuEngineInstallJob *job = g_ptr_array_index(jobs, i);
+		percentage += g_atomic_int_get(&job->percentage);
+	}
+	percentage /= jobs->len;
+	if (percentage > fu_progress_get_percentage(job_first->progress_batch))
+		fu_progress_set_percentage(job_first->progress_batch, percentage);
+	return G_SOURCE_REMOVE;
+}
+
+/* called from the worker thread, so only update the batch from the main thread */
+static void
+fu_engine_install_job_percentage_changed_cb(FuProgress *progress,
+					    guint percentage,
+					    FuEngineInstallJob *job)
+{
+	g_atomic_int_set(&job->percentage, percentage);
+	g_main_context_invoke(NULL, fu_engine_install_batch_progress_cb, job->jobs);
+}
+
+static gboolean
+fu_engine_install_batch(FuEngine *self,
+			GPtrArray *batch,
+			FuProgress *progress,
+			FwupdInstallFlags flags,
+			GError **error)
+{
+	GThreadPool *pool;
+	gint pending = batch->len;
+	g_autoptr(GPtrArray) jobs =
+	    g_ptr_array_new_with_free_func((GDestroyNotify)fu_engine_install_job_free);
+
+	/* nothing to do in parallel */
+	if (batch->len == 1) {
+		return fu_engine_install_release(self,
+						 g_ptr_array_index(batch, 0),
+						 progress,
+						 flags,
+						 error);
+	}
+
+	/* each device gets its own progress, which updates the batch from the main thread */
+	for (guint i = 0; i < batch->len; i++) {
+		FuEngineInstallJob *job = g_new0(FuEngineInstallJob, 1);
+		job->self = self;
+		job->release = g_object_ref(g_ptr_array_index(batch, i));
+		job->progress = fu_progress_new(G_STRLOC);
+		job->progress_batch = progress;
+		job->jobs = jobs;
+		fu_engine_trace_ensure_profile(self, job->progress);
+		g_signal_connect(FU_PROGRESS(job->progress),
+				 "percentage-changed",
+				 G_CALLBACK(fu_engine_install_job_percentage_changed_cb),
+				 job);
+		job->flags = flags;
+		job->pending = &pending;
+		g_ptr_array_add(jobs, job);
+	}
+
+	/* own the main context so that the workers waiting for replug do not dispatch sources */
+	g_info("installing %u devices in parallel", batch->len);
+	g_main_context_acquire(NULL);
+	pool = g_thread_pool_new(fu_engine_install_job_cb, NULL, batch->len, FALSE, error);
+	if (pool == NULL) {
+		g_main_context_release(NULL);
+		return FALSE;
+	}
+	for (guint i = 0; i < jobs->len; i++) {
+		if (!g_thread_pool_push(pool, g_ptr_array_index(jobs, i), error)) {
+			g_atomic_int_add(&pending, (gint)i - (gint)jobs->len);
+			while (g_atomic_int_get(&pending) > 0)
+				g_main_context_iteration(NULL, TRUE);
+			g_thread_pool_free(pool, FALSE, TRUE);
+			while (g_main_context_pending(NULL))
+				g_main_context_iteration(NULL, FALSE);
+			g_main_context_release(NULL);
+			return FALSE;
+		}
+	}
+	while (g_atomic_int_get(&pending) > 0)
+		g_main_context_iteration(NULL, TRUE);
+	g_thread_pool_free(pool, FALSE, TRUE);
+
+	/* emit the signals and progress deferred by the workers before the jobs are freed */
+	while (g_main_context_pending(NULL))
+		g_main_context_iteration(NULL, FALSE);
+	g_main_context_release(NULL);
+	for (guint i = 0; i < jobs->len; i++) {
+		FuEngineInstallJob *job = g_ptr_array_index(jobs, i);
+		fu_engine_trace_add_progress_and_save(self, job->progress, i + 2);
+	}
+
+	/* report the first failure, in install order */
+	for (guint i = 0; i < jobs->len; i++) {
+		FuEngineInstallJob *job = g_ptr_array_index(jobs, i);
+		if (job->error != NULL) {
+			g_propagate_error(error, g_steal_pointer(&job->error));
+			return FALSE;
+		}
+	}
+
+	/* success */
+	fu_progress_finished(progress);
+	return TRUE;
+}
+
 /**
  * fu_engine_install_releases:
  * @self: a #FuEngine
@@ -2365,7 +2873,9 @@ fu_engine_install_releases(FuEngine *self,
 			   FwupdInstallFlags flags,
 			   GError **error)
 {
+	guint composite_cnt = 0;
 	g_autoptr(FuIdleLocker) locker = NULL;
+	g_autoptr(GPtrArray) batches = NULL;
 	g_autoptr(GPtrArray) devices = NULL;
 	g_autoptr(GPtrArray) devices_new = NULL;
 
@@ -2410,26 +2920,31 @@ fu_engine_install_releases(FuEngine *self,
 		return FALSE;
 	}
 
-	/* all authenticated, so install all the things */
+	/* all authenticated, so install all the things, independent devices at the same time */
+	batches = fu_engine_install_releases_get_batches(self, releases);
 	fu_progress_set_id(progress, G_STRLOC);
-	fu_progress_set_steps(progress, releases->len);
-	for (guint i = 0; i < releases->len; i++) {
-		FuRelease *release = g_ptr_array_index(releases, i);
-		self->emulator_composite_cnt = i;
-		if (!fu_engine_install_release(self,
-					       release,
-					       fu_progress_get_child(progress),
-					       flags,
-					       error)) {
+	fu_engine_trace_ensure_profile(self, progress);
+	fu_progress_set_steps(progress, batches->len);
+	for (guint i = 0; i < batches->len; i++) {
+		GPtrArray *batch = g_ptr_array_index(batches, i);
+		self->emulator_composite_cnt = composite_cnt;
+		if (!fu_engine_install_batch(self,
+					     batch,
+					     fu_progress_get_child(progress),
+					     flags,
+					     error)) {
 			g_autoptr(GError) error_local = NULL;
+			fu_engine_trace_add_progress_and_save(self, progress, 1);
 			if (!fu_engine_composite_cleanup(self, devices, &error_local)) {
 				g_warning("failed to cleanup failed composite action: %s",
 					  error_local->message);
 			}
 			return FALSE;
 		}
+		composite_cnt += batch->len;
 		fu_progress_step_done(progress);
 	}
+	fu_engine_trace_add_progress_and_save(self, progress, 1);
 
 	/* set all the device statuses back to unknown */
 	for (guint i = 0; i < releases->len; i++) {
@@ -2695,14 +3210,17 @@ fu_engine_install_release(FuEngine *self,
 
 	/* add the checksum of the container blob if not already set */
 	if (fwupd_release_get_checksums(FWUPD_RELEASE(release))->len == 0) {
-		GChecksumType checksum_types[] = {G_CHECKSUM_SHA256, G_CHECKSUM_SHA1, 0};
-		for (guint i = 0; checksum_types[i] != 0; i++) {
-			g_autofree gchar *checksum =
-			    fu_input_stream_compute_checksum(stream, checksum_types[i], error);
-			if (checksum == NULL)
-				return FALSE;
-			fwupd_release_add_checksum(FWUPD_RELEASE(release), checksum);
-		}
+		GChecksumType checksum_types[] = {G_CHECKSUM_SHA256, G_CHECKSUM_SHA1};
+		g_auto(GStrv) checksums = NULL;
+
+		checksums = fu_input_stream_compute_checksums(stream,
+							      checksum_types,
+							      G_N_ELEMENTS(checksum_types),
+							      error);
+		if (checksums == NULL)
+			return FALSE;
+		for (guint i = 0; checksums[i] != NULL; i++)
+			fwupd_release_add_checksum(FWUPD_RELEASE(release), checksums[i]);
 	}
 
 	/* not in bootloader mode */
@@ -2728,7 +3246,7 @@ fu_engine_install_release(FuEngine *self,
 	}
 
 	/* set this for the callback */
-	self->write_history = (flags & FWUPD_INSTALL_FLAG_NO_HISTORY) == 0;
+	g_atomic_int_set(&self->write_history, (flags & FWUPD_INSTALL_FLAG_NO_HISTORY) == 0);
 
 	/* get the plugin */
 	plugin =
@@ -3733,6 +4251,7 @@ fu_engine_install_blob(FuEngine *self,
 	/* progress */
 	fu_progress_set_id(progress, G_STRLOC);
 	fu_progress_add_flag(progress, FU_PROGRESS_FLAG_NO_PROFILE);
+	fu_progress_set_device_id(progress, fu_device_get_id(device));
 	fu_progress_add_step(progress, FWUPD_STATUS_DEVICE_BUSY, 1, "prepare");
 	fu_progress_add_step(progress, FWUPD_STATUS_DEVICE_WRITE, 98, NULL);
 	fu_progress_add_step(progress, FWUPD_STATUS_DEVICE_BUSY, 1, "cleanup");
@@ -3851,178 +4370,54 @@ fu_engine_get_item_by_id_fallback_history(FuEngine *self, const gchar *id, GErro
 	return NULL;
 }
 
-static gboolean
-fu_engine_search_query_append(FuEngine *self, const gchar *xpath, GError **error)
+/* for the self tests */
+void
+fu_engine_set_silo(FuEngine *self, XbSilo *silo)
 {
+	g_autoptr(FuEngineSilo) engine_silo = NULL;
 	g_autoptr(GError) error_local = NULL;
-	g_autoptr(XbQuery) query = NULL;
-
-	/* prepare tag query with bound GUID parameter */
-	query = xb_query_new_full(self->silo, xpath, XB_QUERY_FLAG_OPTIMIZE, &error_local);
-	if (query == NULL) {
-		if (g_error_matches(error_local, G_IO_ERROR, G_IO_ERROR_NOT_FOUND) ||
-		    g_error_matches(error_local, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT)) {
-			g_debug("ignoring prepared query %s: %s", xpath, error_local->message);
-			return TRUE;
-		}
-		g_propagate_error(error, g_steal_pointer(&error_local));
-		fwupd_error_convert(error);
-		return FALSE;
+	g_return_if_fail(FU_IS_ENGINE(self));
+	g_return_if_fail(XB_IS_SILO(silo));
+	g_ptr_array_set_size(self->silos, 0);
+	fu_engine_releases_cache_invalidate(self);
+	engine_silo = fu_engine_silo_new("self-test", silo, &error_local);
+	if (engine_silo == NULL) {
+		g_warning("failed to create indexes: %s", error_local->message);
+		return;
 	}
-	g_ptr_array_add(self->search_queries, g_steal_pointer(&query));
-
-	/* success */
-	return TRUE;
+	g_ptr_array_add(self->silos, g_steal_pointer(&engine_silo));
 }
 
-static gboolean
-fu_engine_search_query_create(FuEngine *self, GError **error)
+/* for the self tests */
+guint
+fu_engine_get_releases_cache_hits(FuEngine *self)
 {
-	/* invalidate everything */
-	g_ptr_array_set_size(self->search_queries, 0);
+	g_return_val_if_fail(FU_IS_ENGINE(self), G_MAXUINT);
+	return self->releases_cache_hits;
+}
 
-	/* we get one for free, add build the others */
-	g_ptr_array_add(self->search_queries, g_object_ref(self->query_component_by_guid));
-	if (!fu_engine_search_query_append(self, "components/component/id[text()=?]/..", error))
-		return FALSE;
-	if (!fu_engine_search_query_append(self, "components/component/name[text()~=?]/..", error))
-		return FALSE;
-	if (!fu_engine_search_query_append(self,
-					   "components/component/developer_name[text()~=?]/..",
-					   error))
-		return FALSE;
-	if (!fu_engine_search_query_append(self,
-					   "components/component/releases/release/artifacts/"
-					   "artifact/filename[text()=?]/../../../../..",
-					   error))
-		return FALSE;
-	if (!fu_engine_search_query_append(self,
-					   "components/component/releases/release/artifacts/"
-					   "artifact/checksum[text()=?]/../../../../..",
-					   error))
-		return FALSE;
-	if (!fu_engine_search_query_append(
-		self,
-		"components/component/releases/release/issues/issue[text()=?]/../../../..",
-		error))
-		return FALSE;
-	if (!fu_engine_search_query_append(
-		self,
-		"components/component/custom/value[@key='LVFS::UpdateProtocol'][text()=?]/../..",
-		error))
-		return FALSE;
-
-	/* success */
-	return TRUE;
+/* for the self tests */
+guint
+fu_engine_get_md_refresh_cnt(FuEngine *self)
+{
+	g_return_val_if_fail(FU_IS_ENGINE(self), G_MAXUINT);
+	return self->md_refresh_cnt;
 }
 
-static gboolean
-fu_engine_create_silo_index(FuEngine *self, GError **error)
+/* for the self tests */
+guint
+fu_engine_get_metainfo_convert_cnt(FuEngine *self)
 {
-	g_autoptr(GPtrArray) components = NULL;
-	g_autoptr(GError) error_container_checksum1 = NULL;
-	g_autoptr(GError) error_container_checksum2 = NULL;
-	g_autoptr(GError) error_tag_by_guid_version = NULL;
-
-	/* print what we've got */
-	components = xb_silo_query(self->silo, "components/component[@type='firmware']", 0, NULL);
-	if (components == NULL)
-		return TRUE;
-	g_info("%u components now in silo", components->len);
-
-	/* clear old prepared queries */
-	g_clear_object(&self->query_component_by_guid);
-	g_clear_object(&self->query_container_checksum1);
-	g_clear_object(&self->query_container_checksum2);
-	g_clear_object(&self->query_tag_by_guid_version);
-
-	/* build the index */
-	if (!xb_silo_query_build_index(self->silo, "components/component", "type", error)) {
-		fwupd_error_convert(error);
-		return FALSE;
-	}
-	if (!xb_silo_query_build_index(self->silo,
-				       "components/component[@type='firmware']/provides/firmware",
-				       "type",
-				       error)) {
-		fwupd_error_convert(error);
-		return FALSE;
-	}
-	if (!xb_silo_query_build_index(self->silo,
-				       "components/component/provides/firmware",
-				       NULL,
-				       error)) {
-		fwupd_error_convert(error);
-		return FALSE;
-	}
-	if (!xb_silo_query_build_index(self->silo,
-				       "components/component[@type='firmware']/tags/tag",
-				       "namespace",
-				       error)) {
-		fwupd_error_convert(error);
-		return FALSE;
-	}
-
-	/* create prepared queries to save time later */
-	self->query_component_by_guid =
-	    xb_query_new_full(self->silo,
-			      "components/component/provides/firmware[@type=$'flashed'][text()=?]/"
-			      "../..",
-			      XB_QUERY_FLAG_OPTIMIZE,
-			      error);
-	if (self->query_component_by_guid == NULL) {
-		g_prefix_error_literal(error, "failed to prepare query: ");
-		return FALSE;
-	}
-
-	/* old-style <checksum target="container"> and new-style <artifact> */
-	self->query_container_checksum1 =
-	    xb_query_new_full(self->silo,
-			      "components/component[@type='firmware']/releases/release/"
-			      "checksum[@target='container'][text()=?]/..",
-			      XB_QUERY_FLAG_OPTIMIZE,
-			      &error_container_checksum1);
-	if (self->query_container_checksum1 == NULL)
-		g_debug("ignoring prepared query: %s", error_container_checksum1->message);
-	self->query_container_checksum2 =
-	    xb_query_new_full(self->silo,
-			      "components/component[@type='firmware']/releases/release/"
-			      "artifacts/artifact[@type='binary']/checksum[text()=?]/"
-			      "../../..",
-			      XB_QUERY_FLAG_OPTIMIZE,
-			      &error_container_checksum2);
-	if (self->query_container_checksum2 == NULL)
-		g_debug("ignoring prepared query: %s", error_container_checksum2->message);
-
-	/* prepare tag query with bound GUID parameter */
-	self->query_tag_by_guid_version =
-	    xb_query_new_full(self->silo,
-			      "local/components/component[@merge='append']/provides/"
-			      "firmware[text()=?]/../../releases/release[@version=?]/../../"
-			      "tags/tag",
-			      XB_QUERY_FLAG_OPTIMIZE,
-			      &error_tag_by_guid_version);
-	if (self->query_tag_by_guid_version == NULL)
-		g_debug("ignoring prepared query: %s", error_tag_by_guid_version->message);
-
-	/* build all the search queries */
-	if (!fu_engine_search_query_create(self, error))
-		return FALSE;
-
-	/* success */
-	return TRUE;
+	g_return_val_if_fail(FU_IS_ENGINE(self), G_MAXUINT);
+	return self->metainfo_convert_cnt;
 }
 
 /* for the self tests */
-void
-fu_engine_set_silo(FuEngine *self, XbSilo *silo)
+guint
+fu_engine_get_coldplug_worker_cnt(FuEngine *self)
 {
-	g_autoptr(GError) error_local = NULL;
-	g_return_if_fail(FU_IS_ENGINE(self));
-	g_return_if_fail(XB_IS_SILO(silo));
-	g_set_object(&self->silo, silo);
-	if (!fu_engine_create_silo_index(self, &error_local))
-		g_warning("failed to create indexes: %s", error_local->message);
+	g_return_val_if_fail(FU_IS_ENGINE(self), G_MAXUINT);
+	return g_atomic_int_get(&self->coldplug_worker_cnt);
 }
 
 static gboolean
@@ -4036,64 +4431,306 @@ fu_engine_appstream_upgrade_cb(XbBuilderFixup *self,
 	return TRUE;
 }
 
-static GInputStream *
-fu_engine_builder_cabinet_adapter_cb(XbBuilderSource *source,
-				     XbBuilderSourceCtx *ctx,
-				     gpointer user_data,
-				     GCancellable *cancellable,
-				     GError **error)
+/* enough to include the CFHEADER, CFFOLDER and CFFILE entries of most archives */
+#define FU_ENGINE_METAINFO_CACHE_HEADER_SIZE 0x1000
+
+typedef struct {
+	gchar *filename;       /* .cab */
+	gchar *filename_cache; /* .xml, or %NULL when not caching */
+	gchar *xml;	       /* only set when converted */
+	GError *error;
+} FuEngineMetainfoItem;
+
+typedef struct {
+	GAsyncQueue *jcat_contexts; /* (element-type JcatContext) */
+	gsize archive_size_max;
+	FuFirmwareParseFlags parse_flags;
+} FuEngineMetainfoHelper;
+
+static void
+fu_engine_metainfo_item_free(FuEngineMetainfoItem *item)
+{
+	g_free(item->filename);
+	g_free(item->filename_cache);
+	g_free(item->xml);
+	if (item->error != NULL)
+		g_error_free(item->error);
+	g_free(item);
+}
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(FuEngineMetainfoItem, fu_engine_metainfo_item_free)
+
+static JcatContext *
+fu_engine_jcat_context_new(void)
+{
+	JcatContext *jcat_context = jcat_context_new();
+	g_autofree gchar *keyring_path = NULL;
+	g_autofree gchar *pkidir_fw = NULL;
+	g_autofree gchar *pkidir_md = NULL;
+
+	jcat_context_blob_kind_allow(jcat_context, JCAT_BLOB_KIND_SHA256);
+	jcat_context_blob_kind_allow(jcat_context, JCAT_BLOB_KIND_SHA512);
+	jcat_context_blob_kind_allow(jcat_context, JCAT_BLOB_KIND_PKCS7);
+	jcat_context_blob_kind_allow(jcat_context, JCAT_BLOB_KIND_GPG);
+	keyring_path = fu_path_from_kind(FU_PATH_KIND_LOCALSTATEDIR_PKG);
+	jcat_context_set_keyring_path(jcat_context, keyring_path);
+	pkidir_fw = fu_path_build(FU_PATH_KIND_SYSCONFDIR, "pki", "fwupd", NULL);
+	jcat_context_add_public_keys(jcat_context, pkidir_fw);
+	pkidir_md = fu_path_build(FU_PATH_KIND_SYSCONFDIR, "pki", "fwupd-metadata", NULL);
+	jcat_context_add_public_keys(jcat_context, pkidir_md);
+	return jcat_context;
+}
+
+static FuFirmwareParseFlags
+fu_engine_get_cabinet_parse_flags(FuEngine *self)
+{
+	FuFirmwareParseFlags flags = FU_FIRMWARE_PARSE_FLAG_CACHE_STREAM;
+
+	/* distrusting RSA? */
+	if (fu_engine_config_get_only_trust_pq_signatures(self->config))
+		flags |= FU_FIRMWARE_PARSE_FLAG_ONLY_TRUST_PQ_SIGNATURES;
+	return flags;
+}
+
+static FuCabinet *
+fu_engine_cabinet_new_from_stream(JcatContext *jcat_context,
+				  gsize archive_size_max,
+				  FuFirmwareParseFlags flags,
+				  GInputStream *stream,
+				  GError **error)
+{
+	g_autoptr(FuCabinet) cabinet = fu_cabinet_new();
+	fu_firmware_set_size_max(FU_FIRMWARE(cabinet), archive_size_max);
+	fu_cabinet_set_jcat_context(cabinet, jcat_context);
+	if (!fu_firmware_parse_stream(FU_FIRMWARE(cabinet), stream, 0x0, flags, error))
+		return NULL;
+	return g_steal_pointer(&cabinet);
+}
+
+static gint
+fu_engine_metainfo_cache_salt_sort_cb(gconstpointer a, gconstpointer b)
+{
+	return g_strcmp0(*(const gchar **)a, *(const gchar **)b);
+}
+
+/* anything other than the archive itself that changes the converted XML */
+static gchar *
+fu_engine_metainfo_cache_salt(FuEngine *self)
+{
+	GString *str = g_string_new(VERSION);
+	const gchar *pkidirs[] = {"fwupd", "fwupd-metadata"};
+
+	g_string_append_printf(str,
+			       ":%" G_GUINT64_FORMAT,
+			       (guint64)fu_engine_get_cabinet_parse_flags(self));
+
+	/* metadata_trust depends on the installed certificates, and replacing a file in-place
+	 * does not change the mtime of the directory */
+	for (guint i = 0; i < G_N_ELEMENTS(pkidirs); i++) {
+		g_autofree gchar *pkidir =
+		    fu_path_build(FU_PATH_KIND_SYSCONFDIR, "pki", pkidirs[i], NULL);
+		g_autoptr(GPtrArray) fns = fu_path_get_files(pkidir, NULL);
+
+		if (fns == NULL)
+			continue;
+		g_ptr_array_sort(fns, fu_engine_metainfo_cache_salt_sort_cb);
+		for (guint j = 0; j < fns->len; j++) {
+			const gchar *fn = g_ptr_array_index(fns, j);
+			g_autoptr(GFile) file = g_file_new_for_path(fn);
+			g_autoptr(GFileInfo) info = NULL;
+
+			info = g_file_query_info(file,
+						 G_FILE_ATTRIBUTE_STANDARD_SIZE
+						 "," G_FILE_ATTRIBUTE_TIME_MODIFIED,
+						 G_FILE_QUERY_INFO_NONE,
+						 NULL,
+						 NULL);
+			if (info == NULL)
+				continue;
+			g_string_append_printf(
+			    str,
+			    ":%s:%" G_GUINT64_FORMAT ":%" G_GUINT64_FORMAT,
+			    fn,
+			    g_file_info_get_attribute_uint64(info, G_FILE_ATTRIBUTE_STANDARD_SIZE),
+			    g_file_info_get_attribute_uint64(info, G_FILE_ATTRIBUTE_TIME_MODIFIED));
+		}
+	}
+	return g_string_free(str, FALSE);
+}
+
+/* the inode, size and mtime are cheap to get but can be preserved on copy */
+static gchar *
+fu_engine_metainfo_cache_key(const gchar *fn, const gchar *salt, GError **error)
+{
+	guint64 inode;
+	guint64 mtime;
+	guint64 size;
+	g_autofree gchar *csum_header = NULL;
+	g_autofree gchar *str = NULL;
+	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(GFile) file = g_file_new_for_path(fn);
+	g_autoptr(GFileInfo) info = NULL;
+	g_autoptr(GInputStream) stream = NULL;
+
+	info = g_file_query_info(file,
+				 G_FILE_ATTRIBUTE_UNIX_INODE "," G_FILE_ATTRIBUTE_STANDARD_SIZE
+							     "," G_FILE_ATTRIBUTE_TIME_MODIFIED,
+				 G_FILE_QUERY_INFO_NONE,
+				 NULL,
+				 error);
+	if (info == NULL) {
+		fwupd_error_convert(error);
+		return NULL;
+	}
+	size = g_file_info_get_attribute_uint64(info, G_FILE_ATTRIBUTE_STANDARD_SIZE);
+	stream = fu_input_stream_from_path(fn, error);
+	if (stream == NULL)
+		return NULL;
+	blob = fu_input_stream_read_bytes(stream,
+					  0x0,
+					  MIN(size, FU_ENGINE_METAINFO_CACHE_HEADER_SIZE),
+					  NULL,
+					  error);
+	if (blob == NULL)
+		return NULL;
+	csum_header = g_compute_checksum_for_bytes(G_CHECKSUM_SHA256, blob);
+	inode = g_file_info_get_attribute_uint64(info, G_FILE_ATTRIBUTE_UNIX_INODE);
+	mtime = g_file_info_get_attribute_uint64(info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+	str = g_strdup_printf("%s:%" G_GUINT64_FORMAT ":%" G_GUINT64_FORMAT ":%" G_GUINT64_FORMAT
+			      ":%s",
+			      salt,
+			      inode,
+			      size,
+			      mtime,
+			      csum_header);
+	return g_compute_checksum_for_string(G_CHECKSUM_SHA256, str, -1);
+}
+
+/* runs in a worker thread */
+static gboolean
+fu_engine_metainfo_item_convert(FuEngineMetainfoHelper *helper,
+				FuEngineMetainfoItem *item,
+				JcatContext *jcat_context,
+				GError **error)
 {
-	FuEngine *self = FU_ENGINE(user_data);
-	GInputStream *stream = xb_builder_source_ctx_get_stream(ctx);
 	g_autoptr(FuCabinet) cabinet = NULL;
+	g_autoptr(GInputStream) stream = NULL;
 	g_autoptr(XbSilo) silo = NULL;
-	g_autofree gchar *xml = NULL;
 
 	/* convert the CAB into metadata XML */
-	cabinet = fu_engine_build_cabinet_from_stream(self, stream, error);
+	stream = fu_input_stream_from_path(item->filename, error);
+	if (stream == NULL)
+		return FALSE;
+	cabinet = fu_engine_cabinet_new_from_stream(jcat_context,
+						    helper->archive_size_max,
+						    helper->parse_flags,
+						    stream,
+						    error);
 	if (cabinet == NULL)
-		return NULL;
+		return FALSE;
 	silo = fu_cabinet_get_silo(cabinet, error);
 	if (silo == NULL)
-		return NULL;
-	xml = xb_silo_export(silo, XB_NODE_EXPORT_FLAG_NONE, error);
-	if (xml == NULL)
-		return NULL;
-	return g_memory_input_stream_new_from_data(g_steal_pointer(&xml), -1, g_free);
+		return FALSE;
+	item->xml = xb_silo_export(silo, XB_NODE_EXPORT_FLAG_NONE, error);
+	if (item->xml == NULL) {
+		fwupd_error_convert(error);
+		return FALSE;
+	}
+
+	/* this is atomic, so a partially written file is never loaded */
+	if (item->filename_cache != NULL) {
+		g_autoptr(GError) error_local = NULL;
+		if (!g_file_set_contents(item->filename_cache, item->xml, -1, &error_local))
+			g_debug("failed to cache %s: %s", item->filename, error_local->message);
+	}
+	return TRUE;
 }
 
-static XbBuilderSource *
-fu_engine_create_metadata_builder_source(FuEngine *self, const gchar *fn, GError **error)
+static void
+fu_engine_metainfo_worker_cb(gpointer data, gpointer user_data)
 {
-	g_autoptr(GFile) file = g_file_new_for_path(fn);
-	g_autoptr(XbBuilderSource) source = xb_builder_source_new();
+	FuEngineMetainfoItem *item = (FuEngineMetainfoItem *)data;
+	FuEngineMetainfoHelper *helper = (FuEngineMetainfoHelper *)user_data;
+	g_autoptr(JcatContext) jcat_context = g_async_queue_pop(helper->jcat_contexts);
 
-	g_info("using %s as metadata source", fn);
-	xb_builder_source_add_simple_adapter(source,
-					     "application/vnd.ms-cab-compressed,"
-					     "com.microsoft.cab,"
-					     ".cab,"
-					     "application/octet-stream",
-					     fu_engine_builder_cabinet_adapter_cb,
-					     self,
-					     NULL);
-	if (!xb_builder_source_load_file(source,
-					 file,
-					 XB_BUILDER_SOURCE_FLAG_WATCH_FILE |
-					     XB_BUILDER_SOURCE_FLAG_WATCH_DIRECTORY,
-					 NULL,
-					 error)) {
-		fwupd_error_convert(error);
-		return NULL;
+	/* JcatContext is not thread-safe, so each worker borrows its own */
+	if (!fu_engine_metainfo_item_convert(helper, item, jcat_context, &item->error))
+		g_prefix_error(&item->error, "failed to convert %s: ", item->filename);
+	g_async_queue_push(helper->jcat_contexts, g_steal_pointer(&jcat_context));
+}
+
+static gboolean
+fu_engine_metainfo_convert_concurrent(FuEngine *self, GPtrArray *items, GError **error)
+{
+	GThreadPool *pool;
+	guint threads = MIN(g_get_num_processors(), items->len);
+	g_autoptr(GAsyncQueue) jcat_contexts = g_async_queue_new_full(g_object_unref);
+	FuEngineMetainfoHelper helper = {
+	    .jcat_contexts = jcat_contexts,
+	    .archive_size_max = fu_engine_config_get_archive_size_max(self->config),
+	    .parse_flags = fu_engine_get_cabinet_parse_flags(self),
+	};
+
+	/* nothing to do */
+	if (items->len == 0)
+		return TRUE;
+
+	/* convert everything, then wait for all the workers to finish */
+	for (guint i = 0; i < threads; i++)
+		g_async_queue_push(jcat_contexts, fu_engine_jcat_context_new());
+	pool = g_thread_pool_new(fu_engine_metainfo_worker_cb, &helper, threads, TRUE, error);
+	if (pool == NULL)
+		return FALSE;
+	g_debug("converting %u cabinet archives using %u threads", items->len, threads);
+	for (guint i = 0; i < items->len; i++) {
+		if (!g_thread_pool_push(pool, g_ptr_array_index(items, i), error)) {
+			g_thread_pool_free(pool, FALSE, TRUE);
+			return FALSE;
+		}
+	}
+	g_thread_pool_free(pool, FALSE, TRUE);
+
+	/* success */
+	return TRUE;
+}
+
+/* remove the cached XML for archives that have been changed or deleted */
+static void
+fu_engine_metainfo_cache_prune(const gchar *cachedir, GHashTable *filenames_cache)
+{
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GPtrArray) fns = fu_path_glob(cachedir, "*.xml", &error_local);
+
+	if (fns == NULL) {
+		g_debug("nothing to prune: %s", error_local->message);
+		return;
+	}
+	for (guint i = 0; i < fns->len; i++) {
+		const gchar *fn = g_ptr_array_index(fns, i);
+		if (g_hash_table_contains(filenames_cache, fn))
+			continue;
+		g_debug("pruning %s", fn);
+		if (g_unlink(fn) != 0)
+			g_debug("failed to delete %s", fn);
 	}
-	return g_steal_pointer(&source);
 }
 
 static gboolean
-fu_engine_create_metadata(FuEngine *self, XbBuilder *builder, FwupdRemote *remote, GError **error)
+fu_engine_create_metadata(FuEngine *self,
+			  XbBuilder *builder,
+			  FwupdRemote *remote,
+			  FuEngineLoadFlags flags,
+			  GError **error)
 {
-	g_autoptr(GPtrArray) files = NULL;
 	const gchar *path;
+	const gchar *remote_id = fwupd_remote_get_id(remote);
+	g_autofree gchar *cachedir = NULL;
+	g_autofree gchar *salt = fu_engine_metainfo_cache_salt(self);
+	g_autoptr(GHashTable) filenames_cache = g_hash_table_new(g_str_hash, g_str_equal);
+	g_autoptr(GPtrArray) files = NULL;
+	g_autoptr(GPtrArray) items =
+	    g_ptr_array_new_with_free_func((GDestroyNotify)fu_engine_metainfo_item_free);
+	g_autoptr(GPtrArray) items_missing = g_ptr_array_new();
 
 	/* find all files in directory */
 	path = fwupd_remote_get_filename_cache(remote);
@@ -4102,45 +4739,109 @@ fu_engine_create_metadata(FuEngine *self, XbBuilder *builder, FwupdRemote *remot
 			    FWUPD_ERROR,
 			    FWUPD_ERROR_NOT_SUPPORTED,
 			    "no filename cache for %s",
-			    fwupd_remote_get_id(remote));
+			    remote_id);
 		return FALSE;
 	}
 	files = fu_path_get_files(path, error);
 	if (files == NULL)
 		return FALSE;
 
-	/* add each source */
-	for (guint i = 0; i < files->len; i++) {
-		g_autoptr(XbBuilderNode) custom = NULL;
-		g_autoptr(XbBuilderSource) source = NULL;
+	/* the converted metainfo is cached, so only new or changed archives are parsed -- the
+	 * flags are only set on the engine once loaded, but also apply to any later reload */
+	if (((flags | self->load_flags) &
+	     (FU_ENGINE_LOAD_FLAG_NO_CACHE | FU_ENGINE_LOAD_FLAG_READONLY)) == 0) {
 		g_autoptr(GError) error_local = NULL;
+		cachedir = fu_path_build(FU_PATH_KIND_CACHEDIR_PKG, "metainfo", remote_id, NULL);
+		if (!fu_path_mkdir(cachedir, &error_local)) {
+			g_debug("not caching metainfo: %s", error_local->message);
+			g_clear_pointer(&cachedir, g_free);
+		}
+	}
+	for (guint i = 0; i < files->len; i++) {
 		const gchar *fn = g_ptr_array_index(files, i);
 		g_autofree gchar *fn_lowercase = g_ascii_strdown(fn, -1);
+		g_autofree gchar *basename = NULL;
+		g_autofree gchar *key = NULL;
+		g_autoptr(FuEngineMetainfoItem) item = NULL;
+		g_autoptr(GError) error_local = NULL;
 
 		/* check is cab file */
 		if (!g_str_has_suffix(fn_lowercase, ".cab")) {
 			g_info("ignoring: %s", fn);
 			continue;
 		}
+		item = g_new0(FuEngineMetainfoItem, 1);
+		item->filename = g_strdup(fn);
+		if (cachedir != NULL) {
+			key = fu_engine_metainfo_cache_key(fn, salt, &error_local);
+			if (key == NULL) {
+				g_warning("failed to create builder source: %s",
+					  error_local->message);
+				continue;
+			}
+			basename = g_strdup_printf("%s.xml", key);
+			item->filename_cache = g_build_filename(cachedir, basename, NULL);
+			g_hash_table_add(filenames_cache, item->filename_cache);
+		}
+		if (item->filename_cache == NULL ||
+		    !g_file_test(item->filename_cache, G_FILE_TEST_EXISTS))
+			g_ptr_array_add(items_missing, item);
+		g_ptr_array_add(items, g_steal_pointer(&item));
+	}
+	if (!fu_engine_metainfo_convert_concurrent(self, items_missing, error))
+		return FALSE;
+	self->metainfo_convert_cnt += items_missing->len;
+	if (cachedir != NULL)
+		fu_engine_metainfo_cache_prune(cachedir, filenames_cache);
 
-		/* build source for file */
-		source = fu_engine_create_metadata_builder_source(self, fn, &error_local);
-		if (source == NULL) {
-			g_warning("failed to create builder source: %s", error_local->message);
+	/* add each source */
+	for (guint i = 0; i < items->len; i++) {
+		FuEngineMetainfoItem *item = g_ptr_array_index(items, i);
+		g_autoptr(XbBuilderNode) custom = NULL;
+		g_autoptr(XbBuilderSource) source = xb_builder_source_new();
+		g_autoptr(GError) error_local = NULL;
+
+		/* failed to convert */
+		if (item->error != NULL) {
+			g_info("ignoring: %s", item->error->message);
 			continue;
 		}
 
+		/* build source for file, preferring the XML that was just converted */
+		g_info("using %s as metadata source", item->filename);
+		if (item->xml != NULL) {
+			if (!xb_builder_source_load_xml(source,
+							item->xml,
+							XB_BUILDER_SOURCE_FLAG_NONE,
+							&error_local)) {
+				g_warning("failed to create builder source: %s",
+					  error_local->message);
+				continue;
+			}
+		} else {
+			g_autoptr(GFile) file = g_file_new_for_path(item->filename_cache);
+			if (!xb_builder_source_load_file(source,
+							 file,
+							 XB_BUILDER_SOURCE_FLAG_NONE,
+							 NULL,
+							 &error_local)) {
+				g_warning("failed to create builder source: %s",
+					  error_local->message);
+				continue;
+			}
+		}
+
 		/* add metadata */
 		custom = xb_builder_node_new("custom");
 		xb_builder_node_insert_text(custom,
 					    "value",
-					    fn,
+					    item->filename,
 					    "key",
 					    "fwupd::FilenameCache",
 					    NULL);
 		xb_builder_node_insert_text(custom,
 					    "value",
-					    fwupd_remote_get_id(remote),
+					    remote_id,
 					    "key",
 					    "fwupd::RemoteId",
 					    NULL);
@@ -4221,13 +4922,31 @@ fu_engine_md_refresh_device(FuEngine *self, FuDevice *device)
 		fu_device_ensure_from_component(device, component);
 }
 
+static gboolean
+fu_engine_md_device_has_guid(FuDevice *device, GHashTable *guids)
+{
+	GPtrArray *device_guids;
+	fu_device_convert_instance_ids(device);
+	device_guids = fu_device_get_guids(device);
+	for (guint i = 0; i < device_guids->len; i++) {
+		const gchar *guid = g_ptr_array_index(device_guids, i);
+		if (g_hash_table_contains(guids, guid))
+			return TRUE;
+	}
+	return FALSE;
+}
+
+/* only devices providing one of @guids are refreshed, unless %NULL */
 static void
-fu_engine_md_refresh_devices(FuEngine *self)
+fu_engine_md_refresh_devices(FuEngine *self, GHashTable *guids)
 {
 	g_autoptr(GPtrArray) devices = fu_device_list_get_active(self->device_list);
 	for (guint i = 0; i < devices->len; i++) {
 		FuDevice *device = g_ptr_array_index(devices, i);
+		if (guids != NULL && !fu_engine_md_device_has_guid(device, guids))
+			continue;
 		fu_engine_md_refresh_device(self, device);
+		self->md_refresh_cnt++;
 	}
 }
 
@@ -4267,16 +4986,22 @@ fu_engine_load_metadata_store_local(FuEngine *self,
 	return TRUE;
 }
 
-static gboolean
-fu_engine_load_metadata_store(FuEngine *self, FuEngineLoadFlags flags, GError **error)
+/* for the self tests */
+FuEngineSilo *
+fu_engine_get_silo_by_id(FuEngine *self, const gchar *id)
 {
-	XbBuilderCompileFlags compile_flags = XB_BUILDER_COMPILE_FLAG_IGNORE_INVALID;
-	g_autoptr(GFile) xmlb = NULL;
-	g_autoptr(GPtrArray) remotes = NULL;
-	g_autoptr(XbBuilder) builder = xb_builder_new();
+	for (guint i = 0; i < self->silos->len; i++) {
+		FuEngineSilo *engine_silo = g_ptr_array_index(self->silos, i);
+		if (g_strcmp0(fu_engine_silo_get_id(engine_silo), id) == 0)
+			return engine_silo;
+	}
+	return NULL;
+}
 
-	/* clear existing silo */
-	g_clear_object(&self->silo);
+static XbBuilder *
+fu_engine_metadata_builder_new(void)
+{
+	XbBuilder *builder = xb_builder_new();
 
 #ifdef SOURCE_VERSION
 	/* invalidate the cache if the fwupd version changes */
@@ -4289,16 +5014,196 @@ fu_engine_load_metadata_store(FuEngine *self, FuEngineLoadFlags flags, GError **
 					     XB_SILO_PROFILE_FLAG_XPATH |
 						 XB_SILO_PROFILE_FLAG_DEBUG);
 	}
+	return builder;
+}
+
+/* compiles one silo, reusing the existing indexes if the sources have not changed */
+static FuEngineSilo *
+fu_engine_load_metadata_silo(FuEngine *self,
+			     XbBuilder *builder,
+			     const gchar *id,
+			     const gchar *checksum,
+			     FuEngineLoadFlags flags,
+			     GError **error)
+{
+	FuEngineSilo *engine_silo_old = fu_engine_get_silo_by_id(self, id);
+	XbBuilderCompileFlags compile_flags = XB_BUILDER_COMPILE_FLAG_IGNORE_INVALID;
+	g_autofree gchar *basename = g_strdup_printf("metadata-%s.xmlb", id);
+	g_autoptr(FuEngineSilo) engine_silo = NULL;
+	g_autoptr(GFile) xmlb = NULL;
+	g_autoptr(XbSilo) silo = NULL;
+
+	/* the source filename and mtime are not enough */
+	if (checksum != NULL)
+		xb_builder_append_guid(builder, checksum);
+
+	/* on a read-only filesystem don't care about the cache GUID */
+	if (flags & FU_ENGINE_LOAD_FLAG_READONLY)
+		compile_flags |= XB_BUILDER_COMPILE_FLAG_IGNORE_GUID;
+
+	/* ensure silo is up to date */
+	if (flags & FU_ENGINE_LOAD_FLAG_NO_CACHE) {
+		g_autoptr(GFileIOStream) iostr = NULL;
+		xmlb = g_file_new_tmp(NULL, &iostr, error);
+		if (xmlb == NULL)
+			return NULL;
+	} else {
+		g_autofree gchar *xmlbfn = fu_path_build(FU_PATH_KIND_CACHEDIR_PKG, basename, NULL);
+		xmlb = g_file_new_for_path(xmlbfn);
+	}
+	silo = xb_builder_ensure(builder, xmlb, compile_flags, NULL, error);
+	if (silo == NULL) {
+		g_prefix_error(error, "cannot create %s: ", basename);
+		return NULL;
+	}
+
+	/* nothing changed */
+	if (engine_silo_old != NULL &&
+	    g_strcmp0(xb_silo_get_guid(fu_engine_silo_get_silo(engine_silo_old)),
+		      xb_silo_get_guid(silo)) == 0)
+		return g_object_ref(engine_silo_old);
+
+	/* build the indexes and prepared queries */
+	engine_silo = fu_engine_silo_new(id, silo, error);
+	if (engine_silo == NULL)
+		return NULL;
+	fu_engine_silo_set_checksum(engine_silo, checksum);
+	return g_steal_pointer(&engine_silo);
+}
+
+static FuEngineSilo *
+fu_engine_load_metadata_remote(FuEngine *self,
+			       FwupdRemote *remote,
+			       FuEngineLoadFlags flags,
+			       GError **error)
+{
+	FuEngineSilo *engine_silo_old;
+	const gchar *path = fwupd_remote_get_filename_cache(remote);
+	const gchar *remote_id = fwupd_remote_get_id(remote);
+	g_autofree gchar *checksum = NULL;
+	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(GFile) file = NULL;
+	g_autoptr(XbBuilder) builder = fu_engine_metadata_builder_new();
+	g_autoptr(XbBuilderFixup) fixup = NULL;
+	g_autoptr(XbBuilderNode) custom = NULL;
+	g_autoptr(XbBuilderSource) source = xb_builder_source_new();
+
+	/* generate all metadata on demand */
+	if (fwupd_remote_get_kind(remote) == FWUPD_REMOTE_KIND_DIRECTORY) {
+		g_info("loading metadata for remote '%s'", remote_id);
+		if (!fu_engine_create_metadata(self, builder, remote, flags, error)) {
+			g_prefix_error(error, "failed to generate remote %s: ", remote_id);
+			return NULL;
+		}
+		return fu_engine_load_metadata_silo(self, builder, remote_id, NULL, flags, error);
+	}
+
+	/* the metadata has not changed since it was last loaded */
+	blob = fu_bytes_get_contents(path, error);
+	if (blob == NULL)
+		return NULL;
+	checksum = g_compute_checksum_for_bytes(G_CHECKSUM_SHA256, blob);
+	engine_silo_old = fu_engine_get_silo_by_id(self, remote_id);
+	if (engine_silo_old != NULL &&
+	    g_strcmp0(fu_engine_silo_get_checksum(engine_silo_old), checksum) == 0)
+		return g_object_ref(engine_silo_old);
+
+	/* save the remote-id in the custom metadata space */
+	file = g_file_new_for_path(path);
+	if (!xb_builder_source_load_file(source, file, XB_BUILDER_SOURCE_FLAG_NONE, NULL, error)) {
+		fwupd_error_convert(error);
+		return NULL;
+	}
+
+	/* fix up any legacy installed files */
+	fixup = xb_builder_fixup_new("AppStreamUpgrade",
+				     fu_engine_appstream_upgrade_cb,
+				     self,
+				     NULL);
+	xb_builder_fixup_set_max_depth(fixup, 3);
+	xb_builder_source_add_fixup(source, fixup);
+
+	/* add metadata */
+	custom = xb_builder_node_new("custom");
+	xb_builder_node_insert_text(custom, "value", path, "key", "fwupd::FilenameCache", NULL);
+	xb_builder_node_insert_text(custom, "value", remote_id, "key", "fwupd::RemoteId", NULL);
+	xb_builder_source_set_info(source, custom);
+	xb_builder_import_source(builder, source);
+	return fu_engine_load_metadata_silo(self, builder, remote_id, checksum, flags, error);
+}
+
+static void
+fu_engine_add_silo_guids(FuEngineSilo *engine_silo, GHashTable *guids)
+{
+	GPtrArray *guids_silo = fu_engine_silo_get_guids(engine_silo);
+	for (guint i = 0; i < guids_silo->len; i++)
+		g_hash_table_add(guids, g_strdup(g_ptr_array_index(guids_silo, i)));
+}
+
+/* adds the GUIDs of every silo that was added, removed or rebuilt */
+static void
+fu_engine_silos_diff(GPtrArray *silos_old, GPtrArray *silos_new, GHashTable *guids)
+{
+	for (guint i = 0; i < silos_new->len; i++) {
+		FuEngineSilo *engine_silo = g_ptr_array_index(silos_new, i);
+		if (g_ptr_array_find(silos_old, engine_silo, NULL))
+			continue;
+		fu_engine_add_silo_guids(engine_silo, guids);
+	}
+	for (guint i = 0; i < silos_old->len; i++) {
+		FuEngineSilo *engine_silo = g_ptr_array_index(silos_old, i);
+		if (g_ptr_array_find(silos_new, engine_silo, NULL))
+			continue;
+		fu_engine_add_silo_guids(engine_silo, guids);
+	}
+}
+
+/* remove the silos of remotes that no longer exist or are disabled, and the legacy silo */
+static void
+fu_engine_load_metadata_store_prune(FuEngine *self)
+{
+	g_autofree gchar *cachedir = fu_path_from_kind(FU_PATH_KIND_CACHEDIR_PKG);
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GPtrArray) fns = fu_path_glob(cachedir, "metadata*.xmlb", &error_local);
+
+	if (fns == NULL) {
+		g_debug("nothing to prune: %s", error_local->message);
+		return;
+	}
+	for (guint i = 0; i < fns->len; i++) {
+		const gchar *fn = g_ptr_array_index(fns, i);
+		g_autofree gchar *basename = g_path_get_basename(fn);
+
+		if (g_str_has_prefix(basename, "metadata-")) {
+			g_autofree gchar *id = g_strndup(basename + strlen("metadata-"),
+							 strlen(basename) - strlen("metadata-") -
+							     strlen(".xmlb"));
+			if (fu_engine_get_silo_by_id(self, id) != NULL)
+				continue;
+		}
+		g_debug("pruning %s", fn);
+		if (g_unlink(fn) != 0)
+			g_debug("failed to delete %s", fn);
+	}
+}
 
-	/* load each enabled metadata file */
+static gboolean
+fu_engine_load_metadata_store(FuEngine *self,
+			      FuEngineLoadFlags flags,
+			      GHashTable *guids_changed,
+			      GError **error)
+{
+	g_autoptr(FuEngineSilo) engine_silo_local = NULL;
+	g_autoptr(GPtrArray) remotes = NULL;
+	g_autoptr(GPtrArray) silos = g_ptr_array_new_with_free_func(g_object_unref);
+	g_autoptr(XbBuilder) builder = fu_engine_metadata_builder_new();
+
+	/* load each enabled metadata file into its own silo */
 	remotes = fu_remote_list_get_all(self->remote_list);
 	for (guint i = 0; i < remotes->len; i++) {
 		const gchar *path = NULL;
+		g_autoptr(FuEngineSilo) engine_silo = NULL;
 		g_autoptr(GError) error_local = NULL;
-		g_autoptr(GFile) file = NULL;
-		g_autoptr(XbBuilderFixup) fixup = NULL;
-		g_autoptr(XbBuilderNode) custom = NULL;
-		g_autoptr(XbBuilderSource) source = xb_builder_source_new();
 
 		FwupdRemote *remote = g_ptr_array_index(remotes, i);
 		if (!fwupd_remote_has_flag(remote, FWUPD_REMOTE_FLAG_ENABLED))
@@ -4306,57 +5211,14 @@ fu_engine_load_metadata_store(FuEngine *self, FuEngineLoadFlags flags, GError **
 		path = fwupd_remote_get_filename_cache(remote);
 		if (!g_file_test(path, G_FILE_TEST_EXISTS))
 			continue;
-
-		/* generate all metadata on demand */
-		if (fwupd_remote_get_kind(remote) == FWUPD_REMOTE_KIND_DIRECTORY) {
-			g_info("loading metadata for remote '%s'", fwupd_remote_get_id(remote));
-			if (!fu_engine_create_metadata(self, builder, remote, &error_local)) {
-				g_warning("failed to generate remote %s: %s",
-					  fwupd_remote_get_id(remote),
-					  error_local->message);
-			}
-			continue;
-		}
-
-		/* save the remote-id in the custom metadata space */
-		file = g_file_new_for_path(path);
-		if (!xb_builder_source_load_file(source,
-						 file,
-						 XB_BUILDER_SOURCE_FLAG_NONE,
-						 NULL,
-						 &error_local)) {
+		engine_silo = fu_engine_load_metadata_remote(self, remote, flags, &error_local);
+		if (engine_silo == NULL) {
 			g_warning("failed to load remote %s: %s",
 				  fwupd_remote_get_id(remote),
 				  error_local->message);
 			continue;
 		}
-
-		/* fix up any legacy installed files */
-		fixup = xb_builder_fixup_new("AppStreamUpgrade",
-					     fu_engine_appstream_upgrade_cb,
-					     self,
-					     NULL);
-		xb_builder_fixup_set_max_depth(fixup, 3);
-		xb_builder_source_add_fixup(source, fixup);
-
-		/* add metadata */
-		custom = xb_builder_node_new("custom");
-		xb_builder_node_insert_text(custom,
-					    "value",
-					    path,
-					    "key",
-					    "fwupd::FilenameCache",
-					    NULL);
-		xb_builder_node_insert_text(custom,
-					    "value",
-					    fwupd_remote_get_id(remote),
-					    "key",
-					    "fwupd::RemoteId",
-					    NULL);
-		xb_builder_source_set_info(source, custom);
-
-		/* we need to watch for changes? */
-		xb_builder_import_source(builder, source);
+		g_ptr_array_add(silos, g_steal_pointer(&engine_silo));
 	}
 
 	/* add any client-side data, e.g. BKC tags */
@@ -4367,30 +5229,23 @@ fu_engine_load_metadata_store(FuEngine *self, FuEngineLoadFlags flags, GError **
 		return FALSE;
 	if (!fu_engine_load_metadata_store_local(self, builder, FU_PATH_KIND_DATADIR_PKG, error))
 		return FALSE;
-
-	/* on a read-only filesystem don't care about the cache GUID */
-	if (flags & FU_ENGINE_LOAD_FLAG_READONLY)
-		compile_flags |= XB_BUILDER_COMPILE_FLAG_IGNORE_GUID;
-
-	/* ensure silo is up to date */
-	if (flags & FU_ENGINE_LOAD_FLAG_NO_CACHE) {
-		g_autoptr(GFileIOStream) iostr = NULL;
-		xmlb = g_file_new_tmp(NULL, &iostr, error);
-		if (xmlb == NULL)
-			return FALSE;
-	} else {
-		g_autofree gchar *xmlbfn =
-		    fu_path_build(FU_PATH_KIND_CACHEDIR_PKG, "metadata.xmlb", NULL);
-		xmlb = g_file_new_for_path(xmlbfn);
-	}
-	self->silo = xb_builder_ensure(builder, xmlb, compile_flags, NULL, error);
-	if (self->silo == NULL) {
-		g_prefix_error_literal(error, "cannot create metadata.xmlb: ");
+	engine_silo_local =
+	    fu_engine_load_metadata_silo(self, builder, "local", NULL, flags, error);
+	if (engine_silo_local == NULL)
 		return FALSE;
-	}
+	g_ptr_array_add(silos, g_steal_pointer(&engine_silo_local));
+
+	/* so the caller only has to refresh the affected devices */
+	if (guids_changed != NULL)
+		fu_engine_silos_diff(self->silos, silos, guids_changed);
 
 	/* success */
-	return fu_engine_create_silo_index(self, error);
+	g_ptr_array_unref(self->silos);
+	self->silos = g_steal_pointer(&silos);
+	fu_engine_releases_cache_invalidate(self);
+	if ((flags & (FU_ENGINE_LOAD_FLAG_NO_CACHE | FU_ENGINE_LOAD_FLAG_READONLY)) == 0)
+		fu_engine_load_metadata_store_prune(self);
+	return TRUE;
 }
 
 static void
@@ -4416,6 +5271,9 @@ fu_engine_config_changed_cb(FuEngineConfig *config, FuEngine *self)
 
 	fu_idle_set_timeout(self->idle, fu_engine_config_get_idle_timeout(config));
 
+	/* approved firmware, release priority and trusted reports may have changed */
+	fu_engine_releases_cache_invalidate(self);
+
 	/* allow changing the hardcoded ESP location */
 	if (fu_engine_config_get_esp_location(config) != NULL)
 		fu_context_set_esp_location(self->ctx, fu_engine_config_get_esp_location(config));
@@ -4431,11 +5289,11 @@ static void
 fu_engine_metadata_changed(FuEngine *self)
 {
 	g_autoptr(GError) error_local = NULL;
-	if (!fu_engine_load_metadata_store(self, FU_ENGINE_LOAD_FLAG_NONE, &error_local))
+	if (!fu_engine_load_metadata_store(self, FU_ENGINE_LOAD_FLAG_NONE, NULL, &error_local))
 		g_warning("Failed to reload metadata store: %s", error_local->message);
 
-	/* set device properties from the metadata */
-	fu_engine_md_refresh_devices(self);
+	/* set device properties from the metadata, the remote config may have changed too */
+	fu_engine_md_refresh_devices(self, NULL);
 
 	/* invalidate host security attributes */
 	fu_security_attrs_remove_all(self->host_security_attrs);
@@ -4594,6 +5452,30 @@ fu_engine_validate_result_timestamp(JcatResult *jcat_result,
 	return TRUE;
 }
 
+/* only the silos of remotes with different metadata are rebuilt, also used by the self tests */
+gboolean
+fu_engine_update_metadata_store(FuEngine *self, GError **error)
+{
+	g_autoptr(GHashTable) guids_changed =
+	    g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+
+	g_return_val_if_fail(FU_IS_ENGINE(self), FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	if (!fu_engine_load_metadata_store(self, FU_ENGINE_LOAD_FLAG_NONE, guids_changed, error))
+		return FALSE;
+
+	/* refresh SUPPORTED flag on devices provided by the changed remote */
+	fu_engine_md_refresh_devices(self, guids_changed);
+
+	/* invalidate host security attributes */
+	fu_security_attrs_remove_all(self->host_security_attrs);
+
+	/* make the UI update */
+	fu_engine_emit_changed(self);
+	return TRUE;
+}
+
 /**
  * fu_engine_update_metadata_bytes:
  * @self: a #FuEngine
@@ -4727,18 +5609,7 @@ fu_engine_update_metadata_bytes(FuEngine *self,
 	/* save signature to remotes.d */
 	if (!fu_bytes_set_contents(fwupd_remote_get_filename_cache_sig(remote), bytes_sig, error))
 		return FALSE;
-	if (!fu_engine_load_metadata_store(self, FU_ENGINE_LOAD_FLAG_NONE, error))
-		return FALSE;
-
-	/* refresh SUPPORTED flag on devices */
-	fu_engine_md_refresh_devices(self);
-
-	/* invalidate host security attributes */
-	fu_security_attrs_remove_all(self->host_security_attrs);
-
-	/* make the UI update */
-	fu_engine_emit_changed(self);
-	return TRUE;
+	return fu_engine_update_metadata_store(self, error);
 }
 
 /**
@@ -4814,25 +5685,18 @@ fu_engine_update_metadata(FuEngine *self,
 FuCabinet *
 fu_engine_build_cabinet_from_stream(FuEngine *self, GInputStream *stream, GError **error)
 {
-	g_autoptr(FuCabinet) cabinet = fu_cabinet_new();
-	FuFirmwareParseFlags flags = FU_FIRMWARE_PARSE_FLAG_CACHE_STREAM;
-
 	g_return_val_if_fail(FU_IS_ENGINE(self), NULL);
 	g_return_val_if_fail(G_IS_INPUT_STREAM(stream), NULL);
 	g_return_val_if_fail(error == NULL || *error == NULL, NULL);
 
-	/* distrusting RSA? */
-	if (fu_engine_config_get_only_trust_pq_signatures(self->config))
-		flags |= FU_FIRMWARE_PARSE_FLAG_ONLY_TRUST_PQ_SIGNATURES;
-
 	/* load file */
 	fu_engine_set_status(self, FWUPD_STATUS_DECOMPRESSING);
-	fu_firmware_set_size_max(FU_FIRMWARE(cabinet),
-				 fu_engine_config_get_archive_size_max(self->config));
-	fu_cabinet_set_jcat_context(cabinet, self->jcat_context);
-	if (!fu_firmware_parse_stream(FU_FIRMWARE(cabinet), stream, 0x0, flags, error))
-		return NULL;
-	return g_steal_pointer(&cabinet);
+	return fu_engine_cabinet_new_from_stream(
+	    self->jcat_context,
+	    fu_engine_config_get_archive_size_max(self->config),
+	    fu_engine_get_cabinet_parse_flags(self),
+	    stream,
+	    error);
 }
 
 static FuDevice *
@@ -4972,10 +5836,10 @@ fu_engine_get_details(FuEngine *self,
 		      GInputStream *stream,
 		      GError **error)
 {
-	GChecksumType checksum_types[] = {G_CHECKSUM_SHA256, G_CHECKSUM_SHA1, 0};
+	GChecksumType checksum_types[] = {G_CHECKSUM_SHA256, G_CHECKSUM_SHA1};
+	g_auto(GStrv) checksums = NULL;
 	g_autoptr(GPtrArray) components = NULL;
 	g_autoptr(GPtrArray) details = NULL;
-	g_autoptr(GPtrArray) checksums = g_ptr_array_new_with_free_func(g_free);
 	g_autoptr(FuCabinet) cabinet = NULL;
 	g_autoptr(GPtrArray) rels_by_csum = NULL;
 
@@ -4993,18 +5857,16 @@ fu_engine_get_details(FuEngine *self,
 		return NULL;
 
 	/* calculate the checksums of the blob */
-	for (guint i = 0; checksum_types[i] != 0; i++) {
-		g_autofree gchar *checksum =
-		    fu_input_stream_compute_checksum(stream, checksum_types[i], error);
-		if (checksum == NULL)
-			return NULL;
-		g_ptr_array_add(checksums, g_steal_pointer(&checksum));
-	}
+	checksums = fu_input_stream_compute_checksums(stream,
+						      checksum_types,
+						      G_N_ELEMENTS(checksum_types),
+						      error);
+	if (checksums == NULL)
+		return NULL;
 
 	/* does this exist in any enabled remote */
-	for (guint i = 0; i < checksums->len; i++) {
-		const gchar *csum = g_ptr_array_index(checksums, i);
-		rels_by_csum = fu_engine_get_releases_for_container_checksum(self, csum);
+	for (guint i = 0; checksums[i] != NULL; i++) {
+		rels_by_csum = fu_engine_get_releases_for_container_checksum(self, checksums[i]);
 		if (rels_by_csum != NULL)
 			break;
 	}
@@ -5033,10 +5895,8 @@ fu_engine_get_details(FuEngine *self,
 		}
 
 		/* add the checksum of the container blob */
-		for (guint j = 0; j < checksums->len; j++) {
-			const gchar *csum = g_ptr_array_index(checksums, j);
-			fu_release_add_checksum(rel, csum);
-		}
+		for (guint j = 0; checksums[j] != NULL; j++)
+			fu_release_add_checksum(rel, checksums[j]);
 		g_ptr_array_add(details, dev);
 	}
 
@@ -5624,18 +6484,99 @@ fu_engine_get_branch_fallback(const gchar *nullable_branch)
 	return nullable_branch;
 }
 
+static GPtrArray *
+fu_engine_get_releases_for_device_guids(FuEngine *self, FuEngineRequest *request, FuDevice *device)
+{
+	GPtrArray *device_guids = fu_device_get_guids(device);
+	g_autoptr(GPtrArray) releases =
+	    g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
+
+	/* get all the components that provide any of these GUIDs */
+	for (guint j = 0; j < device_guids->len; j++) {
+		const gchar *guid = g_ptr_array_index(device_guids, j);
+		g_autoptr(GError) error_local = NULL;
+		g_autoptr(GPtrArray) components = NULL;
+		g_auto(XbQueryContext) context = XB_QUERY_CONTEXT_INIT();
+
+		xb_query_context_set_flags(&context, XB_QUERY_FLAG_USE_INDEXES);
+		xb_value_bindings_bind_str(xb_query_context_get_bindings(&context), 0, guid, NULL);
+		components = fu_engine_query_silos(self,
+						   fu_engine_silo_get_query_component_by_guid,
+						   &context,
+						   &error_local);
+		if (components == NULL) {
+			g_debug("%s was not found: %s", guid, error_local->message);
+			continue;
+		}
+
+		/* find all the releases that pass all the requirements */
+		g_debug("%s matched %u components", guid, components->len);
+		for (guint i = 0; i < components->len; i++) {
+			XbNode *component = XB_NODE(g_ptr_array_index(components, i));
+			g_autoptr(GError) error_tmp = NULL;
+			if (!fu_engine_add_releases_for_device_component(self,
+									 request,
+									 device,
+									 component,
+									 releases,
+									 &error_tmp)) {
+				g_debug("%s", error_tmp->message);
+				continue;
+			}
+		}
+		g_debug("%s matched %u releases", guid, releases->len);
+
+		/* if we're only checking for SUPPORTED then *any* release is good enough */
+		if (fu_engine_request_has_flag(request, FU_ENGINE_REQUEST_FLAG_ANY_RELEASE) &&
+		    releases->len > 0)
+			break;
+	}
+
+	/* success */
+	return g_steal_pointer(&releases);
+}
+
+/* everything the resolved releases depend on, other than the silos and the engine config */
+static gchar *
+fu_engine_releases_cache_key(FuEngineRequest *request, FuDevice *device)
+{
+	GPtrArray *guids = fu_device_get_guids(device);
+	const gchar *strs[] = {
+	    fu_device_get_id(device),
+	    fu_device_get_version(device),
+	    fu_device_get_version_lowest(device),
+	    fu_device_get_branch(device),
+	    fu_engine_request_get_locale(request),
+	};
+	GString *str = g_string_new(NULL);
+
+	for (guint i = 0; i < G_N_ELEMENTS(strs); i++)
+		g_string_append_printf(str, "%s:", strs[i] != NULL ? strs[i] : "");
+	for (guint i = 0; i < guids->len; i++)
+		g_string_append_printf(str, "%s,", (const gchar *)g_ptr_array_index(guids, i));
+	g_string_append_printf(str,
+			       ":%" G_GINT64_MODIFIER "x:%" G_GINT64_MODIFIER
+			       "x:%" G_GINT64_MODIFIER "x",
+			       (guint64)fu_device_get_flags(device),
+			       (guint64)fu_engine_request_get_feature_flags(request),
+			       (guint64)fu_engine_request_get_flags(request));
+	return g_string_free(str, FALSE);
+}
+
 GPtrArray *
 fu_engine_get_releases_for_device(FuEngine *self,
 				  FuEngineRequest *request,
 				  FuDevice *device,
 				  GError **error)
 {
-	GPtrArray *device_guids;
+	GPtrArray *releases_cached;
+	gint generation;
+	g_autofree gchar *cache_key = NULL;
 	g_autoptr(GPtrArray) branches = NULL;
 	g_autoptr(GPtrArray) releases = NULL;
 
 	/* no components in silo */
-	if (self->query_component_by_guid == NULL) {
+	if (!fu_engine_has_components(self)) {
 		g_set_error_literal(error,
 				    FWUPD_ERROR,
 				    FWUPD_ERROR_NOT_SUPPORTED,
@@ -5676,47 +6617,20 @@ fu_engine_get_releases_for_device(FuEngine *self,
 		return NULL;
 	}
 
-	/* get all the components that provide any of these GUIDs */
-	device_guids = fu_device_get_guids(device);
-	releases = g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
-	for (guint j = 0; j < device_guids->len; j++) {
-		const gchar *guid = g_ptr_array_index(device_guids, j);
-		g_autoptr(GError) error_local = NULL;
-		g_autoptr(GPtrArray) components = NULL;
-		g_auto(XbQueryContext) context = XB_QUERY_CONTEXT_INIT();
-
-		xb_query_context_set_flags(&context, XB_QUERY_FLAG_USE_INDEXES);
-		xb_value_bindings_bind_str(xb_query_context_get_bindings(&context), 0, guid, NULL);
-		components = xb_silo_query_with_context(self->silo,
-							self->query_component_by_guid,
-							&context,
-							&error_local);
-		if (components == NULL) {
-			g_debug("%s was not found: %s", guid, error_local->message);
-			continue;
-		}
-
-		/* find all the releases that pass all the requirements */
-		g_debug("%s matched %u components", guid, components->len);
-		for (guint i = 0; i < components->len; i++) {
-			XbNode *component = XB_NODE(g_ptr_array_index(components, i));
-			g_autoptr(GError) error_tmp = NULL;
-			if (!fu_engine_add_releases_for_device_component(self,
-									 request,
-									 device,
-									 component,
-									 releases,
-									 &error_tmp)) {
-				g_debug("%s", error_tmp->message);
-				continue;
-			}
-		}
-		g_debug("%s matched %u releases", guid, releases->len);
-
-		/* if we're only checking for SUPPORTED then *any* release is good enough */
-		if (fu_engine_request_has_flag(request, FU_ENGINE_REQUEST_FLAG_ANY_RELEASE) &&
-		    releases->len > 0)
-			break;
+	/* use the releases resolved for the same device state and request, as long as no
+	 * device has changed since -- requirements can also depend on other devices */
+	generation = g_atomic_int_get(&self->device_generation);
+	if (generation != self->releases_cache_generation) {
+		g_hash_table_remove_all(self->releases_cache);
+		self->releases_cache_generation = generation;
+	}
+	cache_key = fu_engine_releases_cache_key(request, device);
+	releases_cached = g_hash_table_lookup(self->releases_cache, cache_key);
+	if (releases_cached != NULL) {
+		self->releases_cache_hits++;
+		releases = g_ptr_array_copy(releases_cached, (GCopyFunc)g_object_ref, NULL);
+	} else {
+		releases = fu_engine_get_releases_for_device_guids(self, request, device);
 	}
 
 	/* are there multiple branches available */
@@ -5734,6 +6648,13 @@ fu_engine_get_releases_for_device(FuEngine *self,
 	if (branches->len > 1)
 		fu_device_add_flag(device, FWUPD_DEVICE_FLAG_HAS_MULTIPLE_BRANCHES);
 
+	/* the device flags may have been changed above, so use the new state */
+	if (releases_cached == NULL) {
+		g_hash_table_insert(self->releases_cache,
+				    fu_engine_releases_cache_key(request, device),
+				    g_ptr_array_copy(releases, (GCopyFunc)g_object_ref, NULL));
+	}
+
 	/* return the compound error */
 	if (releases->len == 0) {
 		g_set_error_literal(error,
@@ -5742,7 +6663,51 @@ fu_engine_get_releases_for_device(FuEngine *self,
 				    "No releases found");
 		return NULL;
 	}
-	return g_steal_pointer(&releases);
+	return g_steal_pointer(&releases);
+}
+
+static gboolean
+fu_engine_search_silo(FuEngine *self,
+		      FuEngineSilo *engine_silo,
+		      XbQueryContext *context,
+		      GPtrArray *releases,
+		      GError **error)
+{
+	GPtrArray *search_queries = fu_engine_silo_get_search_queries(engine_silo);
+
+	for (guint i = 0; i < search_queries->len; i++) {
+		XbQuery *query_tmp = g_ptr_array_index(search_queries, i);
+		g_autoptr(GError) error_local = NULL;
+		g_autoptr(GPtrArray) components = NULL;
+
+		components = xb_silo_query_with_context(fu_engine_silo_get_silo(engine_silo),
+							query_tmp,
+							context,
+							&error_local);
+		if (components == NULL) {
+			if (g_error_matches(error_local, G_IO_ERROR, G_IO_ERROR_NOT_FOUND) ||
+			    g_error_matches(error_local, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT))
+				continue;
+			g_propagate_error(error, g_steal_pointer(&error_local));
+			fwupd_error_convert(error);
+			return FALSE;
+		}
+		for (guint j = 0; j < components->len; j++) {
+			g_autoptr(FuRelease) rel = fu_release_new();
+			XbNode *component = g_ptr_array_index(components, j);
+			if (!fu_release_load(rel,
+					     NULL,
+					     component,
+					     NULL,
+					     FWUPD_INSTALL_FLAG_FORCE,
+					     error))
+				return FALSE;
+			g_ptr_array_add(releases, g_steal_pointer(&rel));
+		}
+	}
+
+	/* success */
+	return TRUE;
 }
 
 /**
@@ -5768,33 +6733,10 @@ fu_engine_search(FuEngine *self, const gchar *token, GError **error)
 
 	/* bind search token and then query */
 	xb_value_bindings_bind_str(xb_query_context_get_bindings(&context), 0, token, NULL);
-	for (guint i = 0; i < self->search_queries->len; i++) {
-		XbQuery *query_tmp = g_ptr_array_index(self->search_queries, i);
-		g_autoptr(GError) error_local = NULL;
-		g_autoptr(GPtrArray) components = NULL;
-
-		components =
-		    xb_silo_query_with_context(self->silo, query_tmp, &context, &error_local);
-		if (components == NULL) {
-			if (g_error_matches(error_local, G_IO_ERROR, G_IO_ERROR_NOT_FOUND) ||
-			    g_error_matches(error_local, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT))
-				continue;
-			g_propagate_error(error, g_steal_pointer(&error_local));
-			fwupd_error_convert(error);
+	for (guint i = 0; i < self->silos->len; i++) {
+		FuEngineSilo *engine_silo = g_ptr_array_index(self->silos, i);
+		if (!fu_engine_search_silo(self, engine_silo, &context, releases, error))
 			return NULL;
-		}
-		for (guint j = 0; j < components->len; j++) {
-			g_autoptr(FuRelease) rel = fu_release_new();
-			XbNode *component = g_ptr_array_index(components, j);
-			if (!fu_release_load(rel,
-					     NULL,
-					     component,
-					     NULL,
-					     FWUPD_INSTALL_FLAG_FORCE,
-					     error))
-				return NULL;
-			g_ptr_array_add(releases, g_steal_pointer(&rel));
-		}
 	}
 
 	/* success */
@@ -6010,6 +6952,7 @@ fu_engine_add_approved_firmware(FuEngine *self, const gchar *checksum)
 		    g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
 	}
 	g_hash_table_add(self->approved_firmware, g_strdup(checksum));
+	fu_engine_releases_cache_invalidate(self);
 }
 
 GPtrArray *
@@ -6040,6 +6983,7 @@ gboolean
 fu_engine_set_blocked_firmware(FuEngine *self, GPtrArray *checksums, GError **error)
 {
 	/* update in-memory hash */
+	fu_engine_releases_cache_invalidate(self);
 	if (self->blocked_firmware != NULL) {
 		g_hash_table_unref(self->blocked_firmware);
 		self->blocked_firmware = NULL;
@@ -6220,6 +7164,70 @@ fu_engine_get_upgrades(FuEngine *self,
 	return g_steal_pointer(&releases);
 }
 
+/**
+ * fu_engine_get_upgrades_all:
+ * @self: a #FuEngine
+ * @request: a #FuEngineRequest
+ * @include: #FwupdReleaseFlags that must be set, or %FWUPD_RELEASE_FLAG_NONE
+ * @exclude: #FwupdReleaseFlags that must not be set, or %FWUPD_RELEASE_FLAG_NONE
+ *
+ * Gets the upgrades available for all supported devices. Devices without any upgrade that
+ * matches the flags are not included.
+ *
+ * Returns: (transfer container) (element-type utf8 GPtrArray): device ID to releases
+ **/
+GHashTable *
+fu_engine_get_upgrades_all(FuEngine *self,
+			   FuEngineRequest *request,
+			   FwupdReleaseFlags include,
+			   FwupdReleaseFlags exclude)
+{
+	g_autoptr(GHashTable) upgrades = NULL;
+	g_autoptr(GPtrArray) devices = NULL;
+
+	g_return_val_if_fail(FU_IS_ENGINE(self), NULL);
+	g_return_val_if_fail(FU_IS_ENGINE_REQUEST(request), NULL);
+
+	upgrades = g_hash_table_new_full(g_str_hash,
+					 g_str_equal,
+					 g_free,
+					 (GDestroyNotify)g_ptr_array_unref);
+	devices = fu_device_list_get_active(self->device_list);
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *device = g_ptr_array_index(devices, i);
+		g_autoptr(GError) error_local = NULL;
+		g_autoptr(GPtrArray) releases = NULL;
+		g_autoptr(GPtrArray) releases_filtered = NULL;
+
+		/* not going to have results */
+		if (!fu_device_has_flag(device, FWUPD_DEVICE_FLAG_SUPPORTED))
+			continue;
+		releases =
+		    fu_engine_get_upgrades(self, request, fu_device_get_id(device), &error_local);
+		if (releases == NULL) {
+			g_debug("no upgrades for %s: %s",
+				fu_device_get_id(device),
+				error_local->message);
+			continue;
+		}
+		releases_filtered = g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
+		for (guint j = 0; j < releases->len; j++) {
+			FwupdRelease *rel = g_ptr_array_index(releases, j);
+			if (!fwupd_release_match_flags(rel, include, exclude))
+				continue;
+			g_ptr_array_add(releases_filtered, g_object_ref(rel));
+		}
+		if (releases_filtered->len == 0)
+			continue;
+		g_hash_table_insert(upgrades,
+				    g_strdup(fu_device_get_id(device)),
+				    g_steal_pointer(&releases_filtered));
+	}
+
+	/* success */
+	return g_steal_pointer(&upgrades);
+}
+
 /**
  * fu_engine_clear_results:
  * @self: a #FuEngine
@@ -6420,10 +7428,61 @@ fu_engine_plugin_device_register(FuEngine *self, FuDevice *device)
 	fu_device_add_private_flag(device, FU_DEVICE_PRIVATE_FLAG_REGISTERED);
 }
 
+typedef enum {
+	FU_ENGINE_COLDPLUG_EVENT_KIND_REGISTER,
+	FU_ENGINE_COLDPLUG_EVENT_KIND_ADDED,
+	FU_ENGINE_COLDPLUG_EVENT_KIND_REMOVED,
+} FuEngineColdplugEventKind;
+
+typedef struct {
+	FuEngineColdplugEventKind kind;
+	FuPlugin *plugin;
+	FuDevice *device;
+} FuEngineColdplugEvent;
+
+typedef struct {
+	FuDevice *device;
+	guint idx;    /* in the backend order */
+	gchar *group; /* from fu_engine_coldplug_device_get_group() */
+	gboolean probed;
+	gboolean needs_main_thread;
+	GPtrArray *events; /* (element-type FuEngineColdplugEvent) */
+} FuEngineColdplugItem;
+
+/* set for the worker threads used by the concurrent coldplug */
+static GPrivate fu_engine_coldplug_item_key = G_PRIVATE_INIT(NULL);
+
+static void
+fu_engine_coldplug_event_free(FuEngineColdplugEvent *event)
+{
+	g_object_unref(event->plugin);
+	g_object_unref(event->device);
+	g_free(event);
+}
+
+/* returns TRUE if the plugin signal was emitted from a coldplug worker thread and was deferred */
+static gboolean
+fu_engine_coldplug_event_defer(FuEngineColdplugEventKind kind, FuPlugin *plugin, FuDevice *device)
+{
+	FuEngineColdplugItem *item = g_private_get(&fu_engine_coldplug_item_key);
+	FuEngineColdplugEvent *event;
+
+	if (item == NULL)
+		return FALSE;
+	event = g_new0(FuEngineColdplugEvent, 1);
+	event->kind = kind;
+	event->plugin = g_object_ref(plugin);
+	event->device = g_object_ref(device);
+	g_ptr_array_add(item->events, event);
+	return TRUE;
+}
+
 static void
 fu_engine_plugin_device_register_cb(FuPlugin *plugin, FuDevice *device, gpointer user_data)
 {
 	FuEngine *self = FU_ENGINE(user_data);
+	if (fu_engine_coldplug_event_defer(FU_ENGINE_COLDPLUG_EVENT_KIND_REGISTER, plugin, device))
+		return;
 	fu_engine_plugin_device_register(self, device);
 }
 
@@ -6432,6 +7491,10 @@ fu_engine_plugin_device_added_cb(FuPlugin *plugin, FuDevice *device, gpointer us
 {
 	FuEngine *self = FU_ENGINE(user_data);
 
+	/* merged back from the main thread in a deterministic order */
+	if (fu_engine_coldplug_event_defer(FU_ENGINE_COLDPLUG_EVENT_KIND_ADDED, plugin, device))
+		return;
+
 	/* plugin has prio and device not already set from quirk */
 	if (fu_plugin_get_priority(plugin) > 0 && fu_device_get_priority(device) == 0) {
 		g_info("auto-setting %s priority to %u",
@@ -6861,6 +7924,10 @@ fu_engine_plugin_device_removed_cb(FuPlugin *plugin, FuDevice *device, gpointer
 	FuPlugin *plugin_old;
 	g_autoptr(GError) error = NULL;
 
+	/* merged back from the main thread in a deterministic order */
+	if (fu_engine_coldplug_event_defer(FU_ENGINE_COLDPLUG_EVENT_KIND_REMOVED, plugin, device))
+		return;
+
 	/* get the plugin */
 	plugin_old =
 	    fu_plugin_list_find_by_name(self->plugin_list, fu_device_get_plugin(device), &error);
@@ -6963,7 +8030,6 @@ fu_engine_add_plugin_filter(FuEngine *self, const gchar *plugin_glob)
 static gboolean
 fu_engine_plugin_check_supported_cb(FuPlugin *plugin, const gchar *guid, FuEngine *self)
 {
-	g_autoptr(XbNode) n = NULL;
 	g_autofree gchar *xpath = NULL;
 
 	if (fu_engine_config_get_enumerate_all_devices(self->config))
@@ -6972,8 +8038,16 @@ fu_engine_plugin_check_supported_cb(FuPlugin *plugin, const gchar *guid, FuEngin
 	xpath = g_strdup_printf("components/component[@type='firmware']/"
 				"provides/firmware[@type='flashed'][text()='%s']",
 				guid);
-	n = xb_silo_query_first(self->silo, xpath, NULL);
-	return n != NULL;
+	for (guint i = 0; i < self->silos->len; i++) {
+		FuEngineSilo *engine_silo = g_ptr_array_index(self->silos, i);
+		g_autoptr(XbNode) n = NULL;
+		if (!fu_engine_silo_has_guid(engine_silo, guid))
+			continue;
+		n = xb_silo_query_first(fu_engine_silo_get_silo(engine_silo), xpath, NULL);
+		if (n != NULL)
+			return TRUE;
+	}
+	return FALSE;
 }
 
 FuEngineConfig *
@@ -8008,18 +9082,11 @@ fu_engine_backend_device_added_run_plugins(FuEngine *self, FuDevice *device, FuP
 	}
 }
 
-static void
-fu_engine_backend_device_added(FuEngine *self, FuDevice *device, FuProgress *progress)
+static gboolean
+fu_engine_backend_device_probe(FuEngine *self, FuDevice *device)
 {
 	g_autoptr(GError) error_local = NULL;
 
-	/* progress */
-	fu_progress_set_id(progress, G_STRLOC);
-	fu_progress_add_flag(progress, FU_PROGRESS_FLAG_NO_PROFILE);
-	fu_progress_set_name(progress, fu_device_get_backend_id(device));
-	fu_progress_add_step(progress, FWUPD_STATUS_LOADING, 50, "probe-baseclass");
-	fu_progress_add_step(progress, FWUPD_STATUS_LOADING, 50, "query-possible-plugins");
-
 	/* super useful for plugin development */
 	if (g_getenv("FWUPD_VERBOSE") != NULL) {
 		g_autofree gchar *str = fu_device_to_string(FU_DEVICE(device));
@@ -8039,19 +9106,36 @@ fu_engine_backend_device_added(FuEngine *self, FuDevice *device, FuProgress *pro
 				fu_device_get_backend_id(device),
 				error_local->message);
 		}
-		fu_progress_finished(progress);
-		return;
+		return FALSE;
 	}
-	fu_progress_step_done(progress);
-
-	/* check if the device needs emulation-tag */
-	fu_engine_ensure_device_emulation_tag(self, device);
 
 	/* super useful for plugin development */
 	if (g_getenv("FWUPD_VERBOSE") != NULL) {
 		g_autofree gchar *str = fu_device_to_string(FU_DEVICE(device));
 		g_debug("%s added %s", fu_device_get_backend_id(device), str);
 	}
+	return TRUE;
+}
+
+static void
+fu_engine_backend_device_added(FuEngine *self, FuDevice *device, FuProgress *progress)
+{
+	/* progress */
+	fu_progress_set_id(progress, G_STRLOC);
+	fu_progress_add_flag(progress, FU_PROGRESS_FLAG_NO_PROFILE);
+	fu_progress_set_name(progress, fu_device_get_backend_id(device));
+	fu_progress_add_step(progress, FWUPD_STATUS_LOADING, 50, "probe-baseclass");
+	fu_progress_add_step(progress, FWUPD_STATUS_LOADING, 50, "query-possible-plugins");
+
+	/* add any extra quirks */
+	if (!fu_engine_backend_device_probe(self, device)) {
+		fu_progress_finished(progress);
+		return;
+	}
+	fu_progress_step_done(progress);
+
+	/* check if the device needs emulation-tag */
+	fu_engine_ensure_device_emulation_tag(self, device);
 
 	/* if this is for firmware attributes, reload that part of the daemon */
 	fu_engine_check_firmware_attributes(self, device, TRUE);
@@ -8463,14 +9547,318 @@ fu_engine_win32_registry_get_string(HKEY hkey,
 }
 #endif
 
+static void
+fu_engine_coldplug_item_free(FuEngineColdplugItem *item)
+{
+	g_object_unref(item->device);
+	g_ptr_array_unref(item->events);
+	g_free(item->group);
+	g_free(item);
+}
+
+/* FuHistory is not safe to use from multiple threads */
+G_LOCK_DEFINE_STATIC(fu_engine_coldplug_history);
+
+/* USB devices are named like 1-2.3 in sysfs, and their interfaces like 1-2.3:1.0 */
+static gboolean
+fu_engine_coldplug_is_usb_device_name(const gchar *name)
+{
+	if (!g_ascii_isdigit(name[0]) || strchr(name, '-') == NULL)
+		return FALSE;
+	for (guint i = 0; name[i] != '\0'; i++) {
+		if (!g_ascii_isdigit(name[i]) && name[i] != '-' && name[i] != '.')
+			return FALSE;
+	}
+	return TRUE;
+}
+
+/* the physical device for a sysfs path, e.g. the USB device that owns a hidraw node */
+static gchar *
+fu_engine_coldplug_sysfs_path_get_physical(const gchar *sysfs_path)
+{
+	guint idx = 0;
+	g_auto(GStrv) split = g_strsplit(sysfs_path, "/", -1);
+
+	for (guint i = 0; split[i] != NULL; i++) {
+		if (fu_engine_coldplug_is_usb_device_name(split[i]))
+			idx = i;
+	}
+	if (idx == 0)
+		return g_strdup(sysfs_path);
+	g_free(split[idx + 1]);
+	split[idx + 1] = NULL;
+	return g_strjoinv("/", split);
+}
+
+/* devices with the same key, or a key that is a path below it, use the same worker */
+static gchar *
+fu_engine_coldplug_device_get_group(FuDevice *device)
+{
+	const gchar *backend_id = fu_device_get_backend_id(device);
+
+	if (backend_id == NULL)
+		return g_strdup("");
+	if (g_path_is_absolute(backend_id))
+		return fu_engine_coldplug_sysfs_path_get_physical(backend_id);
+
+	/* libusb uses bus:address, and any device on the same bus might be the parent hub */
+	if (FU_IS_USB_DEVICE(device)) {
+		g_auto(GStrv) split = g_strsplit(backend_id, ":", 2);
+		return g_strdup_printf("usb:%s", split[0]);
+	}
+	return g_strdup(backend_id);
+}
+
+/* the group used by the device itself or by the nearest ancestor */
+static GPtrArray *
+fu_engine_coldplug_group_lookup(GHashTable *groups, const gchar *group)
+{
+	g_autofree gchar *tmp = g_strdup(group);
+
+	while (TRUE) {
+		GPtrArray *group_items = g_hash_table_lookup(groups, tmp);
+		gchar *dirname;
+
+		if (group_items != NULL)
+			return group_items;
+		if (!g_path_is_absolute(tmp) || g_strcmp0(tmp, "/") == 0)
+			return NULL;
+		dirname = g_path_get_dirname(tmp);
+		g_free(tmp);
+		tmp = dirname;
+	}
+}
+
+static gint
+fu_engine_coldplug_item_sort_group_cb(gconstpointer a, gconstpointer b)
+{
+	FuEngineColdplugItem *item1 = *((FuEngineColdplugItem **)a);
+	FuEngineColdplugItem *item2 = *((FuEngineColdplugItem **)b);
+	gsize len1 = strlen(item1->group);
+	gsize len2 = strlen(item2->group);
+	if (len1 != len2)
+		return len1 < len2 ? -1 : 1;
+	return item1->idx < item2->idx ? -1 : 1;
+}
+
+static gint
+fu_engine_coldplug_item_sort_idx_cb(gconstpointer a, gconstpointer b)
+{
+	FuEngineColdplugItem *item1 = *((FuEngineColdplugItem **)a);
+	FuEngineColdplugItem *item2 = *((FuEngineColdplugItem **)b);
+	if (item1->idx == item2->idx)
+		return 0;
+	return item1->idx < item2->idx ? -1 : 1;
+}
+
+static gboolean
+fu_engine_coldplug_device_needs_main_thread(FuEngine *self, FuDevice *device)
+{
+	g_autoptr(GPtrArray) possible_plugins = NULL;
+
+	/* reloads the BIOS settings and might apply policy */
+	if (FU_IS_UDEV_DEVICE(device) &&
+	    g_strcmp0(fu_udev_device_get_subsystem(FU_UDEV_DEVICE(device)),
+		      "firmware-attributes") == 0)
+		return TRUE;
+
+	/* only plugins that have been audited can be called from another thread */
+	possible_plugins = fu_device_get_possible_plugins(device);
+	for (guint i = 0; i < possible_plugins->len; i++) {
+		const gchar *plugin_name = g_ptr_array_index(possible_plugins, i);
+		FuPlugin *plugin = fu_plugin_list_find_by_name(self->plugin_list, plugin_name, NULL);
+		if (plugin == NULL)
+			continue;
+		if (!fu_plugin_has_flag(plugin, FWUPD_PLUGIN_FLAG_THREAD_SAFE))
+			return TRUE;
+	}
+	return FALSE;
+}
+
+static void
+fu_engine_coldplug_worker_cb(gpointer data, gpointer user_data)
+{
+	FuEngine *self = FU_ENGINE(user_data);
+	GPtrArray *items = (GPtrArray *)data;
+
+	for (guint i = 0; i < items->len; i++) {
+		FuEngineColdplugItem *item = g_ptr_array_index(items, i);
+		g_autoptr(FuProgress) progress = fu_progress_new(G_STRLOC);
+
+		/* add any extra quirks */
+		item->probed = fu_engine_backend_device_probe(self, item->device);
+		if (!item->probed)
+			continue;
+
+		/* check if the device needs emulation-tag */
+		G_LOCK(fu_engine_coldplug_history);
+		fu_engine_ensure_device_emulation_tag(self, item->device);
+		G_UNLOCK(fu_engine_coldplug_history);
+
+		/* run the plugins here, deferring the signals to the main thread */
+		item->needs_main_thread =
+		    fu_engine_coldplug_device_needs_main_thread(self, item->device);
+		if (item->needs_main_thread)
+			continue;
+		g_private_set(&fu_engine_coldplug_item_key, item);
+		fu_engine_backend_device_added_run_plugins(self, item->device, progress);
+		g_private_set(&fu_engine_coldplug_item_key, NULL);
+		g_atomic_int_inc(&self->coldplug_worker_cnt);
+	}
+}
+
+static void
+fu_engine_coldplug_item_merge(FuEngine *self, FuEngineColdplugItem *item, FuProgress *progress)
+{
+	/* progress */
+	fu_progress_set_id(progress, G_STRLOC);
+	fu_progress_add_flag(progress, FU_PROGRESS_FLAG_NO_PROFILE);
+	fu_progress_set_name(progress, fu_device_get_backend_id(item->device));
+	fu_progress_set_device_id(progress, fu_device_get_id(item->device));
+
+	/* failed to probe */
+	if (!item->probed) {
+		fu_progress_finished(progress);
+		return;
+	}
+
+	/* if this is for firmware attributes, reload that part of the daemon */
+	fu_engine_check_firmware_attributes(self, item->device, TRUE);
+	if (item->needs_main_thread) {
+		fu_engine_backend_device_added_run_plugins(self, item->device, progress);
+		return;
+	}
+
+	/* replay the plugin signals in the order they were emitted */
+	for (guint i = 0; i < item->events->len; i++) {
+		FuEngineColdplugEvent *event = g_ptr_array_index(item->events, i);
+		switch (event->kind) {
+		case FU_ENGINE_COLDPLUG_EVENT_KIND_REGISTER:
+			fu_engine_plugin_device_register_cb(event->plugin, event->device, self);
+			break;
+		case FU_ENGINE_COLDPLUG_EVENT_KIND_ADDED:
+			fu_engine_plugin_device_added_cb(event->plugin, event->device, self);
+			break;
+		case FU_ENGINE_COLDPLUG_EVENT_KIND_REMOVED:
+			fu_engine_plugin_device_removed_cb(event->plugin, event->device, self);
+			break;
+		default:
+			break;
+		}
+	}
+	fu_progress_finished(progress);
+}
+
+static gboolean
+fu_engine_backends_coldplug_backend_add_devices_concurrent(FuEngine *self,
+							   FuBackend *backend,
+							   GPtrArray *devices,
+							   guint threads,
+							   FuProgress *progress,
+							   GError **error)
+{
+	GThreadPool *pool;
+	g_autoptr(GHashTable) groups =
+	    g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	g_autoptr(GPtrArray) groups_ordered =
+	    g_ptr_array_new_with_free_func((GDestroyNotify)g_ptr_array_unref);
+	g_autoptr(GPtrArray) items =
+	    g_ptr_array_new_with_free_func((GDestroyNotify)fu_engine_coldplug_item_free);
+	g_autoptr(GPtrArray) items_sorted = NULL;
+
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *device = g_ptr_array_index(devices, i);
+		FuEngineColdplugItem *item = g_new0(FuEngineColdplugItem, 1);
+		item->device = g_object_ref(device);
+		item->idx = i;
+		item->group = fu_engine_coldplug_device_get_group(device);
+		item->events =
+		    g_ptr_array_new_with_free_func((GDestroyNotify)fu_engine_coldplug_event_free);
+		g_ptr_array_add(items, item);
+	}
+
+	/* split the devices into groups that can be processed independently, where ancestors
+	 * always have a shorter group so are assigned before any of their descendants */
+	items_sorted = g_ptr_array_copy(items, NULL, NULL);
+	g_ptr_array_sort(items_sorted, fu_engine_coldplug_item_sort_group_cb);
+	for (guint i = 0; i < items_sorted->len; i++) {
+		FuEngineColdplugItem *item = g_ptr_array_index(items_sorted, i);
+		GPtrArray *group_items = fu_engine_coldplug_group_lookup(groups, item->group);
+		if (group_items == NULL) {
+			group_items = g_ptr_array_new();
+			g_ptr_array_add(groups_ordered, group_items);
+		}
+		if (!g_hash_table_contains(groups, item->group))
+			g_hash_table_insert(groups, g_strdup(item->group), group_items);
+		g_ptr_array_add(group_items, item);
+	}
+	for (guint i = 0; i < groups_ordered->len; i++) {
+		GPtrArray *group_items = g_ptr_array_index(groups_ordered, i);
+		g_ptr_array_sort(group_items, fu_engine_coldplug_item_sort_idx_cb);
+	}
+
+	/* probe and run the plugins, then wait for all the workers to finish */
+	pool = g_thread_pool_new(fu_engine_coldplug_worker_cb, self, threads, TRUE, error);
+	if (pool == NULL)
+		return FALSE;
+	g_debug("coldplugging %u devices in %u groups using %u threads",
+		items->len,
+		groups_ordered->len,
+		threads);
+	for (guint i = 0; i < groups_ordered->len; i++) {
+		if (!g_thread_pool_push(pool, g_ptr_array_index(groups_ordered, i), error)) {
+			g_thread_pool_free(pool, FALSE, TRUE);
+			return FALSE;
+		}
+	}
+	g_thread_pool_free(pool, FALSE, TRUE);
+
+	/* merge the results in the same order as the serial coldplug */
+	fu_progress_set_id(progress, G_STRLOC);
+	fu_progress_set_steps(progress, items->len);
+	for (guint i = 0; i < items->len; i++) {
+		FuEngineColdplugItem *item = g_ptr_array_index(items, i);
+		g_autoptr(GPtrArray) possible_plugins = NULL;
+
+		fu_engine_coldplug_item_merge(self, item, fu_progress_get_child(progress));
+		fu_progress_step_done(progress);
+
+		/* free data cached during ->probe */
+		fu_device_probe_complete(item->device);
+
+		/* there's no point keeping this in the cache */
+		possible_plugins = fu_device_get_possible_plugins(item->device);
+		if (possible_plugins->len == 0) {
+			g_debug("removing %s from backend cache as no possible plugin",
+				fu_device_get_backend_id(item->device));
+			fu_backend_device_removed(backend, item->device);
+		}
+	}
+
+	/* success */
+	return TRUE;
+}
+
 static gboolean
 fu_engine_backends_coldplug_backend_add_devices(FuEngine *self,
 						FuBackend *backend,
 						FuProgress *progress,
 						GError **error)
 {
+	guint threads = fu_engine_config_get_coldplug_threads(self->config);
 	g_autoptr(GPtrArray) devices = fu_backend_get_devices(backend);
 
+	/* opt-in, and not supported when forcing devices without a plugin */
+	if (threads > 1 && devices->len > 1 &&
+	    (self->load_flags & FU_ENGINE_LOAD_FLAG_COLDPLUG_FORCE) == 0) {
+		return fu_engine_backends_coldplug_backend_add_devices_concurrent(self,
+										  backend,
+										  devices,
+										  threads,
+										  progress,
+										  error);
+	}
+
 	/* progress */
 	fu_progress_set_id(progress, G_STRLOC);
 	fu_progress_set_steps(progress, devices->len);
@@ -8662,6 +10050,7 @@ fu_engine_load(FuEngine *self, FuEngineLoadFlags flags, FuProgress *progress, GE
 		g_prefix_error_literal(error, "failed to load config: ");
 		return FALSE;
 	}
+	fu_engine_trace_ensure_profile(self, progress);
 	fu_progress_step_done(progress);
 
 	/* set the hardcoded ESP */
@@ -8778,7 +10167,7 @@ fu_engine_load(FuEngine *self, FuEngineLoadFlags flags, FuProgress *progress, GE
 	fu_progress_step_done(progress);
 
 	/* load AppStream metadata */
-	if (!fu_engine_load_metadata_store(self, flags, error)) {
+	if (!fu_engine_load_metadata_store(self, flags, NULL, error)) {
 		g_prefix_error_literal(error, "failed to load AppStream data: ");
 		return FALSE;
 	}
@@ -8923,6 +10312,7 @@ fu_engine_load(FuEngine *self, FuEngineLoadFlags flags, FuProgress *progress, GE
 	if (!fu_engine_update_history_database(self, error))
 		return FALSE;
 	fu_progress_step_done(progress);
+	fu_engine_trace_add_progress_and_save(self, progress, 1);
 
 	/* update the devices JSON file */
 	if (!fu_engine_update_devices_file(self, &error_json_devices))
@@ -9190,9 +10580,6 @@ fu_engine_constructed(GObject *obj)
 #ifdef HAVE_UTSNAME_H
 	struct utsname uname_tmp = {0};
 #endif
-	g_autofree gchar *keyring_path = NULL;
-	g_autofree gchar *pkidir_fw = NULL;
-	g_autofree gchar *pkidir_md = NULL;
 
 	g_signal_connect(FU_CONTEXT(self->ctx),
 			 "security-changed",
@@ -9271,17 +10658,7 @@ fu_engine_constructed(GObject *obj)
 	self->emulation = fu_engine_emulator_new(self);
 
 	/* setup Jcat context */
-	self->jcat_context = jcat_context_new();
-	jcat_context_blob_kind_allow(self->jcat_context, JCAT_BLOB_KIND_SHA256);
-	jcat_context_blob_kind_allow(self->jcat_context, JCAT_BLOB_KIND_SHA512);
-	jcat_context_blob_kind_allow(self->jcat_context, JCAT_BLOB_KIND_PKCS7);
-	jcat_context_blob_kind_allow(self->jcat_context, JCAT_BLOB_KIND_GPG);
-	keyring_path = fu_path_from_kind(FU_PATH_KIND_LOCALSTATEDIR_PKG);
-	jcat_context_set_keyring_path(self->jcat_context, keyring_path);
-	pkidir_fw = fu_path_build(FU_PATH_KIND_SYSCONFDIR, "pki", "fwupd", NULL);
-	jcat_context_add_public_keys(self->jcat_context, pkidir_fw);
-	pkidir_md = fu_path_build(FU_PATH_KIND_SYSCONFDIR, "pki", "fwupd-metadata", NULL);
-	jcat_context_add_public_keys(self->jcat_context, pkidir_md);
+	self->jcat_context = fu_engine_jcat_context_new();
 
 	/* add some runtime versions of things the daemon depends on */
 	fu_engine_add_runtime_version(self, "org.freedesktop.fwupd", VERSION);
@@ -9338,6 +10715,7 @@ static void
 fu_engine_init(FuEngine *self)
 {
 	self->percentage = 0;
+	self->thread_main = g_thread_self();
 	self->config = fu_engine_config_new();
 	self->remote_list = fu_remote_list_new();
 	self->device_list = fu_device_list_new();
@@ -9346,7 +10724,11 @@ fu_engine_init(FuEngine *self)
 	self->plugin_filter = g_ptr_array_new_with_free_func(g_free);
 	self->host_security_attrs = fu_security_attrs_new();
 	self->local_monitors = g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
-	self->search_queries = g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
+	self->silos = g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
+	self->releases_cache = g_hash_table_new_full(g_str_hash,
+						     g_str_equal,
+						     g_free,
+						     (GDestroyNotify)g_ptr_array_unref);
 	self->acquiesce_loop = g_main_loop_new(NULL, FALSE);
 	self->device_changed_allowlist =
 	    g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
@@ -9368,16 +10750,6 @@ fu_engine_finalize(GObject *obj)
 		g_file_monitor_cancel(monitor);
 	}
 
-	if (self->silo != NULL)
-		g_object_unref(self->silo);
-	if (self->query_component_by_guid != NULL)
-		g_object_unref(self->query_component_by_guid);
-	if (self->query_container_checksum1 != NULL)
-		g_object_unref(self->query_container_checksum1);
-	if (self->query_container_checksum2 != NULL)
-		g_object_unref(self->query_container_checksum2);
-	if (self->query_tag_by_guid_version != NULL)
-		g_object_unref(self->query_tag_by_guid_version);
 	if (self->approved_firmware != NULL)
 		g_hash_table_unref(self->approved_firmware);
 	if (self->blocked_firmware != NULL)
@@ -9392,6 +10764,8 @@ fu_engine_finalize(GObject *obj)
 	if (self->passim_client != NULL)
 		g_object_unref(self->passim_client);
 #endif
+	if (self->trace_events != NULL)
+		json_array_unref(self->trace_events);
 	g_main_loop_unref(self->acquiesce_loop);
 
 	g_free(self->host_machine_id);
@@ -9404,7 +10778,8 @@ fu_engine_finalize(GObject *obj)
 	g_object_unref(self->jcat_context);
 	g_ptr_array_unref(self->plugin_filter);
 	g_ptr_array_unref(self->local_monitors);
-	g_ptr_array_unref(self->search_queries);
+	g_ptr_array_unref(self->silos);
+	g_hash_table_unref(self->releases_cache);
 	g_hash_table_unref(self->device_changed_allowlist);
 	g_object_unref(self->plugin_list);
 
@@ -15,6 +15,7 @@
 
 #include "fu-cabinet.h"
 #include "fu-engine-config.h"
+#include "fu-engine-silo.h"
 #include "fu-engine-struct.h"
 #include "fu-release.h"
 
@@ -93,6 +94,11 @@ fu_engine_get_upgrades(FuEngine *self,
 		       FuEngineRequest *request,
 		       const gchar *device_id,
 		       GError **error) G_GNUC_NON_NULL(1, 2, 3);
+GHashTable *
+fu_engine_get_upgrades_all(FuEngine *self,
+			   FuEngineRequest *request,
+			   FwupdReleaseFlags include,
+			   FwupdReleaseFlags exclude) G_GNUC_NON_NULL(1, 2);
 FwupdDevice *
 fu_engine_get_results(FuEngine *self, const gchar *device_id, GError **error) G_GNUC_NON_NULL(1, 2);
 FuSecurityAttrs *
@@ -233,6 +239,18 @@ gboolean
 fu_engine_check_trust(FuEngine *self, FuRelease *release, GError **error) G_GNUC_NON_NULL(1, 2);
 void
 fu_engine_set_silo(FuEngine *self, XbSilo *silo) G_GNUC_NON_NULL(1, 2);
+guint
+fu_engine_get_releases_cache_hits(FuEngine *self) G_GNUC_NON_NULL(1);
+guint
+fu_engine_get_md_refresh_cnt(FuEngine *self) G_GNUC_NON_NULL(1);
+guint
+fu_engine_get_metainfo_convert_cnt(FuEngine *self) G_GNUC_NON_NULL(1);
+guint
+fu_engine_get_coldplug_worker_cnt(FuEngine *self) G_GNUC_NON_NULL(1);
+FuEngineSilo *
+fu_engine_get_silo_by_id(FuEngine *self, const gchar *id) G_GNUC_NON_NULL(1, 2);
+gboolean
+fu_engine_update_metadata_store(FuEngine *self, GError **error) G_GNUC_NON_NULL(1);
 XbNode *
 fu_engine_get_component_by_guids(FuEngine *self, FuDevice *device) G_GNUC_NON_NULL(1, 2);
 gboolean
@@ -32,8 +32,12 @@
  * v12	add install_duration to history
  * v13	add release_flags to history
  * v14	create table emulation_tag
+ * v15	add indexes to history and hsi_history, compact hsi_history
  */
-#define FU_HISTORY_CURRENT_SCHEMA_VERSION 14
+#define FU_HISTORY_CURRENT_SCHEMA_VERSION 15
+
+/* the number of HSI results to keep */
+#define FU_HISTORY_HSI_HISTORY_MAX 1000
 
 static void
 fu_history_finalize(GObject *object);
@@ -42,6 +46,8 @@ struct _FuHistory {
 	GObject parent_instance;
 	FuContext *ctx;
 	sqlite3 *db;
+	GHashTable *stmts; /* (element-type utf8 sqlite3_stmt) */
+	GRecMutex db_mutex; /* for db and stmts, as devices may be installed in parallel */
 };
 
 G_DEFINE_TYPE(FuHistory, fu_history, G_TYPE_OBJECT)
@@ -51,6 +57,38 @@ G_DEFINE_TYPE(FuHistory, fu_history, G_TYPE_OBJECT)
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(sqlite3_stmt, sqlite3_finalize);
 #pragma clang diagnostic pop
 
+/* a statement owned by the cache, which is only reset when going out of scope */
+typedef sqlite3_stmt FuHistoryStmt;
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(FuHistoryStmt, sqlite3_reset);
+
+/* same as sqlite3_prepare_v2(), but the statement is compiled once for the database lifetime */
+static gint
+fu_history_prepare(FuHistory *self, const gchar *sql, FuHistoryStmt **stmt)
+{
+	gint rc;
+	sqlite3_stmt *stmt_tmp = g_hash_table_lookup(self->stmts, sql);
+
+	if (stmt_tmp != NULL) {
+		sqlite3_reset(stmt_tmp);
+		sqlite3_clear_bindings(stmt_tmp);
+		*stmt = stmt_tmp;
+		return SQLITE_OK;
+	}
+	rc = sqlite3_prepare_v3(self->db, sql, -1, SQLITE_PREPARE_PERSISTENT, &stmt_tmp, NULL);
+	if (rc != SQLITE_OK)
+		return rc;
+	g_hash_table_insert(self->stmts, g_strdup(sql), stmt_tmp);
+	*stmt = stmt_tmp;
+	return SQLITE_OK;
+}
+
+static void
+fu_history_close(FuHistory *self)
+{
+	g_hash_table_remove_all(self->stmts);
+	g_clear_pointer(&self->db, sqlite3_close);
+}
+
 static FuDevice *
 fu_history_device_from_stmt(sqlite3_stmt *stmt)
 {
@@ -187,6 +225,30 @@ fu_history_stmt_exec(FuHistory *self, sqlite3_stmt *stmt, GPtrArray *array, GErr
 	return TRUE;
 }
 
+static gboolean
+fu_history_create_indexes(FuHistory *self, GError **error)
+{
+	gint rc;
+	rc = sqlite3_exec(self->db,
+			  "CREATE INDEX IF NOT EXISTS idx_history_device_id "
+			  "ON history (device_id, device_created);"
+			  "CREATE INDEX IF NOT EXISTS idx_history_checksum ON history (checksum);"
+			  "CREATE INDEX IF NOT EXISTS idx_hsi_history_timestamp "
+			  "ON hsi_history (timestamp);",
+			  NULL,
+			  NULL,
+			  NULL);
+	if (rc != SQLITE_OK) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_INTERNAL,
+			    "Failed to create indexes: %s",
+			    sqlite3_errmsg(self->db));
+		return FALSE;
+	}
+	return TRUE;
+}
+
 static gboolean
 fu_history_create_database(FuHistory *self, GError **error)
 {
@@ -241,7 +303,7 @@ fu_history_create_database(FuHistory *self, GError **error)
 			    sqlite3_errmsg(self->db));
 		return FALSE;
 	}
-	return TRUE;
+	return fu_history_create_indexes(self, error);
 }
 
 static gboolean
@@ -470,6 +532,25 @@ fu_history_migrate_database_v12(FuHistory *self, GError **error)
 	return TRUE;
 }
 
+static gboolean
+fu_history_migrate_database_v13(FuHistory *self, GError **error)
+{
+	gint rc;
+
+	/* only keep the HSI results where something changed, and not too many of those */
+	rc = sqlite3_exec(self->db,
+			  "DELETE FROM hsi_history WHERE rowid IN ("
+			  "SELECT rowid FROM (SELECT rowid, hsi_details, "
+			  "LAG(hsi_details) OVER (ORDER BY timestamp, rowid) AS hsi_details_prev "
+			  "FROM hsi_history) WHERE hsi_details = hsi_details_prev);",
+			  NULL,
+			  NULL,
+			  NULL);
+	if (rc != SQLITE_OK)
+		g_debug("ignoring database error: %s", sqlite3_errmsg(self->db));
+	return fu_history_create_indexes(self, error);
+}
+
 /* returns 0 if database is not initialized */
 static guint
 fu_history_get_schema_version(FuHistory *self)
@@ -555,6 +636,10 @@ fu_history_create_or_migrate(FuHistory *self, guint schema_ver, GError **error)
 	case 13:
 		if (!fu_history_migrate_database_v12(self, error))
 			return FALSE;
+	/* fall through */
+	case 14:
+		if (!fu_history_migrate_database_v13(self, error))
+			return FALSE;
 		/* no longer fall through */
 		break;
 	default:
@@ -596,6 +681,16 @@ fu_history_open(FuHistory *self, const gchar *filename, GError **error)
 
 	/* turn off the lookaside cache */
 	sqlite3_db_config(self->db, SQLITE_DBCONFIG_LOOKASIDE, NULL, 0, 0);
+
+	/* readers do not block the writer, and only the checkpoint needs to fsync */
+	rc = sqlite3_exec(self->db,
+			  "PRAGMA journal_mode=WAL;"
+			  "PRAGMA synchronous=NORMAL;",
+			  NULL,
+			  NULL,
+			  NULL);
+	if (rc != SQLITE_OK)
+		g_debug("ignoring database error: %s", sqlite3_errmsg(self->db));
 	return TRUE;
 }
 
@@ -651,7 +746,7 @@ fu_history_load(FuHistory *self, GError **error)
 			g_warning("failed to migrate %s database: %s",
 				  filename,
 				  error_migrate->message);
-			sqlite3_close(self->db);
+			fu_history_close(self);
 			if (g_unlink(filename) != 0) {
 				g_set_error(error,
 					    FWUPD_ERROR,
@@ -709,9 +804,10 @@ fu_history_get_device_flags_filtered(FuDevice *device)
 gboolean
 fu_history_modify_device(FuHistory *self, FuDevice *device, GError **error)
 {
+	g_autoptr(GRecMutexLocker) locker = g_rec_mutex_locker_new(&self->db_mutex);
 	gint rc;
 	g_autofree gchar *id_display = fu_device_get_id_display(device);
-	g_autoptr(sqlite3_stmt) stmt = NULL;
+	g_autoptr(FuHistoryStmt) stmt = NULL;
 
 	g_return_val_if_fail(FU_IS_HISTORY(self), FALSE);
 	g_return_val_if_fail(FU_IS_DEVICE(device), FALSE);
@@ -722,7 +818,7 @@ fu_history_modify_device(FuHistory *self, FuDevice *device, GError **error)
 
 	/* overwrite entry if it exists */
 	g_debug("modifying device %s", id_display);
-	rc = sqlite3_prepare_v2(self->db,
+	rc = fu_history_prepare(self,
 				"UPDATE history SET "
 				"update_state = ?1, "
 				"update_error = ?2, "
@@ -731,9 +827,7 @@ fu_history_modify_device(FuHistory *self, FuDevice *device, GError **error)
 				"install_duration = ?8, "
 				"flags = ?3 "
 				"WHERE device_id = ?4;",
-				-1,
-				&stmt,
-				NULL);
+				&stmt);
 	if (rc != SQLITE_OK) {
 		g_set_error(error,
 			    FWUPD_ERROR,
@@ -789,10 +883,11 @@ fu_history_modify_device_release(FuHistory *self,
 				 FuRelease *release,
 				 GError **error)
 {
+	g_autoptr(GRecMutexLocker) locker = g_rec_mutex_locker_new(&self->db_mutex);
 	gint rc;
 	g_autofree gchar *id_display = fu_device_get_id_display(device);
 	g_autofree gchar *metadata = NULL;
-	g_autoptr(sqlite3_stmt) stmt = NULL;
+	g_autoptr(FuHistoryStmt) stmt = NULL;
 
 	g_return_val_if_fail(FU_IS_HISTORY(self), FALSE);
 	g_return_val_if_fail(FU_IS_DEVICE(device), FALSE);
@@ -806,7 +901,7 @@ fu_history_modify_device_release(FuHistory *self,
 
 	/* overwrite entry if it exists */
 	g_debug("modifying device %s", id_display);
-	rc = sqlite3_prepare_v2(self->db,
+	rc = fu_history_prepare(self,
 				"UPDATE history SET "
 				"update_state = ?1, "
 				"update_error = ?2, "
@@ -815,9 +910,7 @@ fu_history_modify_device_release(FuHistory *self,
 				"metadata = ?8, "
 				"flags = ?3 "
 				"WHERE device_id = ?4;",
-				-1,
-				&stmt,
-				NULL);
+				&stmt);
 	if (rc != SQLITE_OK) {
 		g_set_error(error,
 			    FWUPD_ERROR,
@@ -860,12 +953,13 @@ fu_history_modify_device_release(FuHistory *self,
 gboolean
 fu_history_add_device(FuHistory *self, FuDevice *device, FuRelease *release, GError **error)
 {
+	g_autoptr(GRecMutexLocker) locker = g_rec_mutex_locker_new(&self->db_mutex);
 	const gchar *checksum_device;
 	const gchar *checksum = NULL;
 	gint rc;
 	g_autofree gchar *id_display = fu_device_get_id_display(device);
 	g_autofree gchar *metadata = NULL;
-	g_autoptr(sqlite3_stmt) stmt = NULL;
+	g_autoptr(FuHistoryStmt) stmt = NULL;
 
 	g_return_val_if_fail(FU_IS_HISTORY(self), FALSE);
 	g_return_val_if_fail(FU_IS_DEVICE(device), FALSE);
@@ -890,7 +984,7 @@ fu_history_add_device(FuHistory *self, FuDevice *device, FuRelease *release, GEr
 	metadata = fu_history_convert_hash_to_string(fu_release_get_metadata(release));
 
 	/* add */
-	rc = sqlite3_prepare_v2(self->db,
+	rc = fu_history_prepare(self,
 				"INSERT INTO history (device_id,"
 				"update_state,"
 				"update_error,"
@@ -914,9 +1008,7 @@ fu_history_add_device(FuHistory *self, FuDevice *device, FuRelease *release, GEr
 				"release_flags) "
 				"VALUES (?1,?2,?3,?4,?5,?6,?7,?8,?9,?10,"
 				"?11,?12,?13,?14,?15,?16,?17,?18,?19,?20,?21)",
-				-1,
-				&stmt,
-				NULL);
+				&stmt);
 	if (rc != SQLITE_OK) {
 		g_set_error(error,
 			    FWUPD_ERROR,
@@ -963,8 +1055,9 @@ fu_history_add_device(FuHistory *self, FuDevice *device, FuRelease *release, GEr
 gboolean
 fu_history_remove_all(FuHistory *self, GError **error)
 {
+	g_autoptr(GRecMutexLocker) locker = g_rec_mutex_locker_new(&self->db_mutex);
 	gint rc;
-	g_autoptr(sqlite3_stmt) stmt = NULL;
+	g_autoptr(FuHistoryStmt) stmt = NULL;
 
 	g_return_val_if_fail(FU_IS_HISTORY(self), FALSE);
 
@@ -974,7 +1067,7 @@ fu_history_remove_all(FuHistory *self, GError **error)
 
 	/* remove entries */
 	g_debug("removing all devices");
-	rc = sqlite3_prepare_v2(self->db, "DELETE FROM history;", -1, &stmt, NULL);
+	rc = fu_history_prepare(self, "DELETE FROM history;", &stmt);
 	if (rc != SQLITE_OK) {
 		g_set_error(error,
 			    FWUPD_ERROR,
@@ -1001,9 +1094,10 @@ fu_history_remove_all(FuHistory *self, GError **error)
 gboolean
 fu_history_remove_device(FuHistory *self, FuDevice *device, GError **error)
 {
+	g_autoptr(GRecMutexLocker) locker = g_rec_mutex_locker_new(&self->db_mutex);
 	gint rc;
 	g_autofree gchar *id_display = fu_device_get_id_display(device);
-	g_autoptr(sqlite3_stmt) stmt = NULL;
+	g_autoptr(FuHistoryStmt) stmt = NULL;
 
 	g_return_val_if_fail(FU_IS_HISTORY(self), FALSE);
 	g_return_val_if_fail(FU_IS_DEVICE(device), FALSE);
@@ -1013,11 +1107,7 @@ fu_history_remove_device(FuHistory *self, FuDevice *device, GError **error)
 		return FALSE;
 
 	g_debug("remove device %s", id_display);
-	rc = sqlite3_prepare_v2(self->db,
-				"DELETE FROM history WHERE device_id = ?1;",
-				-1,
-				&stmt,
-				NULL);
+	rc = fu_history_prepare(self, "DELETE FROM history WHERE device_id = ?1;", &stmt);
 	if (rc != SQLITE_OK) {
 		g_set_error(error,
 			    FWUPD_ERROR,
@@ -1045,9 +1135,10 @@ fu_history_remove_device(FuHistory *self, FuDevice *device, GError **error)
 FuDevice *
 fu_history_get_device_by_id(FuHistory *self, const gchar *device_id, GError **error)
 {
+	g_autoptr(GRecMutexLocker) locker = g_rec_mutex_locker_new(&self->db_mutex);
 	gint rc;
 	g_autoptr(GPtrArray) array_tmp = NULL;
-	g_autoptr(sqlite3_stmt) stmt = NULL;
+	g_autoptr(FuHistoryStmt) stmt = NULL;
 
 	g_return_val_if_fail(FU_IS_HISTORY(self), NULL);
 	g_return_val_if_fail(device_id != NULL, NULL);
@@ -1057,7 +1148,7 @@ fu_history_get_device_by_id(FuHistory *self, const gchar *device_id, GError **er
 		return NULL;
 
 	/* get all the devices */
-	rc = sqlite3_prepare_v2(self->db,
+	rc = fu_history_prepare(self,
 				"SELECT device_id, "
 				"checksum, "
 				"plugin, "
@@ -1081,9 +1172,7 @@ fu_history_get_device_by_id(FuHistory *self, const gchar *device_id, GError **er
 				"release_flags FROM history WHERE "
 				"device_id = ?1 ORDER BY device_created DESC "
 				"LIMIT 1",
-				-1,
-				&stmt,
-				NULL);
+				&stmt);
 	if (rc != SQLITE_OK) {
 		g_set_error(error,
 			    FWUPD_ERROR,
@@ -1117,8 +1206,9 @@ fu_history_get_device_by_id(FuHistory *self, const gchar *device_id, GError **er
 GPtrArray *
 fu_history_get_devices(FuHistory *self, GError **error)
 {
+	g_autoptr(GRecMutexLocker) locker = g_rec_mutex_locker_new(&self->db_mutex);
 	g_autoptr(GPtrArray) array = g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
-	g_autoptr(sqlite3_stmt) stmt = NULL;
+	g_autoptr(FuHistoryStmt) stmt = NULL;
 	gint rc;
 
 	g_return_val_if_fail(FU_IS_HISTORY(self), NULL);
@@ -1130,7 +1220,7 @@ fu_history_get_devices(FuHistory *self, GError **error)
 	}
 
 	/* get all the devices */
-	rc = sqlite3_prepare_v2(self->db,
+	rc = fu_history_prepare(self,
 				"SELECT device_id, "
 				"checksum, "
 				"plugin, "
@@ -1153,9 +1243,7 @@ fu_history_get_devices(FuHistory *self, GError **error)
 				"install_duration, "
 				"release_flags FROM history "
 				"ORDER BY device_modified ASC;",
-				-1,
-				&stmt,
-				NULL);
+				&stmt);
 	if (rc != SQLITE_OK) {
 		g_set_error(error,
 			    FWUPD_ERROR,
@@ -1183,9 +1271,10 @@ fu_history_get_devices(FuHistory *self, GError **error)
 GPtrArray *
 fu_history_get_approved_firmware(FuHistory *self, GError **error)
 {
+	g_autoptr(GRecMutexLocker) locker = g_rec_mutex_locker_new(&self->db_mutex);
 	g_autoptr(GPtrArray) array = g_ptr_array_new_with_free_func(g_free);
 	gint rc;
-	g_autoptr(sqlite3_stmt) stmt = NULL;
+	g_autoptr(FuHistoryStmt) stmt = NULL;
 
 	g_return_val_if_fail(FU_IS_HISTORY(self), NULL);
 
@@ -1196,11 +1285,7 @@ fu_history_get_approved_firmware(FuHistory *self, GError **error)
 	}
 
 	/* get all the approved firmware */
-	rc = sqlite3_prepare_v2(self->db,
-				"SELECT checksum FROM approved_firmware;",
-				-1,
-				&stmt,
-				NULL);
+	rc = fu_history_prepare(self, "SELECT checksum FROM approved_firmware;", &stmt);
 	if (rc != SQLITE_OK) {
 		g_set_error(error,
 			    FWUPD_ERROR,
@@ -1238,8 +1323,9 @@ fu_history_get_approved_firmware(FuHistory *self, GError **error)
 gboolean
 fu_history_clear_approved_firmware(FuHistory *self, GError **error)
 {
+	g_autoptr(GRecMutexLocker) locker = g_rec_mutex_locker_new(&self->db_mutex);
 	gint rc;
-	g_autoptr(sqlite3_stmt) stmt = NULL;
+	g_autoptr(FuHistoryStmt) stmt = NULL;
 
 	g_return_val_if_fail(FU_IS_HISTORY(self), FALSE);
 
@@ -1248,7 +1334,7 @@ fu_history_clear_approved_firmware(FuHistory *self, GError **error)
 		return FALSE;
 
 	/* remove entries */
-	rc = sqlite3_prepare_v2(self->db, "DELETE FROM approved_firmware;", -1, &stmt, NULL);
+	rc = fu_history_prepare(self, "DELETE FROM approved_firmware;", &stmt);
 	if (rc != SQLITE_OK) {
 		g_set_error(error,
 			    FWUPD_ERROR,
@@ -1275,8 +1361,9 @@ fu_history_clear_approved_firmware(FuHistory *self, GError **error)
 gboolean
 fu_history_add_approved_firmware(FuHistory *self, const gchar *checksum, GError **error)
 {
+	g_autoptr(GRecMutexLocker) locker = g_rec_mutex_locker_new(&self->db_mutex);
 	gint rc;
-	g_autoptr(sqlite3_stmt) stmt = NULL;
+	g_autoptr(FuHistoryStmt) stmt = NULL;
 
 	g_return_val_if_fail(FU_IS_HISTORY(self), FALSE);
 	g_return_val_if_fail(checksum != NULL, FALSE);
@@ -1286,12 +1373,10 @@ fu_history_add_approved_firmware(FuHistory *self, const gchar *checksum, GError
 		return FALSE;
 
 	/* add */
-	rc = sqlite3_prepare_v2(self->db,
+	rc = fu_history_prepare(self,
 				"INSERT INTO approved_firmware (checksum) "
 				"VALUES (?1)",
-				-1,
-				&stmt,
-				NULL);
+				&stmt);
 	if (rc != SQLITE_OK) {
 		g_set_error(error,
 			    FWUPD_ERROR,
@@ -1318,9 +1403,10 @@ fu_history_add_approved_firmware(FuHistory *self, const gchar *checksum, GError
 GPtrArray *
 fu_history_get_blocked_firmware(FuHistory *self, GError **error)
 {
+	g_autoptr(GRecMutexLocker) locker = g_rec_mutex_locker_new(&self->db_mutex);
 	gint rc;
 	g_autoptr(GPtrArray) array = g_ptr_array_new_with_free_func(g_free);
-	g_autoptr(sqlite3_stmt) stmt = NULL;
+	g_autoptr(FuHistoryStmt) stmt = NULL;
 
 	g_return_val_if_fail(FU_IS_HISTORY(self), NULL);
 
@@ -1331,8 +1417,7 @@ fu_history_get_blocked_firmware(FuHistory *self, GError **error)
 	}
 
 	/* get all the blocked firmware */
-	rc =
-	    sqlite3_prepare_v2(self->db, "SELECT checksum FROM blocked_firmware;", -1, &stmt, NULL);
+	rc = fu_history_prepare(self, "SELECT checksum FROM blocked_firmware;", &stmt);
 	if (rc != SQLITE_OK) {
 		g_set_error(error,
 			    FWUPD_ERROR,
@@ -1370,8 +1455,9 @@ fu_history_get_blocked_firmware(FuHistory *self, GError **error)
 gboolean
 fu_history_clear_blocked_firmware(FuHistory *self, GError **error)
 {
+	g_autoptr(GRecMutexLocker) locker = g_rec_mutex_locker_new(&self->db_mutex);
 	gint rc;
-	g_autoptr(sqlite3_stmt) stmt = NULL;
+	g_autoptr(FuHistoryStmt) stmt = NULL;
 
 	g_return_val_if_fail(FU_IS_HISTORY(self), FALSE);
 
@@ -1380,7 +1466,7 @@ fu_history_clear_blocked_firmware(FuHistory *self, GError **error)
 		return FALSE;
 
 	/* remove entries */
-	rc = sqlite3_prepare_v2(self->db, "DELETE FROM blocked_firmware;", -1, &stmt, NULL);
+	rc = fu_history_prepare(self, "DELETE FROM blocked_firmware;", &stmt);
 	if (rc != SQLITE_OK) {
 		g_set_error(error,
 			    FWUPD_ERROR,
@@ -1407,8 +1493,9 @@ fu_history_clear_blocked_firmware(FuHistory *self, GError **error)
 gboolean
 fu_history_add_blocked_firmware(FuHistory *self, const gchar *checksum, GError **error)
 {
+	g_autoptr(GRecMutexLocker) locker = g_rec_mutex_locker_new(&self->db_mutex);
 	gint rc;
-	g_autoptr(sqlite3_stmt) stmt = NULL;
+	g_autoptr(FuHistoryStmt) stmt = NULL;
 
 	g_return_val_if_fail(FU_IS_HISTORY(self), FALSE);
 	g_return_val_if_fail(checksum != NULL, FALSE);
@@ -1418,12 +1505,10 @@ fu_history_add_blocked_firmware(FuHistory *self, const gchar *checksum, GError *
 		return FALSE;
 
 	/* add */
-	rc = sqlite3_prepare_v2(self->db,
+	rc = fu_history_prepare(self,
 				"INSERT INTO blocked_firmware (checksum) "
 				"VALUES (?1)",
-				-1,
-				&stmt,
-				NULL);
+				&stmt);
 	if (rc != SQLITE_OK) {
 		g_set_error(error,
 			    FWUPD_ERROR,
@@ -1442,8 +1527,10 @@ fu_history_add_security_attribute(FuHistory *self,
 				  const gchar *hsi_score,
 				  GError **error)
 {
+	g_autoptr(GRecMutexLocker) locker = g_rec_mutex_locker_new(&self->db_mutex);
 	gint rc;
-	g_autoptr(sqlite3_stmt) stmt = NULL;
+	g_autoptr(FuHistoryStmt) stmt = NULL;
+	g_autoptr(FuHistoryStmt) stmt_trim = NULL;
 
 	g_return_val_if_fail(FU_IS_HISTORY(self), FALSE);
 
@@ -1452,12 +1539,10 @@ fu_history_add_security_attribute(FuHistory *self,
 		return FALSE;
 
 	/* remove entries */
-	rc = sqlite3_prepare_v2(self->db,
+	rc = fu_history_prepare(self,
 				"INSERT INTO hsi_history (hsi_details, hsi_score)"
 				"VALUES (?1, ?2)",
-				-1,
-				&stmt,
-				NULL);
+				&stmt);
 	if (rc != SQLITE_OK) {
 		g_set_error(error,
 			    FWUPD_ERROR,
@@ -1468,7 +1553,25 @@ fu_history_add_security_attribute(FuHistory *self,
 	}
 	sqlite3_bind_text(stmt, 1, security_attr_json, -1, SQLITE_STATIC);
 	sqlite3_bind_text(stmt, 2, hsi_score, -1, SQLITE_STATIC);
-	return fu_history_stmt_exec(self, stmt, NULL, error);
+	if (!fu_history_stmt_exec(self, stmt, NULL, error))
+		return FALSE;
+
+	/* only keep the most recent entries */
+	rc = fu_history_prepare(self,
+				"DELETE FROM hsi_history WHERE rowid NOT IN ("
+				"SELECT rowid FROM hsi_history ORDER BY timestamp DESC, rowid DESC "
+				"LIMIT ?1);",
+				&stmt_trim);
+	if (rc != SQLITE_OK) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_INTERNAL,
+			    "Failed to prepare SQL to trim security attributes: %s",
+			    sqlite3_errmsg(self->db));
+		return FALSE;
+	}
+	sqlite3_bind_int(stmt_trim, 1, FU_HISTORY_HSI_HISTORY_MAX);
+	return fu_history_stmt_exec(self, stmt_trim, NULL, error);
 }
 
 /**
@@ -1487,10 +1590,11 @@ fu_history_add_security_attribute(FuHistory *self,
 GPtrArray *
 fu_history_get_security_attrs(FuHistory *self, guint limit, GError **error)
 {
+	g_autoptr(GRecMutexLocker) locker = g_rec_mutex_locker_new(&self->db_mutex);
 	gint rc;
 	guint old_hash = 0;
 	g_autoptr(GPtrArray) array = g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
-	g_autoptr(sqlite3_stmt) stmt = NULL;
+	g_autoptr(FuHistoryStmt) stmt = NULL;
 
 	g_return_val_if_fail(FU_IS_HISTORY(self), NULL);
 
@@ -1501,12 +1605,10 @@ fu_history_get_security_attrs(FuHistory *self, guint limit, GError **error)
 	}
 
 	/* get all the devices */
-	rc = sqlite3_prepare_v2(self->db,
+	rc = fu_history_prepare(self,
 				"SELECT timestamp, hsi_details FROM hsi_history "
 				"ORDER BY timestamp DESC;",
-				-1,
-				&stmt,
-				NULL);
+				&stmt);
 	if (rc != SQLITE_OK) {
 		g_set_error(error,
 			    FWUPD_ERROR,
@@ -1590,8 +1692,9 @@ fu_history_get_security_attrs(FuHistory *self, guint limit, GError **error)
 gboolean
 fu_history_has_emulation_tag(FuHistory *self, const gchar *device_id, GError **error)
 {
+	g_autoptr(GRecMutexLocker) locker = g_rec_mutex_locker_new(&self->db_mutex);
 	gint rc;
-	g_autoptr(sqlite3_stmt) stmt = NULL;
+	g_autoptr(FuHistoryStmt) stmt = NULL;
 
 	g_return_val_if_fail(FU_IS_HISTORY(self), FALSE);
 
@@ -1603,18 +1706,14 @@ fu_history_has_emulation_tag(FuHistory *self, const gchar *device_id, GError **e
 
 	/* get tagged device ID */
 	if (device_id != NULL) {
-		rc = sqlite3_prepare_v2(self->db,
+		rc = fu_history_prepare(self,
 					"SELECT device_id FROM emulation_tag "
 					"WHERE device_id = ?1 LIMIT 1;",
-					-1,
-					&stmt,
-					NULL);
+					&stmt);
 	} else {
-		rc = sqlite3_prepare_v2(self->db,
+		rc = fu_history_prepare(self,
 					"SELECT device_id FROM emulation_tag LIMIT 1;",
-					-1,
-					&stmt,
-					NULL);
+					&stmt);
 	}
 	if (rc != SQLITE_OK) {
 		g_set_error(error,
@@ -1669,8 +1768,9 @@ fu_history_has_emulation_tag(FuHistory *self, const gchar *device_id, GError **e
 gboolean
 fu_history_add_emulation_tag(FuHistory *self, const gchar *device_id, GError **error)
 {
+	g_autoptr(GRecMutexLocker) locker = g_rec_mutex_locker_new(&self->db_mutex);
 	gint rc;
-	g_autoptr(sqlite3_stmt) stmt = NULL;
+	g_autoptr(FuHistoryStmt) stmt = NULL;
 
 	g_return_val_if_fail(FU_IS_HISTORY(self), FALSE);
 	g_return_val_if_fail(device_id != NULL, FALSE);
@@ -1680,12 +1780,10 @@ fu_history_add_emulation_tag(FuHistory *self, const gchar *device_id, GError **e
 		return FALSE;
 
 	/* add */
-	rc = sqlite3_prepare_v2(self->db,
+	rc = fu_history_prepare(self,
 				"INSERT INTO emulation_tag (device_id) "
 				"VALUES (?1)",
-				-1,
-				&stmt,
-				NULL);
+				&stmt);
 	if (rc != SQLITE_OK) {
 		g_set_error(error,
 			    FWUPD_ERROR,
@@ -1712,8 +1810,9 @@ fu_history_add_emulation_tag(FuHistory *self, const gchar *device_id, GError **e
 gboolean
 fu_history_remove_emulation_tag(FuHistory *self, const gchar *device_id, GError **error)
 {
+	g_autoptr(GRecMutexLocker) locker = g_rec_mutex_locker_new(&self->db_mutex);
 	gint rc;
-	g_autoptr(sqlite3_stmt) stmt = NULL;
+	g_autoptr(FuHistoryStmt) stmt = NULL;
 
 	g_return_val_if_fail(FU_IS_HISTORY(self), FALSE);
 	g_return_val_if_fail(device_id != NULL, FALSE);
@@ -1723,11 +1822,7 @@ fu_history_remove_emulation_tag(FuHistory *self, const gchar *device_id, GError
 		return FALSE;
 
 	/* remove entries */
-	rc = sqlite3_prepare_v2(self->db,
-				"DELETE FROM emulation_tag WHERE device_id = ?1;",
-				-1,
-				&stmt,
-				NULL);
+	rc = fu_history_prepare(self, "DELETE FROM emulation_tag WHERE device_id = ?1;", &stmt);
 	if (rc != SQLITE_OK) {
 		g_set_error(error,
 			    FWUPD_ERROR,
@@ -1743,6 +1838,7 @@ fu_history_remove_emulation_tag(FuHistory *self, const gchar *device_id, GError
 static void
 fu_history_housekeeping_cb(FuContext *ctx, FuHistory *self)
 {
+	g_autoptr(GRecMutexLocker) locker = g_rec_mutex_locker_new(&self->db_mutex);
 	sqlite3_release_memory(G_MAXINT32);
 	if (self->db != NULL)
 		sqlite3_db_release_memory(self->db);
@@ -1769,14 +1865,20 @@ fu_history_class_init(FuHistoryClass *klass)
 static void
 fu_history_init(FuHistory *self)
 {
+	self->stmts = g_hash_table_new_full(g_str_hash,
+					    g_str_equal,
+					    g_free,
+					    (GDestroyNotify)sqlite3_finalize);
+	g_rec_mutex_init(&self->db_mutex);
 }
 
 static void
 fu_history_finalize(GObject *object)
 {
 	FuHistory *self = FU_HISTORY(object);
-	if (self->db != NULL)
-		sqlite3_close(self->db);
+	fu_history_close(self);
+	g_hash_table_unref(self->stmts);
+	g_rec_mutex_clear(&self->db_mutex);
 	G_OBJECT_CLASS(fu_history_parent_class)->finalize(object);
 }
 
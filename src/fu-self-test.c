@@ -12,6 +12,7 @@
 #include <glib/gstdio.h>
 #include <string.h>
 
+#include "fwupd-enums-private.h"
 #include "fwupd-remote-private.h"
 
 #include "../plugins/test/fu-test-plugin.h"
@@ -23,11 +24,13 @@
 #include "fu-context-private.h"
 #include "fu-device-list.h"
 #include "fu-device-private.h"
+#include "fu-device-signal-list.h"
 #include "fu-drm-device-private.h"
 #include "fu-efivars-private.h"
 #include "fu-engine-config.h"
 #include "fu-engine-helper.h"
 #include "fu-engine-requirements.h"
+#include "fu-engine-silo.h"
 #include "fu-engine.h"
 #include "fu-history.h"
 #include "fu-idle.h"
@@ -37,12 +40,16 @@
 #include "fu-remote-list.h"
 #include "fu-remote.h"
 #include "fu-security-attrs-private.h"
+#include "fu-udev-device-private.h"
 #include "fu-usb-backend.h"
 #include "fu-util-common.h"
 
 #ifdef HAVE_GIO_UNIX
 #include "fu-unix-seekable-input-stream.h"
 #endif
+#ifdef HAVE_UDEV
+#include "fu-udev-backend.h"
+#endif
 
 #pragma GCC diagnostic ignored "-Wanalyzer-null-argument"
 
@@ -127,6 +134,148 @@ fu_test_free(FuTest *self)
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(FuTest, fu_test_free)
 #pragma clang diagnostic pop
 
+typedef struct {
+	guint cnt;
+	GVariant *parameters;
+} FuDeviceSignalListHelper;
+
+static void
+fu_device_signal_list_changed_cb(FuDeviceSignalList *device_signals,
+				 FuDevice *device,
+				 GVariant *val,
+				 GVariant *parameters,
+				 FuDeviceSignalListHelper *helper)
+{
+	if (helper->parameters != NULL)
+		g_variant_unref(helper->parameters);
+	helper->parameters = g_variant_ref(parameters);
+	helper->cnt++;
+}
+
+static void
+fu_device_signal_list_diff_func(void)
+{
+	FuDeviceSignalListHelper helper = {0};
+	const gchar *device_id = NULL;
+	const gchar *tmp = NULL;
+	g_autofree const gchar **invalidated = NULL;
+	g_autoptr(FuDevice) device = fu_device_new(NULL);
+	g_autoptr(FuDeviceSignalList) device_signals = fu_device_signal_list_new();
+	g_autoptr(GVariant) changed = NULL;
+	g_autoptr(GVariant) val = NULL;
+
+	g_signal_connect(device_signals,
+			 "changed",
+			 G_CALLBACK(fu_device_signal_list_changed_cb),
+			 &helper);
+	fu_device_set_id(device, "dev");
+	fwupd_device_set_vendor(FWUPD_DEVICE(device), "ACME");
+	fwupd_device_set_summary(FWUPD_DEVICE(device), "Bar");
+	val = fu_device_signal_list_added(device_signals, device);
+	g_assert_nonnull(val);
+	g_assert_true(g_variant_lookup(val, FWUPD_RESULT_KEY_VENDOR, "&s", &tmp));
+	g_assert_cmpstr(tmp, ==, "ACME");
+
+	/* nothing changed since it was added */
+	fu_device_signal_list_changed(device_signals, device);
+	g_assert_cmpint(helper.cnt, ==, 0);
+
+	/* one changed value, one new value and one removed value */
+	fwupd_device_set_vendor(FWUPD_DEVICE(device), "Other");
+	fwupd_device_set_summary(FWUPD_DEVICE(device), NULL);
+	fwupd_device_set_branch(FWUPD_DEVICE(device), "community");
+	fu_device_signal_list_changed(device_signals, device);
+	g_assert_cmpint(helper.cnt, ==, 1);
+	g_variant_get(helper.parameters, "(&s@a{sv}^a&s)", &device_id, &changed, &invalidated);
+	g_assert_cmpstr(device_id, ==, fu_device_get_id(device));
+	g_assert_true(g_variant_lookup(changed, FWUPD_RESULT_KEY_VENDOR, "&s", &tmp));
+	g_assert_cmpstr(tmp, ==, "Other");
+	g_assert_true(g_variant_lookup(changed, FWUPD_RESULT_KEY_BRANCH, "&s", &tmp));
+	g_assert_cmpstr(tmp, ==, "community");
+	g_assert_false(g_variant_lookup(changed, FWUPD_RESULT_KEY_DEVICE_ID, "&s", &tmp));
+	g_assert_cmpint(g_strv_length((gchar **)invalidated), ==, 1);
+	g_assert_cmpstr(invalidated[0], ==, FWUPD_RESULT_KEY_SUMMARY);
+
+	/* compared against what was last sent */
+	fu_device_signal_list_changed(device_signals, device);
+	g_assert_cmpint(helper.cnt, ==, 1);
+	g_variant_unref(helper.parameters);
+}
+
+static void
+fu_device_signal_list_cache_func(void)
+{
+	g_autoptr(FuDevice) device = fu_device_new(NULL);
+	g_autoptr(FuDevice) device_new = fu_device_new(NULL);
+	g_autoptr(FuDeviceSignalList) device_signals = fu_device_signal_list_new();
+	g_autoptr(GVariant) val1 = NULL;
+	g_autoptr(GVariant) val2 = NULL;
+	g_autoptr(GVariant) val3 = NULL;
+	g_autoptr(GVariant) val4 = NULL;
+
+	/* the device is only serialized again once it has changed */
+	fu_device_set_id(device, "dev");
+	val1 = fu_device_signal_list_added(device_signals, device);
+	val2 = fu_device_signal_list_get_variant(device_signals, device);
+	g_assert_true(val1 == val2);
+	fwupd_device_set_vendor(FWUPD_DEVICE(device), "ACME");
+	val3 = fu_device_signal_list_get_variant(device_signals, device);
+	g_assert_true(val3 != val2);
+
+	/* a replugged device is never the same */
+	fu_device_set_id(device_new, "dev");
+	fwupd_device_set_vendor(FWUPD_DEVICE(device_new), "ACME");
+	val4 = fu_device_signal_list_get_variant(device_signals, device_new);
+	g_assert_true(val4 != val3);
+}
+
+static void
+fu_device_signal_list_coalesce_func(void)
+{
+	FuDeviceSignalListHelper helper = {0};
+	const gchar *tmp = NULL;
+	g_autoptr(FuDevice) device = fu_device_new(NULL);
+	g_autoptr(FuDeviceSignalList) device_signals = fu_device_signal_list_new();
+	g_autoptr(GVariant) changed = NULL;
+	g_autoptr(GVariant) val = NULL;
+
+	g_signal_connect(device_signals,
+			 "changed",
+			 G_CALLBACK(fu_device_signal_list_changed_cb),
+			 &helper);
+	fu_device_signal_list_set_delay(device_signals, 50);
+	fu_device_set_id(device, "dev");
+	val = fu_device_signal_list_added(device_signals, device);
+
+	/* the first change is sent straight away */
+	fwupd_device_set_vendor(FWUPD_DEVICE(device), "A");
+	fu_device_signal_list_changed(device_signals, device);
+	g_assert_cmpint(helper.cnt, ==, 1);
+
+	/* changes within the delay are coalesced into one signal with the latest values */
+	fwupd_device_set_vendor(FWUPD_DEVICE(device), "B");
+	fu_device_signal_list_changed(device_signals, device);
+	fwupd_device_set_vendor(FWUPD_DEVICE(device), "C");
+	fu_device_signal_list_changed(device_signals, device);
+	g_assert_cmpint(helper.cnt, ==, 1);
+	while (helper.cnt == 1)
+		g_main_context_iteration(NULL, TRUE);
+	g_assert_cmpint(helper.cnt, ==, 2);
+	g_variant_get(helper.parameters, "(&s@a{sv}as)", NULL, &changed, NULL);
+	g_assert_true(g_variant_lookup(changed, FWUPD_RESULT_KEY_VENDOR, "&s", &tmp));
+	g_assert_cmpstr(tmp, ==, "C");
+
+	/* a pending change is never sent after the device is removed */
+	fwupd_device_set_vendor(FWUPD_DEVICE(device), "D");
+	fu_device_signal_list_changed(device_signals, device);
+	fu_device_signal_list_removed(device_signals, device);
+	g_usleep(100 * 1000);
+	while (g_main_context_pending(NULL))
+		g_main_context_iteration(NULL, FALSE);
+	g_assert_cmpint(helper.cnt, ==, 2);
+	g_variant_unref(helper.parameters);
+}
+
 static void
 fu_client_list_func(void)
 {
@@ -2443,6 +2592,286 @@ fu_engine_device_equivalent_func(gconstpointer user_data)
 	g_assert_true(fu_device_has_problem(device_worst, FWUPD_DEVICE_PROBLEM_LOWER_PRIORITY));
 }
 
+static void
+fu_engine_silo_func(gconstpointer user_data)
+{
+	gboolean ret;
+	g_autoptr(FuEngineSilo) engine_silo = NULL;
+	g_autoptr(FuEngineSilo) engine_silo_empty = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(XbBuilder) builder = xb_builder_new();
+	g_autoptr(XbBuilderSource) source = xb_builder_source_new();
+	g_autoptr(XbSilo) silo = NULL;
+	g_autoptr(XbSilo) silo_empty = xb_silo_new();
+	const gchar *xml =
+	    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+	    "<components version=\"0.9\">\n"
+	    "  <component type=\"firmware\">\n"
+	    "    <id>com.acme.one.firmware</id>\n"
+	    "    <provides>\n"
+	    "      <firmware type=\"flashed\">2d47f29b-83a2-4f31-a2e8-63474f4d4c2e</firmware>\n"
+	    "      <firmware type=\"flashed\">1ff60ab2-3905-06a1-b476-0371f00c9e9b</firmware>\n"
+	    "    </provides>\n"
+	    "  </component>\n"
+	    "  <component type=\"firmware\">\n"
+	    "    <id>com.acme.two.firmware</id>\n"
+	    "    <provides>\n"
+	    "      <firmware type=\"flashed\">2d47f29b-83a2-4f31-a2e8-63474f4d4c2e</firmware>\n"
+	    "      <firmware type=\"runtime\">b585990a-003e-5270-89d5-3705a17f9a43</firmware>\n"
+	    "    </provides>\n"
+	    "  </component>\n"
+	    "</components>\n";
+
+	ret = xb_builder_source_load_xml(source, xml, XB_BUILDER_SOURCE_FLAG_NONE, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	xb_builder_import_source(builder, source);
+	silo = xb_builder_compile(builder, XB_BUILDER_COMPILE_FLAG_NONE, NULL, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(silo);
+
+	/* only the flashed GUIDs are tracked, and only once */
+	engine_silo = fu_engine_silo_new("lvfs", silo, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(engine_silo);
+	g_assert_cmpstr(fu_engine_silo_get_id(engine_silo), ==, "lvfs");
+	g_assert_cmpint(fu_engine_silo_get_guids(engine_silo)->len, ==, 2);
+	g_assert_true(fu_engine_silo_has_guid(engine_silo, "2d47f29b-83a2-4f31-a2e8-63474f4d4c2e"));
+	g_assert_true(fu_engine_silo_has_guid(engine_silo, "1ff60ab2-3905-06a1-b476-0371f00c9e9b"));
+	g_assert_false(
+	    fu_engine_silo_has_guid(engine_silo, "b585990a-003e-5270-89d5-3705a17f9a43"));
+	g_assert_nonnull(fu_engine_silo_get_query_component_by_guid(engine_silo));
+	g_assert_cmpint(fu_engine_silo_get_search_queries(engine_silo)->len, >, 0);
+
+	/* no components, so nothing to query */
+	engine_silo_empty = fu_engine_silo_new("local", silo_empty, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(engine_silo_empty);
+	g_assert_cmpint(fu_engine_silo_get_guids(engine_silo_empty)->len, ==, 0);
+	g_assert_null(fu_engine_silo_get_query_component_by_guid(engine_silo_empty));
+	g_assert_cmpint(fu_engine_silo_get_search_queries(engine_silo_empty)->len, ==, 0);
+}
+
+static void
+fu_engine_silo_incremental_write(const gchar *filename, const gchar *guid, const gchar *version)
+{
+	gboolean ret;
+	g_autofree gchar *xml = NULL;
+	g_autoptr(GError) error = NULL;
+
+	xml = g_strdup_printf("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+			      "<components version=\"0.9\">\n"
+			      "  <component type=\"firmware\">\n"
+			      "    <id>com.acme.%s.firmware</id>\n"
+			      "    <provides>\n"
+			      "      <firmware type=\"flashed\">%s</firmware>\n"
+			      "    </provides>\n"
+			      "    <releases>\n"
+			      "      <release version=\"%s\"/>\n"
+			      "    </releases>\n"
+			      "  </component>\n"
+			      "</components>\n",
+			      guid,
+			      guid,
+			      version);
+	ret = g_file_set_contents(filename, xml, -1, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+}
+
+static void
+fu_engine_silo_incremental_func(gconstpointer user_data)
+{
+	FuTest *self = (FuTest *)user_data;
+	gboolean ret;
+	guint md_refresh_cnt;
+	const gchar *guid1 = "2d47f29b-83a2-4f31-a2e8-63474f4d4c2e";
+	const gchar *guid2 = "1ff60ab2-3905-06a1-b476-0371f00c9e9b";
+	const gchar *filename1 = "/tmp/fwupd-self-test/incremental1.xml";
+	const gchar *filename2 = "/tmp/fwupd-self-test/incremental2.xml";
+	g_autofree gchar *cachedir = fu_path_from_kind(FU_PATH_KIND_CACHEDIR_PKG);
+	g_autofree gchar *xmlb_legacy = g_build_filename(cachedir, "metadata.xmlb", NULL);
+	g_autofree gchar *xmlb_stale = g_build_filename(cachedir, "metadata-stale.xmlb", NULL);
+	g_autofree gchar *xmlb2 = g_build_filename(cachedir, "metadata-incremental2.xmlb", NULL);
+	g_autoptr(FuDevice) device1 = fu_device_new(self->ctx);
+	g_autoptr(FuDevice) device2 = fu_device_new(self->ctx);
+	g_autoptr(FuEngine) engine = fu_engine_new(self->ctx);
+	g_autoptr(FuEngineSilo) engine_silo1 = NULL;
+	g_autoptr(FuEngineSilo) engine_silo2 = NULL;
+	g_autoptr(FuProgress) progress = fu_progress_new(G_STRLOC);
+	g_autoptr(FwupdRemote) remote1 = fwupd_remote_new();
+	g_autoptr(FwupdRemote) remote2 = fwupd_remote_new();
+	g_autoptr(GError) error = NULL;
+
+	/* two remotes, each providing a different GUID */
+	g_mkdir_with_parents("/tmp/fwupd-self-test", 0700);
+	fu_engine_silo_incremental_write(filename1, guid1, "1.2.3");
+	fu_engine_silo_incremental_write(filename2, guid2, "1.2.3");
+	fwupd_remote_set_id(remote1, "incremental1");
+	fwupd_remote_set_kind(remote1, FWUPD_REMOTE_KIND_DOWNLOAD);
+	fwupd_remote_set_filename_cache(remote1, filename1);
+	fwupd_remote_add_flag(remote1, FWUPD_REMOTE_FLAG_ENABLED);
+	fu_engine_add_remote(engine, remote1);
+	fwupd_remote_set_id(remote2, "incremental2");
+	fwupd_remote_set_kind(remote2, FWUPD_REMOTE_KIND_DOWNLOAD);
+	fwupd_remote_set_filename_cache(remote2, filename2);
+	fwupd_remote_add_flag(remote2, FWUPD_REMOTE_FLAG_ENABLED);
+	fu_engine_add_remote(engine, remote2);
+	ret = fu_engine_load(engine, FU_ENGINE_LOAD_FLAG_NO_CACHE, progress, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	engine_silo1 = g_object_ref(fu_engine_get_silo_by_id(engine, "incremental1"));
+	engine_silo2 = g_object_ref(fu_engine_get_silo_by_id(engine, "incremental2"));
+	g_assert_true(fu_engine_silo_has_guid(engine_silo1, guid1));
+	g_assert_true(fu_engine_silo_has_guid(engine_silo2, guid2));
+
+	/* one device for each remote */
+	fu_device_set_id(device1, "device1");
+	fu_device_add_instance_id(device1, guid1);
+	fu_engine_add_device(engine, device1);
+	fu_device_set_id(device2, "device2");
+	fu_device_add_instance_id(device2, guid2);
+	fu_engine_add_device(engine, device2);
+
+	/* nothing changed, so nothing is rebuilt or refreshed */
+	md_refresh_cnt = fu_engine_get_md_refresh_cnt(engine);
+	ret = fu_engine_update_metadata_store(engine, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	g_assert_true(fu_engine_get_silo_by_id(engine, "incremental1") == engine_silo1);
+	g_assert_true(fu_engine_get_silo_by_id(engine, "incremental2") == engine_silo2);
+	g_assert_cmpint(fu_engine_get_md_refresh_cnt(engine), ==, md_refresh_cnt);
+
+	/* only the updated remote is rebuilt, and only its device is refreshed */
+	g_mkdir_with_parents(cachedir, 0700);
+	ret = g_file_set_contents(xmlb_legacy, "", -1, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	ret = g_file_set_contents(xmlb_stale, "", -1, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	fu_engine_silo_incremental_write(filename2, guid2, "1.2.4");
+	ret = fu_engine_update_metadata_store(engine, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	g_assert_true(fu_engine_get_silo_by_id(engine, "incremental1") == engine_silo1);
+	g_assert_true(fu_engine_get_silo_by_id(engine, "incremental2") != engine_silo2);
+	g_assert_cmpint(fu_engine_get_md_refresh_cnt(engine), ==, md_refresh_cnt + 1);
+
+	/* the legacy silo and the silos of remotes that no longer exist are deleted */
+	g_assert_true(g_file_test(xmlb2, G_FILE_TEST_EXISTS));
+	g_assert_false(g_file_test(xmlb_legacy, G_FILE_TEST_EXISTS));
+	g_assert_false(g_file_test(xmlb_stale, G_FILE_TEST_EXISTS));
+}
+
+static guint
+fu_engine_metainfo_cache_count(const gchar *cachedir)
+{
+	g_autoptr(GPtrArray) fns = fu_path_glob(cachedir, "*.xml", NULL);
+	return fns != NULL ? fns->len : 0;
+}
+
+static void
+fu_engine_metainfo_cache_func(gconstpointer user_data)
+{
+	FuTest *self = (FuTest *)user_data;
+	gboolean ret;
+	const gchar *basenames[] = {"hwid-1.2.3.cab", "noreqs-1.2.3.cab"};
+	const gchar *dirname = "/tmp/fwupd-self-test/directory-remote";
+	g_autofree gchar *cachedir = NULL;
+	g_autofree gchar *fn0 = g_build_filename(dirname, basenames[0], NULL);
+	g_autofree gchar *fn1 = g_build_filename(dirname, basenames[1], NULL);
+	g_autoptr(FuEngine) engine = fu_engine_new(self->ctx);
+	g_autoptr(FuEngine) engine_readonly = fu_engine_new(self->ctx);
+	g_autoptr(FuProgress) progress = fu_progress_new(G_STRLOC);
+	g_autoptr(FwupdRemote) remote = fwupd_remote_new();
+	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(GError) error = NULL;
+
+	/* start without any cached metainfo */
+	cachedir = fu_path_build(FU_PATH_KIND_CACHEDIR_PKG, "metainfo", "directory-test", NULL);
+	if (g_file_test(cachedir, G_FILE_TEST_EXISTS)) {
+		ret = fu_path_rmtree(cachedir, &error);
+		g_assert_no_error(error);
+		g_assert_true(ret);
+	}
+
+	/* a directory remote with two cabinet archives */
+	for (guint i = 0; i < G_N_ELEMENTS(basenames); i++) {
+		g_autofree gchar *fn_src = NULL;
+		g_autofree gchar *fn_dst = g_build_filename(dirname, basenames[i], NULL);
+		g_autoptr(GBytes) blob_tmp = NULL;
+
+		fn_src = g_test_build_filename(G_TEST_BUILT,
+					       "tests",
+					       "missing-hwid",
+					       basenames[i],
+					       NULL);
+		blob_tmp = fu_bytes_get_contents(fn_src, &error);
+		g_assert_no_error(error);
+		g_assert_nonnull(blob_tmp);
+		ret = fu_path_mkdir_parent(fn_dst, &error);
+		g_assert_no_error(error);
+		g_assert_true(ret);
+		ret = fu_bytes_set_contents(fn_dst, blob_tmp, &error);
+		g_assert_no_error(error);
+		g_assert_true(ret);
+	}
+	fwupd_remote_set_id(remote, "directory-test");
+	fwupd_remote_set_kind(remote, FWUPD_REMOTE_KIND_DIRECTORY);
+	fwupd_remote_set_filename_cache(remote, dirname);
+	fwupd_remote_add_flag(remote, FWUPD_REMOTE_FLAG_ENABLED);
+
+	/* nothing is written to the cache when loading read-only */
+	fu_engine_add_remote(engine_readonly, remote);
+	ret = fu_engine_load(engine_readonly,
+			     FU_ENGINE_LOAD_FLAG_READONLY | FU_ENGINE_LOAD_FLAG_NO_CACHE,
+			     progress,
+			     &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	g_assert_cmpint(fu_engine_get_metainfo_convert_cnt(engine_readonly), ==, 2);
+	g_assert_false(g_file_test(cachedir, G_FILE_TEST_EXISTS));
+	ret = fu_engine_update_metadata_store(engine_readonly, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	g_assert_cmpint(fu_engine_get_metainfo_convert_cnt(engine_readonly), ==, 4);
+	g_assert_false(g_file_test(cachedir, G_FILE_TEST_EXISTS));
+
+	/* each archive is converted once */
+	fu_engine_add_remote(engine, remote);
+	ret = fu_engine_load(engine, FU_ENGINE_LOAD_FLAG_NONE, progress, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	g_assert_cmpint(fu_engine_get_metainfo_convert_cnt(engine), ==, 2);
+	g_assert_cmpint(fu_engine_metainfo_cache_count(cachedir), ==, 2);
+	ret = fu_engine_update_metadata_store(engine, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	g_assert_cmpint(fu_engine_get_metainfo_convert_cnt(engine), ==, 2);
+
+	/* only the archive that was replaced is converted again */
+	blob = fu_bytes_get_contents(fn0, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(blob);
+	ret = fu_bytes_set_contents(fn0, blob, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	ret = fu_engine_update_metadata_store(engine, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	g_assert_cmpint(fu_engine_get_metainfo_convert_cnt(engine), ==, 3);
+	g_assert_cmpint(fu_engine_metainfo_cache_count(cachedir), ==, 2);
+
+	/* the cached metainfo of a deleted archive is pruned */
+	g_assert_cmpint(g_unlink(fn1), ==, 0);
+	ret = fu_engine_update_metadata_store(engine, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	g_assert_cmpint(fu_engine_get_metainfo_convert_cnt(engine), ==, 3);
+	g_assert_cmpint(fu_engine_metainfo_cache_count(cachedir), ==, 1);
+}
+
 static void
 fu_engine_device_md_set_flags_func(gconstpointer user_data)
 {
@@ -2816,12 +3245,14 @@ fu_engine_downgrade_func(gconstpointer user_data)
 {
 	FuTest *self = (FuTest *)user_data;
 	FwupdRelease *rel;
+	GPtrArray *releases_all;
 	gboolean ret;
 	g_autoptr(FuDevice) device = fu_device_new(self->ctx);
 	g_autoptr(FuEngine) engine = fu_engine_new(self->ctx);
 	g_autoptr(FuEngineRequest) request = fu_engine_request_new(NULL);
 	g_autoptr(FuProgress) progress = fu_progress_new(G_STRLOC);
 	g_autoptr(GError) error = NULL;
+	g_autoptr(GHashTable) upgrades = NULL;
 	g_autoptr(GPtrArray) devices = NULL;
 	g_autoptr(GPtrArray) devices_pre = NULL;
 	g_autoptr(GPtrArray) releases_dg = NULL;
@@ -2829,6 +3260,9 @@ fu_engine_downgrade_func(gconstpointer user_data)
 	g_autoptr(GPtrArray) releases_up = NULL;
 	g_autoptr(GPtrArray) releases_up2 = NULL;
 	g_autoptr(GPtrArray) remotes = NULL;
+	g_autoptr(GVariant) releases_variant = NULL;
+	g_autoptr(GVariant) upgrades_dict = NULL;
+	g_autoptr(GVariant) upgrades_variant = NULL;
 	g_autoptr(XbSilo) silo_empty = xb_silo_new();
 
 	/* ensure empty tree */
@@ -2988,6 +3422,46 @@ fu_engine_downgrade_func(gconstpointer user_data)
 	rel = FWUPD_RELEASE(g_ptr_array_index(releases_up, 1));
 	g_assert_cmpstr(fwupd_release_get_version(rel), ==, "1.2.4");
 
+	/* upgrades for all devices at once */
+	upgrades = fu_engine_get_upgrades_all(engine,
+					      request,
+					      FWUPD_RELEASE_FLAG_NONE,
+					      FWUPD_RELEASE_FLAG_NONE);
+	g_assert_cmpint(g_hash_table_size(upgrades), ==, 1);
+	releases_all = g_hash_table_lookup(upgrades, fu_device_get_id(device));
+	g_assert_nonnull(releases_all);
+	g_assert_cmpint(releases_all->len, ==, 2);
+
+	/* as sent by the daemon, in the format the client parses */
+	upgrades_variant = g_variant_ref_sink(fu_engine_upgrades_to_variant(upgrades));
+	g_assert_cmpstr(g_variant_get_type_string(upgrades_variant), ==, "(a{saa{sv}})");
+	upgrades_dict = g_variant_get_child_value(upgrades_variant, 0);
+	g_assert_cmpint(g_variant_n_children(upgrades_dict), ==, 1);
+	releases_variant = g_variant_lookup_value(upgrades_dict,
+						  fu_device_get_id(device),
+						  G_VARIANT_TYPE("aa{sv}"));
+	g_assert_nonnull(releases_variant);
+	g_assert_cmpint(g_variant_n_children(releases_variant), ==, releases_all->len);
+	for (guint i = 0; i < releases_all->len; i++) {
+		FwupdRelease *rel_all = g_ptr_array_index(releases_all, i);
+		g_autoptr(FwupdRelease) rel_client = fwupd_release_new();
+		g_autoptr(GVariant) rel_variant = g_variant_get_child_value(releases_variant, i);
+		ret = fwupd_codec_from_variant(FWUPD_CODEC(rel_client), rel_variant, &error);
+		g_assert_no_error(error);
+		g_assert_true(ret);
+		g_assert_cmpstr(fwupd_release_get_version(rel_client),
+				==,
+				fwupd_release_get_version(rel_all));
+	}
+	g_clear_pointer(&upgrades, g_hash_table_unref);
+
+	/* all the releases are filtered out */
+	upgrades = fu_engine_get_upgrades_all(engine,
+					      request,
+					      FWUPD_RELEASE_FLAG_NONE,
+					      FWUPD_RELEASE_FLAG_IS_UPGRADE);
+	g_assert_cmpint(g_hash_table_size(upgrades), ==, 0);
+
 	/* downgrades */
 	releases_dg = fu_engine_get_downgrades(engine, request, fu_device_get_id(device), &error);
 	g_assert_no_error(error);
@@ -3003,6 +3477,146 @@ fu_engine_downgrade_func(gconstpointer user_data)
 	g_assert_null(releases_up2);
 }
 
+static void
+fu_engine_releases_cache_func(gconstpointer user_data)
+{
+	FuTest *self = (FuTest *)user_data;
+	gboolean ret;
+	g_autoptr(FuEngine) engine = fu_engine_new(self->ctx);
+	g_autoptr(FuEngineRequest) request = fu_engine_request_new(NULL);
+	g_autoptr(FuProgress) progress = fu_progress_new(G_STRLOC);
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) devices = g_ptr_array_new_with_free_func(g_object_unref);
+	g_autoptr(GPtrArray) releases = NULL;
+	g_autoptr(GString) xml = g_string_new("<components>");
+	g_autoptr(GTimer) timer = g_timer_new();
+	g_autoptr(XbBuilder) builder = xb_builder_new();
+	g_autoptr(XbBuilderSource) source = xb_builder_source_new();
+	g_autoptr(XbSilo) silo = NULL;
+
+	/* load engine to get FuConfig set up */
+	ret = fu_engine_load(engine, FU_ENGINE_LOAD_FLAG_NO_CACHE, progress, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+
+	/* roughly the number of components in the LVFS metadata */
+	for (guint i = 0; i < 5000; i++) {
+		g_autofree gchar *instance_id = g_strdup_printf("ACME\\DEV_%04u", i);
+		g_autofree gchar *guid = fwupd_guid_hash_string(instance_id);
+		g_string_append_printf(xml,
+				       "<component type=\"firmware\">"
+				       "<id>com.acme.dev%04u.firmware</id>"
+				       "<provides>"
+				       "<firmware type=\"flashed\">%s</firmware>"
+				       "</provides>"
+				       "<releases>",
+				       i,
+				       guid);
+		for (guint j = 0; j < 5; j++) {
+			g_string_append_printf(
+			    xml,
+			    "<release version=\"1.2.%u\">"
+			    "<location>https://test.org/%04u-%u.cab</location>"
+			    "<checksum target=\"container\" type=\"sha1\">%04u%036u</checksum>"
+			    "</release>",
+			    5 - j,
+			    i,
+			    j,
+			    i,
+			    j);
+		}
+		g_string_append(xml, "</releases></component>");
+	}
+	g_string_append(xml, "</components>");
+	ret = xb_builder_source_load_xml(source, xml->str, XB_BUILDER_SOURCE_FLAG_NONE, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	xb_builder_import_source(builder, source);
+	silo = xb_builder_compile(builder, XB_BUILDER_COMPILE_FLAG_NONE, NULL, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(silo);
+	fu_engine_set_silo(engine, silo);
+
+	/* a host with 50 devices that all have metadata */
+	for (guint i = 0; i < 50; i++) {
+		g_autofree gchar *device_id = g_strdup_printf("dev%02u", i);
+		g_autofree gchar *instance_id = g_strdup_printf("ACME\\DEV_%04u", i * 100);
+		g_autoptr(FuDevice) device = fu_device_new(self->ctx);
+		fu_device_set_id(device, device_id);
+		fu_device_set_version_format(device, FWUPD_VERSION_FORMAT_TRIPLET);
+		fu_device_set_version(device, "1.2.3");
+		fu_device_build_vendor_id_u16(device, "USB", 0xFFFF);
+		fu_device_add_protocol(device, "com.acme");
+		fu_device_add_instance_id(device, instance_id);
+		fu_device_add_flag(device, FWUPD_DEVICE_FLAG_UPDATABLE);
+		fu_device_add_flag(device, FWUPD_DEVICE_FLAG_UNSIGNED_PAYLOAD);
+		fu_engine_add_device(engine, device);
+		g_ptr_array_add(devices, g_steal_pointer(&device));
+	}
+
+	/* first run resolves every release, the second is served from the cache */
+	for (guint n = 0; n < 2; n++) {
+		guint hits = fu_engine_get_releases_cache_hits(engine);
+		g_timer_reset(timer);
+		for (guint i = 0; i < devices->len; i++) {
+			FuDevice *device = g_ptr_array_index(devices, i);
+			g_autoptr(GPtrArray) releases_up = NULL;
+
+			releases_up = fu_engine_get_upgrades(engine,
+							     request,
+							     fu_device_get_id(device),
+							     &error);
+			g_assert_no_error(error);
+			g_assert_nonnull(releases_up);
+			g_assert_cmpint(releases_up->len, ==, 2);
+		}
+		g_print("%s=%.3fms ",
+			n == 0 ? "uncached" : "cached",
+			g_timer_elapsed(timer, NULL) * 1000.f);
+		g_assert_cmpint(fu_engine_get_releases_cache_hits(engine) - hits, ==, n * 50);
+	}
+
+	/* a different version is resolved again */
+	fu_device_set_version(g_ptr_array_index(devices, 0), "1.2.4");
+	releases = fu_engine_get_releases(engine,
+					  request,
+					  fu_device_get_id(g_ptr_array_index(devices, 0)),
+					  &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(releases);
+	g_assert_cmpint(releases->len, ==, 5);
+	g_assert_cmpint(fu_engine_get_releases_cache_hits(engine), ==, 50);
+
+	/* requirements can depend on other devices, so any change resolves everything again */
+	for (guint n = 0; n < 2; n++) {
+		FuDevice *device = g_ptr_array_index(devices, 1);
+		g_autoptr(GPtrArray) releases_tmp = NULL;
+		releases_tmp =
+		    fu_engine_get_releases(engine, request, fu_device_get_id(device), &error);
+		g_assert_no_error(error);
+		g_assert_nonnull(releases_tmp);
+	}
+	g_assert_cmpint(fu_engine_get_releases_cache_hits(engine), ==, 51);
+	fu_device_set_version(g_ptr_array_index(devices, 2), "1.2.4");
+	g_clear_pointer(&releases, g_ptr_array_unref);
+	releases = fu_engine_get_releases(engine,
+					  request,
+					  fu_device_get_id(g_ptr_array_index(devices, 1)),
+					  &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(releases);
+	g_assert_cmpint(fu_engine_get_releases_cache_hits(engine), ==, 51);
+	fu_device_add_flag(g_ptr_array_index(devices, 2), FWUPD_DEVICE_FLAG_NEEDS_REBOOT);
+	g_clear_pointer(&releases, g_ptr_array_unref);
+	releases = fu_engine_get_releases(engine,
+					  request,
+					  fu_device_get_id(g_ptr_array_index(devices, 1)),
+					  &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(releases);
+	g_assert_cmpint(fu_engine_get_releases_cache_hits(engine), ==, 51);
+}
+
 static void
 fu_engine_md_verfmt_func(gconstpointer user_data)
 {
@@ -3700,6 +4314,139 @@ fu_engine_multiple_rels_func(gconstpointer user_data)
 	g_assert_true(ret);
 }
 
+static void
+fu_engine_install_threads_func(gconstpointer user_data)
+{
+	FuTest *self = (FuTest *)user_data;
+	gboolean ret;
+	g_autofree gchar *filename = NULL;
+	g_autoptr(FuCabinet) cabinet = NULL;
+	g_autoptr(FuEngine) engine = fu_engine_new(self->ctx);
+	g_autoptr(FuPlugin) plugin = fu_plugin_new_from_gtype(fu_test_plugin_get_type(), self->ctx);
+	g_autoptr(FuProgress) progress = fu_progress_new(G_STRLOC);
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GInputStream) stream = NULL;
+	g_autoptr(GPtrArray) devices =
+	    g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
+	g_autoptr(GPtrArray) releases =
+	    g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
+	g_autoptr(XbNode) component = NULL;
+	g_autoptr(XbSilo) silo_empty = xb_silo_new();
+	g_autoptr(FuEngineRequest) request = fu_engine_request_new(NULL);
+
+#ifndef HAVE_LIBARCHIVE
+	g_test_skip("no libarchive support");
+	return;
+#endif
+
+	/* ensure empty tree */
+	fu_self_test_mkroot();
+
+	/* no metadata in daemon */
+	fu_engine_set_silo(engine, silo_empty);
+
+	/* set up dummy plugin */
+	ret = fu_plugin_reset_config_values(plugin, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	ret = fu_plugin_set_config_value(plugin, "WriteDelay", "50", &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	fu_engine_add_plugin(engine, plugin);
+
+	/* update independent devices at the same time */
+	fu_config_set_default(FU_CONFIG(fu_engine_get_config(engine)),
+			      "fwupd",
+			      "InstallThreads",
+			      "4");
+	ret = fu_engine_load(engine, FU_ENGINE_LOAD_FLAG_NO_CACHE, progress, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+
+	filename = g_test_build_filename(G_TEST_BUILT,
+					 "tests",
+					 "multiple-rels",
+					 "multiple-rels-1.2.4.cab",
+					 NULL);
+	stream = fu_input_stream_from_path(filename, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(stream);
+	cabinet = fu_engine_build_cabinet_from_stream(engine, stream, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(cabinet);
+	component = fu_cabinet_get_component(cabinet, "com.hughski.test.firmware", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(component);
+
+	/* add some devices that do not share a parent */
+	for (guint i = 0; i < 3; i++) {
+		g_autofree gchar *id = g_strdup_printf("test_device%u", i);
+		g_autoptr(FuDevice) device = fu_device_new(self->ctx);
+		g_autoptr(FuRelease) release = fu_release_new();
+
+		fu_device_set_version_format(device, FWUPD_VERSION_FORMAT_TRIPLET);
+		fu_device_set_version(device, "1.2.2");
+		fu_device_set_id(device, id);
+		fu_device_build_vendor_id_u16(device, "USB", 0xFFFF);
+		fu_device_add_protocol(device, "com.acme");
+		fu_device_set_name(device, "Test Device");
+		fu_device_set_plugin(device, "test");
+		fu_device_add_instance_id(device, "12345678-1234-1234-1234-123456789012");
+		fu_device_add_flag(device, FWUPD_DEVICE_FLAG_UPDATABLE);
+		fu_device_add_flag(device, FWUPD_DEVICE_FLAG_UNSIGNED_PAYLOAD);
+		fu_device_set_metadata_integer(device, "nr-update", 0);
+		fu_engine_add_device(engine, device);
+		g_ptr_array_add(devices, g_object_ref(device));
+
+		fu_release_set_device(release, device);
+		ret = fu_release_load(release,
+				      cabinet,
+				      component,
+				      NULL,
+				      FWUPD_INSTALL_FLAG_NONE,
+				      &error);
+		g_assert_no_error(error);
+		g_assert_true(ret);
+		g_ptr_array_add(releases, g_steal_pointer(&release));
+	}
+
+	/* install them all */
+	ret = fu_engine_install_releases(engine,
+					 request,
+					 releases,
+					 cabinet,
+					 progress,
+					 FWUPD_INSTALL_FLAG_NONE,
+					 &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	g_assert_cmpint(fu_progress_get_percentage(progress), ==, 100);
+
+	/* check each device was only updated once */
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *device = g_ptr_array_index(devices, i);
+		g_assert_cmpint(fu_device_get_metadata_integer(device, "nr-update"), ==, 1);
+		g_assert_cmpstr(fu_device_get_version(device), !=, "1.2.2");
+	}
+
+	/* check each device was written while the others were also being written */
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *device = g_ptr_array_index(devices, i);
+		const gchar *start_str = fu_device_get_metadata(device, "write-start");
+		g_assert_nonnull(start_str);
+		for (guint j = 0; j < devices->len; j++) {
+			FuDevice *device_tmp = g_ptr_array_index(devices, j);
+			const gchar *end_str = fu_device_get_metadata(device_tmp, "write-end");
+			if (i == j)
+				continue;
+			g_assert_nonnull(end_str);
+			g_assert_cmpint(g_ascii_strtoll(start_str, NULL, 10),
+					<,
+					g_ascii_strtoll(end_str, NULL, 10));
+		}
+	}
+}
+
 static void
 fu_engine_history_inherit(gconstpointer user_data)
 {
@@ -4269,6 +5016,7 @@ typedef struct {
 	FuDevice *device_new;
 	FuDevice *device_old;
 	FuDeviceList *device_list;
+	gint64 added_usec;
 } FuDeviceListReplugHelper;
 
 static gboolean
@@ -4350,6 +5098,131 @@ fu_device_list_replug_auto_func(gconstpointer user_data)
 	g_assert_false(fu_device_has_flag(device1, FWUPD_DEVICE_FLAG_WAIT_FOR_REPLUG));
 }
 
+static gboolean
+fu_device_list_add_latency_cb(gpointer user_data)
+{
+	FuDeviceListReplugHelper *helper = (FuDeviceListReplugHelper *)user_data;
+	helper->added_usec = g_get_monotonic_time();
+	fu_device_list_add(helper->device_list, helper->device_new);
+	return G_SOURCE_REMOVE;
+}
+
+static gpointer
+fu_device_list_add_latency_thread_cb(gpointer user_data)
+{
+	g_usleep(50 * 1000);
+	fu_device_list_add_latency_cb(user_data);
+	return NULL;
+}
+
+static void
+fu_device_list_replug_latency_func(gconstpointer user_data)
+{
+	FuTest *self = (FuTest *)user_data;
+	gboolean ret;
+	gint64 latency_usec;
+	g_autoptr(FuDeviceList) device_list = fu_device_list_new();
+	FuDeviceListReplugHelper helper = {NULL};
+
+	helper.device_list = device_list;
+	for (guint i = 0; i < 2; i++) {
+		g_autoptr(FuDevice) device1 = fu_device_new(self->ctx);
+		g_autoptr(FuDevice) device2 = fu_device_new(self->ctx);
+		g_autoptr(GError) error = NULL;
+		g_autoptr(GThread) thread = NULL;
+
+		/* fake devices with the same connection */
+		fu_device_set_id(device1, "device1");
+		fu_device_set_physical_id(device1, "ID");
+		fu_device_set_plugin(device1, "self-test");
+		fu_device_set_remove_delay(device1, FU_DEVICE_REMOVE_DELAY_RE_ENUMERATE);
+		fu_device_set_id(device2, "device2");
+		fu_device_set_physical_id(device2, "ID");
+		fu_device_set_plugin(device2, "self-test");
+		fu_device_set_remove_delay(device2, FU_DEVICE_REMOVE_DELAY_RE_ENUMERATE);
+		fu_device_list_add(device_list, device1);
+
+		/* unplug, and replug from either the main context or another thread */
+		fu_device_add_flag(device1, FWUPD_DEVICE_FLAG_WAIT_FOR_REPLUG);
+		fu_device_list_remove(device_list, device1);
+		helper.device_new = device2;
+		helper.added_usec = 0;
+		if (i == 0) {
+			g_timeout_add(50, fu_device_list_add_latency_cb, &helper);
+		} else {
+			thread = g_thread_new("replug",
+					      fu_device_list_add_latency_thread_cb,
+					      &helper);
+		}
+		ret = fu_device_list_wait_for_replug(device_list, &error);
+		g_assert_no_error(error);
+		g_assert_true(ret);
+		latency_usec = g_get_monotonic_time() - helper.added_usec;
+		if (thread != NULL)
+			g_thread_join(g_steal_pointer(&thread));
+		g_assert_cmpint(helper.added_usec, >, 0);
+		g_assert_false(fu_device_has_flag(device1, FWUPD_DEVICE_FLAG_WAIT_FOR_REPLUG));
+		g_test_message("replug detected after %.2fms", (gdouble)latency_usec / 1000.f);
+		if (g_test_slow())
+			g_assert_cmpint(latency_usec, <, 100 * 1000);
+		fu_device_list_remove_all(device_list);
+	}
+}
+
+static gpointer
+fu_device_list_wait_for_replug_thread_cb(gpointer user_data)
+{
+	FuDeviceListReplugHelper *helper = (FuDeviceListReplugHelper *)user_data;
+	g_autoptr(GError) error = NULL;
+	gboolean ret;
+
+	ret = fu_device_list_wait_for_replug(helper->device_list, &error);
+	g_assert_no_error(error);
+	return GINT_TO_POINTER(ret);
+}
+
+static void
+fu_device_list_replug_cond_func(gconstpointer user_data)
+{
+	FuTest *self = (FuTest *)user_data;
+	gboolean ret;
+	gint64 elapsed_usec;
+	g_autoptr(FuDevice) device1 = fu_device_new(self->ctx);
+	g_autoptr(FuDevice) device2 = fu_device_new(self->ctx);
+	g_autoptr(FuDeviceList) device_list = fu_device_list_new();
+	g_autoptr(GThread) thread = NULL;
+	FuDeviceListReplugHelper helper = {NULL};
+
+	/* fake devices with the same connection */
+	fu_device_set_id(device1, "device1");
+	fu_device_set_physical_id(device1, "ID");
+	fu_device_set_plugin(device1, "self-test");
+	fu_device_set_remove_delay(device1, FU_DEVICE_REMOVE_DELAY_RE_ENUMERATE);
+	fu_device_set_id(device2, "device2");
+	fu_device_set_physical_id(device2, "ID");
+	fu_device_set_plugin(device2, "self-test");
+	fu_device_set_remove_delay(device2, FU_DEVICE_REMOVE_DELAY_RE_ENUMERATE);
+	fu_device_list_add(device_list, device1);
+	fu_device_add_flag(device1, FWUPD_DEVICE_FLAG_WAIT_FOR_REPLUG);
+	fu_device_list_remove(device_list, device1);
+
+	/* own the main context so the waiter has to block on the condition variable */
+	g_assert_true(g_main_context_acquire(NULL));
+	helper.device_list = device_list;
+	helper.added_usec = g_get_monotonic_time();
+	thread = g_thread_new("wait-for-replug", fu_device_list_wait_for_replug_thread_cb, &helper);
+	g_usleep(50 * 1000);
+	fu_device_list_add(device_list, device2);
+	ret = GPOINTER_TO_INT(g_thread_join(g_steal_pointer(&thread)));
+	g_main_context_release(NULL);
+	g_assert_true(ret);
+	g_assert_false(fu_device_has_flag(device1, FWUPD_DEVICE_FLAG_WAIT_FOR_REPLUG));
+
+	/* woken by the replug rather than by the remove delay expiring */
+	elapsed_usec = g_get_monotonic_time() - helper.added_usec;
+	g_assert_cmpint(elapsed_usec, <, (gint64)FU_DEVICE_REMOVE_DELAY_RE_ENUMERATE * 1000);
+}
+
 static void
 fu_device_list_replug_user_func(gconstpointer user_data)
 {
@@ -4777,6 +5650,66 @@ fu_device_list_equivalent_id_func(gconstpointer user_data)
 	g_assert_null(device4);
 }
 
+static void
+fu_device_list_index_func(gconstpointer user_data)
+{
+	FuTest *self = (FuTest *)user_data;
+	g_autoptr(FuDeviceList) device_list = fu_device_list_new();
+	g_autoptr(GError) error = NULL;
+
+	/* lots of devices so a linear scan would be noticeable */
+	for (guint i = 0; i < 500; i++) {
+		g_autoptr(FuDevice) device = fu_device_new(self->ctx);
+		g_autofree gchar *id = g_strdup_printf("device%u", i);
+		g_autofree gchar *instance_id = g_strdup_printf("USB\\VID_273F&PID_%04X", i);
+		fu_device_set_id(device, id);
+		fu_device_add_instance_id(device, instance_id);
+		fu_device_list_add(device_list, device);
+	}
+	for (guint i = 0; i < 500; i++) {
+		g_autofree gchar *instance_id = g_strdup_printf("USB\\VID_273F&PID_%04X", i);
+		g_autofree gchar *guid = fwupd_guid_hash_string(instance_id);
+		g_autoptr(FuDevice) device =
+		    fu_device_list_get_by_guid(device_list, guid, &error);
+		g_autoptr(FuDevice) device_iid = NULL;
+		g_assert_no_error(error);
+		g_assert_nonnull(device);
+
+		/* also by instance ID, as used by ProxyGuid in quirk files */
+		device_iid = fu_device_list_get_by_guid(device_list, instance_id, &error);
+		g_assert_no_error(error);
+		g_assert_true(device_iid == device);
+	}
+
+	/* GUIDs and IDs changed after the device was added are still found */
+	{
+		g_autoptr(FuDevice) device = fu_device_new(self->ctx);
+		g_autoptr(FuDevice) device2 = NULL;
+		g_autoptr(FuDevice) device3 = NULL;
+		g_autoptr(FuDevice) device4 = NULL;
+		g_autofree gchar *id_old = NULL;
+
+		fu_device_set_id(device, "late");
+		fu_device_list_add(device_list, device);
+		fu_device_add_instance_id(device, "LATE\\GUID");
+		fu_device_convert_instance_ids(device);
+		device2 = fu_device_list_get_by_guid(device_list,
+						     fu_device_get_guid_default(device),
+						     &error);
+		g_assert_no_error(error);
+		g_assert_true(device2 == device);
+
+		id_old = g_strdup(fu_device_get_id(device));
+		fu_device_set_id(device, "0123456789012345678901234567890123456789");
+		device3 = fu_device_list_get_by_id(device_list, "01234567", &error);
+		g_assert_no_error(error);
+		g_assert_true(device3 == device);
+		device4 = fu_device_list_get_by_id(device_list, id_old, &error);
+		g_assert_error(error, FWUPD_ERROR, FWUPD_ERROR_NOT_FOUND);
+		g_assert_null(device4);
+	}
+}
+
 static void
 fu_device_list_unconnected_no_delay_func(gconstpointer user_data)
 {
@@ -4964,6 +5897,70 @@ fu_plugin_list_depsolve_func(gconstpointer user_data)
 	g_assert_true(fu_plugin_has_flag(plugin, FWUPD_PLUGIN_FLAG_DISABLED));
 }
 
+static void
+fu_history_performance_func(gconstpointer user_data)
+{
+	FuTest *self = (FuTest *)user_data;
+	gboolean ret;
+	g_autofree gchar *dirname = NULL;
+	g_autofree gchar *filename = NULL;
+	g_autoptr(FuHistory) history = fu_history_new(self->ctx);
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) devices = NULL;
+	g_autoptr(GTimer) timer = g_timer_new();
+
+	/* delete the database */
+	dirname = fu_path_from_kind(FU_PATH_KIND_LOCALSTATEDIR_PKG);
+	if (!g_file_test(dirname, G_FILE_TEST_IS_DIR))
+		return;
+	filename = g_build_filename(dirname, "pending.db", NULL);
+	(void)g_unlink(filename);
+
+	/* years of history */
+	for (guint i = 0; i < 10000; i++) {
+		g_autofree gchar *device_id = g_strdup_printf("device-%05u", i);
+		g_autofree gchar *checksum = g_strdup_printf("%040x", i);
+		g_autoptr(FuDevice) device = fu_device_new(self->ctx);
+		g_autoptr(FuRelease) release = fu_release_new();
+
+		fu_device_set_id(device, device_id);
+		fu_device_set_name(device, "ColorHug");
+		fu_device_set_version_format(device, FWUPD_VERSION_FORMAT_TRIPLET);
+		fu_device_set_version(device, "3.0.1");
+		fu_device_set_created_usec(device, (1514338000ull + i) * G_USEC_PER_SEC);
+		fu_release_add_checksum(release, checksum);
+		fu_release_set_version(release, "3.0.2");
+		ret = fu_history_add_device(history, device, release, &error);
+		g_assert_no_error(error);
+		g_assert_true(ret);
+	}
+	g_print("add=%.3fms ", g_timer_elapsed(timer, NULL) * 1000.f);
+
+	/* lookup some devices */
+	g_timer_reset(timer);
+	for (guint i = 0; i < 10000; i += 10) {
+		g_autofree gchar *device_id = g_strdup_printf("device-%05u", i);
+		g_autoptr(FuDevice) device = NULL;
+		device = fu_history_get_device_by_id(history, device_id, &error);
+		g_assert_no_error(error);
+		g_assert_nonnull(device);
+	}
+	g_print("lookup=%.3fms ", g_timer_elapsed(timer, NULL) * 1000.f);
+
+	/* get everything */
+	g_timer_reset(timer);
+	devices = fu_history_get_devices(history, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(devices);
+	g_assert_cmpint(devices->len, ==, 10000);
+	g_print("all=%.3fms ", g_timer_elapsed(timer, NULL) * 1000.f);
+
+	/* do not leave this around for the other tests */
+	ret = fu_history_remove_all(history, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+}
+
 static void
 fu_history_migrate_v1_func(gconstpointer user_data)
 {
@@ -5175,6 +6172,139 @@ fu_backend_usb_func(gconstpointer user_data)
 	g_assert_cmpint(cnt_removed, ==, 1);
 }
 
+static void
+fu_backend_usb_rescan_func(gconstpointer user_data)
+{
+	FuTest *self = (FuTest *)user_data;
+	guint cnt_removed = 0;
+	g_autoptr(FuBackend) backend = fu_usb_backend_new(self->ctx);
+	g_autoptr(GHashTable) backend_ids =
+	    g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	g_autoptr(GPtrArray) backend_ids_added = NULL;
+	g_autoptr(GTimer) timer = g_timer_new();
+
+	g_signal_connect(backend,
+			 "device-removed",
+			 G_CALLBACK(fu_backend_usb_hotplug_cb),
+			 &cnt_removed);
+
+	/* 500 devices already added, spread over a few busses */
+	for (guint i = 0; i < 500; i++) {
+		g_autofree gchar *backend_id = g_strdup_printf("%02x:%02x", i / 100, i % 100);
+		g_autoptr(FuDevice) device = fu_device_new(self->ctx);
+		fu_device_set_backend_id(device, backend_id);
+		fu_backend_device_added(backend, device);
+		g_hash_table_add(backend_ids, g_steal_pointer(&backend_id));
+	}
+
+	/* nothing changed, so nothing to create */
+	g_timer_reset(timer);
+	backend_ids_added = fu_usb_backend_rescan_diff(FU_USB_BACKEND(backend), backend_ids);
+	g_print("rescan=%.3fms ", g_timer_elapsed(timer, NULL) * 1000.f);
+	g_assert_cmpint(backend_ids_added->len, ==, 0);
+	g_assert_cmpint(cnt_removed, ==, 0);
+	g_clear_pointer(&backend_ids_added, g_ptr_array_unref);
+
+	/* unplug one device, and plug in another on a new bus */
+	g_hash_table_remove(backend_ids, "02:07");
+	g_hash_table_add(backend_ids, g_strdup("05:01"));
+	backend_ids_added = fu_usb_backend_rescan_diff(FU_USB_BACKEND(backend), backend_ids);
+	g_assert_cmpint(backend_ids_added->len, ==, 1);
+	g_assert_cmpstr(g_ptr_array_index(backend_ids_added, 0), ==, "05:01");
+	g_assert_cmpint(cnt_removed, ==, 1);
+	g_assert_null(fu_backend_lookup_by_id(backend, "02:07"));
+	g_assert_nonnull(fu_backend_lookup_by_id(backend, "02:08"));
+}
+
+#ifdef HAVE_UDEV
+static void
+fu_backend_udev_coldplug_func(gconstpointer user_data)
+{
+	gboolean ret;
+	const gchar *subsystems[] = {"block", "hidraw", "nvme", "tpm", "video4linux", "pci", "usb"};
+	g_autofree gchar *sysfsdir = fu_path_from_kind(FU_PATH_KIND_SYSFSDIR);
+	g_autofree gchar *sysfs_path = NULL;
+	g_autofree gchar *vendor1 = NULL;
+	g_autofree gchar *vendor2 = NULL;
+	g_autofree gchar *vendor3 = NULL;
+	g_autofree gchar *vendor4 = NULL;
+	g_autofree gchar *vendor5 = NULL;
+	g_autoptr(FuContext) ctx = fu_context_new();
+	g_autoptr(FuBackend) backend = fu_udev_backend_new(ctx);
+	g_autoptr(FuProgress) progress = fu_progress_new(G_STRLOC);
+	g_autoptr(FuUdevDevice) udev_device = NULL;
+	g_autoptr(FuUdevDevice) udev_device_tmp = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) devices = NULL;
+	g_autoptr(GTimer) timer = g_timer_new();
+
+	/* enumerate the fake sysfs tree */
+	for (guint i = 0; i < G_N_ELEMENTS(subsystems); i++)
+		fu_context_add_udev_subsystem(ctx, subsystems[i], NULL);
+	ret = fu_backend_setup(backend, FU_BACKEND_SETUP_FLAG_NONE, progress, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	g_timer_reset(timer);
+	ret = fu_backend_coldplug(backend, progress, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	g_print("coldplug=%.3fms ", g_timer_elapsed(timer, NULL) * 1000.f);
+	devices = fu_backend_get_devices(backend);
+	g_assert_cmpint(devices->len, >, 0);
+
+	/* immutable attributes are only read once */
+	sysfs_path = g_build_filename(sysfsdir, "devices", "pci0000:00", "0000:00:14.0", NULL);
+	udev_device = fu_udev_device_new(ctx, sysfs_path);
+	g_timer_reset(timer);
+	vendor1 = fu_udev_device_read_sysfs(udev_device,
+					    "vendor",
+					    FU_UDEV_DEVICE_ATTR_READ_TIMEOUT_DEFAULT,
+					    &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(vendor1);
+	g_print("uncached=%.3fms ", g_timer_elapsed(timer, NULL) * 1000.f);
+	g_timer_reset(timer);
+	vendor2 = fu_udev_device_read_sysfs(udev_device,
+					    "vendor",
+					    FU_UDEV_DEVICE_ATTR_READ_TIMEOUT_DEFAULT,
+					    &error);
+	g_assert_no_error(error);
+	g_print("cached=%.3fms ", g_timer_elapsed(timer, NULL) * 1000.f);
+	g_assert_cmpstr(vendor1, ==, vendor2);
+
+	/* a cached attribute is not read from the file again... */
+	g_mkdir_with_parents("/tmp/fwupd-self-test/sys/fake", 0700);
+	ret = g_file_set_contents("/tmp/fwupd-self-test/sys/fake/vendor", "0x8086", -1, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	udev_device_tmp = fu_udev_device_new(ctx, "/tmp/fwupd-self-test/sys/fake");
+	vendor3 = fu_udev_device_read_sysfs(udev_device_tmp,
+					    "vendor",
+					    FU_UDEV_DEVICE_ATTR_READ_TIMEOUT_DEFAULT,
+					    &error);
+	g_assert_no_error(error);
+	g_assert_cmpstr(vendor3, ==, "0x8086");
+	ret = g_file_set_contents("/tmp/fwupd-self-test/sys/fake/vendor", "0x1234", -1, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	vendor4 = fu_udev_device_read_sysfs(udev_device_tmp,
+					    "vendor",
+					    FU_UDEV_DEVICE_ATTR_READ_TIMEOUT_DEFAULT,
+					    &error);
+	g_assert_no_error(error);
+	g_assert_cmpstr(vendor4, ==, "0x8086");
+
+	/* ...until the kernel device changes */
+	fu_udev_device_emit_changed(udev_device_tmp);
+	vendor5 = fu_udev_device_read_sysfs(udev_device_tmp,
+					    "vendor",
+					    FU_UDEV_DEVICE_ATTR_READ_TIMEOUT_DEFAULT,
+					    &error);
+	g_assert_no_error(error);
+	g_assert_cmpstr(vendor5, ==, "0x1234");
+}
+#endif
+
 static void
 fu_backend_usb_invalid_func(gconstpointer user_data)
 {
@@ -8100,6 +9230,92 @@ fu_test_engine_fake_block(gconstpointer user_data)
 	g_assert_cmpstr(fu_device_get_vendor(device), ==, "IBM-ESXS");
 }
 
+static GPtrArray *
+fu_test_engine_coldplug_threads_load(FuTest *self,
+				     const gchar *threads,
+				     gdouble *elapsed,
+				     guint *worker_cnt)
+{
+	gboolean ret;
+	g_autoptr(FuEngine) engine = fu_engine_new(self->ctx);
+	g_autoptr(FuProgress) progress = fu_progress_new(G_STRLOC);
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) devices = NULL;
+	g_autoptr(GPtrArray) ids = g_ptr_array_new_with_free_func(g_free);
+	g_autoptr(GTimer) timer = g_timer_new();
+
+	fu_config_set_default(FU_CONFIG(fu_engine_get_config(engine)),
+			      "fwupd",
+			      "ColdplugThreads",
+			      threads);
+	ret = fu_engine_load(engine,
+			     FU_ENGINE_LOAD_FLAG_COLDPLUG | FU_ENGINE_LOAD_FLAG_BUILTIN_PLUGINS |
+				 FU_ENGINE_LOAD_FLAG_READONLY | FU_ENGINE_LOAD_FLAG_NO_CACHE,
+			     progress,
+			     &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	*elapsed = g_timer_elapsed(timer, NULL);
+	*worker_cnt = fu_engine_get_coldplug_worker_cnt(engine);
+
+	/* the device IDs in the order they were added */
+	devices = fu_engine_get_devices(engine, &error);
+	if (devices == NULL) {
+		g_assert_error(error, FWUPD_ERROR, FWUPD_ERROR_NOTHING_TO_DO);
+		return g_steal_pointer(&ids);
+	}
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *device = g_ptr_array_index(devices, i);
+		g_ptr_array_add(ids,
+				g_strdup_printf("%s:%s",
+						fu_device_get_plugin(device),
+						fu_device_get_id(device)));
+	}
+	return g_steal_pointer(&ids);
+}
+
+static void
+fu_test_engine_coldplug_threads(gconstpointer user_data)
+{
+	FuTest *self = (FuTest *)user_data;
+	gdouble elapsed_serial = 0.f;
+	gdouble elapsed_threaded = 0.f;
+	guint worker_cnt_serial = 0;
+	guint worker_cnt_threaded = 0;
+	g_autoptr(GPtrArray) ids_serial = NULL;
+	g_autoptr(GPtrArray) ids_threaded = NULL;
+
+	/* non-linux */
+	if (!fu_context_has_backend(self->ctx, "udev")) {
+		g_test_skip("no Udev backend");
+		return;
+	}
+
+	/* same devices, in the same order, regardless of how they were probed */
+	ids_serial =
+	    fu_test_engine_coldplug_threads_load(self, "0", &elapsed_serial, &worker_cnt_serial);
+	ids_threaded = fu_test_engine_coldplug_threads_load(self,
+							    "4",
+							    &elapsed_threaded,
+							    &worker_cnt_threaded);
+	g_assert_cmpint(ids_serial->len, >, 0);
+	g_assert_cmpint(ids_serial->len, ==, ids_threaded->len);
+	for (guint i = 0; i < ids_serial->len; i++) {
+		g_assert_cmpstr(g_ptr_array_index(ids_serial, i),
+				==,
+				g_ptr_array_index(ids_threaded, i));
+	}
+
+	/* the nvme and scsi plugins are thread-safe, so were run from the pool */
+	g_assert_cmpint(worker_cnt_serial, ==, 0);
+	g_assert_cmpint(worker_cnt_threaded, >=, 2);
+	g_test_message("coldplug of %u devices: serial %.1fms, threaded %.1fms (%u on workers)",
+		       ids_serial->len,
+		       elapsed_serial * 1000.f,
+		       elapsed_threaded * 1000.f,
+		       worker_cnt_threaded);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -8164,6 +9380,9 @@ main(int argc, char **argv)
 	g_test_add_func("/fwupd/idle", fu_idle_func);
 	g_test_add_func("/fwupd/util", fu_util_func);
 	g_test_add_func("/fwupd/client-list", fu_client_list_func);
+	g_test_add_func("/fwupd/device-signal-list{diff}", fu_device_signal_list_diff_func);
+	g_test_add_func("/fwupd/device-signal-list{cache}", fu_device_signal_list_cache_func);
+	g_test_add_func("/fwupd/device-signal-list{coalesce}", fu_device_signal_list_coalesce_func);
 	g_test_add_func("/fwupd/remote{download}", fu_remote_download_func);
 	g_test_add_func("/fwupd/remote{base-uri}", fu_remote_baseuri_func);
 	g_test_add_func("/fwupd/remote{no-path}", fu_remote_nopath_func);
@@ -8174,6 +9393,10 @@ main(int argc, char **argv)
 	g_test_add_func("/fwupd/unix-seekable-input-stream", fu_unix_seekable_input_stream_func);
 	g_test_add_data_func("/fwupd/backend{usb}", self, fu_backend_usb_func);
 	g_test_add_data_func("/fwupd/backend{usb-invalid}", self, fu_backend_usb_invalid_func);
+	g_test_add_data_func("/fwupd/backend{usb-rescan}", self, fu_backend_usb_rescan_func);
+#ifdef HAVE_UDEV
+	g_test_add_data_func("/fwupd/backend{udev-coldplug}", self, fu_backend_udev_coldplug_func);
+#endif
 	g_test_add_data_func("/fwupd/plugin{module}", self, fu_plugin_module_func);
 	g_test_add_data_func("/fwupd/memcpy", self, fu_memcpy_func);
 	g_test_add_func("/fwupd/cabinet", fu_common_cabinet_func);
@@ -8182,6 +9405,7 @@ main(int argc, char **argv)
 	g_test_add_data_func("/fwupd/device-list{unconnected-no-delay}",
 			     self,
 			     fu_device_list_unconnected_no_delay_func);
+	g_test_add_data_func("/fwupd/device-list{index}", self, fu_device_list_index_func);
 	g_test_add_data_func("/fwupd/device-list{equivalent-id}",
 			     self,
 			     fu_device_list_equivalent_id_func);
@@ -8240,6 +9464,11 @@ main(int argc, char **argv)
 	g_test_add_data_func("/fwupd/engine{device-md-set-flags}",
 			     self,
 			     fu_engine_device_md_set_flags_func);
+	g_test_add_data_func("/fwupd/engine{silo}", self, fu_engine_silo_func);
+	g_test_add_data_func("/fwupd/engine{silo-incremental}",
+			     self,
+			     fu_engine_silo_incremental_func);
+	g_test_add_data_func("/fwupd/engine{metainfo-cache}", self, fu_engine_metainfo_cache_func);
 	g_test_add_data_func("/fwupd/engine{device-md-checksum-set-version}",
 			     self,
 			     fu_engine_device_md_checksum_set_version_func);
@@ -8249,6 +9478,9 @@ main(int argc, char **argv)
 	g_test_add_data_func("/fwupd/engine{multiple-releases}",
 			     self,
 			     fu_engine_multiple_rels_func);
+	g_test_add_data_func("/fwupd/engine{install-threads}",
+			     self,
+			     fu_engine_install_threads_func);
 	g_test_add_data_func("/fwupd/engine{install-loop-restart}",
 			     self,
 			     fu_engine_install_loop_restart_func);
@@ -8262,6 +9494,9 @@ main(int argc, char **argv)
 	g_test_add_data_func("/fwupd/engine{fake-serio}", self, fu_test_engine_fake_serio);
 	g_test_add_data_func("/fwupd/engine{fake-nvme}", self, fu_test_engine_fake_nvme);
 	g_test_add_data_func("/fwupd/engine{fake-block}", self, fu_test_engine_fake_block);
+	g_test_add_data_func("/fwupd/engine{coldplug-threads}",
+			     self,
+			     fu_test_engine_coldplug_threads);
 	g_test_add_data_func("/fwupd/engine{fake-tpm}", self, fu_test_engine_fake_tpm);
 	g_test_add_data_func("/fwupd/engine{fake-v4l}", self, fu_test_engine_fake_v4l);
 	if (g_test_slow()) {
@@ -8272,6 +9507,12 @@ main(int argc, char **argv)
 	g_test_add_data_func("/fwupd/device-list{replug-user}",
 			     self,
 			     fu_device_list_replug_user_func);
+	g_test_add_data_func("/fwupd/device-list{replug-latency}",
+			     self,
+			     fu_device_list_replug_latency_func);
+	g_test_add_data_func("/fwupd/device-list{replug-cond}",
+			     self,
+			     fu_device_list_replug_cond_func);
 	g_test_add_func("/fwupd/engine{machine-hash}", fu_engine_machine_hash_func);
 	g_test_add_func("/fwupd/engine{error-array}", fu_engine_error_array_func);
 	g_test_add_data_func("/fwupd/engine{report-metadata}",
@@ -8285,6 +9526,7 @@ main(int argc, char **argv)
 	g_test_add_data_func("/fwupd/engine{history-inherit}", self, fu_engine_history_inherit);
 	g_test_add_data_func("/fwupd/engine{partial-hash}", self, fu_engine_partial_hash_func);
 	g_test_add_data_func("/fwupd/engine{downgrade}", self, fu_engine_downgrade_func);
+	g_test_add_data_func("/fwupd/engine{releases-cache}", self, fu_engine_releases_cache_func);
 	g_test_add_data_func("/fwupd/engine{md-verfmt}", self, fu_engine_md_verfmt_func);
 	g_test_add_data_func("/fwupd/engine{requirements-success}",
 			     self,
@@ -8389,6 +9631,7 @@ main(int argc, char **argv)
 	g_test_add_data_func("/fwupd/history", self, fu_history_func);
 	g_test_add_data_func("/fwupd/history{migrate-v1}", self, fu_history_migrate_v1_func);
 	g_test_add_data_func("/fwupd/history{migrate-v2}", self, fu_history_migrate_v2_func);
+	g_test_add_data_func("/fwupd/history{performance}", self, fu_history_performance_func);
 	g_test_add_data_func("/fwupd/plugin-list", self, fu_plugin_list_func);
 	g_test_add_data_func("/fwupd/plugin-list{depsolve}", self, fu_plugin_list_depsolve_func);
 	g_test_add_func("/fwupd/common{cab-success}", fu_common_store_cab_func);
@@ -30,6 +30,7 @@
 #include "fu-context-private.h"
 #include "fu-debug.h"
 #include "fu-device-private.h"
+#include "fu-efivars-private.h"
 #include "fu-engine-helper.h"
 #include "fu-engine-requirements.h"
 #include "fu-engine.h"
@@ -4029,6 +4030,7 @@ static gboolean
 fu_util_security(FuUtil *self, gchar **values, GError **error)
 {
 	FuSecurityAttrToStringFlags flags = FU_SECURITY_ATTR_TO_STRING_FLAG_NONE;
+	FuEfivars *efivars;
 	const gchar *fwupd_version = NULL;
 	g_autoptr(FuSecurityAttrs) attrs = NULL;
 	g_autoptr(FuSecurityAttrs) events = NULL;
@@ -4067,6 +4069,12 @@ fu_util_security(FuUtil *self, gchar **values, GError **error)
 	attrs = fu_engine_get_host_security_attrs(self->engine);
 	items = fu_security_attrs_get_all(attrs, fwupd_version);
 
+	/* how many variable reads were saved by the cache */
+	efivars = fu_context_get_efivars(fu_engine_get_context(self->engine));
+	g_debug("efivars read %u times, %u reads served from cache",
+		fu_efivars_get_cache_misses(efivars),
+		fu_efivars_get_cache_hits(efivars));
+
 	/* print the "why" */
 	if (self->as_json) {
 		str = fwupd_codec_to_json_string(FWUPD_CODEC(attrs), FWUPD_CODEC_FLAG_NONE, error);
@@ -5262,6 +5270,7 @@ main(int argc, char *argv[])
 	g_autofree gchar *cmd_descriptions = NULL;
 	g_autofree gchar *filter_device = NULL;
 	g_autofree gchar *filter_release = NULL;
+	g_autofree gchar *trace_filename = NULL;
 	const GOptionEntry options[] = {
 	    {"version",
 	     '\0',
@@ -5441,6 +5450,14 @@ main(int argc, char *argv[])
 	     /* TRANSLATORS: command line option */
 	     N_("Answer yes to all questions"),
 	     NULL},
+	    {"trace",
+	     '\0',
+	     0,
+	     G_OPTION_ARG_FILENAME,
+	     &trace_filename,
+	     /* TRANSLATORS: command line option */
+	     N_("Write a trace of the time spent in each step to a file, for Perfetto"),
+	     NULL},
 	    {"json",
 	     '\0',
 	     0,
@@ -6036,7 +6053,8 @@ main(int argc, char *argv[])
 				 error->message);
 		return EXIT_FAILURE;
 	}
-	fu_progress_set_profile(self->progress, g_getenv("FWUPD_VERBOSE") != NULL);
+	fu_progress_set_profile(self->progress,
+				g_getenv("FWUPD_VERBOSE") != NULL || trace_filename != NULL);
 
 	/* allow disabling SSL strict mode for broken corporate proxies */
 	if (self->disable_ssl_strict) {
@@ -6137,6 +6155,15 @@ main(int argc, char *argv[])
 
 	/* run the specified command */
 	ret = fu_util_cmd_array_run(cmd_array, self, argv[1], (gchar **)&argv[2], &error);
+
+	/* write the trace even on failure, as that is probably what is being debugged */
+	if (trace_filename != NULL) {
+		g_autoptr(JsonArray) trace_events = json_array_new();
+		g_autoptr(GError) error_trace = NULL;
+		fu_engine_trace_add_progress(trace_events, self->progress, 1);
+		if (!fu_engine_trace_save(trace_events, trace_filename, &error_trace))
+			g_warning("%s", error_trace->message);
+	}
 	if (!ret) {
 #ifdef SUPPORTED_BUILD
 		/* sanity check */
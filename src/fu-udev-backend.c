@@ -10,10 +10,15 @@
 
 #include <fwupdplugin.h>
 
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <glib-unix.h>
 #include <glib/gstdio.h>
 #include <linux/netlink.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "fu-context-private.h"
 #include "fu-engine-struct.h"
@@ -367,29 +372,62 @@ fu_udev_backend_device_number_sort_cb(gconstpointer a, gconstpointer b)
 	return 0;
 }
 
+typedef struct {
+	gint sysfs_fd;
+	const gchar *sysfsdir;
+	const gchar *subsystem;
+	GPtrArray *paths; /* (element-type utf-8) */
+} FuUdevBackendColdplugHelper;
+
 static void
-fu_udev_backend_coldplug_subsystem(FuUdevBackend *self, const gchar *fn)
+fu_udev_backend_coldplug_helper_free(FuUdevBackendColdplugHelper *helper)
 {
-	const gchar *basename;
-	g_autoptr(GDir) dir = NULL;
-	g_autoptr(GError) error_dir = NULL;
-	g_autoptr(GPtrArray) devices =
-	    g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
+	if (helper->paths != NULL)
+		g_ptr_array_unref(helper->paths);
+	g_free(helper);
+}
 
-	dir = g_dir_open(fn, 0, &error_dir);
+/* this is run in a worker thread, and only touches the filesystem */
+static void
+fu_udev_backend_coldplug_enumerate_cb(gpointer data, gpointer user_data)
+{
+	FuUdevBackendColdplugHelper *helper = (FuUdevBackendColdplugHelper *)data;
+	DIR *dir;
+	gint dir_fd;
+	struct dirent *ent;
+	g_autofree gchar *relpath = g_build_filename("class", helper->subsystem, NULL);
+
+	/* prefer the class, falling back to the bus */
+	dir_fd = openat(helper->sysfs_fd, relpath, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (dir_fd < 0) {
+		g_free(relpath);
+		relpath = g_build_filename("bus", helper->subsystem, "devices", NULL);
+		dir_fd = openat(helper->sysfs_fd, relpath, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	}
+	if (dir_fd < 0) {
+		if (errno != ENOENT)
+			g_debug("ignoring %s: %s", helper->subsystem, fwupd_strerror(errno));
+		return;
+	}
+	dir = fdopendir(dir_fd);
 	if (dir == NULL) {
-		if (!g_error_matches(error_dir, G_FILE_ERROR, G_FILE_ERROR_NOENT))
-			g_debug("ignoring: %s", error_dir->message);
+		g_debug("ignoring %s: %s", helper->subsystem, fwupd_strerror(errno));
+		close(dir_fd);
 		return;
 	}
-	while ((basename = g_dir_read_name(dir)) != NULL) {
-		g_autofree gchar *fn_full = g_build_filename(fn, basename, NULL);
+	while ((ent = readdir(dir)) != NULL) {
+		struct stat st = {0};
+		g_autofree gchar *fn_full = NULL;
 		g_autofree gchar *fn_real = NULL;
 		g_autoptr(GError) error_local = NULL;
-		g_autoptr(FuUdevDevice) device = NULL;
 
-		if (!g_file_test(fn_full, G_FILE_TEST_IS_DIR))
+		if (g_strcmp0(ent->d_name, ".") == 0 || g_strcmp0(ent->d_name, "..") == 0)
+			continue;
+
+		/* follows the symlink without building the absolute path */
+		if (fstatat(dir_fd, ent->d_name, &st, 0) != 0 || !S_ISDIR(st.st_mode))
 			continue;
+		fn_full = g_build_filename(helper->sysfsdir, relpath, ent->d_name, NULL);
 		fn_real = fu_path_make_absolute(fn_full, &error_local);
 		if (fn_real == NULL) {
 			g_warning("failed to get symlink target for %s: %s",
@@ -397,6 +435,22 @@ fu_udev_backend_coldplug_subsystem(FuUdevBackend *self, const gchar *fn)
 				  error_local->message);
 			continue;
 		}
+		g_ptr_array_add(helper->paths, g_steal_pointer(&fn_real));
+	}
+	closedir(dir);
+}
+
+static void
+fu_udev_backend_coldplug_subsystem(FuUdevBackend *self, GPtrArray *paths)
+{
+	g_autoptr(GPtrArray) devices =
+	    g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
+
+	for (guint i = 0; i < paths->len; i++) {
+		const gchar *fn_real = g_ptr_array_index(paths, i);
+		g_autoptr(GError) error_local = NULL;
+		g_autoptr(FuUdevDevice) device = NULL;
+
 		if (g_hash_table_contains(self->map_paths, fn_real)) {
 			g_debug("skipping duplicate %s", fn_real);
 			continue;
@@ -410,7 +464,7 @@ fu_udev_backend_coldplug_subsystem(FuUdevBackend *self, const gchar *fn)
 				  error_local->message);
 			continue;
 		}
-		g_hash_table_add(self->map_paths, g_steal_pointer(&fn_real));
+		g_hash_table_add(self->map_paths, g_strdup(fn_real));
 		g_ptr_array_add(devices, g_steal_pointer(&device));
 	}
 
@@ -663,48 +717,82 @@ fu_udev_backend_netlink_setup(FuUdevBackend *self, GError **error)
 }
 
 static gboolean
-fu_udev_backend_coldplug(FuBackend *backend, FuProgress *progress, GError **error)
+fu_udev_backend_coldplug_sysfs(FuUdevBackend *self, FuProgress *progress, GError **error)
 {
-	FuContext *ctx = fu_backend_get_context(backend);
-	FuUdevBackend *self = FU_UDEV_BACKEND(backend);
+	FuContext *ctx = fu_backend_get_context(FU_BACKEND(self));
+	GThreadPool *pool;
+	gint sysfs_fd;
 	g_autofree gchar *sysfsdir = fu_path_from_kind(FU_PATH_KIND_SYSFSDIR);
+	g_autoptr(GPtrArray) helpers =
+	    g_ptr_array_new_with_free_func((GDestroyNotify)fu_udev_backend_coldplug_helper_free);
 	g_autoptr(GPtrArray) udev_subsystems = fu_context_get_udev_subsystems(ctx);
 
-	/* get all devices of class */
-	fu_progress_set_id(progress, G_STRLOC);
-	fu_progress_set_steps(progress, udev_subsystems->len);
+	/* we only care about subsystems, not subsystem:devtype matches */
 	for (guint i = 0; i < udev_subsystems->len; i++) {
 		const gchar *subsystem = g_ptr_array_index(udev_subsystems, i);
-		g_autofree gchar *class_fn = NULL;
-		g_autofree gchar *bus_fn = NULL;
-
-		/* we only care about subsystems, not subsystem:devtype matches */
-		if (g_strstr_len(subsystem, -1, ":") != NULL) {
-			fu_progress_step_done(progress);
+		FuUdevBackendColdplugHelper *helper;
+		if (g_strstr_len(subsystem, -1, ":") != NULL)
 			continue;
+		helper = g_new0(FuUdevBackendColdplugHelper, 1);
+		helper->sysfsdir = sysfsdir;
+		helper->subsystem = subsystem;
+		helper->paths = g_ptr_array_new_with_free_func(g_free);
+		g_ptr_array_add(helpers, helper);
+	}
+
+	/* enumerate all the subsystem directories at the same time */
+	sysfs_fd = open(sysfsdir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (sysfs_fd < 0) {
+		g_debug("failed to open %s: %s", sysfsdir, fwupd_strerror(errno));
+		self->done_coldplug = TRUE;
+		return TRUE;
+	}
+	pool = g_thread_pool_new(fu_udev_backend_coldplug_enumerate_cb,
+				 NULL,
+				 MAX(MIN(g_get_num_processors(), helpers->len), 1),
+				 TRUE,
+				 error);
+	if (pool == NULL) {
+		close(sysfs_fd);
+		return FALSE;
+	}
+	for (guint i = 0; i < helpers->len; i++) {
+		FuUdevBackendColdplugHelper *helper = g_ptr_array_index(helpers, i);
+		helper->sysfs_fd = sysfs_fd;
+		if (!g_thread_pool_push(pool, helper, error)) {
+			g_thread_pool_free(pool, FALSE, TRUE);
+			close(sysfs_fd);
+			return FALSE;
 		}
+	}
+	g_thread_pool_free(pool, FALSE, TRUE);
+	close(sysfs_fd);
 
-		class_fn = g_build_filename(sysfsdir, "class", subsystem, NULL);
-		if (g_file_test(class_fn, G_FILE_TEST_EXISTS)) {
-			fu_udev_backend_coldplug_subsystem(self, class_fn);
-			fu_progress_step_done(progress);
-			continue;
-		}
-		bus_fn = g_build_filename(sysfsdir, "bus", subsystem, "devices", NULL);
-		if (g_file_test(bus_fn, G_FILE_TEST_EXISTS)) {
-			fu_udev_backend_coldplug_subsystem(self, bus_fn);
-			fu_progress_step_done(progress);
-			continue;
-		}
+	/* create the devices in the main thread, in subsystem order */
+	fu_progress_set_id(progress, G_STRLOC);
+	fu_progress_set_steps(progress, helpers->len);
+	for (guint i = 0; i < helpers->len; i++) {
+		FuUdevBackendColdplugHelper *helper = g_ptr_array_index(helpers, i);
+		fu_udev_backend_coldplug_subsystem(self, helper->paths);
 		fu_progress_step_done(progress);
 	}
 
 	/* success */
-	g_hash_table_remove_all(self->coldplug_cache);
 	self->done_coldplug = TRUE;
 	return TRUE;
 }
 
+static gboolean
+fu_udev_backend_coldplug(FuBackend *backend, FuProgress *progress, GError **error)
+{
+	FuUdevBackend *self = FU_UDEV_BACKEND(backend);
+	gboolean ret = fu_udev_backend_coldplug_sysfs(self, progress, error);
+
+	/* the cache is only valid while coldplugging, even if that failed */
+	g_hash_table_remove_all(self->coldplug_cache);
+	return ret;
+}
+
 static gboolean
 fu_udev_backend_setup(FuBackend *backend,
 		      FuBackendSetupFlags flags,
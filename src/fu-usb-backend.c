@@ -39,6 +39,39 @@ G_DEFINE_TYPE(FuUsbBackend, fu_usb_backend, FU_TYPE_BACKEND)
 #define FU_USB_BACKEND_POLL_INTERVAL_DEFAULT	 1000 /* ms */
 #define FU_USB_BACKEND_POLL_INTERVAL_WAIT_REPLUG 5    /* ms */
 
+/*
+ * Emits ::device-removed for every device not in @backend_ids (bus:address), and returns the IDs
+ * that have not been added yet -- borrowed from @backend_ids. This is O(n) in the device count.
+ */
+GPtrArray *
+fu_usb_backend_rescan_diff(FuUsbBackend *self, GHashTable *backend_ids)
+{
+	GHashTableIter iter;
+	const gchar *backend_id;
+	g_autoptr(GPtrArray) backend_ids_added = g_ptr_array_new();
+	g_autoptr(GPtrArray) devices = fu_backend_get_devices(FU_BACKEND(self));
+
+	g_return_val_if_fail(FU_IS_USB_BACKEND(self), NULL);
+	g_return_val_if_fail(backend_ids != NULL, NULL);
+
+	/* look for any removed devices */
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *device = g_ptr_array_index(devices, i);
+		if (!g_hash_table_contains(backend_ids, fu_device_get_backend_id(device)))
+			fu_backend_device_removed(FU_BACKEND(self), device);
+	}
+
+	/* look for any new devices */
+	g_hash_table_iter_init(&iter, backend_ids);
+	while (g_hash_table_iter_next(&iter, (gpointer *)&backend_id, NULL)) {
+		if (fu_backend_lookup_by_id(FU_BACKEND(self), backend_id) == NULL)
+			g_ptr_array_add(backend_ids_added, (gpointer)backend_id);
+	}
+
+	/* success */
+	return g_steal_pointer(&backend_ids_added);
+}
+
 #ifndef HAVE_UDEV
 static gchar *
 fu_usb_backend_get_usb_device_backend_id(libusb_device *usb_device)
@@ -138,39 +171,30 @@ static void
 fu_usb_backend_rescan(FuUsbBackend *self)
 {
 	libusb_device **dev_list = NULL;
-	g_autoptr(GList) existing_devices = NULL;
-	g_autoptr(GPtrArray) devices = fu_backend_get_devices(FU_BACKEND(self));
+	g_autoptr(GHashTable) usb_devices = NULL;
+	g_autoptr(GPtrArray) backend_ids = NULL;
 
 	/* skip actual enumeration */
 	if (g_getenv("FWUPD_SELF_TEST") != NULL)
 		return;
 
-	/* copy to a context so we can remove from the array */
-	for (guint i = 0; i < devices->len; i++) {
-		FuUsbDevice *device = g_ptr_array_index(devices, i);
-		existing_devices = g_list_prepend(existing_devices, device);
-	}
-
-	/* look for any removed devices */
+	/* bus:address -> libusb_device */
+	usb_devices = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
 	libusb_get_device_list(self->ctx, &dev_list);
-	for (GList *l = existing_devices; l != NULL; l = l->next) {
-		FuUsbDevice *device = FU_USB_DEVICE(l->data);
-		gboolean found = FALSE;
-		for (guint i = 0; dev_list != NULL && dev_list[i] != NULL; i++) {
-			if (libusb_get_bus_number(dev_list[i]) == fu_usb_device_get_bus(device) &&
-			    libusb_get_device_address(dev_list[i]) ==
-				fu_usb_device_get_address(device)) {
-				found = TRUE;
-				break;
-			}
-		}
-		if (!found)
-			fu_backend_device_removed(FU_BACKEND(self), FU_DEVICE(device));
+	for (guint i = 0; dev_list != NULL && dev_list[i] != NULL; i++) {
+		g_hash_table_insert(usb_devices,
+				    fu_usb_backend_get_usb_device_backend_id(dev_list[i]),
+				    dev_list[i]);
 	}
 
-	/* add any devices not yet added (duplicates will be filtered */
-	for (guint i = 0; dev_list != NULL && dev_list[i] != NULL; i++)
-		fu_usb_backend_add_device(self, dev_list[i]);
+	/* remove any devices that have gone, and only create the ones not already added */
+	backend_ids = fu_usb_backend_rescan_diff(self, usb_devices);
+	for (guint i = 0; i < backend_ids->len; i++) {
+		const gchar *backend_id = g_ptr_array_index(backend_ids, i);
+		libusb_device *usb_device = g_hash_table_lookup(usb_devices, backend_id);
+		g_autoptr(FuUsbDevice) device = fu_usb_backend_create_device(self, usb_device);
+		fu_backend_device_added(FU_BACKEND(self), FU_DEVICE(device));
+	}
 
 	libusb_free_device_list(dev_list, 1);
 }
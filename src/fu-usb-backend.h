@@ -13,3 +13,7 @@ G_DECLARE_FINAL_TYPE(FuUsbBackend, fu_usb_backend, FU, USB_BACKEND, FuBackend)
 
 FuBackend *
 fu_usb_backend_new(FuContext *ctx) G_GNUC_NON_NULL(1);
+
+/* for the self tests */
+GPtrArray *
+fu_usb_backend_rescan_diff(FuUsbBackend *self, GHashTable *backend_ids) G_GNUC_NON_NULL(1, 2);
@@ -1658,6 +1658,7 @@ fu_util_plugin_flag_to_cli_text(FwupdPluginFlags plugin_flag)
 	case FWUPD_PLUGIN_FLAG_UNKNOWN:
 	case FWUPD_PLUGIN_FLAG_CLEAR_UPDATABLE:
 	case FWUPD_PLUGIN_FLAG_USER_WARNING:
+	case FWUPD_PLUGIN_FLAG_THREAD_SAFE:
 	case FWUPD_PLUGIN_FLAG_NONE:
 		return NULL;
 	case FWUPD_PLUGIN_FLAG_READY:
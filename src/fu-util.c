@@ -2664,10 +2664,61 @@ fu_util_perhaps_refresh_remotes(FuUtil *self, GError **error)
 	return fu_util_download_metadata(self, error);
 }
 
+/* older daemons can only return the upgrades for one device at a time, so @upgrades is left
+ * unset and the caller has to use fu_util_get_upgrades_for_device() */
+static gboolean
+fu_util_get_upgrades_all(FuUtil *self, GHashTable **upgrades, GError **error)
+{
+	g_autoptr(GError) error_local = NULL;
+
+	*upgrades = fwupd_client_get_upgrades_all(self->client,
+						  self->filter_release_include,
+						  self->filter_release_exclude,
+						  self->cancellable,
+						  &error_local);
+	if (*upgrades == NULL) {
+		if (!g_error_matches(error_local, FWUPD_ERROR, FWUPD_ERROR_NOT_SUPPORTED)) {
+			g_propagate_error(error, g_steal_pointer(&error_local));
+			return FALSE;
+		}
+		g_debug("getting upgrades for each device: %s", error_local->message);
+	}
+	return TRUE;
+}
+
+static GPtrArray *
+fu_util_get_upgrades_for_device(FuUtil *self,
+				GHashTable *upgrades,
+				FwupdDevice *dev,
+				GError **error)
+{
+	GPtrArray *rels;
+
+	if (upgrades == NULL) {
+		return fwupd_client_get_upgrades(self->client,
+						 fwupd_device_get_id(dev),
+						 self->cancellable,
+						 error);
+	}
+	rels = g_hash_table_lookup(upgrades, fwupd_device_get_id(dev));
+	if (rels == NULL) {
+		g_set_error_literal(error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_NOTHING_TO_DO,
+				    "no upgrades for device");
+		return NULL;
+	}
+	return g_ptr_array_ref(rels);
+}
+
 static gboolean
 fu_util_get_updates_as_json(FuUtil *self, GPtrArray *devices, GError **error)
 {
+	g_autoptr(GHashTable) upgrades = NULL;
 	g_autoptr(JsonBuilder) builder = json_builder_new();
+
+	if (!fu_util_get_upgrades_all(self, &upgrades, error))
+		return FALSE;
 	json_builder_begin_object(builder);
 	json_builder_set_member_name(builder, "Devices");
 	json_builder_begin_array(builder);
@@ -2681,10 +2732,7 @@ fu_util_get_updates_as_json(FuUtil *self, GPtrArray *devices, GError **error)
 			continue;
 
 		/* get the releases for this device and filter for validity */
-		rels = fwupd_client_get_upgrades(self->client,
-						 fwupd_device_get_id(dev),
-						 self->cancellable,
-						 &error_local);
+		rels = fu_util_get_upgrades_for_device(self, upgrades, dev, &error_local);
 		if (rels == NULL) {
 			g_debug("no upgrades: %s", error_local->message);
 			continue;
@@ -2714,6 +2762,7 @@ fu_util_get_updates(FuUtil *self, gchar **values, GError **error)
 	g_autoptr(GPtrArray) devices = NULL;
 	gboolean supported = FALSE;
 	g_autoptr(FuUtilNode) root = g_node_new(NULL);
+	g_autoptr(GHashTable) upgrades = NULL;
 	g_autoptr(GPtrArray) devices_no_support = g_ptr_array_new();
 	g_autoptr(GPtrArray) devices_no_upgrades = g_ptr_array_new();
 
@@ -2747,6 +2796,8 @@ fu_util_get_updates(FuUtil *self, gchar **values, GError **error)
 	if (self->as_json)
 		return fu_util_get_updates_as_json(self, devices, error);
 
+	if (!fu_util_get_upgrades_all(self, &upgrades, error))
+		return FALSE;
 	for (guint i = 0; i < devices->len; i++) {
 		FwupdDevice *dev = g_ptr_array_index(devices, i);
 		g_autoptr(GPtrArray) rels = NULL;
@@ -2768,10 +2819,7 @@ fu_util_get_updates(FuUtil *self, gchar **values, GError **error)
 		supported = TRUE;
 
 		/* get the releases for this device and filter for validity */
-		rels = fwupd_client_get_upgrades(self->client,
-						 fwupd_device_get_id(dev),
-						 self->cancellable,
-						 &error_local);
+		rels = fu_util_get_upgrades_for_device(self, upgrades, dev, &error_local);
 		if (rels == NULL) {
 			g_ptr_array_add(devices_no_upgrades, dev);
 			/* discard the actual reason from user, but leave for debugging */